@@ -3,6 +3,20 @@
 
 #include "PT_ElectrodeAreaActor.h"
 #include "PT_JSONConverter.h"
+#include "PT_SimulationComponent.h"
+#include "PT_Single3DActor.h"
+#include "Async/ParallelFor.h"
+#include "Async/Async.h"
+#include "Engine/Texture2D.h"
+
+/** Resolution of the first, coarsest preview atlas level. */
+static constexpr int32 PreviewAtlasCoarsestResolution = 9;
+
+/** Upper bound of the candidate positions scored by PlanAdaptiveSampling. */
+static constexpr int32 MaxAdaptiveSamplingCandidates = 65536;
+
+/** Source of the interpolator versions, unique over all electrode area actors. */
+static int32 NextInterpolatorVersion = 0;
 
 // Sets default values
 APT_ElectrodeAreaActor::APT_ElectrodeAreaActor()
@@ -10,6 +24,15 @@ APT_ElectrodeAreaActor::APT_ElectrodeAreaActor()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	this->ElectrodeRenderer = CreateDefaultSubobject<UPT_ElectrodeRendererComponent>(TEXT("ElectrodeRenderer"));
+}
+
+void APT_ElectrodeAreaActor::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+
+	// The root belongs to the Blueprint subclasses, the renderer is attached below it
+	this->ElectrodeRenderer->AttachToOwnerRoot();
 }
 
 // Called when the game starts or when spawned
@@ -19,6 +42,12 @@ void APT_ElectrodeAreaActor::BeginPlay()
 	
 }
 
+void APT_ElectrodeAreaActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	this->CancelPreviewAtlas();
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void APT_ElectrodeAreaActor::Tick(float DeltaTime)
 {
@@ -96,6 +125,10 @@ void APT_ElectrodeAreaActor::ProcessResponseData(
     {
         UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::ProcessResponseData] Field %s not found."), *ElectrodesFieldName);
     }
+
+    this->SetGridFrame({ OutA, OutB, OutC, OutD }, outCellSize, OutRows, outColumns);
+    this->GridRotation = OutRotation;
+    this->ElectrodeRenderer->SetElectrodePositions(OutElectrodePositions);
 }
 
 void APT_ElectrodeAreaActor::ProcessValidationResponseData(
@@ -141,6 +174,8 @@ void APT_ElectrodeAreaActor::ProcessValidationResponseData(
             }
         }
     }
+
+    this->ElectrodeRenderer->SetValidationResult(OutSuccessfullElectrodeIndex);
 }
 
 
@@ -150,31 +185,156 @@ TArray<FVector> APT_ElectrodeAreaActor::FindNearestNeighbors(
 {
     check(InGrid.Num() > 0);
 
-    TArray<FDistanceAndPoint> DistancesAndPoints;
-    DistancesAndPoints.SetNumZeroed(InGrid.Num());
+    // The index is only rebuilt when the grid changes, a drag pays one tree descent per mouse move
+    this->UpdateNeighborSearchIndex(InGrid);
+
+    int32 NeighborIndices[3];
+    double DistancesSquared[3];
+    const int32 NumFound = this->NeighborSearchIndex.FindNearest(InPoint, 3, NeighborIndices, DistancesSquared);
+
+    TArray<FVector> NearestNeighbors;
+    NearestNeighbors.SetNumZeroed(NumFound);
+    OutNearestNeighborsGridIndicies.SetNumZeroed(NumFound);
+
+    for (int32 i = 0; i < NumFound; i++)
+    {
+        NearestNeighbors[i] = InGrid[NeighborIndices[i]];
+        OutNearestNeighborsGridIndicies[i] = NeighborIndices[i];
+    }
+
+    return NearestNeighbors;
+}
+
+void APT_ElectrodeAreaActor::FindNearestNeighborsBatch(const TArray<FVector>& InPoints, const TArray<FVector>& InGrid, const int32& InCount, TArray<int32>& OutGridIndices, TArray<double>& OutDistances)
+{
+    if (InGrid.IsEmpty())
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::FindNearestNeighborsBatch] Grid is empty!"));
+        OutGridIndices.Empty();
+        OutDistances.Empty();
+        return;
+    }
+
+    this->UpdateNeighborSearchIndex(InGrid);
+
+    this->NeighborSearchIndex.FindNearestBatch(InPoints, InCount, OutGridIndices, OutDistances);
+    for (double& Distance : OutDistances)
+    {
+        Distance = FMath::Sqrt(Distance);
+    }
+}
+
+void APT_ElectrodeAreaActor::UpdateNeighborSearchIndex(const TArray<FVector>& InGrid)
+{
+    // A checksum of the positions is one linear pass without copying, Blueprints may change the grid in place
+    const uint32 GridHash = FCrc::MemCrc32(InGrid.GetData(), InGrid.Num() * sizeof(FVector));
+    if (this->NeighborSearchIndex.Num() == InGrid.Num() && this->NeighborSearchGridHash == GridHash)
+    {
+        return;
+    }
+
+    this->NeighborSearchIndex.Build(InGrid);
+    this->NeighborSearchGridHash = GridHash;
+}
+
+void APT_ElectrodeAreaActor::FindNearestNeighborsBySorting(const FVector& InPoint, const TArray<FVector>& InGrid, const int32 InCount, TArray<FDistanceAndPoint>& OutDistancesAndPoints)
+{
+    OutDistancesAndPoints.SetNumUninitialized(InGrid.Num());
 
     for (int32 i = 0; i < InGrid.Num(); i++)
     {
         double Distance = FVector::Dist(InPoint, InGrid[i]);
-        DistancesAndPoints[i] = { Distance, InGrid[i], i };
+        OutDistancesAndPoints[i] = { Distance, InGrid[i], i };
     }
 
-    DistancesAndPoints.Sort([](const FDistanceAndPoint& A, const FDistanceAndPoint& B)
+    OutDistancesAndPoints.Sort([](const FDistanceAndPoint& A, const FDistanceAndPoint& B)
     {
         return A.Distance < B.Distance;
     });
 
-    TArray<FVector> NearestNeighbors;
-    NearestNeighbors.SetNumZeroed(FMath::Min(3, InGrid.Num()));
-    OutNearestNeighborsGridIndicies.SetNumZeroed(FMath::Min(3, InGrid.Num()));
+    OutDistancesAndPoints.SetNum(FMath::Min(InCount, InGrid.Num()), false);
+}
+
+void APT_ElectrodeAreaActor::BenchmarkNeighborSearch(const int32& InNumQueries, TArray<int32>& OutElectrodeCounts, TArray<double>& OutSortMicroseconds, TArray<double>& OutIndexMicroseconds, TArray<double>& OutBatchMicroseconds)
+{
+    OutElectrodeCounts.Empty();
+    OutSortMicroseconds.Empty();
+    OutIndexMicroseconds.Empty();
+    OutBatchMicroseconds.Empty();
+
+    const int32 NumQueries = FMath::Max(InNumQueries, 1);
+    const double Spacing = this->GridCellSize > 0.0 ? this->GridCellSize : 1.0;
+    FRandomStream RandomStream(42);
 
-    for (int32 i = 0; i < FMath::Min(3, InGrid.Num()); i++)
+    for (int32 NumElectrodes = 16; NumElectrodes <= 1024; NumElectrodes *= 2)
     {
-        NearestNeighbors[i] = DistancesAndPoints[i].Point;
-        OutNearestNeighborsGridIndicies[i] = DistancesAndPoints[i].gridIndex;
-    }
+        // Slightly jittered square lattice in the XY plane, queries uniformly distributed over it
+        const int32 Columns = FMath::CeilToInt32(FMath::Sqrt((double)NumElectrodes));
+        const int32 Rows = FMath::DivideAndRoundUp(NumElectrodes, Columns);
+        TArray<FVector> Grid;
+        Grid.SetNumUninitialized(NumElectrodes);
+        for (int32 ElectrodeIndex = 0; ElectrodeIndex < NumElectrodes; ElectrodeIndex++)
+        {
+            Grid[ElectrodeIndex] = FVector(
+                (ElectrodeIndex % Columns + RandomStream.FRandRange(-0.1, 0.1)) * Spacing,
+                (ElectrodeIndex / Columns + RandomStream.FRandRange(-0.1, 0.1)) * Spacing,
+                0.0);
+        }
 
-    return NearestNeighbors;
+        TArray<FVector> QueryPoints;
+        QueryPoints.SetNumUninitialized(NumQueries);
+        for (FVector& QueryPoint : QueryPoints)
+        {
+            QueryPoint = FVector(RandomStream.FRandRange(0.0, Columns - 1) * Spacing, RandomStream.FRandRange(0.0, Rows - 1) * Spacing, 0.0);
+        }
+
+        const double BuildStart = FPlatformTime::Seconds();
+        FPT_ElectrodeSpatialIndex SpatialIndex;
+        SpatialIndex.Build(Grid);
+        const double BuildMicroseconds = (FPlatformTime::Seconds() - BuildStart) * 1e6;
+
+        TArray<FDistanceAndPoint> DistancesAndPoints;
+        TArray<double> SortDistances;
+        SortDistances.SetNumUninitialized(NumQueries * 3);
+        const double SortStart = FPlatformTime::Seconds();
+        for (int32 QueryIndex = 0; QueryIndex < NumQueries; QueryIndex++)
+        {
+            FindNearestNeighborsBySorting(QueryPoints[QueryIndex], Grid, 3, DistancesAndPoints);
+            for (int32 i = 0; i < 3; i++)
+            {
+                SortDistances[QueryIndex * 3 + i] = DistancesAndPoints[i].Distance;
+            }
+        }
+        const double SortMicroseconds = (FPlatformTime::Seconds() - SortStart) * 1e6 / NumQueries;
+
+        int32 NeighborIndices[3];
+        double DistancesSquared[3];
+        int32 NumMismatches = 0;
+        const double IndexStart = FPlatformTime::Seconds();
+        for (int32 QueryIndex = 0; QueryIndex < NumQueries; QueryIndex++)
+        {
+            SpatialIndex.FindNearest(QueryPoints[QueryIndex], 3, NeighborIndices, DistancesSquared);
+            NumMismatches += !FMath::IsNearlyEqual(FMath::Sqrt(DistancesSquared[2]), SortDistances[QueryIndex * 3 + 2], UE_DOUBLE_KINDA_SMALL_NUMBER);
+        }
+        const double IndexMicroseconds = (FPlatformTime::Seconds() - IndexStart) * 1e6 / NumQueries;
+
+        TArray<int32> BatchIndices;
+        TArray<double> BatchDistancesSquared;
+        const double BatchStart = FPlatformTime::Seconds();
+        SpatialIndex.FindNearestBatch(QueryPoints, 3, BatchIndices, BatchDistancesSquared);
+        const double BatchMicroseconds = (FPlatformTime::Seconds() - BatchStart) * 1e6 / NumQueries;
+
+        OutElectrodeCounts.Add(NumElectrodes);
+        OutSortMicroseconds.Add(SortMicroseconds);
+        OutIndexMicroseconds.Add(IndexMicroseconds);
+        OutBatchMicroseconds.Add(BatchMicroseconds);
+
+        UE_LOG(LogTemp, Log, TEXT("[APT_ElectrodeAreaActor::BenchmarkNeighborSearch] %4d electrodes: Sort %.3f us/query, Index %.3f us/query, Batch %.3f us/query, Build %.1f us"), NumElectrodes, SortMicroseconds, IndexMicroseconds, BatchMicroseconds, BuildMicroseconds);
+        if (NumMismatches > 0)
+        {
+            UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::BenchmarkNeighborSearch] %d of %d index queries differ from the sorted reference!"), NumMismatches, NumQueries);
+        }
+    }
 }
 
 void APT_ElectrodeAreaActor::BarycentricWeightCalculation(const FVector& InPoint, const FVector& InA, const FVector& InB, const FVector& InC, double& OutWeightA, double& OutWeightB, double& OutWeightC)
@@ -195,3 +355,627 @@ void APT_ElectrodeAreaActor::BarycentricWeightCalculation(const FVector& InPoint
     OutWeightA = 1.0 - OutWeightB - OutWeightC;
 }
 
+void APT_ElectrodeAreaActor::SetGridFrame(const TArray<FVector>& InCornerPoints, const double& InCellSize, const int32& InRows, const int32& InColumns)
+{
+    this->GridCornerPoints = InCornerPoints;
+    this->GridCellSize = InCellSize;
+    this->GridRows = InRows;
+    this->GridColumns = InColumns;
+    this->InterpolatorVersion = ++NextInterpolatorVersion;
+
+    // The active atlas lies on the previous frame, BuildPreviewAtlas starts the one of the new frame
+    this->CancelPreviewAtlas();
+    this->ActivePreviewAtlas.Reset();
+    this->ActivePreviewAtlasKey.Empty();
+}
+
+void APT_ElectrodeAreaActor::BuildInterpolator(const TArray<FVector>& InElectrodePositions, const TArray<int32>& InValidElectrodeIndices)
+{
+    this->Interpolator.Build(InElectrodePositions, InValidElectrodeIndices, this->NeighborCount);
+    this->InterpolationTriangle = INDEX_NONE;
+    this->InterpolatorVersion = ++NextInterpolatorVersion;
+
+    // Identifies the interpolator state in the preview atlas cache, rebuilding the same state hits the cache again
+    this->InterpolatorHash = FCrc::MemCrc32(InElectrodePositions.GetData(), InElectrodePositions.Num() * sizeof(FVector));
+    this->InterpolatorHash = FCrc::MemCrc32(InValidElectrodeIndices.GetData(), InValidElectrodeIndices.Num() * sizeof(int32), this->InterpolatorHash);
+    this->InterpolatorHash = FCrc::MemCrc32(&this->NeighborCount, sizeof(this->NeighborCount), this->InterpolatorHash);
+
+    if (!this->Interpolator.IsBuilt())
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::BuildInterpolator] No valid electrodes!"));
+        return;
+    }
+
+    if (this->GridCornerPoints.Num() == 4)
+    {
+        this->Interpolator.BuildGrid(this->GridCornerPoints, this->GridCellSize, this->GridRows, this->GridColumns);
+    }
+}
+
+bool APT_ElectrodeAreaActor::CalculateInterpolationWeights(const FVector& InPoint, TArray<int32>& OutElectrodeIndices, TArray<double>& OutWeights)
+{
+    OutElectrodeIndices.SetNumUninitialized(FPT_ElectrodeInterpolator::MaxNeighborCount);
+    OutWeights.SetNumUninitialized(FPT_ElectrodeInterpolator::MaxNeighborCount);
+
+    const int32 NumWeights = this->Interpolator.CalculateWeights(this->InterpolationMode, InPoint, OutElectrodeIndices.GetData(), OutWeights.GetData(), &this->InterpolationTriangle);
+    OutElectrodeIndices.SetNum(NumWeights);
+    OutWeights.SetNum(NumWeights);
+
+    if (NumWeights == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::CalculateInterpolationWeights] Interpolator is not built!"));
+        return false;
+    }
+    return true;
+}
+
+bool APT_ElectrodeAreaActor::FindInterpolationTriangle(const FVector& InPoint, TArray<int32>& OutElectrodeIndices, double& OutWeightA, double& OutWeightB, double& OutWeightC)
+{
+    OutElectrodeIndices.Empty();
+
+    if (!this->Interpolator.GetTriangulation().IsBuilt())
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::FindInterpolationTriangle] No triangulation, the interpolator is not built or the electrodes are collinear!"));
+        return false;
+    }
+
+    int32 Slots[3];
+    double Weights[3];
+    this->Interpolator.FindEnclosingTriangle(InPoint, Slots, Weights, &this->InterpolationTriangle);
+
+    for (int32 Corner = 0; Corner < 3; Corner++)
+    {
+        OutElectrodeIndices.Add(this->Interpolator.GetElectrodeIndex(Slots[Corner]));
+    }
+    OutWeightA = Weights[0];
+    OutWeightB = Weights[1];
+    OutWeightC = Weights[2];
+    return true;
+}
+
+bool APT_ElectrodeAreaActor::CalculateBarycentricWeightsBatch(const TArray<FVector>& InPoints, TArray<int32>& OutTriangleIndices, TArray<double>& OutWeightsA, TArray<double>& OutWeightsB, TArray<double>& OutWeightsC)
+{
+    if (!this->Interpolator.CalculateBarycentricWeightsBatch(InPoints, OutTriangleIndices, OutWeightsA, OutWeightsB, OutWeightsC))
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::CalculateBarycentricWeightsBatch] No triangulation, the interpolator is not built or the electrodes are collinear!"));
+        return false;
+    }
+    return true;
+}
+
+bool APT_ElectrodeAreaActor::GetInterpolationTriangleElectrodes(const int32& InTriangleIndex, TArray<int32>& OutElectrodeIndices) const
+{
+    OutElectrodeIndices.Empty();
+    if (InTriangleIndex < 0 || InTriangleIndex >= this->Interpolator.GetTriangulation().GetNumTriangles())
+    {
+        return false;
+    }
+
+    OutElectrodeIndices.SetNumUninitialized(3);
+    this->Interpolator.GetTriangleElectrodeIndices(InTriangleIndex, OutElectrodeIndices.GetData());
+    return true;
+}
+
+void APT_ElectrodeAreaActor::BenchmarkInterpolationModes(
+    UPT_SimulationComponent* InSimulationComponent,
+    const TArray<FVector>& InQueryPoints,
+    TArray<double>& OutWeightMicroseconds,
+    TArray<double>& OutBlendMilliseconds
+)
+{
+    OutWeightMicroseconds.Empty();
+    OutBlendMilliseconds.Empty();
+
+    if (!this->Interpolator.IsBuilt() || InQueryPoints.IsEmpty())
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::BenchmarkInterpolationModes] Interpolator is not built or no query points given!"));
+        return;
+    }
+
+    constexpr int32 MaxBlendQueries = 16;
+    const UEnum* ModeEnum = StaticEnum<EInterpolationMode>();
+    const int32 NumModes = ModeEnum->NumEnums() - 1;
+
+    int32 ElectrodeIndices[FPT_ElectrodeInterpolator::MaxNeighborCount];
+    double Weights[FPT_ElectrodeInterpolator::MaxNeighborCount];
+
+    for (int32 ModeIndex = 0; ModeIndex < NumModes; ModeIndex++)
+    {
+        const EInterpolationMode Mode = (EInterpolationMode)ModeEnum->GetValueByIndex(ModeIndex);
+
+        const double WeightStart = FPlatformTime::Seconds();
+        for (const FVector& QueryPoint : InQueryPoints)
+        {
+            this->Interpolator.CalculateWeights(Mode, QueryPoint, ElectrodeIndices, Weights);
+        }
+        const double WeightMicroseconds = (FPlatformTime::Seconds() - WeightStart) * 1e6 / InQueryPoints.Num();
+        OutWeightMicroseconds.Add(WeightMicroseconds);
+
+        double BlendMilliseconds = 0.0;
+        if (InSimulationComponent)
+        {
+            const int32 NumBlendQueries = FMath::Min(MaxBlendQueries, InQueryPoints.Num());
+            TArray<int32> ElectrodeIndexArray;
+            TArray<double> WeightArray;
+
+            const double BlendStart = FPlatformTime::Seconds();
+            for (int32 QueryIndex = 0; QueryIndex < NumBlendQueries; QueryIndex++)
+            {
+                const int32 NumWeights = this->Interpolator.CalculateWeights(Mode, InQueryPoints[QueryIndex], ElectrodeIndices, Weights);
+                ElectrodeIndexArray = TArray<int32>(ElectrodeIndices, NumWeights);
+                WeightArray = TArray<double>(Weights, NumWeights);
+                InSimulationComponent->ProcessWeightedInterpolation(ElectrodeIndexArray, WeightArray);
+            }
+            BlendMilliseconds = (FPlatformTime::Seconds() - BlendStart) * 1e3 / NumBlendQueries;
+        }
+        OutBlendMilliseconds.Add(BlendMilliseconds);
+
+        UE_LOG(LogTemp, Log, TEXT("[APT_ElectrodeAreaActor::BenchmarkInterpolationModes] %s: Weights %.3f us/query, Blend %.3f ms/query"), *ModeEnum->GetNameStringByIndex(ModeIndex), WeightMicroseconds, BlendMilliseconds);
+    }
+}
+
+void APT_ElectrodeAreaActor::PlanAdaptiveSampling(
+    UPT_SimulationComponent* InSimulationComponent,
+    const APT_Single3DActor* InScalpActor,
+    const ESamplingScore InScore,
+    const int32& InNumProposals,
+    const double& InCandidateSpacing,
+    const FString& InPatientId,
+    const FString& InConfigId,
+    TArray<FVector>& OutProposalPositions,
+    TArray<double>& OutProposalScores,
+    FString& OutProposalJsonString
+)
+{
+    OutProposalPositions.Empty();
+    OutProposalScores.Empty();
+    OutProposalJsonString.Empty();
+
+    FVector Origin;
+    FVector AxisU;
+    FVector AxisV;
+    double LengthU = 0.0;
+    double LengthV = 0.0;
+    if (!InSimulationComponent || !this->Interpolator.IsBuilt() || !FPT_ElectrodeInterpolator::CalculateGridAxes(this->GridCornerPoints, Origin, AxisU, AxisV, LengthU, LengthV))
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::PlanAdaptiveSampling] Simulation component, interpolator or grid frame missing!"));
+        return;
+    }
+
+    if (!InScalpActor || !InScalpActor->GetMeshBuffer() || InScalpActor->GetMeshBuffer()->GetNumTriangles() == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::PlanAdaptiveSampling] No scalp mesh to place the proposals on!"));
+        return;
+    }
+
+    // Per electrode summary the candidates are scored on, indexed by the original electrode index
+    int32 NumElectrodes = 0;
+    int32 NumTags = 0;
+    TArray<double> MeanMagnitudeArray;
+    TArray<double> ElectrodeErrorArray;
+    if (InScore == ESamplingScore::LeaveOneOutError)
+    {
+        // A report of an earlier interpolator, grid frame or mode describes other electrodes or weights
+        FPT_LeaveOneOutReport Report = InSimulationComponent->GetLeaveOneOutReport();
+        if (Report.ElectrodeIndexArray.IsEmpty() || Report.InterpolatorVersion != this->InterpolatorVersion || Report.InterpolationMode != this->InterpolationMode)
+        {
+            Report = InSimulationComponent->RunLeaveOneOutAnalysis(this);
+        }
+
+        for (int32 i = 0; i < Report.ElectrodeIndexArray.Num(); i++)
+        {
+            const int32 ElectrodeIndex = Report.ElectrodeIndexArray[i];
+            if (ElectrodeErrorArray.Num() <= ElectrodeIndex)
+            {
+                ElectrodeErrorArray.SetNumZeroed(ElectrodeIndex + 1);
+            }
+            ElectrodeErrorArray[ElectrodeIndex] = Report.RelativeRmsErrorArray[i];
+        }
+    }
+    else
+    {
+        InSimulationComponent->CalculateElectrodeMeanMagnitudes(MeanMagnitudeArray, NumElectrodes, NumTags);
+    }
+
+    const double ReferenceSpacing = this->GridCellSize > 0.0 ? this->GridCellSize : FMath::Max(LengthU, LengthV) / 10.0;
+    double Spacing = InCandidateSpacing > 0.0 ? InCandidateSpacing : 0.5 * ReferenceSpacing;
+
+    // A fine spacing on a large grid would allocate and score millions of candidates, it is widened to stay in budget
+    const double RequestedCandidates = (LengthU / Spacing + 1.0) * (LengthV / Spacing + 1.0);
+    if (RequestedCandidates > MaxAdaptiveSamplingCandidates)
+    {
+        Spacing *= FMath::Sqrt(RequestedCandidates / MaxAdaptiveSamplingCandidates);
+        UE_LOG(LogTemp, Warning, TEXT("[APT_ElectrodeAreaActor::PlanAdaptiveSampling] %.0f candidates exceed the limit of %d, the candidate spacing is widened to %f."), RequestedCandidates, MaxAdaptiveSamplingCandidates, Spacing);
+    }
+
+    const int32 NumU = FMath::FloorToInt32(LengthU / Spacing) + 1;
+    const int32 NumV = FMath::FloorToInt32(LengthV / Spacing) + 1;
+    const int32 NumCandidates = NumU * NumV;
+
+    // The candidates are scored where the electrodes would actually sit, on the scalp below the grid plane
+    TArray<FVector> PlanePositions;
+    PlanePositions.SetNumUninitialized(NumCandidates);
+    for (int32 CandidateIndex = 0; CandidateIndex < NumCandidates; CandidateIndex++)
+    {
+        PlanePositions[CandidateIndex] = Origin + (CandidateIndex % NumU) * Spacing * AxisU + (CandidateIndex / NumU) * Spacing * AxisV;
+    }
+
+    TArray<FVector> CandidatePositions;
+    TArray<FVector> CandidateNormals;
+    TArray<bool> CandidateHits;
+    InScalpActor->FindClosestMeshPointsBatch(PlanePositions, UE_DOUBLE_BIG_NUMBER, CandidatePositions, CandidateNormals, CandidateHits);
+
+    TArray<double> CandidateScores;
+    CandidateScores.SetNumZeroed(NumCandidates);
+
+    ParallelFor(NumCandidates, [&](const int32 CandidateIndex)
+    {
+        if (!CandidateHits[CandidateIndex])
+        {
+            return;
+        }
+        const FVector& Position = CandidatePositions[CandidateIndex];
+
+        int32 ElectrodeIndices[FPT_ElectrodeInterpolator::MaxNeighborCount];
+        double Weights[FPT_ElectrodeInterpolator::MaxNeighborCount];
+        const int32 NumWeights = this->Interpolator.CalculateWeights(EInterpolationMode::InverseDistance, Position, ElectrodeIndices, Weights);
+
+        int32 NearestSlot = 0;
+        double NearestDistanceSquared = 0.0;
+        this->Interpolator.FindNearestElectrodes(Position, 1, &NearestSlot, &NearestDistanceSquared);
+
+        // Nothing is gained next to an existing electrode, the uncertainty grows up to one cell size away from it
+        const double DistanceFactor = FMath::Min(FMath::Sqrt(NearestDistanceSquared) / ReferenceSpacing, 1.0);
+
+        double Score = 0.0;
+        if (InScore == ESamplingScore::LeaveOneOutError)
+        {
+            for (int32 i = 0; i < NumWeights; i++)
+            {
+                Score += Weights[i] * (ElectrodeErrorArray.IsValidIndex(ElectrodeIndices[i]) ? ElectrodeErrorArray[ElectrodeIndices[i]] : 0.0);
+            }
+        }
+        else
+        {
+            // Weighted standard deviation of the neighbors' per tag mean magnitudes
+            for (int32 CurrentTagIndex = 0; CurrentTagIndex < NumTags; CurrentTagIndex++)
+            {
+                double Mean = 0.0;
+                double MeanSquare = 0.0;
+                for (int32 i = 0; i < NumWeights; i++)
+                {
+                    const double Value = ElectrodeIndices[i] < NumElectrodes ? MeanMagnitudeArray[ElectrodeIndices[i] * NumTags + CurrentTagIndex] : 0.0;
+                    Mean += Weights[i] * Value;
+                    MeanSquare += Weights[i] * Value * Value;
+                }
+                Score += FMath::Max(MeanSquare - Mean * Mean, 0.0);
+            }
+            Score = FMath::Sqrt(Score);
+        }
+
+        CandidateScores[CandidateIndex] = Score * DistanceFactor;
+    });
+
+    // Greedy selection of the best candidates that keep a minimum distance to each other
+    TArray<int32> CandidateOrder;
+    CandidateOrder.SetNumUninitialized(NumCandidates);
+    for (int32 CandidateIndex = 0; CandidateIndex < NumCandidates; CandidateIndex++)
+    {
+        CandidateOrder[CandidateIndex] = CandidateIndex;
+    }
+    CandidateOrder.Sort([&CandidateScores](const int32 A, const int32 B) { return CandidateScores[A] > CandidateScores[B]; });
+
+    const double MinimumSeparationSquared = FMath::Square(ReferenceSpacing);
+    for (const int32 CandidateIndex : CandidateOrder)
+    {
+        if (OutProposalPositions.Num() >= InNumProposals || CandidateScores[CandidateIndex] <= 0.0)
+        {
+            break;
+        }
+
+        bool bIsSeparated = true;
+        for (const FVector& Proposal : OutProposalPositions)
+        {
+            if (FVector::DistSquared(Proposal, CandidatePositions[CandidateIndex]) < MinimumSeparationSquared)
+            {
+                bIsSeparated = false;
+                break;
+            }
+        }
+
+        if (bIsSeparated)
+        {
+            OutProposalPositions.Add(CandidatePositions[CandidateIndex]);
+            OutProposalScores.Add(CandidateScores[CandidateIndex]);
+        }
+    }
+
+    if (OutProposalPositions.IsEmpty())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("[APT_ElectrodeAreaActor::PlanAdaptiveSampling] No candidate position with a positive score found."));
+        return;
+    }
+
+    // The proposals are scattered over the grid area, so they are listed as single points without grid metadata
+    TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
+    TSharedPtr<FJsonObject> MetadataJson = MakeShareable(new FJsonObject);
+    MetadataJson->SetStringField(TEXT("Patient_ID"), InPatientId);
+    MetadataJson->SetStringField(TEXT("Config_ID"), InConfigId);
+    MetadataJson->SetStringField(TEXT("Layout"), TEXT("Points"));
+    MetadataJson->SetNumberField(TEXT("Number"), OutProposalPositions.Num());
+    JsonObject->SetObjectField(TEXT("Metadata"), MetadataJson);
+
+    TSharedPtr<FJsonObject> ElectrodesJson = MakeShareable(new FJsonObject);
+    for (int32 i = 0; i < OutProposalPositions.Num(); i++)
+    {
+        ElectrodesJson->SetObjectField(FString::Printf(TEXT("Electrode_%d"), i), UPT_JSONConverter::CreateJsonObjectFromVector(OutProposalPositions[i]));
+    }
+    JsonObject->SetObjectField(TEXT("Electrodes"), ElectrodesJson);
+
+    OutProposalJsonString = UPT_JSONConverter::SerializeJsonObjectToString(JsonObject);
+
+    UE_LOG(LogTemp, Log, TEXT("[APT_ElectrodeAreaActor::PlanAdaptiveSampling] Scored %d candidates, proposing %d positions (best score %f)."), NumCandidates, OutProposalPositions.Num(), OutProposalScores[0]);
+}
+
+void APT_ElectrodeAreaActor::BuildPreviewAtlas(UPT_SimulationComponent* InSimulationComponent, const FString& InPatientId, const FString& InConfigId, const FString& InRoiId, const int32& InResolution)
+{
+    this->CancelPreviewAtlas();
+
+    // The values depend on the interpolation mode, the grid frame and the interpolator as well, so all are part of the key
+    uint32 GridFrameHash = FCrc::MemCrc32(this->GridCornerPoints.GetData(), this->GridCornerPoints.Num() * sizeof(FVector));
+    const int32 GridShape[2] = { this->GridRows, this->GridColumns };
+    GridFrameHash = FCrc::MemCrc32(&this->GridCellSize, sizeof(this->GridCellSize), GridFrameHash);
+    GridFrameHash = FCrc::MemCrc32(GridShape, sizeof(GridShape), GridFrameHash);
+    const FString Key = FString::Printf(TEXT("%s/%s/%s/%s/%08x/%08x"), *InPatientId, *InConfigId, *InRoiId, *StaticEnum<EInterpolationMode>()->GetNameStringByValue((int64)this->InterpolationMode), GridFrameHash, this->InterpolatorHash);
+    const int32 FinalResolution = FMath::Max(InResolution, 2);
+    this->ActivePreviewAtlasKey = Key;
+
+    if (const TSharedRef<const FPreviewAtlas, ESPMode::ThreadSafe>* CachedAtlas = this->PreviewAtlasCache.Find(Key))
+    {
+        if ((*CachedAtlas)->bIsComplete && (*CachedAtlas)->Resolution == FinalResolution)
+        {
+            this->PublishPreviewAtlas(Key, *CachedAtlas);
+            return;
+        }
+    }
+    this->ActivePreviewAtlas.Reset();
+
+    FVector Origin;
+    FVector AxisU;
+    FVector AxisV;
+    double LengthU = 0.0;
+    double LengthV = 0.0;
+    if (!InSimulationComponent || !this->Interpolator.IsBuilt() || !FPT_ElectrodeInterpolator::CalculateGridAxes(this->GridCornerPoints, Origin, AxisU, AxisV, LengthU, LengthV))
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::BuildPreviewAtlas] Simulation component, interpolator or grid frame missing!"));
+        return;
+    }
+
+    // The ROI mean of a blend is the blend of the ROI means, so the job only needs the means per electrode and tag
+    TArray<double> MeanMagnitudeArray;
+    int32 NumElectrodes = 0;
+    int32 NumTags = 0;
+    InSimulationComponent->CalculateElectrodeMeanMagnitudes(MeanMagnitudeArray, NumElectrodes, NumTags);
+
+    TArray<double> CellShareArray;
+    CellShareArray.SetNumZeroed(NumTags);
+    int64 TotalCells = 0;
+    for (int32 CurrentTagIndex = 0; CurrentTagIndex < NumTags; CurrentTagIndex++)
+    {
+        TotalCells += InSimulationComponent->GetNumRoiCells(CurrentTagIndex);
+    }
+    for (int32 CurrentTagIndex = 0; CurrentTagIndex < NumTags && TotalCells > 0; CurrentTagIndex++)
+    {
+        CellShareArray[CurrentTagIndex] = (double)InSimulationComponent->GetNumRoiCells(CurrentTagIndex) / TotalCells;
+    }
+
+    if (NumTags == 0 || TotalCells == 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::BuildPreviewAtlas] No simulation data loaded!"));
+        return;
+    }
+
+    TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> CancelFlag = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+    this->PreviewAtlasCancelFlag = CancelFlag;
+
+    // The job works on copies, so rebuilding the interpolator or reloading the data does not affect a running evaluation
+    Async(EAsyncExecution::ThreadPool, [WeakThis = TWeakObjectPtr<APT_ElectrodeAreaActor>(this), Key, CancelFlag, JobInterpolator = this->Interpolator, Mode = this->InterpolationMode,
+        Origin, AxisU, AxisV, LengthU, LengthV, FinalResolution, MeanMagnitudeArray = MoveTemp(MeanMagnitudeArray), CellShareArray = MoveTemp(CellShareArray), NumElectrodes, NumTags]()
+    {
+        const int32 NumLayers = NumTags + 1;
+        int32 Resolution = FMath::Min(PreviewAtlasCoarsestResolution, FinalResolution);
+
+        while (!*CancelFlag)
+        {
+            TSharedRef<FPreviewAtlas, ESPMode::ThreadSafe> Atlas = MakeShared<FPreviewAtlas, ESPMode::ThreadSafe>();
+            Atlas->Origin = Origin;
+            Atlas->AxisU = AxisU;
+            Atlas->AxisV = AxisV;
+            Atlas->LengthU = LengthU;
+            Atlas->LengthV = LengthV;
+            Atlas->Resolution = Resolution;
+            Atlas->NumLayers = NumLayers;
+            Atlas->bIsComplete = Resolution == FinalResolution;
+
+            const int32 NumNodes = Resolution * Resolution;
+            Atlas->Values.SetNumZeroed(NumLayers * NumNodes);
+            float* Values = Atlas->Values.GetData();
+
+            // The barycentric weights of the whole lattice are located in one batch, row by row
+            TArray<int32> NodeTriangles;
+            TArray<double> NodeWeightsA;
+            TArray<double> NodeWeightsB;
+            TArray<double> NodeWeightsC;
+            if (Mode == EInterpolationMode::Barycentric)
+            {
+                TArray<FVector> NodePoints;
+                NodePoints.SetNumUninitialized(NumNodes);
+                for (int32 Node = 0; Node < NumNodes; Node++)
+                {
+                    NodePoints[Node] = Origin + (Node % Resolution) * LengthU / (Resolution - 1) * AxisU + (Node / Resolution) * LengthV / (Resolution - 1) * AxisV;
+                }
+                JobInterpolator.CalculateBarycentricWeightsBatch(NodePoints, NodeTriangles, NodeWeightsA, NodeWeightsB, NodeWeightsC);
+            }
+
+            ParallelFor(NumNodes, [&](const int32 Node)
+            {
+                int32 ElectrodeIndices[FPT_ElectrodeInterpolator::MaxNeighborCount];
+                double Weights[FPT_ElectrodeInterpolator::MaxNeighborCount];
+                int32 NumWeights = 0;
+                if (NodeTriangles.IsValidIndex(Node))
+                {
+                    JobInterpolator.GetTriangleElectrodeIndices(NodeTriangles[Node], ElectrodeIndices);
+                    Weights[0] = NodeWeightsA[Node];
+                    Weights[1] = NodeWeightsB[Node];
+                    Weights[2] = NodeWeightsC[Node];
+                    NumWeights = 3;
+                }
+                else
+                {
+                    const FVector Point = Origin + (Node % Resolution) * LengthU / (Resolution - 1) * AxisU + (Node / Resolution) * LengthV / (Resolution - 1) * AxisV;
+                    NumWeights = JobInterpolator.CalculateWeights(Mode, Point, ElectrodeIndices, Weights);
+                }
+
+                double Overall = 0.0;
+                for (int32 CurrentTagIndex = 0; CurrentTagIndex < NumTags; CurrentTagIndex++)
+                {
+                    double Mean = 0.0;
+                    for (int32 i = 0; i < NumWeights; i++)
+                    {
+                        if (ElectrodeIndices[i] >= 0 && ElectrodeIndices[i] < NumElectrodes)
+                        {
+                            Mean += Weights[i] * MeanMagnitudeArray[ElectrodeIndices[i] * NumTags + CurrentTagIndex];
+                        }
+                    }
+                    Values[(CurrentTagIndex + 1) * NumNodes + Node] = (float)Mean;
+                    Overall += CellShareArray[CurrentTagIndex] * Mean;
+                }
+                Values[Node] = (float)Overall;
+            });
+
+            Atlas->MinValues.SetNumUninitialized(NumLayers);
+            Atlas->MaxValues.SetNumUninitialized(NumLayers);
+            for (int32 Layer = 0; Layer < NumLayers; Layer++)
+            {
+                const float* LayerValues = Values + Layer * NumNodes;
+                Atlas->MinValues[Layer] = LayerValues[0];
+                Atlas->MaxValues[Layer] = LayerValues[0];
+                for (int32 Node = 1; Node < NumNodes; Node++)
+                {
+                    Atlas->MinValues[Layer] = FMath::Min(Atlas->MinValues[Layer], LayerValues[Node]);
+                    Atlas->MaxValues[Layer] = FMath::Max(Atlas->MaxValues[Layer], LayerValues[Node]);
+                }
+            }
+
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, Key, CancelFlag, Atlas]()
+            {
+                APT_ElectrodeAreaActor* This = WeakThis.Get();
+                if (This && !*CancelFlag)
+                {
+                    This->PublishPreviewAtlas(Key, Atlas);
+                }
+            });
+
+            if (Resolution == FinalResolution)
+            {
+                break;
+            }
+            Resolution = FMath::Min(2 * Resolution - 1, FinalResolution);
+        }
+    });
+}
+
+void APT_ElectrodeAreaActor::PublishPreviewAtlas(const FString& InKey, const TSharedRef<const FPreviewAtlas, ESPMode::ThreadSafe>& InAtlas)
+{
+    this->PreviewAtlasCache.Add(InKey, InAtlas);
+
+    if (InKey == this->ActivePreviewAtlasKey)
+    {
+        this->ActivePreviewAtlas = InAtlas;
+        this->OnPreviewAtlasUpdated.Broadcast(InAtlas->Resolution, InAtlas->bIsComplete);
+    }
+}
+
+void APT_ElectrodeAreaActor::CancelPreviewAtlas()
+{
+    if (this->PreviewAtlasCancelFlag.IsValid())
+    {
+        this->PreviewAtlasCancelFlag->AtomicSet(true);
+        this->PreviewAtlasCancelFlag.Reset();
+    }
+}
+
+void APT_ElectrodeAreaActor::ClearPreviewAtlasCache()
+{
+    this->CancelPreviewAtlas();
+    this->PreviewAtlasCache.Empty();
+    this->ActivePreviewAtlas.Reset();
+}
+
+bool APT_ElectrodeAreaActor::QueryPreviewAtlas(const FVector& InPoint, const int32& InTagIndex, double& OutValue) const
+{
+    OutValue = 0.0;
+
+    const FPreviewAtlas* Atlas = this->ActivePreviewAtlas.Get();
+    const int32 Layer = InTagIndex + 1;
+    if (!Atlas || Layer < 0 || Layer >= Atlas->NumLayers)
+    {
+        return false;
+    }
+
+    const FVector Offset = InPoint - Atlas->Origin;
+    const double U = FMath::Clamp(FVector::DotProduct(Offset, Atlas->AxisU) / Atlas->LengthU, 0.0, 1.0) * (Atlas->Resolution - 1);
+    const double V = FMath::Clamp(FVector::DotProduct(Offset, Atlas->AxisV) / Atlas->LengthV, 0.0, 1.0) * (Atlas->Resolution - 1);
+    const int32 Column = FMath::Min(FMath::FloorToInt32(U), Atlas->Resolution - 2);
+    const int32 Row = FMath::Min(FMath::FloorToInt32(V), Atlas->Resolution - 2);
+    const double FracU = U - Column;
+    const double FracV = V - Row;
+
+    const float* Values = Atlas->Values.GetData() + Layer * Atlas->Resolution * Atlas->Resolution + Row * Atlas->Resolution + Column;
+    OutValue = FMath::BiLerp<double>(Values[0], Values[1], Values[Atlas->Resolution], Values[Atlas->Resolution + 1], FracU, FracV);
+    return true;
+}
+
+UTexture2D* APT_ElectrodeAreaActor::CreatePreviewAtlasTexture(const int32& InTagIndex, double& OutMinValue, double& OutMaxValue) const
+{
+    OutMinValue = 0.0;
+    OutMaxValue = 0.0;
+
+    const FPreviewAtlas* Atlas = this->ActivePreviewAtlas.Get();
+    const int32 Layer = InTagIndex + 1;
+    if (!Atlas || Layer < 0 || Layer >= Atlas->NumLayers)
+    {
+        UE_LOG(LogTemp, Error, TEXT("[APT_ElectrodeAreaActor::CreatePreviewAtlasTexture] No preview atlas available for tag %d!"), InTagIndex);
+        return nullptr;
+    }
+
+    OutMinValue = Atlas->MinValues[Layer];
+    OutMaxValue = Atlas->MaxValues[Layer];
+    const double Range = FMath::IsNearlyZero(OutMaxValue - OutMinValue) ? 1.0 : OutMaxValue - OutMinValue;
+
+    UTexture2D* Texture = UTexture2D::CreateTransient(Atlas->Resolution, Atlas->Resolution, PF_B8G8R8A8);
+    if (!Texture)
+    {
+        return nullptr;
+    }
+    Texture->Filter = TF_Bilinear;
+    Texture->AddressX = TA_Clamp;
+    Texture->AddressY = TA_Clamp;
+
+    const int32 NumNodes = Atlas->Resolution * Atlas->Resolution;
+    const float* Values = Atlas->Values.GetData() + Layer * NumNodes;
+    FColor* TextureData = static_cast<FColor*>(Texture->GetPlatformData()->Mips[0].BulkData.Lock(LOCK_READ_WRITE));
+    for (int32 Node = 0; Node < NumNodes; Node++)
+    {
+        TextureData[Node] = UPT_SimulationComponent::SamplePlasmaColormap((Values[Node] - OutMinValue) / Range).ToFColor(true);
+    }
+    Texture->GetPlatformData()->Mips[0].BulkData.Unlock();
+    Texture->UpdateResource();
+
+    return Texture;
+}
+
+int32 APT_ElectrodeAreaActor::GetPreviewAtlasResolution() const
+{
+    return this->ActivePreviewAtlas.IsValid() ? this->ActivePreviewAtlas->Resolution : 0;
+}
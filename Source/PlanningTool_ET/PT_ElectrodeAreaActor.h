@@ -6,7 +6,7 @@
  * @brief Header file for the APT_ElectrodeAreaActor class.
  *
  * This file contains the declaration of the APT_ElectrodeAreaActor class, which is responsible for handling electrode area operations.
- * It includes methods for processing HTTP response data, finding nearest neighbors, and calculating barycentric weights.
+ * It includes methods for processing HTTP response data, finding nearest neighbors, and calculating interpolation weights.
  *
  * @author Jan-Vincent Mock
  * @date 2024
@@ -16,9 +16,19 @@
 
 #include "CoreMinimal.h"
 #include "PT_HTTPComponent.h"
+#include "PT_EnumContainer.h"
+#include "PT_ElectrodeInterpolator.h"
+#include "PT_ElectrodeSpatialIndex.h"
+#include "PT_ElectrodeRendererComponent.h"
 #include "GameFramework/Actor.h"
 #include "PT_ElectrodeAreaActor.generated.h"
 
+class UPT_SimulationComponent;
+class APT_Single3DActor;
+class UTexture2D;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FPreviewAtlasEventDelegate, int32, Resolution, bool, bIsComplete);
+
 /**
  * @class APT_ElectrodeAreaActor
  * @brief A class that represents an electrode area actor.
@@ -76,6 +86,9 @@ public:
 	/**
   * @brief Finds the nearest neighbors to a given point within a grid.
   *
+  * The grid is indexed by a k-d tree that is kept while a checksum of the grid positions stays the same, so repeated
+  * queries on the same grid, e.g. while dragging, skip the rebuild and take logarithmic time.
+  *
   * @param InPoint The point for which to find the nearest neighbors.
   * @param InGrid The grid of points to search within.
   * @param OutNearestNeighborsGridIndicies The indices of the nearest neighbors within the grid.
@@ -84,6 +97,34 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
 	TArray<FVector> FindNearestNeighbors(const FVector& InPoint, const TArray<FVector>& InGrid, TArray<int>& OutNearestNeighborsGridIndicies);
 
+	/**
+  * @brief Finds the nearest neighbors of many points within a grid in parallel.
+  *
+  * @param InPoints The points for which to find the nearest neighbors.
+  * @param InGrid The grid of points to search within.
+  * @param InCount The number of neighbors per point.
+  * @param OutGridIndices The grid indices of the neighbors in [Point * InCount + Neighbor] layout, sorted by distance per point.
+  * @param OutDistances The distances of the neighbors in the same layout.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void FindNearestNeighborsBatch(const TArray<FVector>& InPoints, const TArray<FVector>& InGrid, const int32& InCount, TArray<int32>& OutGridIndices, TArray<double>& OutDistances);
+
+	/**
+  * @brief Compares the nearest neighbor search by sorting all distances with the k-d tree on synthetic grids.
+  *
+  * Grids of 16 to 1024 electrodes are generated, doubling the count every step. For every grid the three nearest
+  * electrodes of random query points are searched by sorting, by single tree queries and by one batch query.
+  * Differing results are logged as errors.
+  *
+  * @param InNumQueries The number of query points per grid.
+  * @param OutElectrodeCounts The number of electrodes of every grid.
+  * @param OutSortMicroseconds The mean time per query when sorting all distances, one entry per grid.
+  * @param OutIndexMicroseconds The mean time per single tree query, one entry per grid.
+  * @param OutBatchMicroseconds The mean time per query of the parallel batch query, one entry per grid.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void BenchmarkNeighborSearch(const int32& InNumQueries, TArray<int32>& OutElectrodeCounts, TArray<double>& OutSortMicroseconds, TArray<double>& OutIndexMicroseconds, TArray<double>& OutBatchMicroseconds);
+
 	/**
   * @brief Calculates the barycentric weights for a point within a triangle.
   *
@@ -98,12 +139,238 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
 	void BarycentricWeightCalculation(const FVector& InPoint, const FVector& InA, const FVector& InB, const FVector& InC, double& OutWeightA, double& OutWeightB, double& OutWeightC);
 
+	/**
+  * @brief Sets the frame of the rectangular electrode grid used by the bilinear interpolation mode.
+  *
+  * ProcessResponseData sets the frame automatically. Takes effect with the next call of BuildInterpolator.
+  *
+  * @param InCornerPoints The four corner points of the grid.
+  * @param InCellSize The distance between neighboring electrodes.
+  * @param InRows The number of rows of the grid.
+  * @param InColumns The number of columns of the grid.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void SetGridFrame(const TArray<FVector>& InCornerPoints, const double& InCellSize, const int32& InRows, const int32& InColumns);
+
+	/**
+  * @brief Builds the interpolator for the successfully simulated electrodes.
+  *
+  * Has to be called again whenever the electrode positions, the valid electrodes, the grid frame or the NeighborCount change.
+  *
+  * @param InElectrodePositions The positions of all electrodes.
+  * @param InValidElectrodeIndices The indices of the successfully simulated electrodes. If empty, all electrodes are used.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void BuildInterpolator(const TArray<FVector>& InElectrodePositions, const TArray<int32>& InValidElectrodeIndices);
+
+	/**
+  * @brief Calculates the electrode weights for a point with the current InterpolationMode.
+  *
+  * @param InPoint The point for which to calculate the weights.
+  * @param OutElectrodeIndices The indices of the electrodes to blend.
+  * @param OutWeights The weight of every electrode, summing up to one.
+  * @return True if weights could be calculated.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	bool CalculateInterpolationWeights(const FVector& InPoint, TArray<int32>& OutElectrodeIndices, TArray<double>& OutWeights);
+
+	/**
+  * @brief Finds the triangle of successfully simulated electrodes enclosing a point, with its barycentric weights.
+  *
+  * Unlike the three nearest neighbors, the triangle of the Delaunay triangulation built by BuildInterpolator always
+  * contains the point, so the weights are never negative and change continuously while dragging. The search walks
+  * from the triangle of the previous call. Points outside of the grid are clamped to its border.
+  * The results can be passed directly to UPT_SimulationComponent::ProcessBarycentricInterpolation.
+  *
+  * @param InPoint The point for which to find the triangle.
+  * @param OutElectrodeIndices The indices of the three corner electrodes.
+  * @param OutWeightA The weight of the first corner electrode.
+  * @param OutWeightB The weight of the second corner electrode.
+  * @param OutWeightC The weight of the third corner electrode.
+  * @return True if the interpolator holds a triangulation.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	bool FindInterpolationTriangle(const FVector& InPoint, TArray<int32>& OutElectrodeIndices, double& OutWeightA, double& OutWeightB, double& OutWeightC);
+
+	/**
+  * @brief Calculates the barycentric weights of many points in parallel, e.g. for trajectory replays or parameter sweeps.
+  *
+  * Points given in their natural order, along a trajectory or row by row, are located fastest.
+  *
+  * @param InPoints The points for which to calculate the weights.
+  * @param OutTriangleIndices The enclosing triangle of every point, see GetInterpolationTriangleElectrodes.
+  * @param OutWeightsA The weight of the first corner electrode of every point.
+  * @param OutWeightsB The weight of the second corner electrode of every point.
+  * @param OutWeightsC The weight of the third corner electrode of every point.
+  * @return True if the interpolator holds a triangulation.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	bool CalculateBarycentricWeightsBatch(const TArray<FVector>& InPoints, TArray<int32>& OutTriangleIndices, TArray<double>& OutWeightsA, TArray<double>& OutWeightsB, TArray<double>& OutWeightsC);
+
+	/**
+  * @brief Gets the corner electrodes of a triangle returned by CalculateBarycentricWeightsBatch.
+  *
+  * @param InTriangleIndex The index of the triangle.
+  * @param OutElectrodeIndices The indices of the three corner electrodes, in the order of the weights.
+  * @return True if the triangle exists.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	bool GetInterpolationTriangleElectrodes(const int32& InTriangleIndex, TArray<int32>& OutElectrodeIndices) const;
+
+	/**
+  * @brief Compares the runtime of all interpolation modes on a set of query points.
+  *
+  * The weight calculation is timed for every query point, the blend of the simulation data for up to 16 of them.
+  * The blend overwrites the interpolated data of the simulation component.
+  *
+  * @param InSimulationComponent The simulation component holding the loaded simulation data.
+  * @param InQueryPoints The points to interpolate at.
+  * @param OutWeightMicroseconds The mean weight calculation time per query, one entry per interpolation mode.
+  * @param OutBlendMilliseconds The mean blend time per query, one entry per interpolation mode.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void BenchmarkInterpolationModes(UPT_SimulationComponent* InSimulationComponent, const TArray<FVector>& InQueryPoints, TArray<double>& OutWeightMicroseconds, TArray<double>& OutBlendMilliseconds);
+
+	/**
+  * @brief Proposes positions on the electrode plane where new simulations would reduce the interpolation uncertainty most.
+  *
+  * Candidate positions on a regular lattice over the grid are scored in parallel. The score is the disagreement of the
+  * neighboring electrodes or their leave-one-out error, scaled by the distance to the nearest simulated electrode.
+  * Every candidate is moved to its closest point on the scalp before it is scored. The lattice holds at most 65536
+  * candidates, a finer spacing is widened. A leave-one-out report of an earlier interpolator, grid frame or mode is
+  * evaluated again. The best candidates that keep a cell size distance to each other are returned, together with a
+  * configuration JSON listing them as single points ("Layout": "Points") under "Electrodes", without grid metadata.
+  * Once the configuration is uploaded, the simulations can be started with UPT_HTTPComponent::SendRunSimulationData.
+  *
+  * @param InSimulationComponent The simulation component holding the loaded simulation data.
+  * @param InScalpActor The actor holding the scalp mesh the proposals are placed on.
+  * @param InScore The score used to rank the candidates.
+  * @param InNumProposals The maximum number of positions to propose.
+  * @param InCandidateSpacing The spacing of the candidate lattice. If not positive, half the cell size is used.
+  * @param InPatientId The patient ID written to the configuration JSON.
+  * @param InConfigId The ID of the new configuration written to the configuration JSON.
+  * @param OutProposalPositions The proposed positions on the scalp, best first.
+  * @param OutProposalScores The score of every proposed position.
+  * @param OutProposalJsonString The configuration JSON of the proposed positions.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void PlanAdaptiveSampling(UPT_SimulationComponent* InSimulationComponent, const APT_Single3DActor* InScalpActor, const ESamplingScore InScore, const int32& InNumProposals, const double& InCandidateSpacing, const FString& InPatientId, const FString& InConfigId, TArray<FVector>& OutProposalPositions, TArray<double>& OutProposalScores, FString& OutProposalJsonString);
+
+	/**
+  * @brief Starts the background evaluation of the preview atlas of the electrode plane.
+  *
+  * The atlas holds the ROI mean magnitude, overall and per tag, on a regular lattice over the grid rectangle. It is
+  * evaluated in parallel on worker threads, starting at a coarse resolution that is doubled until InResolution is
+  * reached. Every finished level replaces the active atlas and fires OnPreviewAtlasUpdated. Finished atlases are
+  * cached per patient, configuration, ROI, interpolation mode, grid frame and interpolator state, so switching back to
+  * a known combination is instant.
+  * Has to be called after the simulation data is loaded and the interpolator is built.
+  *
+  * @param InSimulationComponent The simulation component holding the loaded simulation data.
+  * @param InPatientId The patient ID of the loaded simulation data.
+  * @param InConfigId The configuration ID of the loaded simulation data.
+  * @param InRoiId The ROI ID of the loaded simulation data.
+  * @param InResolution The number of lattice nodes along every grid edge of the final level.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void BuildPreviewAtlas(UPT_SimulationComponent* InSimulationComponent, const FString& InPatientId, const FString& InConfigId, const FString& InRoiId, const int32& InResolution);
+
+	/**
+  * @brief Stops a running preview atlas evaluation. Levels finished before remain available.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void CancelPreviewAtlas();
+
+	/**
+  * @brief Releases all cached preview atlases, e.g. after the simulation data of a combination was recomputed.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	void ClearPreviewAtlasCache();
+
+	/**
+  * @brief Samples the active preview atlas at a point of the electrode plane.
+  *
+  * @param InPoint The point, projected onto the grid plane and clamped to the grid.
+  * @param InTagIndex The index of the data tag, -1 for the mean over all tags.
+  * @param OutValue The bilinearly sampled ROI mean magnitude.
+  * @return True if an atlas is available.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	bool QueryPreviewAtlas(const FVector& InPoint, const int32& InTagIndex, double& OutValue) const;
+
+	/**
+  * @brief Creates a heatmap texture of the active preview atlas with the plasma colormap.
+  *
+  * Texel (X, Y) lies at X / (Resolution - 1) along the first and Y / (Resolution - 1) along the second grid edge,
+  * starting at the first corner point. The colormap spans the minimum to the maximum of the chosen layer.
+  *
+  * @param InTagIndex The index of the data tag, -1 for the mean over all tags.
+  * @param OutMinValue The value mapped to the low end of the colormap.
+  * @param OutMaxValue The value mapped to the high end of the colormap.
+  * @return The texture, nullptr if no atlas is available.
+  */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_AREA")
+	UTexture2D* CreatePreviewAtlasTexture(const int32& InTagIndex, double& OutMinValue, double& OutMaxValue) const;
+
+	/**
+  * @brief Gets the resolution of the active preview atlas.
+  * @return The number of lattice nodes along every grid edge, 0 if no atlas is available.
+  */
+	UFUNCTION(BlueprintPure, Category = "ELECTRODE_AREA")
+	int32 GetPreviewAtlasResolution() const;
+
+	/** @brief Event fired whenever a level of the active preview atlas is finished. */
+	UPROPERTY(BlueprintAssignable, Category = "PT_ELECTRODE_AREA_Event")
+	FPreviewAtlasEventDelegate OnPreviewAtlasUpdated;
+
+	/**
+  * @brief Gets the interpolator over the successfully simulated electrodes.
+  * @return The interpolator, empty until BuildInterpolator was called.
+  */
+	const FPT_ElectrodeInterpolator& GetInterpolator() const { return this->Interpolator; }
+
+	/**
+  * @brief Gets the corner points of the electrode grid.
+  * @return The four corner points, empty until SetGridFrame was called.
+  */
+	const TArray<FVector>& GetGridCornerPoints() const { return this->GridCornerPoints; }
+
+	/**
+  * @brief Gets the version of the interpolator, changed by every BuildInterpolator and SetGridFrame call.
+  * @return The version, unique over all electrode area actors.
+  */
+	int32 GetInterpolatorVersion() const { return this->InterpolatorVersion; }
+
+	/** @brief The interpolation mode used by CalculateInterpolationWeights. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ELECTRODE_AREA")
+	EInterpolationMode InterpolationMode = EInterpolationMode::Barycentric;
+
+	/** @brief The number of electrodes blended by the inverse distance and radial basis modes. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ELECTRODE_AREA", meta = (ClampMin = "1", ClampMax = "32"))
+	int32 NeighborCount = 8;
+
+	/** @brief Draws the electrodes of the processed grid, colored by their validation state. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "ELECTRODE_AREA")
+	UPT_ElectrodeRendererComponent* ElectrodeRenderer;
+
 protected:
 	/**
   * @brief Called when the game starts or when spawned.
   */
 	virtual void BeginPlay() override;
 
+	/**
+  * @brief Called after the Blueprint components are created. Attaches the electrode renderer to the root component.
+  * @param Transform The transform of the actor.
+  */
+	virtual void OnConstruction(const FTransform& Transform) override;
+
+	/**
+  * @brief Called when the actor is removed from the level. Stops a running preview atlas evaluation.
+  * @param EndPlayReason The reason why the actor is removed.
+  */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
 	/**
   * @struct FDistanceAndPoint
@@ -116,4 +383,90 @@ private:
 		int gridIndex; ///< The index of the point in the grid.
 	};
 
+	/**
+  * @struct FPreviewAtlas
+  * @brief ROI mean magnitudes on a regular lattice over the grid rectangle. Immutable once published.
+  */
+	struct FPreviewAtlas
+	{
+		FVector Origin; ///< The first grid corner point.
+		FVector AxisU; ///< The unit vector along the first grid edge.
+		FVector AxisV; ///< The unit vector along the second grid edge.
+		double LengthU = 0.0; ///< The length of the first grid edge.
+		double LengthV = 0.0; ///< The length of the second grid edge.
+		int32 Resolution = 0; ///< The number of lattice nodes along every grid edge.
+		int32 NumLayers = 0; ///< The number of layers, the overall mean followed by one layer per tag.
+		TArray<float> Values; ///< The values in [Layer][V][U] layout.
+		TArray<float> MinValues; ///< The minimum value per layer.
+		TArray<float> MaxValues; ///< The maximum value per layer.
+		bool bIsComplete = false; ///< Whether the final resolution is reached.
+	};
+
+	/**
+  * @brief Finds the nearest neighbors by sorting the distances to all grid points. Reference of BenchmarkNeighborSearch.
+  * @param InPoint The point for which to find the nearest neighbors.
+  * @param InGrid The grid of points to search within.
+  * @param InCount The number of neighbors.
+  * @param OutDistancesAndPoints The nearest neighbors, sorted by distance.
+  */
+	static void FindNearestNeighborsBySorting(const FVector& InPoint, const TArray<FVector>& InGrid, const int32 InCount, TArray<FDistanceAndPoint>& OutDistancesAndPoints);
+
+	/**
+  * @brief Stores a finished preview atlas level in the cache and activates it if it belongs to the active combination.
+  * @param InKey The cache key of the combination.
+  * @param InAtlas The finished atlas.
+  */
+	void PublishPreviewAtlas(const FString& InKey, const TSharedRef<const FPreviewAtlas, ESPMode::ThreadSafe>& InAtlas);
+
+	/** @brief Interpolator over the successfully simulated electrodes. */
+	FPT_ElectrodeInterpolator Interpolator;
+
+	/** @brief Triangle of the last barycentric query, the start of the next point location walk. */
+	int32 InterpolationTriangle = INDEX_NONE;
+
+	/** @brief Version of the interpolator and grid frame, see GetInterpolatorVersion(). */
+	int32 InterpolatorVersion = 0;
+
+	/** @brief Checksum of the electrode positions, valid electrodes and neighbor count of the last BuildInterpolator call. */
+	uint32 InterpolatorHash = 0;
+
+	/**
+  * @brief Rebuilds the neighbor search index if the size or the checksum of the grid positions changed.
+  * @param InGrid The grid of points to search within.
+  */
+	void UpdateNeighborSearchIndex(const TArray<FVector>& InGrid);
+
+	/** @brief k-d tree over the grid last passed to FindNearestNeighbors. */
+	FPT_ElectrodeSpatialIndex NeighborSearchIndex;
+
+	/** @brief Checksum of the grid positions the index was built from. */
+	uint32 NeighborSearchGridHash = 0;
+
+	/** @brief Corner points of the electrode grid. */
+	TArray<FVector> GridCornerPoints;
+
+	/** @brief Distance between neighboring electrodes of the grid. */
+	double GridCellSize = 0.0;
+
+	/** @brief Number of rows of the electrode grid. */
+	int32 GridRows = 0;
+
+	/** @brief Number of columns of the electrode grid. */
+	int32 GridColumns = 0;
+
+	/** @brief Rotation of the electrode grid. */
+	FRotator GridRotation = FRotator::ZeroRotator;
+
+	/** @brief Finished preview atlases per patient, configuration, ROI, interpolation mode, grid frame and interpolator state. */
+	TMap<FString, TSharedRef<const FPreviewAtlas, ESPMode::ThreadSafe>> PreviewAtlasCache;
+
+	/** @brief The preview atlas used by the queries. */
+	TSharedPtr<const FPreviewAtlas, ESPMode::ThreadSafe> ActivePreviewAtlas;
+
+	/** @brief The cache key of the active combination. */
+	FString ActivePreviewAtlasKey;
+
+	/** @brief Cancellation flag of the running preview atlas evaluation. */
+	TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> PreviewAtlasCancelFlag;
+
 };
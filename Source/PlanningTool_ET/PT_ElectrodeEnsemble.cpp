@@ -0,0 +1,535 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_ElectrodeEnsemble.h"
+#include "Async/ParallelFor.h"
+
+/** Number of values processed per parallel work item. */
+static constexpr int32 EnsembleChunkSize = 8192;
+
+/** Maximum number of Jacobi sweeps for the eigen decomposition of the Gram matrix. */
+static constexpr int32 MaxJacobiSweeps = 64;
+
+/** Number of cells blended on the stack per block by CountCellsAboveThreshold. */
+static constexpr int32 CountBlockSize = 512;
+
+/**
+ * Accumulates InWeight * InSource into InOutDestination.
+ * Kept as a plain contiguous loop so the compiler can vectorize it.
+ */
+template <typename SourceType>
+static FORCEINLINE void AccumulateScaled(double* RESTRICT InOutDestination, const SourceType* RESTRICT InSource, const double InWeight, const int32 InNum)
+{
+	for (int32 Index = 0; Index < InNum; Index++)
+	{
+		InOutDestination[Index] += InWeight * InSource[Index];
+	}
+}
+
+/**
+ * Computes all eigenvalues and eigenvectors of a symmetric matrix with the cyclic Jacobi method.
+ * The matrix is destroyed, the eigenvectors are returned column-wise in OutEigenvectors.
+ */
+static void JacobiEigenDecomposition(TArray<double>& InOutMatrix, const int32 InSize, TArray<double>& OutEigenvalues, TArray<double>& OutEigenvectors)
+{
+	double* A = InOutMatrix.GetData();
+	OutEigenvectors.SetNumZeroed(InSize * InSize);
+	double* V = OutEigenvectors.GetData();
+
+	double Trace = 0.0;
+	for (int32 i = 0; i < InSize; i++)
+	{
+		V[i * InSize + i] = 1.0;
+		Trace += FMath::Abs(A[i * InSize + i]);
+	}
+
+	const double Tolerance = FMath::Square(Trace * 1e-15);
+
+	for (int32 Sweep = 0; Sweep < MaxJacobiSweeps; Sweep++)
+	{
+		double OffDiagonal = 0.0;
+		for (int32 p = 0; p < InSize; p++)
+		{
+			for (int32 q = p + 1; q < InSize; q++)
+			{
+				OffDiagonal += FMath::Square(A[p * InSize + q]);
+			}
+		}
+
+		if (OffDiagonal <= Tolerance)
+		{
+			break;
+		}
+
+		for (int32 p = 0; p < InSize; p++)
+		{
+			for (int32 q = p + 1; q < InSize; q++)
+			{
+				const double Apq = A[p * InSize + q];
+				if (Apq == 0.0)
+				{
+					continue;
+				}
+
+				const double Theta = (A[q * InSize + q] - A[p * InSize + p]) / (2.0 * Apq);
+				const double T = (Theta >= 0.0 ? 1.0 : -1.0) / (FMath::Abs(Theta) + FMath::Sqrt(Theta * Theta + 1.0));
+				const double C = 1.0 / FMath::Sqrt(T * T + 1.0);
+				const double S = T * C;
+
+				for (int32 k = 0; k < InSize; k++)
+				{
+					const double Akp = A[k * InSize + p];
+					const double Akq = A[k * InSize + q];
+					A[k * InSize + p] = C * Akp - S * Akq;
+					A[k * InSize + q] = S * Akp + C * Akq;
+				}
+
+				for (int32 k = 0; k < InSize; k++)
+				{
+					const double Apk = A[p * InSize + k];
+					const double Aqk = A[q * InSize + k];
+					A[p * InSize + k] = C * Apk - S * Aqk;
+					A[q * InSize + k] = S * Apk + C * Aqk;
+				}
+
+				for (int32 k = 0; k < InSize; k++)
+				{
+					const double Vkp = V[k * InSize + p];
+					const double Vkq = V[k * InSize + q];
+					V[k * InSize + p] = C * Vkp - S * Vkq;
+					V[k * InSize + q] = S * Vkp + C * Vkq;
+				}
+			}
+		}
+	}
+
+	OutEigenvalues.SetNumUninitialized(InSize);
+	for (int32 i = 0; i < InSize; i++)
+	{
+		OutEigenvalues[i] = A[i * InSize + i];
+	}
+}
+
+void FPT_TagEnsemble::Init(const int32 InNumElectrodes, const int32 InNumCells)
+{
+	this->Reset();
+	this->NumElectrodes = FMath::Max(InNumElectrodes, 0);
+	this->NumCells = FMath::Max(InNumCells, 0);
+	this->RawData.SetNumZeroed(this->NumElectrodes * NumChannels * this->NumCells);
+}
+
+void FPT_TagEnsemble::Reset()
+{
+	this->NumElectrodes = 0;
+	this->NumCells = 0;
+	this->Rank = 0;
+	this->RawData.Empty();
+	this->BasisData.Empty();
+	this->CoefficientData.Empty();
+}
+
+double* FPT_TagEnsemble::GetRawChannel(const int32 InElectrodeIndex, const int32 InChannel)
+{
+	check(!this->IsCompressed());
+	return this->RawData.GetData() + ((int64)InElectrodeIndex * NumChannels + InChannel) * this->NumCells;
+}
+
+const double* FPT_TagEnsemble::GetRawChannel(const int32 InElectrodeIndex, const int32 InChannel) const
+{
+	check(!this->IsCompressed());
+	return this->RawData.GetData() + ((int64)InElectrodeIndex * NumChannels + InChannel) * this->NumCells;
+}
+
+void FPT_TagEnsemble::Blend(const int32* InElectrodeIndices, const double* InWeights, const int32 InNum, double* OutChannels, const int32 InFirstChannel, const int32 InLastChannel) const
+{
+	if (this->NumCells == 0)
+	{
+		return;
+	}
+
+	// In coefficient space the weights are applied to the coefficients once, the cells only see the basis rows
+	TArray<double, TInlineAllocator<MaxBasisRank>> BlendedCoefficients;
+	if (this->IsCompressed())
+	{
+		BlendedCoefficients.SetNumZeroed(this->Rank);
+		for (int32 i = 0; i < InNum; i++)
+		{
+			if (InElectrodeIndices[i] < 0 || InElectrodeIndices[i] >= this->NumElectrodes)
+			{
+				continue;
+			}
+
+			const double* Coefficients = this->CoefficientData.GetData() + (int64)InElectrodeIndices[i] * this->Rank;
+			for (int32 r = 0; r < this->Rank; r++)
+			{
+				BlendedCoefficients[r] += InWeights[i] * Coefficients[r];
+			}
+		}
+	}
+
+	const int32 NumChunks = FMath::DivideAndRoundUp(this->NumCells, EnsembleChunkSize);
+	ParallelFor(NumChunks, [&](const int32 ChunkIndex)
+	{
+		const int32 Begin = ChunkIndex * EnsembleChunkSize;
+		const int32 Count = FMath::Min(EnsembleChunkSize, this->NumCells - Begin);
+
+		for (int32 Channel = InFirstChannel; Channel <= InLastChannel; Channel++)
+		{
+			double* Destination = OutChannels + (int64)Channel * this->NumCells + Begin;
+			FMemory::Memzero(Destination, Count * sizeof(double));
+
+			if (this->IsCompressed())
+			{
+				for (int32 r = 0; r < this->Rank; r++)
+				{
+					const float* Source = this->BasisData.GetData() + ((int64)r * NumChannels + Channel) * this->NumCells + Begin;
+					AccumulateScaled(Destination, Source, BlendedCoefficients[r], Count);
+				}
+			}
+			else
+			{
+				for (int32 i = 0; i < InNum; i++)
+				{
+					if (InWeights[i] == 0.0 || InElectrodeIndices[i] < 0 || InElectrodeIndices[i] >= this->NumElectrodes)
+					{
+						continue;
+					}
+
+					const double* Source = this->RawData.GetData() + ((int64)InElectrodeIndices[i] * NumChannels + Channel) * this->NumCells + Begin;
+					AccumulateScaled(Destination, Source, InWeights[i], Count);
+				}
+			}
+		}
+	});
+}
+
+void FPT_TagEnsemble::CalculateChannelMeans(const int32 InChannel, TArray<double>& OutMeans) const
+{
+	OutMeans.SetNumZeroed(this->NumElectrodes);
+
+	if (this->NumCells == 0)
+	{
+		return;
+	}
+
+	// The mean is linear, so in coefficient space it is the coefficient-weighted sum of the basis row means
+	if (this->IsCompressed())
+	{
+		TArray<double, TInlineAllocator<MaxBasisRank>> BasisMeans;
+		BasisMeans.SetNumZeroed(this->Rank);
+		for (int32 r = 0; r < this->Rank; r++)
+		{
+			const float* Source = this->BasisData.GetData() + ((int64)r * NumChannels + InChannel) * this->NumCells;
+			double Sum = 0.0;
+			for (int32 Cell = 0; Cell < this->NumCells; Cell++)
+			{
+				Sum += Source[Cell];
+			}
+			BasisMeans[r] = Sum / this->NumCells;
+		}
+
+		for (int32 e = 0; e < this->NumElectrodes; e++)
+		{
+			const double* Coefficients = this->CoefficientData.GetData() + (int64)e * this->Rank;
+			for (int32 r = 0; r < this->Rank; r++)
+			{
+				OutMeans[e] += Coefficients[r] * BasisMeans[r];
+			}
+		}
+		return;
+	}
+
+	ParallelFor(this->NumElectrodes, [&](const int32 e)
+	{
+		const double* Source = this->GetRawChannel(e, InChannel);
+		double Sum = 0.0;
+		for (int32 Cell = 0; Cell < this->NumCells; Cell++)
+		{
+			Sum += Source[Cell];
+		}
+		OutMeans[e] = Sum / this->NumCells;
+	});
+}
+
+void FPT_TagEnsemble::CalculateWeightedChannelSums(const int32 InFirstChannel, const int32 InNumChannels, const double* InCellWeights, TArray<double>& OutSums) const
+{
+	OutSums.SetNumZeroed(this->NumElectrodes);
+
+	// Sums of one row of data against the weights, either per basis row or per electrode
+	auto WeightedSum = [this, InFirstChannel, InNumChannels, InCellWeights](const auto* InRow)
+	{
+		double Sum = 0.0;
+		for (int32 Channel = 0; Channel < InNumChannels; Channel++)
+		{
+			const auto* Source = InRow + (int64)(InFirstChannel + Channel) * this->NumCells;
+			const double* Weights = InCellWeights + (int64)Channel * this->NumCells;
+			for (int32 Cell = 0; Cell < this->NumCells; Cell++)
+			{
+				Sum += Weights[Cell] * Source[Cell];
+			}
+		}
+		return Sum;
+	};
+
+	if (this->IsCompressed())
+	{
+		TArray<double, TInlineAllocator<MaxBasisRank>> BasisSums;
+		BasisSums.SetNumZeroed(this->Rank);
+		ParallelFor(this->Rank, [&](const int32 r)
+		{
+			BasisSums[r] = WeightedSum(this->BasisData.GetData() + (int64)r * NumChannels * this->NumCells);
+		});
+
+		for (int32 e = 0; e < this->NumElectrodes; e++)
+		{
+			const double* Coefficients = this->CoefficientData.GetData() + (int64)e * this->Rank;
+			for (int32 r = 0; r < this->Rank; r++)
+			{
+				OutSums[e] += Coefficients[r] * BasisSums[r];
+			}
+		}
+		return;
+	}
+
+	ParallelFor(this->NumElectrodes, [&](const int32 e)
+	{
+		OutSums[e] = WeightedSum(this->RawData.GetData() + (int64)e * NumChannels * this->NumCells);
+	});
+}
+
+int32 FPT_TagEnsemble::CountCellsAboveThreshold(const int32* InElectrodeIndices, const double* InWeights, const int32 InNum, const double InThreshold) const
+{
+	double BlendedCoefficients[MaxBasisRank];
+	if (this->IsCompressed())
+	{
+		FMemory::Memzero(BlendedCoefficients, sizeof(BlendedCoefficients));
+		for (int32 i = 0; i < InNum; i++)
+		{
+			if (InElectrodeIndices[i] < 0 || InElectrodeIndices[i] >= this->NumElectrodes)
+			{
+				continue;
+			}
+
+			const double* Coefficients = this->CoefficientData.GetData() + (int64)InElectrodeIndices[i] * this->Rank;
+			for (int32 r = 0; r < this->Rank; r++)
+			{
+				BlendedCoefficients[r] += InWeights[i] * Coefficients[r];
+			}
+		}
+	}
+
+	double Block[CountBlockSize];
+	int32 Count = 0;
+	for (int32 Begin = 0; Begin < this->NumCells; Begin += CountBlockSize)
+	{
+		const int32 BlockCount = FMath::Min(CountBlockSize, this->NumCells - Begin);
+		FMemory::Memzero(Block, BlockCount * sizeof(double));
+
+		if (this->IsCompressed())
+		{
+			for (int32 r = 0; r < this->Rank; r++)
+			{
+				const float* Source = this->BasisData.GetData() + (int64)r * NumChannels * this->NumCells + Begin;
+				AccumulateScaled(Block, Source, BlendedCoefficients[r], BlockCount);
+			}
+		}
+		else
+		{
+			for (int32 i = 0; i < InNum; i++)
+			{
+				if (InWeights[i] == 0.0 || InElectrodeIndices[i] < 0 || InElectrodeIndices[i] >= this->NumElectrodes)
+				{
+					continue;
+				}
+
+				const double* Source = this->RawData.GetData() + (int64)InElectrodeIndices[i] * NumChannels * this->NumCells + Begin;
+				AccumulateScaled(Block, Source, InWeights[i], BlockCount);
+			}
+		}
+
+		for (int32 Cell = 0; Cell < BlockCount; Cell++)
+		{
+			Count += Block[Cell] > InThreshold ? 1 : 0;
+		}
+	}
+
+	return Count;
+}
+
+bool FPT_TagEnsemble::Compress(const int32 InMaxRank, const double InEnergyThreshold, double& OutRelativeError, double& OutMaxAbsoluteError)
+{
+	OutRelativeError = 0.0;
+	OutMaxAbsoluteError = 0.0;
+
+	if (this->IsCompressed() || this->NumElectrodes < 2 || this->NumCells == 0)
+	{
+		return false;
+	}
+
+	const int32 NumRows = this->NumElectrodes;
+	const int64 RowLength = (int64)NumChannels * this->NumCells;
+	const double* Rows = this->RawData.GetData();
+
+	// Gram matrix G = X * X^T, one row of the upper triangle per work item
+	TArray<double> Gram;
+	Gram.SetNumZeroed(NumRows * NumRows);
+	ParallelFor(NumRows, [&](const int32 RowA)
+	{
+		const double* DataA = Rows + RowA * RowLength;
+		for (int32 RowB = RowA; RowB < NumRows; RowB++)
+		{
+			const double* DataB = Rows + RowB * RowLength;
+			double Dot = 0.0;
+			for (int64 i = 0; i < RowLength; i++)
+			{
+				Dot += DataA[i] * DataB[i];
+			}
+			Gram[RowA * NumRows + RowB] = Dot;
+			Gram[RowB * NumRows + RowA] = Dot;
+		}
+	});
+
+	TArray<double> Eigenvalues;
+	TArray<double> Eigenvectors;
+	JacobiEigenDecomposition(Gram, NumRows, Eigenvalues, Eigenvectors);
+
+	TArray<int32> Order;
+	Order.SetNumUninitialized(NumRows);
+	for (int32 i = 0; i < NumRows; i++)
+	{
+		Order[i] = i;
+	}
+	Order.Sort([&Eigenvalues](const int32 A, const int32 B) { return Eigenvalues[A] > Eigenvalues[B]; });
+
+	double TotalEnergy = 0.0;
+	for (const double Eigenvalue : Eigenvalues)
+	{
+		TotalEnergy += FMath::Max(Eigenvalue, 0.0);
+	}
+
+	if (TotalEnergy <= 0.0)
+	{
+		return false;
+	}
+
+	// The basis is one array indexed by int32, so very large tags are limited to the rank that still fits
+	const int64 MaxRankByLength = (int64)MAX_int32 / RowLength;
+	if (MaxRankByLength < 1)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_TagEnsemble::Compress] %lld values per electrode exceed the size of one basis array!"), RowLength);
+		return false;
+	}
+
+	// Smallest rank that retains the requested energy, never keeping numerically empty directions
+	const int32 MaxRank = FMath::Clamp(InMaxRank, 1, (int32)FMath::Min<int64>(FMath::Min(NumRows, MaxBasisRank), MaxRankByLength));
+	if (MaxRank < FMath::Min(InMaxRank, FMath::Min(NumRows, MaxBasisRank)))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[FPT_TagEnsemble::Compress] The rank is limited to %d, a larger basis of %lld values per row would not fit into one array."), MaxRank, RowLength);
+	}
+	const double Threshold = FMath::Clamp(InEnergyThreshold, 0.0, 1.0) * TotalEnergy;
+	int32 NewRank = 0;
+	double RetainedEnergy = 0.0;
+	while (NewRank < MaxRank && RetainedEnergy < Threshold && Eigenvalues[Order[NewRank]] > TotalEnergy * 1e-14)
+	{
+		RetainedEnergy += Eigenvalues[Order[NewRank]];
+		NewRank++;
+	}
+	NewRank = FMath::Max(NewRank, 1);
+
+	// Basis rows B_r = (1 / sigma_r) * sum_e U[e][r] * X_e and coefficients C[e][r] = sigma_r * U[e][r]
+	TArray<double> RowWeights;
+	RowWeights.SetNumZeroed(NewRank * NumRows);
+	TArray<double> NewCoefficients;
+	NewCoefficients.SetNumZeroed(NumRows * NewRank);
+	for (int32 r = 0; r < NewRank; r++)
+	{
+		const int32 Column = Order[r];
+		const double Sigma = FMath::Sqrt(FMath::Max(Eigenvalues[Column], UE_DOUBLE_SMALL_NUMBER));
+		for (int32 e = 0; e < NumRows; e++)
+		{
+			const double U = Eigenvectors[e * NumRows + Column];
+			RowWeights[r * NumRows + e] = U / Sigma;
+			NewCoefficients[e * NewRank + r] = U * Sigma;
+		}
+	}
+
+	TArray<float> NewBasis;
+	NewBasis.SetNumUninitialized((int32)(NewRank * RowLength));
+	const int32 NumChunks = (int32)FMath::DivideAndRoundUp(RowLength, (int64)EnsembleChunkSize);
+	ParallelFor(NumChunks, [&](const int32 ChunkIndex)
+	{
+		const int64 Begin = (int64)ChunkIndex * EnsembleChunkSize;
+		const int32 Count = (int32)FMath::Min((int64)EnsembleChunkSize, RowLength - Begin);
+		TArray<double> Accumulator;
+		Accumulator.SetNumUninitialized(Count);
+
+		for (int32 r = 0; r < NewRank; r++)
+		{
+			FMemory::Memzero(Accumulator.GetData(), Count * sizeof(double));
+			for (int32 e = 0; e < NumRows; e++)
+			{
+				AccumulateScaled(Accumulator.GetData(), Rows + e * RowLength + Begin, RowWeights[r * NumRows + e], Count);
+			}
+
+			float* Destination = NewBasis.GetData() + r * RowLength + Begin;
+			for (int32 i = 0; i < Count; i++)
+			{
+				Destination[i] = (float)Accumulator[i];
+			}
+		}
+	});
+
+	// Error report against the raw data, reconstructed with the single precision basis actually stored
+	TArray<double> MaxErrorPerRow;
+	MaxErrorPerRow.SetNumZeroed(NumRows);
+	TArray<double> SquaredErrorPerRow;
+	SquaredErrorPerRow.SetNumZeroed(NumRows);
+	TArray<double> SquaredNormPerRow;
+	SquaredNormPerRow.SetNumZeroed(NumRows);
+	ParallelFor(NumRows, [&](const int32 Row)
+	{
+		TArray<double> Reconstruction;
+		Reconstruction.SetNumUninitialized(EnsembleChunkSize);
+		const double* Source = Rows + Row * RowLength;
+
+		for (int64 Begin = 0; Begin < RowLength; Begin += EnsembleChunkSize)
+		{
+			const int32 Count = (int32)FMath::Min((int64)EnsembleChunkSize, RowLength - Begin);
+			FMemory::Memzero(Reconstruction.GetData(), Count * sizeof(double));
+			for (int32 r = 0; r < NewRank; r++)
+			{
+				AccumulateScaled(Reconstruction.GetData(), NewBasis.GetData() + r * RowLength + Begin, NewCoefficients[Row * NewRank + r], Count);
+			}
+
+			for (int32 i = 0; i < Count; i++)
+			{
+				const double Error = Source[Begin + i] - Reconstruction[i];
+				MaxErrorPerRow[Row] = FMath::Max(MaxErrorPerRow[Row], FMath::Abs(Error));
+				SquaredErrorPerRow[Row] += Error * Error;
+				SquaredNormPerRow[Row] += Source[Begin + i] * Source[Begin + i];
+			}
+		}
+	});
+
+	double SquaredError = 0.0;
+	double SquaredNorm = 0.0;
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		OutMaxAbsoluteError = FMath::Max(OutMaxAbsoluteError, MaxErrorPerRow[Row]);
+		SquaredError += SquaredErrorPerRow[Row];
+		SquaredNorm += SquaredNormPerRow[Row];
+	}
+	OutRelativeError = SquaredNorm > 0.0 ? FMath::Sqrt(SquaredError / SquaredNorm) : 0.0;
+
+	this->Rank = NewRank;
+	this->BasisData = MoveTemp(NewBasis);
+	this->CoefficientData = MoveTemp(NewCoefficients);
+	this->RawData.Empty();
+
+	return true;
+}
+
+SIZE_T FPT_TagEnsemble::GetAllocatedSize() const
+{
+	return this->RawData.GetAllocatedSize() + this->BasisData.GetAllocatedSize() + this->CoefficientData.GetAllocatedSize();
+}
@@ -0,0 +1,162 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_ElectrodeEnsemble.h
+ * @brief Header file for the FPT_TagEnsemble class.
+ *
+ * This file contains the declaration of the FPT_TagEnsemble class, which stores the simulated fields of all electrodes
+ * for a single data tag and blends them for interpolation. The ensemble can optionally be factorized into a truncated
+ * low-rank basis to reduce its memory footprint.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @class FPT_TagEnsemble
+ * @brief Dense [electrode x cell] storage of the simulation data of one data tag.
+ *
+ * Only the ROI cells of a tag are stored, in the order given by the ROI index mapping of the tag. Every cell holds four
+ * channels: the magnitude followed by the X, Y and Z components of the vector field. The data is either kept raw
+ * ([Electrode][Channel][Cell], double precision) or, after Compress(), as a truncated basis ([Rank][Channel][Cell],
+ * single precision) plus per-electrode coefficients ([Electrode][Rank]). Blending works on both representations.
+ */
+class PLANNINGTOOL_ET_API FPT_TagEnsemble
+{
+public:
+	/** @brief Number of channels stored per cell (magnitude, vector X, vector Y, vector Z). */
+	static constexpr int32 NumChannels = 4;
+
+	/** @brief Channel index of the magnitude data. */
+	static constexpr int32 MagnitudeChannel = 0;
+
+	/** @brief Channel index of the first vector field component. */
+	static constexpr int32 VectorChannel = 1;
+
+	/** @brief Upper bound of the rank of the truncated basis. */
+	static constexpr int32 MaxBasisRank = 64;
+
+	/**
+	 * @brief Allocates zeroed raw storage.
+	 * @param InNumElectrodes The number of electrodes.
+	 * @param InNumCells The number of ROI cells of the tag.
+	 */
+	void Init(const int32 InNumElectrodes, const int32 InNumCells);
+
+	/**
+	 * @brief Releases all storage.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Gets a writable pointer to one channel of one electrode. Only valid while the ensemble is not compressed.
+	 * @param InElectrodeIndex The index of the electrode.
+	 * @param InChannel The channel index.
+	 * @return Pointer to NumCells consecutive values.
+	 */
+	double* GetRawChannel(const int32 InElectrodeIndex, const int32 InChannel);
+
+	/**
+	 * @brief Gets a read-only pointer to one channel of one electrode. Only valid while the ensemble is not compressed.
+	 * @param InElectrodeIndex The index of the electrode.
+	 * @param InChannel The channel index.
+	 * @return Pointer to NumCells consecutive values.
+	 */
+	const double* GetRawChannel(const int32 InElectrodeIndex, const int32 InChannel) const;
+
+	/**
+	 * @brief Blends the data of several electrodes with the given weights.
+	 *
+	 * The result is written channel by channel into OutChannels, which must hold NumChannels * NumCells values.
+	 * Channels not selected by the channel range are left untouched.
+	 *
+	 * @param InElectrodeIndices The indices of the electrodes to blend.
+	 * @param InWeights The weight of every electrode.
+	 * @param InNum The number of electrodes to blend.
+	 * @param OutChannels The output buffer in [Channel][Cell] layout.
+	 * @param InFirstChannel The first channel to evaluate.
+	 * @param InLastChannel The last channel to evaluate.
+	 */
+	void Blend(const int32* InElectrodeIndices, const double* InWeights, const int32 InNum, double* OutChannels, const int32 InFirstChannel = 0, const int32 InLastChannel = NumChannels - 1) const;
+
+	/**
+	 * @brief Calculates the mean of one channel over all cells for every electrode.
+	 * @param InChannel The channel index.
+	 * @param OutMeans Receives one mean per electrode.
+	 */
+	void CalculateChannelMeans(const int32 InChannel, TArray<double>& OutMeans) const;
+
+	/**
+	 * @brief Calculates the weighted sum of a channel range over all cells for every electrode.
+	 * @param InFirstChannel The first channel to sum.
+	 * @param InNumChannels The number of consecutive channels to sum.
+	 * @param InCellWeights The weight of every cell and channel in [Channel - InFirstChannel][Cell] layout.
+	 * @param OutSums Receives one sum per electrode.
+	 */
+	void CalculateWeightedChannelSums(const int32 InFirstChannel, const int32 InNumChannels, const double* InCellWeights, TArray<double>& OutSums) const;
+
+	/**
+	 * @brief Counts the cells whose blended magnitude exceeds a threshold.
+	 *
+	 * The magnitude is blended block by block on the stack, so the call does not allocate. It runs on the calling thread
+	 * only and is meant to be issued from parallel candidate evaluations.
+	 *
+	 * @param InElectrodeIndices The indices of the electrodes to blend.
+	 * @param InWeights The weight of every electrode.
+	 * @param InNum The number of electrodes to blend.
+	 * @param InThreshold The magnitude threshold.
+	 * @return The number of cells with a blended magnitude above the threshold.
+	 */
+	int32 CountCellsAboveThreshold(const int32* InElectrodeIndices, const double* InWeights, const int32 InNum, const double InThreshold) const;
+
+	/**
+	 * @brief Factorizes the raw data into a truncated basis and releases the raw data.
+	 *
+	 * The factorization uses the eigen decomposition of the [electrode x electrode] Gram matrix. The rank is the smallest
+	 * one that retains InEnergyThreshold of the total energy, clamped to InMaxRank, MaxBasisRank and the largest rank
+	 * whose basis still fits into one array. Both errors compare the raw data with its reconstruction from the stored
+	 * single precision basis.
+	 *
+	 * @param InMaxRank The maximum rank of the basis.
+	 * @param InEnergyThreshold The fraction of the energy (sum of squared singular values) to retain.
+	 * @param OutRelativeError The relative Frobenius norm error of the factorization.
+	 * @param OutMaxAbsoluteError The largest absolute error of any reconstructed value.
+	 * @return True if the ensemble was compressed.
+	 */
+	bool Compress(const int32 InMaxRank, const double InEnergyThreshold, double& OutRelativeError, double& OutMaxAbsoluteError);
+
+	/** @brief Whether the ensemble holds a truncated basis instead of raw data. */
+	bool IsCompressed() const { return this->Rank > 0; }
+
+	/** @brief Gets the number of electrodes. */
+	int32 GetNumElectrodes() const { return this->NumElectrodes; }
+
+	/** @brief Gets the number of ROI cells. */
+	int32 GetNumCells() const { return this->NumCells; }
+
+	/** @brief Gets the rank of the basis, 0 if the ensemble is not compressed. */
+	int32 GetRank() const { return this->Rank; }
+
+	/** @brief Gets the number of bytes held by the ensemble. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** @brief The number of electrodes. */
+	int32 NumElectrodes = 0;
+
+	/** @brief The number of ROI cells. */
+	int32 NumCells = 0;
+
+	/** @brief The rank of the basis, 0 while the raw data is held. */
+	int32 Rank = 0;
+
+	/** @brief Raw data in [Electrode][Channel][Cell] layout. */
+	TArray<double> RawData;
+
+	/** @brief Basis rows in [Rank][Channel][Cell] layout. */
+	TArray<float> BasisData;
+
+	/** @brief Coefficients in [Electrode][Rank] layout. */
+	TArray<double> CoefficientData;
+};
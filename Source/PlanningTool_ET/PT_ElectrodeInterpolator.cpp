@@ -0,0 +1,777 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_ElectrodeInterpolator.h"
+#include "Async/ParallelFor.h"
+
+/** Exponent of the inverse distance weighting. */
+static constexpr double InverseDistancePower = 2.0;
+
+/**
+ * Inverse multiquadric kernel. It is strictly positive definite, so the augmented system of distinct points is always
+ * invertible.
+ */
+static FORCEINLINE double EvaluateRadialKernel(const double InDistanceSquared, const double InShape)
+{
+	return 1.0 / FMath::Sqrt(1.0 + InDistanceSquared / (InShape * InShape));
+}
+
+/**
+ * Inverts a dense row-major matrix in place with Gauss-Jordan elimination and partial pivoting.
+ * Returns false if the matrix is numerically singular.
+ */
+static bool InvertMatrix(double* InOutMatrix, const int32 InSize)
+{
+	TArray<double, TInlineAllocator<(FPT_ElectrodeInterpolator::MaxNeighborCount + 1) * (FPT_ElectrodeInterpolator::MaxNeighborCount + 1)>> Inverse;
+	Inverse.SetNumZeroed(InSize * InSize);
+	for (int32 i = 0; i < InSize; i++)
+	{
+		Inverse[i * InSize + i] = 1.0;
+	}
+
+	for (int32 Column = 0; Column < InSize; Column++)
+	{
+		int32 Pivot = Column;
+		for (int32 Row = Column + 1; Row < InSize; Row++)
+		{
+			if (FMath::Abs(InOutMatrix[Row * InSize + Column]) > FMath::Abs(InOutMatrix[Pivot * InSize + Column]))
+			{
+				Pivot = Row;
+			}
+		}
+
+		if (FMath::Abs(InOutMatrix[Pivot * InSize + Column]) < UE_DOUBLE_SMALL_NUMBER)
+		{
+			return false;
+		}
+
+		if (Pivot != Column)
+		{
+			for (int32 k = 0; k < InSize; k++)
+			{
+				Swap(InOutMatrix[Pivot * InSize + k], InOutMatrix[Column * InSize + k]);
+				Swap(Inverse[Pivot * InSize + k], Inverse[Column * InSize + k]);
+			}
+		}
+
+		const double InvPivot = 1.0 / InOutMatrix[Column * InSize + Column];
+		for (int32 k = 0; k < InSize; k++)
+		{
+			InOutMatrix[Column * InSize + k] *= InvPivot;
+			Inverse[Column * InSize + k] *= InvPivot;
+		}
+
+		for (int32 Row = 0; Row < InSize; Row++)
+		{
+			const double Factor = InOutMatrix[Row * InSize + Column];
+			if (Row == Column || Factor == 0.0)
+			{
+				continue;
+			}
+
+			for (int32 k = 0; k < InSize; k++)
+			{
+				InOutMatrix[Row * InSize + k] -= Factor * InOutMatrix[Column * InSize + k];
+				Inverse[Row * InSize + k] -= Factor * Inverse[Column * InSize + k];
+			}
+		}
+	}
+
+	FMemory::Memcpy(InOutMatrix, Inverse.GetData(), InSize * InSize * sizeof(double));
+	return true;
+}
+
+void FPT_ElectrodeInterpolator::Build(const TArray<FVector>& InElectrodePositions, const TArray<int32>& InValidElectrodeIndices, const int32 InNeighborCount)
+{
+	this->Reset();
+
+	if (InValidElectrodeIndices.IsEmpty())
+	{
+		for (int32 CurrentElectrodeIndex = 0; CurrentElectrodeIndex < InElectrodePositions.Num(); CurrentElectrodeIndex++)
+		{
+			this->ElectrodeIndices.Add(CurrentElectrodeIndex);
+		}
+	}
+	else
+	{
+		for (const int32 CurrentElectrodeIndex : InValidElectrodeIndices)
+		{
+			if (InElectrodePositions.IsValidIndex(CurrentElectrodeIndex))
+			{
+				this->ElectrodeIndices.AddUnique(CurrentElectrodeIndex);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("[FPT_ElectrodeInterpolator::Build] Electrode index %d has no position, skipping it."), CurrentElectrodeIndex);
+			}
+		}
+	}
+
+	const int32 NumElectrodes = this->ElectrodeIndices.Num();
+	this->PositionX.SetNumUninitialized(NumElectrodes);
+	this->PositionY.SetNumUninitialized(NumElectrodes);
+	this->PositionZ.SetNumUninitialized(NumElectrodes);
+	for (int32 Slot = 0; Slot < NumElectrodes; Slot++)
+	{
+		const FVector& Position = InElectrodePositions[this->ElectrodeIndices[Slot]];
+		this->PositionX[Slot] = Position.X;
+		this->PositionY[Slot] = Position.Y;
+		this->PositionZ[Slot] = Position.Z;
+	}
+
+	this->BuildSearchStructures();
+	this->NeighborCount = FMath::Clamp(InNeighborCount, 1, MaxNeighborCount);
+	this->BuildRadialBasisStencils();
+}
+
+void FPT_ElectrodeInterpolator::BuildWithout(const FPT_ElectrodeInterpolator& InSource, const int32 InExcludedElectrodeIndex)
+{
+	this->Reset();
+
+	const int32 ExcludedSlot = InSource.ElectrodeIndices.Find(InExcludedElectrodeIndex);
+	for (int32 Slot = 0; Slot < InSource.GetNumElectrodes(); Slot++)
+	{
+		if (Slot != ExcludedSlot)
+		{
+			this->ElectrodeIndices.Add(InSource.ElectrodeIndices[Slot]);
+			this->PositionX.Add(InSource.PositionX[Slot]);
+			this->PositionY.Add(InSource.PositionY[Slot]);
+			this->PositionZ.Add(InSource.PositionZ[Slot]);
+		}
+	}
+
+	this->BuildSearchStructures();
+	this->NeighborCount = InSource.NeighborCount;
+
+	const int32 NumElectrodes = this->GetNumElectrodes();
+	if (ExcludedSlot == INDEX_NONE || FMath::Min(this->NeighborCount, NumElectrodes) != InSource.StencilSize)
+	{
+		this->BuildRadialBasisStencils();
+	}
+	else if (NumElectrodes > 0)
+	{
+		// A stencil without the excluded electrode still holds the nearest electrodes of its center, so only the
+		// stencils containing it are rebuilt, the others are copied with their slots shifted
+		const int32 Size = InSource.StencilSize;
+		const int32 SystemSize = Size + 1;
+		this->StencilSize = Size;
+		this->StencilSlots.SetNumZeroed(NumElectrodes * Size);
+		this->StencilInverses.SetNumZeroed(NumElectrodes * SystemSize * SystemSize);
+		this->StencilShapes.SetNumZeroed(NumElectrodes);
+		this->StencilValid.SetNumZeroed(NumElectrodes);
+
+		TArray<int32> AffectedSlots;
+		for (int32 SourceSlot = 0; SourceSlot < InSource.GetNumElectrodes(); SourceSlot++)
+		{
+			if (SourceSlot == ExcludedSlot)
+			{
+				continue;
+			}
+
+			const int32 Slot = SourceSlot > ExcludedSlot ? SourceSlot - 1 : SourceSlot;
+			const int32* SourceSlots = InSource.StencilSlots.GetData() + SourceSlot * Size;
+			bool bIsAffected = false;
+			for (int32 i = 0; i < Size; i++)
+			{
+				bIsAffected |= SourceSlots[i] == ExcludedSlot;
+			}
+
+			if (bIsAffected)
+			{
+				AffectedSlots.Add(Slot);
+				continue;
+			}
+
+			int32* Slots = this->StencilSlots.GetData() + Slot * Size;
+			for (int32 i = 0; i < Size; i++)
+			{
+				Slots[i] = SourceSlots[i] > ExcludedSlot ? SourceSlots[i] - 1 : SourceSlots[i];
+			}
+			FMemory::Memcpy(this->StencilInverses.GetData() + Slot * SystemSize * SystemSize, InSource.StencilInverses.GetData() + SourceSlot * SystemSize * SystemSize, SystemSize * SystemSize * sizeof(double));
+			this->StencilShapes[Slot] = InSource.StencilShapes[SourceSlot];
+			this->StencilValid[Slot] = InSource.StencilValid[SourceSlot];
+		}
+
+		for (const int32 Slot : AffectedSlots)
+		{
+			this->BuildRadialBasisStencil(Slot);
+		}
+	}
+
+	// The lattice keeps its frame, only the node of the excluded electrode becomes empty
+	if (InSource.IsGridBuilt())
+	{
+		this->GridOrigin = InSource.GridOrigin;
+		this->GridAxisU = InSource.GridAxisU;
+		this->GridAxisV = InSource.GridAxisV;
+		this->GridStep = InSource.GridStep;
+		this->GridColumns = InSource.GridColumns;
+		this->GridRows = InSource.GridRows;
+		this->GridSlots = InSource.GridSlots;
+
+		for (int32& Slot : this->GridSlots)
+		{
+			if (Slot == INDEX_NONE || ExcludedSlot == INDEX_NONE)
+			{
+				continue;
+			}
+			Slot = (Slot == ExcludedSlot) ? INDEX_NONE : (Slot > ExcludedSlot ? Slot - 1 : Slot);
+		}
+	}
+}
+
+void FPT_ElectrodeInterpolator::BuildSearchStructures()
+{
+	TArray<FVector> Positions;
+	Positions.SetNumUninitialized(this->GetNumElectrodes());
+	for (int32 Slot = 0; Slot < Positions.Num(); Slot++)
+	{
+		Positions[Slot] = this->GetPosition(Slot);
+	}
+
+	this->SpatialIndex.Build(Positions);
+	this->Triangulation.Build(Positions);
+}
+
+void FPT_ElectrodeInterpolator::BuildRadialBasisStencils()
+{
+	const int32 NumElectrodes = this->GetNumElectrodes();
+	this->StencilSize = FMath::Min(this->NeighborCount, NumElectrodes);
+
+	if (NumElectrodes == 0)
+	{
+		return;
+	}
+
+	// Precompute the inverted radial basis system of every electrode, the stencils are independent of each other
+	const int32 SystemSize = this->StencilSize + 1;
+	this->StencilSlots.SetNumZeroed(NumElectrodes * this->StencilSize);
+	this->StencilInverses.SetNumZeroed(NumElectrodes * SystemSize * SystemSize);
+	this->StencilShapes.SetNumZeroed(NumElectrodes);
+	this->StencilValid.SetNumZeroed(NumElectrodes);
+
+	ParallelFor(NumElectrodes, [this](const int32 Slot)
+	{
+		this->BuildRadialBasisStencil(Slot);
+	});
+}
+
+void FPT_ElectrodeInterpolator::Reset()
+{
+	this->PositionX.Empty();
+	this->PositionY.Empty();
+	this->PositionZ.Empty();
+	this->ElectrodeIndices.Empty();
+	this->SpatialIndex.Reset();
+	this->Triangulation.Reset();
+	this->NeighborCount = 0;
+	this->StencilSize = 0;
+	this->StencilSlots.Empty();
+	this->StencilInverses.Empty();
+	this->StencilShapes.Empty();
+	this->StencilValid.Empty();
+	this->GridOrigin = FVector::ZeroVector;
+	this->GridAxisU = FVector::ForwardVector;
+	this->GridAxisV = FVector::RightVector;
+	this->GridStep = 0.0;
+	this->GridColumns = 0;
+	this->GridRows = 0;
+	this->GridSlots.Empty();
+}
+
+bool FPT_ElectrodeInterpolator::CalculateGridAxes(const TArray<FVector>& InCornerPoints, FVector& OutOrigin, FVector& OutAxisU, FVector& OutAxisV, double& OutLengthU, double& OutLengthV)
+{
+	if (InCornerPoints.Num() != 4)
+	{
+		return false;
+	}
+
+	// The corner diagonal to the first one is the farthest, the two remaining corners span the grid edges
+	int32 DiagonalCorner = 1;
+	for (int32 CornerIndex = 2; CornerIndex < 4; CornerIndex++)
+	{
+		if (FVector::DistSquared(InCornerPoints[0], InCornerPoints[CornerIndex]) > FVector::DistSquared(InCornerPoints[0], InCornerPoints[DiagonalCorner]))
+		{
+			DiagonalCorner = CornerIndex;
+		}
+	}
+
+	int32 EdgeCorners[2];
+	int32 NumEdgeCorners = 0;
+	for (int32 CornerIndex = 1; CornerIndex < 4; CornerIndex++)
+	{
+		if (CornerIndex != DiagonalCorner)
+		{
+			EdgeCorners[NumEdgeCorners++] = CornerIndex;
+		}
+	}
+
+	OutOrigin = InCornerPoints[0];
+	OutAxisU = InCornerPoints[EdgeCorners[0]] - InCornerPoints[0];
+	OutAxisV = InCornerPoints[EdgeCorners[1]] - InCornerPoints[0];
+	OutLengthU = OutAxisU.Size();
+	if (!OutAxisU.Normalize() || !OutAxisV.Normalize())
+	{
+		return false;
+	}
+
+	// Make the second axis exactly orthogonal to the first one
+	OutAxisV = (OutAxisV - FVector::DotProduct(OutAxisV, OutAxisU) * OutAxisU).GetSafeNormal();
+	OutLengthV = FVector::DotProduct(InCornerPoints[EdgeCorners[1]] - InCornerPoints[0], OutAxisV);
+	return !OutAxisV.IsZero();
+}
+
+bool FPT_ElectrodeInterpolator::BuildGrid(const TArray<FVector>& InCornerPoints, const double InCellSize, const int32 InRows, const int32 InColumns)
+{
+	this->GridSlots.Empty();
+	this->GridRows = 0;
+	this->GridColumns = 0;
+
+	if (!this->IsBuilt() || InCornerPoints.Num() != 4)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_ElectrodeInterpolator::BuildGrid] Interpolator not built or corner points missing!"));
+		return false;
+	}
+
+	FVector CornerOrigin;
+	FVector AxisU;
+	FVector AxisV;
+	double LengthU = 0.0;
+	double LengthV = 0.0;
+	if (!CalculateGridAxes(InCornerPoints, CornerOrigin, AxisU, AxisV, LengthU, LengthV))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_ElectrodeInterpolator::BuildGrid] Degenerate corner points!"));
+		return false;
+	}
+
+	const int32 NumElectrodes = this->GetNumElectrodes();
+	TArray<FVector2D> PlanePositions;
+	PlanePositions.SetNumUninitialized(NumElectrodes);
+	FVector2D Minimum(UE_DOUBLE_BIG_NUMBER, UE_DOUBLE_BIG_NUMBER);
+	for (int32 Slot = 0; Slot < NumElectrodes; Slot++)
+	{
+		const FVector Offset = this->GetPosition(Slot) - CornerOrigin;
+		PlanePositions[Slot] = FVector2D(FVector::DotProduct(Offset, AxisU), FVector::DotProduct(Offset, AxisV));
+		Minimum.X = FMath::Min(Minimum.X, PlanePositions[Slot].X);
+		Minimum.Y = FMath::Min(Minimum.Y, PlanePositions[Slot].Y);
+	}
+
+	// Without a cell size the lattice step is the smallest distance between two electrodes
+	double Step = InCellSize;
+	if (Step <= 0.0)
+	{
+		Step = UE_DOUBLE_BIG_NUMBER;
+		for (int32 SlotA = 0; SlotA < NumElectrodes; SlotA++)
+		{
+			for (int32 SlotB = SlotA + 1; SlotB < NumElectrodes; SlotB++)
+			{
+				const double Distance = FVector2D::Distance(PlanePositions[SlotA], PlanePositions[SlotB]);
+				if (Distance > UE_DOUBLE_KINDA_SMALL_NUMBER)
+				{
+					Step = FMath::Min(Step, Distance);
+				}
+			}
+		}
+
+		if (Step == UE_DOUBLE_BIG_NUMBER)
+		{
+			Step = 1.0;
+		}
+	}
+
+	TArray<FIntPoint> LatticeNodes;
+	LatticeNodes.SetNumUninitialized(NumElectrodes);
+	int32 Columns = 0;
+	int32 Rows = 0;
+	for (int32 Slot = 0; Slot < NumElectrodes; Slot++)
+	{
+		LatticeNodes[Slot] = FIntPoint(FMath::RoundToInt((PlanePositions[Slot].X - Minimum.X) / Step), FMath::RoundToInt((PlanePositions[Slot].Y - Minimum.Y) / Step));
+		Columns = FMath::Max(Columns, LatticeNodes[Slot].X + 1);
+		Rows = FMath::Max(Rows, LatticeNodes[Slot].Y + 1);
+	}
+
+	if ((InRows > 0 && InColumns > 0) && !((Rows <= InRows && Columns <= InColumns) || (Rows <= InColumns && Columns <= InRows)))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[FPT_ElectrodeInterpolator::BuildGrid] Electrodes span %d x %d lattice nodes, expected %d x %d!"), Rows, Columns, InRows, InColumns);
+	}
+
+	this->GridSlots.Init(INDEX_NONE, Rows * Columns);
+	for (int32 Slot = 0; Slot < NumElectrodes; Slot++)
+	{
+		int32& Node = this->GridSlots[LatticeNodes[Slot].Y * Columns + LatticeNodes[Slot].X];
+		if (Node != INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[FPT_ElectrodeInterpolator::BuildGrid] Electrodes %d and %d snap to the same lattice node!"), this->ElectrodeIndices[Node], this->ElectrodeIndices[Slot]);
+			continue;
+		}
+		Node = Slot;
+	}
+
+	this->GridOrigin = CornerOrigin + Minimum.X * AxisU + Minimum.Y * AxisV;
+	this->GridAxisU = AxisU;
+	this->GridAxisV = AxisV;
+	this->GridStep = Step;
+	this->GridColumns = Columns;
+	this->GridRows = Rows;
+	return true;
+}
+
+void FPT_ElectrodeInterpolator::BuildRadialBasisStencil(const int32 InSlot)
+{
+	const int32 Size = this->StencilSize;
+	const int32 SystemSize = Size + 1;
+	int32* Slots = this->StencilSlots.GetData() + InSlot * Size;
+	double* Matrix = this->StencilInverses.GetData() + InSlot * SystemSize * SystemSize;
+
+	double DistancesSquared[MaxNeighborCount];
+	const int32 NumFound = this->FindNearestElectrodes(this->GetPosition(InSlot), Size, Slots, DistancesSquared);
+	if (NumFound != Size)
+	{
+		return;
+	}
+
+	// The shape parameter follows the local electrode spacing
+	double MeanDistance = 0.0;
+	for (int32 i = 1; i < Size; i++)
+	{
+		MeanDistance += FMath::Sqrt(DistancesSquared[i]);
+	}
+	const double Shape = (Size > 1 && MeanDistance > 0.0) ? MeanDistance / (Size - 1) : 1.0;
+	this->StencilShapes[InSlot] = Shape;
+
+	// Augmented system [Phi 1; 1^T 0], the constant term makes the weights a partition of unity
+	for (int32 i = 0; i < Size; i++)
+	{
+		const FVector PositionI = this->GetPosition(Slots[i]);
+		for (int32 j = 0; j < Size; j++)
+		{
+			Matrix[i * SystemSize + j] = EvaluateRadialKernel(FVector::DistSquared(PositionI, this->GetPosition(Slots[j])), Shape);
+		}
+		Matrix[i * SystemSize + Size] = 1.0;
+		Matrix[Size * SystemSize + i] = 1.0;
+	}
+	Matrix[Size * SystemSize + Size] = 0.0;
+
+	this->StencilValid[InSlot] = InvertMatrix(Matrix, SystemSize);
+}
+
+int32 FPT_ElectrodeInterpolator::FindNearestElectrodes(const FVector& InPoint, const int32 InCount, int32* OutSlots, double* OutDistancesSquared) const
+{
+	return this->SpatialIndex.FindNearest(InPoint, InCount, OutSlots, OutDistancesSquared);
+}
+
+void FPT_ElectrodeInterpolator::FindNearestElectrodesBatch(const TArray<FVector>& InPoints, const int32 InCount, TArray<int32>& OutSlots, TArray<double>& OutDistancesSquared) const
+{
+	this->SpatialIndex.FindNearestBatch(InPoints, InCount, OutSlots, OutDistancesSquared);
+}
+
+bool FPT_ElectrodeInterpolator::FindEnclosingTriangle(const FVector& InPoint, int32* OutSlots, double* OutWeights, int32* InOutTriangle) const
+{
+	if (this->FindLatticeTriangle(InPoint, OutSlots, OutWeights))
+	{
+		return true;
+	}
+
+	if (!this->Triangulation.IsBuilt())
+	{
+		return false;
+	}
+
+	// Without a previous triangle the walk starts next to the nearest electrode
+	const int32 StartTriangle = InOutTriangle ? *InOutTriangle : INDEX_NONE;
+	int32 StartSlot = INDEX_NONE;
+	if (StartTriangle < 0 || StartTriangle >= this->Triangulation.GetNumTriangles())
+	{
+		double StartDistanceSquared = 0.0;
+		this->FindNearestElectrodes(InPoint, 1, &StartSlot, &StartDistanceSquared);
+	}
+
+	bool bIsInside = false;
+	const int32 Triangle = this->Triangulation.Locate(InPoint, StartTriangle, StartSlot, OutSlots, OutWeights, bIsInside);
+	if (InOutTriangle)
+	{
+		*InOutTriangle = Triangle;
+	}
+	return bIsInside;
+}
+
+bool FPT_ElectrodeInterpolator::FindLatticeTriangle(const FVector& InPoint, int32* OutSlots, double* OutWeights) const
+{
+	if (!this->IsGridBuilt() || this->GridColumns < 2 || this->GridRows < 2)
+	{
+		return false;
+	}
+
+	const FVector Offset = InPoint - this->GridOrigin;
+	const double U = FVector::DotProduct(Offset, this->GridAxisU) / this->GridStep;
+	const double V = FVector::DotProduct(Offset, this->GridAxisV) / this->GridStep;
+	const int32 Column = FMath::FloorToInt32(U);
+	const int32 Row = FMath::FloorToInt32(V);
+	if (Column < 0 || Row < 0 || Column >= this->GridColumns - 1 || Row >= this->GridRows - 1)
+	{
+		return false;
+	}
+
+	// Lattice cell split along its diagonal into the triangle towards the origin corner and the opposite one
+	const double S = U - Column;
+	const double T = V - Row;
+	const bool bIsLowerTriangle = S + T <= 1.0;
+	const int32 CornerColumns[3] = { bIsLowerTriangle ? Column : Column + 1, bIsLowerTriangle ? Column + 1 : Column, bIsLowerTriangle ? Column : Column + 1 };
+	const int32 CornerRows[3] = { bIsLowerTriangle ? Row : Row + 1, bIsLowerTriangle ? Row : Row + 1, bIsLowerTriangle ? Row + 1 : Row };
+
+	for (int32 Corner = 0; Corner < 3; Corner++)
+	{
+		OutSlots[Corner] = this->GridSlots[CornerRows[Corner] * this->GridColumns + CornerColumns[Corner]];
+		if (OutSlots[Corner] == INDEX_NONE)
+		{
+			return false;
+		}
+	}
+
+	OutWeights[0] = bIsLowerTriangle ? 1.0 - S - T : S + T - 1.0;
+	OutWeights[1] = bIsLowerTriangle ? S : 1.0 - S;
+	OutWeights[2] = bIsLowerTriangle ? T : 1.0 - T;
+	return true;
+}
+
+bool FPT_ElectrodeInterpolator::CalculateBarycentricWeightsBatch(const TArray<FVector>& InPoints, TArray<int32>& OutTriangles, TArray<double>& OutWeightsA, TArray<double>& OutWeightsB, TArray<double>& OutWeightsC) const
+{
+	if (!this->Triangulation.IsBuilt())
+	{
+		return false;
+	}
+
+	this->Triangulation.LocateBatch(InPoints, OutTriangles, OutWeightsA, OutWeightsB, OutWeightsC);
+	return true;
+}
+
+void FPT_ElectrodeInterpolator::GetTriangleElectrodeIndices(const int32 InTriangle, int32* OutElectrodeIndices) const
+{
+	const FIntVector& Slots = this->Triangulation.GetTriangleVertices(InTriangle);
+	OutElectrodeIndices[0] = this->ElectrodeIndices[Slots.X];
+	OutElectrodeIndices[1] = this->ElectrodeIndices[Slots.Y];
+	OutElectrodeIndices[2] = this->ElectrodeIndices[Slots.Z];
+}
+
+int32 FPT_ElectrodeInterpolator::CalculateWeights(const EInterpolationMode InMode, const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights, int32* InOutTriangle) const
+{
+	if (!this->IsBuilt())
+	{
+		return 0;
+	}
+
+	switch (InMode)
+	{
+	case EInterpolationMode::InverseDistance:
+		return this->CalculateInverseDistanceWeights(InPoint, OutElectrodeIndices, OutWeights);
+	case EInterpolationMode::RadialBasis:
+		return this->CalculateRadialBasisWeights(InPoint, OutElectrodeIndices, OutWeights);
+	case EInterpolationMode::Bilinear:
+		return this->IsGridBuilt() ? this->CalculateBilinearWeights(InPoint, OutElectrodeIndices, OutWeights) : this->CalculateBarycentricWeights(InPoint, OutElectrodeIndices, OutWeights, InOutTriangle);
+	case EInterpolationMode::Barycentric:
+	default:
+		return this->CalculateBarycentricWeights(InPoint, OutElectrodeIndices, OutWeights, InOutTriangle);
+	}
+}
+
+int32 FPT_ElectrodeInterpolator::CalculateBilinearWeightsWithout(const int32 InExcludedSlot, int32* OutElectrodeIndices, double* OutWeights) const
+{
+	const int32 NodeIndex = this->GridSlots.Find(InExcludedSlot);
+	if (NodeIndex == INDEX_NONE)
+	{
+		return 0;
+	}
+
+	const int32 Row = NodeIndex / this->GridColumns;
+	const int32 Column = NodeIndex % this->GridColumns;
+	auto GetNodeSlot = [this](const int32 InRow, const int32 InColumn)
+	{
+		return (InRow >= 0 && InRow < this->GridRows && InColumn >= 0 && InColumn < this->GridColumns) ? this->GridSlots[InRow * this->GridColumns + InColumn] : INDEX_NONE;
+	};
+
+	// Center of the cell of the diagonal neighbors, then the midpoint of the row or column neighbors
+	const FIntPoint Candidates[3][4] = {
+		{ FIntPoint(-1, -1), FIntPoint(1, -1), FIntPoint(-1, 1), FIntPoint(1, 1) },
+		{ FIntPoint(-1, 0), FIntPoint(1, 0), FIntPoint::ZeroValue, FIntPoint::ZeroValue },
+		{ FIntPoint(0, -1), FIntPoint(0, 1), FIntPoint::ZeroValue, FIntPoint::ZeroValue } };
+	const int32 NumCorners[3] = { 4, 2, 2 };
+
+	for (int32 CandidateIndex = 0; CandidateIndex < 3; CandidateIndex++)
+	{
+		int32 Slots[4];
+		bool bIsComplete = true;
+		for (int32 Corner = 0; Corner < NumCorners[CandidateIndex] && bIsComplete; Corner++)
+		{
+			Slots[Corner] = GetNodeSlot(Row + Candidates[CandidateIndex][Corner].Y, Column + Candidates[CandidateIndex][Corner].X);
+			bIsComplete = Slots[Corner] != INDEX_NONE;
+		}
+
+		if (bIsComplete)
+		{
+			for (int32 Corner = 0; Corner < NumCorners[CandidateIndex]; Corner++)
+			{
+				OutElectrodeIndices[Corner] = this->ElectrodeIndices[Slots[Corner]];
+				OutWeights[Corner] = 1.0 / NumCorners[CandidateIndex];
+			}
+			return NumCorners[CandidateIndex];
+		}
+	}
+	return 0;
+}
+
+int32 FPT_ElectrodeInterpolator::CalculateBarycentricWeights(const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights, int32* InOutTriangle) const
+{
+	int32 Slots[3];
+	if (this->Triangulation.IsBuilt())
+	{
+		this->FindEnclosingTriangle(InPoint, Slots, OutWeights, InOutTriangle);
+		for (int32 i = 0; i < 3; i++)
+		{
+			OutElectrodeIndices[i] = this->ElectrodeIndices[Slots[i]];
+		}
+		return 3;
+	}
+
+	// Fewer than three or collinear electrodes have no triangulation, those fall back to inverse distance weighting
+	double DistancesSquared[3];
+	const int32 NumFound = this->FindNearestElectrodes(InPoint, 3, Slots, DistancesSquared);
+
+	double InverseDistanceSum = 0.0;
+	for (int32 i = 0; i < NumFound; i++)
+	{
+		if (DistancesSquared[i] <= UE_DOUBLE_SMALL_NUMBER)
+		{
+			OutElectrodeIndices[0] = this->ElectrodeIndices[Slots[i]];
+			OutWeights[0] = 1.0;
+			return 1;
+		}
+
+		OutElectrodeIndices[i] = this->ElectrodeIndices[Slots[i]];
+		OutWeights[i] = 1.0 / FMath::Pow(DistancesSquared[i], 0.5 * InverseDistancePower);
+		InverseDistanceSum += OutWeights[i];
+	}
+
+	for (int32 i = 0; i < NumFound; i++)
+	{
+		OutWeights[i] /= InverseDistanceSum;
+	}
+	return NumFound;
+}
+
+int32 FPT_ElectrodeInterpolator::CalculateInverseDistanceWeights(const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights) const
+{
+	int32 Slots[MaxNeighborCount];
+	double DistancesSquared[MaxNeighborCount];
+	const int32 NumFound = this->FindNearestElectrodes(InPoint, this->NeighborCount, Slots, DistancesSquared);
+
+	// A point on top of an electrode takes its data unchanged
+	if (DistancesSquared[0] <= UE_DOUBLE_SMALL_NUMBER)
+	{
+		OutElectrodeIndices[0] = this->ElectrodeIndices[Slots[0]];
+		OutWeights[0] = 1.0;
+		return 1;
+	}
+
+	double WeightSum = 0.0;
+	for (int32 i = 0; i < NumFound; i++)
+	{
+		OutElectrodeIndices[i] = this->ElectrodeIndices[Slots[i]];
+		OutWeights[i] = 1.0 / FMath::Pow(DistancesSquared[i], 0.5 * InverseDistancePower);
+		WeightSum += OutWeights[i];
+	}
+
+	for (int32 i = 0; i < NumFound; i++)
+	{
+		OutWeights[i] /= WeightSum;
+	}
+	return NumFound;
+}
+
+int32 FPT_ElectrodeInterpolator::CalculateRadialBasisWeights(const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights) const
+{
+	int32 CenterSlot = 0;
+	double CenterDistanceSquared = 0.0;
+	this->FindNearestElectrodes(InPoint, 1, &CenterSlot, &CenterDistanceSquared);
+
+	if (!this->StencilValid[CenterSlot])
+	{
+		return this->CalculateInverseDistanceWeights(InPoint, OutElectrodeIndices, OutWeights);
+	}
+
+	// The cardinal weights are the precomputed inverse applied to the kernel vector of the query point
+	const int32 Size = this->StencilSize;
+	const int32 SystemSize = Size + 1;
+	const int32* Slots = this->StencilSlots.GetData() + CenterSlot * Size;
+	const double* Inverse = this->StencilInverses.GetData() + CenterSlot * SystemSize * SystemSize;
+	const double Shape = this->StencilShapes[CenterSlot];
+
+	double Kernel[MaxNeighborCount + 1];
+	for (int32 j = 0; j < Size; j++)
+	{
+		Kernel[j] = EvaluateRadialKernel(FVector::DistSquared(InPoint, this->GetPosition(Slots[j])), Shape);
+	}
+	Kernel[Size] = 1.0;
+
+	for (int32 i = 0; i < Size; i++)
+	{
+		const double* Row = Inverse + i * SystemSize;
+		double Weight = 0.0;
+		for (int32 j = 0; j < SystemSize; j++)
+		{
+			Weight += Row[j] * Kernel[j];
+		}
+		OutElectrodeIndices[i] = this->ElectrodeIndices[Slots[i]];
+		OutWeights[i] = Weight;
+	}
+	return Size;
+}
+
+int32 FPT_ElectrodeInterpolator::CalculateBilinearWeights(const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights) const
+{
+	// Fractional lattice coordinates, points outside of the grid are clamped to its border
+	const FVector Offset = InPoint - this->GridOrigin;
+	const double U = FMath::Clamp(FVector::DotProduct(Offset, this->GridAxisU) / this->GridStep, 0.0, (double)(this->GridColumns - 1));
+	const double V = FMath::Clamp(FVector::DotProduct(Offset, this->GridAxisV) / this->GridStep, 0.0, (double)(this->GridRows - 1));
+
+	const int32 Column = FMath::Min(FMath::FloorToInt32(U), FMath::Max(this->GridColumns - 2, 0));
+	const int32 Row = FMath::Min(FMath::FloorToInt32(V), FMath::Max(this->GridRows - 2, 0));
+	const double S = U - Column;
+	const double T = V - Row;
+
+	const int32 CornerColumns[4] = { Column, Column + 1, Column, Column + 1 };
+	const int32 CornerRows[4] = { Row, Row, Row + 1, Row + 1 };
+	const double CornerWeights[4] = { (1.0 - S) * (1.0 - T), S * (1.0 - T), (1.0 - S) * T, S * T };
+
+	// Missing corners (failed simulations) are dropped and the remaining weights renormalized
+	int32 NumWeights = 0;
+	double WeightSum = 0.0;
+	for (int32 Corner = 0; Corner < 4; Corner++)
+	{
+		if (CornerColumns[Corner] >= this->GridColumns || CornerRows[Corner] >= this->GridRows || CornerWeights[Corner] <= 0.0)
+		{
+			continue;
+		}
+
+		const int32 Slot = this->GridSlots[CornerRows[Corner] * this->GridColumns + CornerColumns[Corner]];
+		if (Slot == INDEX_NONE)
+		{
+			continue;
+		}
+
+		OutElectrodeIndices[NumWeights] = this->ElectrodeIndices[Slot];
+		OutWeights[NumWeights] = CornerWeights[Corner];
+		WeightSum += CornerWeights[Corner];
+		NumWeights++;
+	}
+
+	if (NumWeights == 0 || WeightSum <= UE_DOUBLE_SMALL_NUMBER)
+	{
+		return this->CalculateInverseDistanceWeights(InPoint, OutElectrodeIndices, OutWeights);
+	}
+
+	for (int32 i = 0; i < NumWeights; i++)
+	{
+		OutWeights[i] /= WeightSum;
+	}
+	return NumWeights;
+}
@@ -0,0 +1,272 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_ElectrodeInterpolator.h
+ * @brief Header file for the FPT_ElectrodeInterpolator class.
+ *
+ * This file contains the declaration of the FPT_ElectrodeInterpolator class, which calculates the electrode weights
+ * used to blend the simulation data of several electrodes at an arbitrary position on the electrode area.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PT_EnumContainer.h"
+#include "PT_ElectrodeSpatialIndex.h"
+#include "PT_ElectrodeTriangulation.h"
+
+/**
+ * @class FPT_ElectrodeInterpolator
+ * @brief Calculates interpolation weights between the successfully simulated electrodes.
+ *
+ * The interpolator is built once per electrode set. All weight queries are const and can be issued from several threads
+ * at the same time. The returned electrode indices refer to the original electrode numbering, so they can be passed
+ * directly to the simulation component. Neighbor queries go through a k-d tree over the electrode positions, the
+ * barycentric mode locates the enclosing triangle of a Delaunay triangulation of the electrodes.
+ */
+class PLANNINGTOOL_ET_API FPT_ElectrodeInterpolator
+{
+public:
+	/** @brief Upper bound of the number of electrodes blended by a single query. */
+	static constexpr int32 MaxNeighborCount = 32;
+
+	/**
+	 * @brief Builds the interpolator for a set of electrodes.
+	 *
+	 * For the radial basis mode a local stencil is set up around every electrode and its augmented kernel matrix is
+	 * inverted once, so a query only has to evaluate the kernel and multiply with the precomputed inverse.
+	 *
+	 * @param InElectrodePositions The positions of all electrodes.
+	 * @param InValidElectrodeIndices The indices of the electrodes to use. If empty, all electrodes are used.
+	 * @param InNeighborCount The number of electrodes blended in the inverse distance and radial basis modes.
+	 */
+	void Build(const TArray<FVector>& InElectrodePositions, const TArray<int32>& InValidElectrodeIndices, const int32 InNeighborCount);
+
+	/**
+	 * @brief Builds the interpolator from another one, leaving out a single electrode.
+	 *
+	 * Used to predict an electrode from its neighbors. Only the radial basis stencils containing the excluded electrode
+	 * are rebuilt, all others are taken over from the source. The lattice of the bilinear mode is taken over unchanged,
+	 * apart from the node of the excluded electrode, see CalculateBilinearWeightsWithout() for predicting that node.
+	 *
+	 * @param InSource The interpolator holding all electrodes.
+	 * @param InExcludedElectrodeIndex The index of the electrode to leave out.
+	 */
+	void BuildWithout(const FPT_ElectrodeInterpolator& InSource, const int32 InExcludedElectrodeIndex);
+
+	/**
+	 * @brief Sets up the rectangular electrode lattice used by the bilinear mode. Has to be called after Build().
+	 *
+	 * The lattice axes are taken from the grid corner points, every electrode is snapped to its row and column by
+	 * projecting it onto the grid plane. A point then finds its enclosing cell in constant time.
+	 *
+	 * @param InCornerPoints The four corner points of the electrode grid.
+	 * @param InCellSize The distance between neighboring electrodes. If not positive, it is estimated from the electrodes.
+	 * @param InRows The expected number of rows, only used for validation.
+	 * @param InColumns The expected number of columns, only used for validation.
+	 * @return True if the lattice could be set up.
+	 */
+	bool BuildGrid(const TArray<FVector>& InCornerPoints, const double InCellSize, const int32 InRows, const int32 InColumns);
+
+	/**
+	 * @brief Calculates an orthonormal frame of the grid plane from the four grid corner points.
+	 * @param InCornerPoints The four corner points of the electrode grid, in any order.
+	 * @param OutOrigin The first corner point.
+	 * @param OutAxisU The unit vector along the first grid edge.
+	 * @param OutAxisV The unit vector along the second grid edge, orthogonal to OutAxisU.
+	 * @param OutLengthU The length of the grid along OutAxisU.
+	 * @param OutLengthV The length of the grid along OutAxisV.
+	 * @return True if the corner points span a plane.
+	 */
+	static bool CalculateGridAxes(const TArray<FVector>& InCornerPoints, FVector& OutOrigin, FVector& OutAxisU, FVector& OutAxisV, double& OutLengthU, double& OutLengthV);
+
+	/**
+	 * @brief Releases all data.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Calculates the interpolation weights for a point.
+	 * @param InMode The interpolation mode.
+	 * @param InPoint The point to interpolate at.
+	 * @param OutElectrodeIndices Receives up to MaxNeighborCount electrode indices.
+	 * @param OutWeights Receives the weight of every returned electrode. The weights sum up to one.
+	 * @param InOutTriangle The triangle of the previous barycentric query, receives the triangle of this one. Optional.
+	 * @return The number of electrodes written, 0 if the interpolator is empty.
+	 */
+	int32 CalculateWeights(const EInterpolationMode InMode, const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights, int32* InOutTriangle = nullptr) const;
+
+	/**
+	 * @brief Calculates the bilinear weights predicting the lattice node of an electrode from the lattice without it.
+	 *
+	 * With the node removed, it lies in the center of the cell spanned by its four diagonal neighbors and takes a
+	 * quarter of each. On the lattice border, where that cell is incomplete, the node is interpolated linearly between
+	 * its two neighbors along the row or the column.
+	 *
+	 * @param InExcludedSlot The internal slot of the electrode to predict.
+	 * @param OutElectrodeIndices Receives up to four electrode indices.
+	 * @param OutWeights Receives the weight of every returned electrode. The weights sum up to one.
+	 * @return The number of electrodes written, 0 if the lattice is not set up or the node has no usable neighbors.
+	 */
+	int32 CalculateBilinearWeightsWithout(const int32 InExcludedSlot, int32* OutElectrodeIndices, double* OutWeights) const;
+
+	/**
+	 * @brief Finds the nearest electrodes to a point.
+	 * @param InPoint The query point.
+	 * @param InCount The number of electrodes to find.
+	 * @param OutSlots Receives the internal slots of the nearest electrodes, sorted by distance.
+	 * @param OutDistancesSquared Receives the squared distances of the nearest electrodes.
+	 * @return The number of electrodes found.
+	 */
+	int32 FindNearestElectrodes(const FVector& InPoint, const int32 InCount, int32* OutSlots, double* OutDistancesSquared) const;
+
+	/**
+	 * @brief Finds the nearest electrodes to many points in parallel.
+	 * @param InPoints The query points.
+	 * @param InCount The number of electrodes to find per point.
+	 * @param OutSlots Receives the internal slots in [Point * InCount + Neighbor] layout, INDEX_NONE if there are fewer electrodes.
+	 * @param OutDistancesSquared Receives the squared distances in the same layout.
+	 */
+	void FindNearestElectrodesBatch(const TArray<FVector>& InPoints, const int32 InCount, TArray<int32>& OutSlots, TArray<double>& OutDistancesSquared) const;
+
+	/**
+	 * @brief Finds the triangle of the electrode triangulation enclosing a point.
+	 *
+	 * On the lattice of a regular grid the enclosing cell is split along its diagonal, which takes constant time and
+	 * leaves InOutTriangle unchanged. Otherwise, and for cells with missing corners, the triangulation is walked,
+	 * starting at InOutTriangle if it is valid, otherwise at the nearest electrode. Points outside of the triangulated
+	 * area are clamped to its border.
+	 *
+	 * @param InPoint The query point.
+	 * @param OutSlots Receives the internal slots of the three corner electrodes.
+	 * @param OutWeights Receives the non-negative barycentric weights of the corners, summing up to one.
+	 * @param InOutTriangle The triangle of the previous query, receives the found triangle. Optional.
+	 * @return True if the point lies inside the triangulated area, false if it was clamped or there is no triangulation.
+	 */
+	bool FindEnclosingTriangle(const FVector& InPoint, int32* OutSlots, double* OutWeights, int32* InOutTriangle = nullptr) const;
+
+	/**
+	 * @brief Calculates the barycentric weights of many points in parallel, in structure of arrays layout.
+	 * @param InPoints The query points, e.g. a drag trajectory or a lattice sweep in its natural order.
+	 * @param OutTriangles Receives the enclosing triangle of every point, see GetTriangleElectrodeIndices().
+	 * @param OutWeightsA Receives the weight of the first corner electrode of every point.
+	 * @param OutWeightsB Receives the weight of the second corner electrode of every point.
+	 * @param OutWeightsC Receives the weight of the third corner electrode of every point.
+	 * @return False if there is no triangulation.
+	 */
+	bool CalculateBarycentricWeightsBatch(const TArray<FVector>& InPoints, TArray<int32>& OutTriangles, TArray<double>& OutWeightsA, TArray<double>& OutWeightsB, TArray<double>& OutWeightsC) const;
+
+	/** @brief Gets the electrode indices of the three corners of a triangle of the triangulation. */
+	void GetTriangleElectrodeIndices(const int32 InTriangle, int32* OutElectrodeIndices) const;
+
+	/** @brief Gets the Delaunay triangulation of the electrodes, its vertices are slots. */
+	const FPT_ElectrodeTriangulation& GetTriangulation() const { return this->Triangulation; }
+
+	/** @brief Whether the interpolator holds at least one electrode. */
+	bool IsBuilt() const { return this->ElectrodeIndices.Num() > 0; }
+
+	/** @brief Gets the number of electrodes used by the interpolator. */
+	int32 GetNumElectrodes() const { return this->ElectrodeIndices.Num(); }
+
+	/** @brief Gets the number of electrodes blended in the inverse distance and radial basis modes. */
+	int32 GetNeighborCount() const { return this->NeighborCount; }
+
+	/** @brief Whether the lattice of the bilinear mode is set up. */
+	bool IsGridBuilt() const { return this->GridSlots.Num() > 0; }
+
+	/** @brief Gets the number of lattice rows, 0 if the lattice is not set up. */
+	int32 GetGridRows() const { return this->GridRows; }
+
+	/** @brief Gets the number of lattice columns, 0 if the lattice is not set up. */
+	int32 GetGridColumns() const { return this->GridColumns; }
+
+	/** @brief Gets the slot at every lattice node, [Row * Columns + Column], INDEX_NONE for empty nodes. */
+	const TArray<int32>& GetGridSlots() const { return this->GridSlots; }
+
+	/** @brief Gets the electrode index stored in an internal slot. */
+	int32 GetElectrodeIndex(const int32 InSlot) const { return this->ElectrodeIndices[InSlot]; }
+
+	/** @brief Gets the position of the electrode stored in an internal slot. */
+	FVector GetPosition(const int32 InSlot) const { return FVector(this->PositionX[InSlot], this->PositionY[InSlot], this->PositionZ[InSlot]); }
+
+private:
+	/**
+	 * @brief Finds the enclosing triangle on the lattice of a regular grid by splitting the cell along its diagonal.
+	 * @return False if no grid is built, the point lies outside of the lattice or a corner of its cell is missing.
+	 */
+	bool FindLatticeTriangle(const FVector& InPoint, int32* OutSlots, double* OutWeights) const;
+
+	/** @brief Barycentric weights of the corners of the enclosing triangle. */
+	int32 CalculateBarycentricWeights(const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights, int32* InOutTriangle) const;
+
+	/** @brief Inverse distance weights of the nearest electrodes. */
+	int32 CalculateInverseDistanceWeights(const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights) const;
+
+	/** @brief Radial basis weights from the precomputed stencil of the nearest electrode. */
+	int32 CalculateRadialBasisWeights(const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights) const;
+
+	/** @brief Bilinear weights of the corner electrodes of the enclosing lattice cell. */
+	int32 CalculateBilinearWeights(const FVector& InPoint, int32* OutElectrodeIndices, double* OutWeights) const;
+
+	/** @brief Builds the k-d tree and the triangulation over the electrode positions. */
+	void BuildSearchStructures();
+
+	/** @brief Builds the radial basis stencils of all electrodes in parallel. */
+	void BuildRadialBasisStencils();
+
+	/** @brief Builds and inverts the radial basis stencil of one electrode. */
+	void BuildRadialBasisStencil(const int32 InSlot);
+
+	/** @brief Electrode positions in structure of arrays layout. */
+	TArray<double> PositionX;
+	TArray<double> PositionY;
+	TArray<double> PositionZ;
+
+	/** @brief Original electrode index per slot. */
+	TArray<int32> ElectrodeIndices;
+
+	/** @brief k-d tree over the electrode positions, its indices are slots. */
+	FPT_ElectrodeSpatialIndex SpatialIndex;
+
+	/** @brief Delaunay triangulation of the electrode positions, its vertices are slots. */
+	FPT_ElectrodeTriangulation Triangulation;
+
+	/** @brief Number of electrodes blended in the inverse distance and radial basis modes. */
+	int32 NeighborCount = 0;
+
+	/** @brief Stencil size of the radial basis mode (NeighborCount clamped to the number of electrodes). */
+	int32 StencilSize = 0;
+
+	/** @brief Slots of the radial basis stencil per electrode, [Slot][StencilSize]. */
+	TArray<int32> StencilSlots;
+
+	/** @brief Inverse of the augmented kernel matrix per electrode, [Slot][(StencilSize + 1)^2]. */
+	TArray<double> StencilInverses;
+
+	/** @brief Kernel shape parameter per electrode. */
+	TArray<double> StencilShapes;
+
+	/** @brief Whether the stencil of an electrode could be inverted. */
+	TArray<bool> StencilValid;
+
+	/** @brief Position of lattice row 0, column 0. */
+	FVector GridOrigin = FVector::ZeroVector;
+
+	/** @brief Unit vector along the lattice columns. */
+	FVector GridAxisU = FVector::ForwardVector;
+
+	/** @brief Unit vector along the lattice rows. */
+	FVector GridAxisV = FVector::RightVector;
+
+	/** @brief Distance between neighboring lattice nodes. */
+	double GridStep = 0.0;
+
+	/** @brief Number of lattice columns. */
+	int32 GridColumns = 0;
+
+	/** @brief Number of lattice rows. */
+	int32 GridRows = 0;
+
+	/** @brief Slot of the electrode at every lattice node, [Row * GridColumns + Column], INDEX_NONE if empty. */
+	TArray<int32> GridSlots;
+};
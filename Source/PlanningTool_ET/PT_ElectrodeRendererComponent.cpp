@@ -0,0 +1,153 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_ElectrodeRendererComponent.h"
+#include "UObject/ConstructorHelpers.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/MaterialInterface.h"
+
+UPT_ElectrodeRendererComponent::UPT_ElectrodeRendererComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	this->NumCustomDataFloats = 2;
+	this->SetMobility(EComponentMobility::Movable);
+	this->SetCastShadow(false);
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> DefaultMesh(TEXT("/Engine/BasicShapes/Sphere.Sphere"));
+	static ConstructorHelpers::FObjectFinder<UMaterialInterface> DefaultMaterial(TEXT("/Engine/BasicShapes/BasicShapeMaterial.BasicShapeMaterial"));
+	if (DefaultMesh.Succeeded())
+	{
+		this->SetStaticMesh(DefaultMesh.Object);
+	}
+	if (DefaultMaterial.Succeeded())
+	{
+		this->SetMaterial(0, DefaultMaterial.Object);
+	}
+}
+
+void UPT_ElectrodeRendererComponent::AttachToOwnerRoot()
+{
+	AActor* Owner = this->GetOwner();
+	if (!Owner)
+	{
+		return;
+	}
+
+	USceneComponent* Root = Owner->GetRootComponent();
+	if (!Root)
+	{
+		Owner->SetRootComponent(this);
+	}
+	else if (Root != this && this->GetAttachParent() != Root)
+	{
+		// The instances are placed in world space, so the relative transform of the renderer does not move them
+		this->AttachToComponent(Root, FAttachmentTransformRules::KeepRelativeTransform);
+	}
+}
+
+void UPT_ElectrodeRendererComponent::SetElectrodePositions(const TArray<FVector>& InElectrodePositions)
+{
+	if (!this->GetStaticMesh())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_ElectrodeRendererComponent::SetElectrodePositions] No electrode mesh is set, the electrodes are not drawn!"));
+	}
+
+	TArray<FTransform> Transforms;
+	this->CreateInstanceTransforms(InElectrodePositions, Transforms);
+
+	if (Transforms.Num() == this->GetInstanceCount())
+	{
+		this->BatchUpdateInstancesTransforms(0, Transforms, true, true);
+		return;
+	}
+
+	// New instances start with zeroed custom data, which is pending validation and no selection
+	this->ClearInstances();
+	this->AddInstances(Transforms, false, true);
+}
+
+void UPT_ElectrodeRendererComponent::ClearElectrodes()
+{
+	this->ClearInstances();
+}
+
+void UPT_ElectrodeRendererComponent::SetValidationResult(const TArray<int32>& InSuccessfulElectrodeIndices)
+{
+	const int32 NumInstances = this->GetInstanceCount();
+	TArray<bool> SucceededArray;
+	SucceededArray.Init(false, NumInstances);
+	for (const int32 ElectrodeIndex : InSuccessfulElectrodeIndices)
+	{
+		if (SucceededArray.IsValidIndex(ElectrodeIndex))
+		{
+			SucceededArray[ElectrodeIndex] = true;
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[UPT_ElectrodeRendererComponent::SetValidationResult] Electrode %d is not drawn."), ElectrodeIndex);
+		}
+	}
+
+	for (int32 Instance = 0; Instance < NumInstances; Instance++)
+	{
+		const EElectrodeValidationState State = SucceededArray[Instance] ? EElectrodeValidationState::Succeeded : EElectrodeValidationState::Failed;
+		this->SetCustomDataValue(Instance, ValidationStateDataIndex, (float)State, false);
+	}
+	this->MarkRenderStateDirty();
+}
+
+void UPT_ElectrodeRendererComponent::SetAllValidationStates(const EElectrodeValidationState InState)
+{
+	this->SetCustomDataOfAllInstances(ValidationStateDataIndex, (float)InState);
+}
+
+void UPT_ElectrodeRendererComponent::SetSelectedElectrodes(const TArray<int32>& InElectrodeIndices)
+{
+	const int32 NumInstances = this->GetInstanceCount();
+	TArray<bool> SelectedArray;
+	SelectedArray.Init(false, NumInstances);
+	for (const int32 ElectrodeIndex : InElectrodeIndices)
+	{
+		if (SelectedArray.IsValidIndex(ElectrodeIndex))
+		{
+			SelectedArray[ElectrodeIndex] = true;
+		}
+	}
+
+	// Only instances whose selection changes are written
+	bool bHasChanged = false;
+	for (int32 Instance = 0; Instance < NumInstances; Instance++)
+	{
+		const float Value = SelectedArray[Instance] ? 1.f : 0.f;
+		if (this->PerInstanceSMCustomData[Instance * this->NumCustomDataFloats + SelectionDataIndex] != Value)
+		{
+			this->SetCustomDataValue(Instance, SelectionDataIndex, Value, false);
+			bHasChanged = true;
+		}
+	}
+
+	if (bHasChanged)
+	{
+		this->MarkRenderStateDirty();
+	}
+}
+
+void UPT_ElectrodeRendererComponent::SetCustomDataOfAllInstances(const int32 InDataIndex, const float InValue)
+{
+	const int32 NumInstances = this->GetInstanceCount();
+	for (int32 Instance = 0; Instance < NumInstances; Instance++)
+	{
+		this->SetCustomDataValue(Instance, InDataIndex, InValue, false);
+	}
+	this->MarkRenderStateDirty();
+}
+
+void UPT_ElectrodeRendererComponent::CreateInstanceTransforms(const TArray<FVector>& InElectrodePositions, TArray<FTransform>& OutTransforms) const
+{
+	OutTransforms.SetNumUninitialized(InElectrodePositions.Num());
+	for (int32 i = 0; i < InElectrodePositions.Num(); i++)
+	{
+		OutTransforms[i] = FTransform(FQuat::Identity, InElectrodePositions[i], FVector(this->ElectrodeScale));
+	}
+}
@@ -0,0 +1,112 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_ElectrodeRendererComponent.h
+ * @brief Header file for the UPT_ElectrodeRendererComponent class.
+ *
+ * This file contains the declaration of the UPT_ElectrodeRendererComponent class, which draws all electrodes of a grid
+ * as instances of one static mesh.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "PT_EnumContainer.h"
+#include "PT_ElectrodeRendererComponent.generated.h"
+
+/**
+ * @class UPT_ElectrodeRendererComponent
+ * @brief Draws the electrodes of a grid as instances of one static mesh.
+ *
+ * All electrodes share one draw call regardless of their number. Every instance carries two custom data floats the
+ * electrode material reads with PerInstanceCustomData: index 0 holds the EElectrodeValidationState and index 1 is 1 for
+ * selected electrodes, 0 otherwise. Setting positions for the same number of electrodes, e.g. while the grid is
+ * moved, updates all instance transforms in one batch. State changes write the custom data of all affected instances
+ * and mark the render state dirty once.
+ *
+ * The engine sphere with the basic shape material is drawn by default; Blueprints set the electrode mesh and a
+ * material reading the custom data via SetStaticMesh and SetMaterial. The component is not the root of its owner, the
+ * owner attaches it to its root in OnConstruction via AttachToOwnerRoot.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class PLANNINGTOOL_ET_API UPT_ElectrodeRendererComponent : public UInstancedStaticMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * @brief Sets default values for this component's properties.
+	 */
+	UPT_ElectrodeRendererComponent();
+
+	/**
+	 * @brief Attaches the renderer to the root component of its owner, or makes it the root of an owner without one.
+	 *
+	 * Called from the OnConstruction of the owner, when the components of its Blueprint exist, so the root and the
+	 * serialized hierarchy of existing Blueprint subclasses stay unchanged.
+	 */
+	void AttachToOwnerRoot();
+
+	/**
+	 * @brief Places one instance per electrode.
+	 *
+	 * If the number of electrodes is unchanged, the instance transforms are updated in one batch and the custom data is
+	 * kept. Otherwise the instances are recreated with pending validation and no selection.
+	 *
+	 * @param InElectrodePositions The electrode positions in world space.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_RENDERER")
+	void SetElectrodePositions(const TArray<FVector>& InElectrodePositions);
+
+	/**
+	 * @brief Removes all instances.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_RENDERER")
+	void ClearElectrodes();
+
+	/**
+	 * @brief Marks the successfully simulated electrodes as succeeded and all others as failed.
+	 * @param InSuccessfulElectrodeIndices The indices of the successfully simulated electrodes.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_RENDERER")
+	void SetValidationResult(const TArray<int32>& InSuccessfulElectrodeIndices);
+
+	/**
+	 * @brief Sets the validation state of all electrodes.
+	 * @param InState The validation state.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_RENDERER")
+	void SetAllValidationStates(const EElectrodeValidationState InState);
+
+	/**
+	 * @brief Selects a set of electrodes, deselecting all others.
+	 * @param InElectrodeIndices The indices of the selected electrodes.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "ELECTRODE_RENDERER")
+	void SetSelectedElectrodes(const TArray<int32>& InElectrodeIndices);
+
+	/**
+	 * @brief Gets the number of drawn electrodes.
+	 * @return The number of instances.
+	 */
+	UFUNCTION(BlueprintPure, Category = "ELECTRODE_RENDERER")
+	int32 GetElectrodeCount() const { return this->GetInstanceCount(); }
+
+	/** @brief The uniform scale of every electrode instance. The default engine sphere has a diameter of 100 units. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "ELECTRODE_RENDERER")
+	float ElectrodeScale = 1.f;
+
+	/** @brief Index of the custom data float holding the validation state. */
+	static constexpr int32 ValidationStateDataIndex = 0;
+
+	/** @brief Index of the custom data float holding the selection. */
+	static constexpr int32 SelectionDataIndex = 1;
+
+private:
+	/** @brief Writes one custom data float of all instances and marks the render state dirty. */
+	void SetCustomDataOfAllInstances(const int32 InDataIndex, const float InValue);
+
+	/** @brief Builds the instance transforms of electrode positions in world space. */
+	void CreateInstanceTransforms(const TArray<FVector>& InElectrodePositions, TArray<FTransform>& OutTransforms) const;
+};
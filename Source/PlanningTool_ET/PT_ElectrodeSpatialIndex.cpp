@@ -0,0 +1,158 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_ElectrodeSpatialIndex.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+
+/** A point with its index while the tree is built. */
+struct FSpatialIndexPoint
+{
+	FVector Position;
+	int32 Index;
+};
+
+/** Reorders a range of points into a subtree and records the splitting axis of its median. */
+static void BuildSubtree(TArrayView<FSpatialIndexPoint> InOutPoints, uint8* OutAxes)
+{
+	const int32 Num = InOutPoints.Num();
+	if (Num <= 1)
+	{
+		return;
+	}
+
+	FVector Minimum(UE_DOUBLE_BIG_NUMBER);
+	FVector Maximum(-UE_DOUBLE_BIG_NUMBER);
+	for (const FSpatialIndexPoint& Point : InOutPoints)
+	{
+		Minimum = Minimum.ComponentMin(Point.Position);
+		Maximum = Maximum.ComponentMax(Point.Position);
+	}
+
+	const FVector Extent = Maximum - Minimum;
+	const uint8 Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z) ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+	Algo::Sort(InOutPoints, [Axis](const FSpatialIndexPoint& A, const FSpatialIndexPoint& B) { return A.Position[Axis] < B.Position[Axis]; });
+
+	const int32 Median = Num / 2;
+	OutAxes[Median] = Axis;
+	BuildSubtree(InOutPoints.Slice(0, Median), OutAxes);
+	BuildSubtree(InOutPoints.Slice(Median + 1, Num - Median - 1), OutAxes + Median + 1);
+}
+
+/** Inserts a candidate into a list of at most InCount candidates sorted by distance. */
+static FORCEINLINE void InsertCandidate(const int32 InIndex, const double InDistanceSquared, const int32 InCount, int32& InOutNumFound, int32* OutIndices, double* OutDistancesSquared)
+{
+	if (InOutNumFound == InCount && InDistanceSquared >= OutDistancesSquared[InCount - 1])
+	{
+		return;
+	}
+
+	int32 Position = (InOutNumFound < InCount) ? InOutNumFound++ : InCount - 1;
+	while (Position > 0 && OutDistancesSquared[Position - 1] > InDistanceSquared)
+	{
+		OutDistancesSquared[Position] = OutDistancesSquared[Position - 1];
+		OutIndices[Position] = OutIndices[Position - 1];
+		Position--;
+	}
+	OutDistancesSquared[Position] = InDistanceSquared;
+	OutIndices[Position] = InIndex;
+}
+
+void FPT_ElectrodeSpatialIndex::Build(const TArray<FVector>& InPositions)
+{
+	this->Reset();
+
+	const int32 NumPoints = InPositions.Num();
+	TArray<FSpatialIndexPoint> Points;
+	Points.SetNumUninitialized(NumPoints);
+	for (int32 Index = 0; Index < NumPoints; Index++)
+	{
+		Points[Index] = { InPositions[Index], Index };
+	}
+
+	this->NodeAxes.SetNumZeroed(NumPoints);
+	BuildSubtree(Points, this->NodeAxes.GetData());
+
+	this->NodeCoordinates.SetNumUninitialized(NumPoints * 3);
+	this->NodeIndices.SetNumUninitialized(NumPoints);
+	for (int32 Node = 0; Node < NumPoints; Node++)
+	{
+		this->NodeCoordinates[Node * 3 + 0] = Points[Node].Position.X;
+		this->NodeCoordinates[Node * 3 + 1] = Points[Node].Position.Y;
+		this->NodeCoordinates[Node * 3 + 2] = Points[Node].Position.Z;
+		this->NodeIndices[Node] = Points[Node].Index;
+	}
+}
+
+void FPT_ElectrodeSpatialIndex::Reset()
+{
+	this->NodeCoordinates.Empty();
+	this->NodeIndices.Empty();
+	this->NodeAxes.Empty();
+}
+
+int32 FPT_ElectrodeSpatialIndex::FindNearest(const FVector& InPoint, const int32 InCount, int32* OutIndices, double* OutDistancesSquared) const
+{
+	const int32 Count = FMath::Min(InCount, this->Num());
+	if (Count <= 0)
+	{
+		return 0;
+	}
+
+	const double Point[3] = { InPoint.X, InPoint.Y, InPoint.Z };
+	int32 NumFound = 0;
+	this->SearchRange(0, this->Num(), Point, Count, NumFound, OutIndices, OutDistancesSquared);
+	return NumFound;
+}
+
+void FPT_ElectrodeSpatialIndex::SearchRange(const int32 InBegin, const int32 InEnd, const double* InPoint, const int32 InCount, int32& InOutNumFound, int32* OutIndices, double* OutDistancesSquared) const
+{
+	if (InBegin >= InEnd)
+	{
+		return;
+	}
+
+	const int32 Median = InBegin + (InEnd - InBegin) / 2;
+	const double* Coordinates = this->NodeCoordinates.GetData() + Median * 3;
+	const double DX = Coordinates[0] - InPoint[0];
+	const double DY = Coordinates[1] - InPoint[1];
+	const double DZ = Coordinates[2] - InPoint[2];
+	InsertCandidate(this->NodeIndices[Median], DX * DX + DY * DY + DZ * DZ, InCount, InOutNumFound, OutIndices, OutDistancesSquared);
+
+	// The far side only has to be visited if the splitting plane is closer than the current farthest candidate
+	const uint8 Axis = this->NodeAxes[Median];
+	const double PlaneDistance = InPoint[Axis] - Coordinates[Axis];
+	if (PlaneDistance < 0.0)
+	{
+		this->SearchRange(InBegin, Median, InPoint, InCount, InOutNumFound, OutIndices, OutDistancesSquared);
+		if (InOutNumFound < InCount || PlaneDistance * PlaneDistance < OutDistancesSquared[InCount - 1])
+		{
+			this->SearchRange(Median + 1, InEnd, InPoint, InCount, InOutNumFound, OutIndices, OutDistancesSquared);
+		}
+	}
+	else
+	{
+		this->SearchRange(Median + 1, InEnd, InPoint, InCount, InOutNumFound, OutIndices, OutDistancesSquared);
+		if (InOutNumFound < InCount || PlaneDistance * PlaneDistance < OutDistancesSquared[InCount - 1])
+		{
+			this->SearchRange(InBegin, Median, InPoint, InCount, InOutNumFound, OutIndices, OutDistancesSquared);
+		}
+	}
+}
+
+void FPT_ElectrodeSpatialIndex::FindNearestBatch(const TArray<FVector>& InPoints, const int32 InCount, TArray<int32>& OutIndices, TArray<double>& OutDistancesSquared) const
+{
+	const int32 Count = FMath::Max(InCount, 0);
+	OutIndices.Init(INDEX_NONE, InPoints.Num() * Count);
+	OutDistancesSquared.Init(UE_DOUBLE_BIG_NUMBER, InPoints.Num() * Count);
+
+	if (Count == 0 || !this->IsBuilt())
+	{
+		return;
+	}
+
+	ParallelFor(InPoints.Num(), [this, &InPoints, Count, &OutIndices, &OutDistancesSquared](const int32 PointIndex)
+	{
+		this->FindNearest(InPoints[PointIndex], Count, OutIndices.GetData() + PointIndex * Count, OutDistancesSquared.GetData() + PointIndex * Count);
+	});
+}
@@ -0,0 +1,75 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_ElectrodeSpatialIndex.h
+ * @brief Header file for the FPT_ElectrodeSpatialIndex class.
+ *
+ * This file contains the declaration of the FPT_ElectrodeSpatialIndex class, a k-d tree over the electrode positions
+ * that answers nearest neighbor queries in logarithmic time.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @class FPT_ElectrodeSpatialIndex
+ * @brief A balanced k-d tree over a set of electrode positions.
+ *
+ * The tree is stored implicitly: the points are reordered so that the median of every index range is the splitting
+ * node of that range, its left half holds the smaller and its right half the larger coordinates along the splitting
+ * axis. The index is built once per electrode set, all queries are const and can be issued from several threads at
+ * the same time. The returned indices refer to the order of the positions passed to Build().
+ */
+class PLANNINGTOOL_ET_API FPT_ElectrodeSpatialIndex
+{
+public:
+	/**
+	 * @brief Builds the tree. Every range is split along the axis of its largest extent.
+	 * @param InPositions The positions to index.
+	 */
+	void Build(const TArray<FVector>& InPositions);
+
+	/**
+	 * @brief Releases all data.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Finds the nearest points to a query point.
+	 * @param InPoint The query point.
+	 * @param InCount The number of points to find.
+	 * @param OutIndices Receives the indices of the nearest points, sorted by distance. Has to hold InCount entries.
+	 * @param OutDistancesSquared Receives the squared distances of the nearest points. Has to hold InCount entries.
+	 * @return The number of points found, InCount clamped to the number of indexed points.
+	 */
+	int32 FindNearest(const FVector& InPoint, const int32 InCount, int32* OutIndices, double* OutDistancesSquared) const;
+
+	/**
+	 * @brief Finds the nearest points to many query points in parallel.
+	 * @param InPoints The query points.
+	 * @param InCount The number of points to find per query point.
+	 * @param OutIndices Receives the indices in [Point * InCount + Neighbor] layout, INDEX_NONE past the number of indexed points.
+	 * @param OutDistancesSquared Receives the squared distances in the same layout.
+	 */
+	void FindNearestBatch(const TArray<FVector>& InPoints, const int32 InCount, TArray<int32>& OutIndices, TArray<double>& OutDistancesSquared) const;
+
+	/** @brief Whether the tree holds at least one point. */
+	bool IsBuilt() const { return this->NodeIndices.Num() > 0; }
+
+	/** @brief Gets the number of indexed points. */
+	int32 Num() const { return this->NodeIndices.Num(); }
+
+private:
+	/** @brief Descends into the subtree of the range [InBegin, InEnd), near side first. */
+	void SearchRange(const int32 InBegin, const int32 InEnd, const double* InPoint, const int32 InCount, int32& InOutNumFound, int32* OutIndices, double* OutDistancesSquared) const;
+
+	/** @brief Point coordinates in tree order, [Node * 3 + Axis]. */
+	TArray<double> NodeCoordinates;
+
+	/** @brief Index passed to Build() per node. */
+	TArray<int32> NodeIndices;
+
+	/** @brief Splitting axis per node, only meaningful for the median node of a range. */
+	TArray<uint8> NodeAxes;
+};
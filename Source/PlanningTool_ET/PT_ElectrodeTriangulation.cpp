@@ -0,0 +1,548 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_ElectrodeTriangulation.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+
+/** Twice the signed area of the triangle (A, B, C), positive if counterclockwise. */
+static FORCEINLINE double Orient(const FVector2D& InA, const FVector2D& InB, const FVector2D& InC)
+{
+	return (InB.X - InA.X) * (InC.Y - InA.Y) - (InB.Y - InA.Y) * (InC.X - InA.X);
+}
+
+/** Positive if D lies inside the circumcircle of the counterclockwise triangle (A, B, C). */
+static FORCEINLINE double InCircle(const FVector2D& InA, const FVector2D& InB, const FVector2D& InC, const FVector2D& InD)
+{
+	const FVector2D A = InA - InD;
+	const FVector2D B = InB - InD;
+	const FVector2D C = InC - InD;
+	return (A.X * A.X + A.Y * A.Y) * (B.X * C.Y - C.X * B.Y)
+		- (B.X * B.X + B.Y * B.Y) * (A.X * C.Y - C.X * A.Y)
+		+ (C.X * C.X + C.Y * C.Y) * (A.X * B.Y - B.X * A.Y);
+}
+
+/** Whether a point lies on the outer side of the edge (A, B) of a counterclockwise triangle, with a tolerance relative to the edge length. */
+static FORCEINLINE bool IsOutsideEdge(const FVector2D& InA, const FVector2D& InB, const FVector2D& InPoint)
+{
+	return Orient(InA, InB, InPoint) < -1e-12 * FVector2D::DistSquared(InA, InB);
+}
+
+/** Dominant eigenvector of a symmetric 3x3 matrix by power iteration, orthogonal to InExcluded if given. */
+static FVector CalculateDominantAxis(const FMatrix& InCovariance, const FVector& InStart, const FVector& InExcluded)
+{
+	FVector Axis = InStart;
+	for (int32 Iteration = 0; Iteration < 64; Iteration++)
+	{
+		Axis -= FVector::DotProduct(Axis, InExcluded) * InExcluded;
+		if (!Axis.Normalize(UE_DOUBLE_SMALL_NUMBER))
+		{
+			return FVector::ZeroVector;
+		}
+		Axis = FVector(InCovariance.TransformVector(Axis));
+	}
+
+	Axis -= FVector::DotProduct(Axis, InExcluded) * InExcluded;
+	return Axis.GetSafeNormal();
+}
+
+bool FPT_ElectrodeTriangulation::FitPlane(const TArray<FVector>& InPositions)
+{
+	FVector Centroid = FVector::ZeroVector;
+	for (const FVector& Position : InPositions)
+	{
+		Centroid += Position;
+	}
+	Centroid /= InPositions.Num();
+
+	FMatrix Covariance(ForceInitToZero);
+	FVector FarthestOffset = FVector::ZeroVector;
+	for (const FVector& Position : InPositions)
+	{
+		const FVector Offset = Position - Centroid;
+		for (int32 Row = 0; Row < 3; Row++)
+		{
+			for (int32 Column = 0; Column < 3; Column++)
+			{
+				Covariance.M[Row][Column] += Offset[Row] * Offset[Column];
+			}
+		}
+
+		if (Offset.SizeSquared() > FarthestOffset.SizeSquared())
+		{
+			FarthestOffset = Offset;
+		}
+	}
+
+	// The plane is spanned by the two directions of the largest spread
+	const FVector AxisU = CalculateDominantAxis(Covariance, FarthestOffset, FVector::ZeroVector);
+	if (AxisU.IsZero())
+	{
+		return false;
+	}
+
+	FVector Perpendicular = FVector::ZeroVector;
+	for (const FVector& Position : InPositions)
+	{
+		const FVector Offset = Position - Centroid;
+		const FVector Candidate = Offset - FVector::DotProduct(Offset, AxisU) * AxisU;
+		if (Candidate.SizeSquared() > Perpendicular.SizeSquared())
+		{
+			Perpendicular = Candidate;
+		}
+	}
+
+	const FVector AxisV = CalculateDominantAxis(Covariance, Perpendicular, AxisU);
+	if (AxisV.IsZero())
+	{
+		return false;
+	}
+
+	this->PlaneOrigin = Centroid;
+	this->PlaneAxisU = AxisU;
+	this->PlaneAxisV = AxisV;
+
+	this->PlanePositions.SetNumUninitialized(InPositions.Num());
+	for (int32 Vertex = 0; Vertex < InPositions.Num(); Vertex++)
+	{
+		this->PlanePositions[Vertex] = this->Project(InPositions[Vertex]);
+	}
+	return true;
+}
+
+bool FPT_ElectrodeTriangulation::Build(const TArray<FVector>& InPositions)
+{
+	this->Reset();
+
+	const int32 NumPoints = InPositions.Num();
+	if (NumPoints < 3 || !this->FitPlane(InPositions))
+	{
+		return false;
+	}
+
+	FVector2D Minimum(UE_DOUBLE_BIG_NUMBER, UE_DOUBLE_BIG_NUMBER);
+	FVector2D Maximum(-UE_DOUBLE_BIG_NUMBER, -UE_DOUBLE_BIG_NUMBER);
+	for (const FVector2D& Position : this->PlanePositions)
+	{
+		Minimum.X = FMath::Min(Minimum.X, Position.X);
+		Minimum.Y = FMath::Min(Minimum.Y, Position.Y);
+		Maximum.X = FMath::Max(Maximum.X, Position.X);
+		Maximum.Y = FMath::Max(Maximum.Y, Position.Y);
+	}
+
+	const double Extent = FMath::Max(Maximum.X - Minimum.X, Maximum.Y - Minimum.Y);
+	if (Extent <= UE_DOUBLE_SMALL_NUMBER)
+	{
+		return false;
+	}
+	const double DuplicateDistanceSquared = FMath::Square(1e-9 * Extent);
+
+	// The points followed by a counterclockwise super triangle enclosing all of them
+	const FVector2D Center = 0.5 * (Minimum + Maximum);
+	TArray<FVector2D> Points = this->PlanePositions;
+	Points.Add(Center + FVector2D(-20.0 * Extent, -10.0 * Extent));
+	Points.Add(Center + FVector2D(20.0 * Extent, -10.0 * Extent));
+	Points.Add(Center + FVector2D(0.0, 20.0 * Extent));
+
+	TArray<FIntVector> Vertices;
+	TArray<FIntVector> Neighbors;
+	TArray<bool> Alive;
+	TArray<int32> CavityStamps;
+	Vertices.Add(FIntVector(NumPoints, NumPoints + 1, NumPoints + 2));
+	Neighbors.Add(FIntVector(INDEX_NONE));
+	Alive.Add(true);
+	CavityStamps.Add(INDEX_NONE);
+
+	// Sorted insertion keeps consecutive points close, so every walk only crosses a few triangles
+	TArray<int32> InsertionOrder;
+	InsertionOrder.SetNumUninitialized(NumPoints);
+	for (int32 Vertex = 0; Vertex < NumPoints; Vertex++)
+	{
+		InsertionOrder[Vertex] = Vertex;
+	}
+	Algo::Sort(InsertionOrder, [&Points](const int32 A, const int32 B) { return Points[A].X < Points[B].X || (Points[A].X == Points[B].X && Points[A].Y < Points[B].Y); });
+
+	this->VertexTriangles.Init(INDEX_NONE, NumPoints);
+	TArray<int32> Cavity;
+	TArray<int32> NewTriangles;
+	int32 LastTriangle = 0;
+
+	for (const int32 Vertex : InsertionOrder)
+	{
+		const FVector2D& Point = Points[Vertex];
+
+		// Walk to the triangle containing the point, it always lies inside the super triangle
+		int32 Triangle = LastTriangle;
+		for (int32 Step = 0; Step < Vertices.Num(); Step++)
+		{
+			bool bHasMoved = false;
+			for (int32 k = 0; k < 3; k++)
+			{
+				const int32 Edge = (k + Step) % 3;
+				const FIntVector& Corners = Vertices[Triangle];
+				if (Neighbors[Triangle][Edge] != INDEX_NONE && IsOutsideEdge(Points[Corners[(Edge + 1) % 3]], Points[Corners[(Edge + 2) % 3]], Point))
+				{
+					Triangle = Neighbors[Triangle][Edge];
+					bHasMoved = true;
+					break;
+				}
+			}
+
+			if (!bHasMoved)
+			{
+				break;
+			}
+		}
+
+		const FIntVector& Corners = Vertices[Triangle];
+		if (FVector2D::DistSquared(Point, Points[Corners.X]) <= DuplicateDistanceSquared
+			|| FVector2D::DistSquared(Point, Points[Corners.Y]) <= DuplicateDistanceSquared
+			|| FVector2D::DistSquared(Point, Points[Corners.Z]) <= DuplicateDistanceSquared)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[FPT_ElectrodeTriangulation::Build] Point %d duplicates another point, leaving it out."), Vertex);
+			continue;
+		}
+
+		// The triangles whose circumcircle contains the point form a connected cavity around it
+		Cavity.Reset();
+		Cavity.Add(Triangle);
+		CavityStamps[Triangle] = Vertex;
+		for (int32 CavityIndex = 0; CavityIndex < Cavity.Num(); CavityIndex++)
+		{
+			for (int32 Edge = 0; Edge < 3; Edge++)
+			{
+				const int32 Neighbor = Neighbors[Cavity[CavityIndex]][Edge];
+				if (Neighbor == INDEX_NONE || CavityStamps[Neighbor] == Vertex)
+				{
+					continue;
+				}
+
+				const FIntVector& NeighborCorners = Vertices[Neighbor];
+				if (InCircle(Points[NeighborCorners.X], Points[NeighborCorners.Y], Points[NeighborCorners.Z], Point) > 0.0)
+				{
+					CavityStamps[Neighbor] = Vertex;
+					Cavity.Add(Neighbor);
+				}
+			}
+		}
+
+		// Every boundary edge of the cavity forms a new triangle with the point
+		NewTriangles.Reset();
+		for (const int32 CavityTriangle : Cavity)
+		{
+			Alive[CavityTriangle] = false;
+			for (int32 Edge = 0; Edge < 3; Edge++)
+			{
+				const int32 Outside = Neighbors[CavityTriangle][Edge];
+				if (Outside != INDEX_NONE && CavityStamps[Outside] == Vertex)
+				{
+					continue;
+				}
+
+				const int32 NewTriangle = Vertices.Add(FIntVector(Vertices[CavityTriangle][(Edge + 1) % 3], Vertices[CavityTriangle][(Edge + 2) % 3], Vertex));
+				Neighbors.Add(FIntVector(INDEX_NONE, INDEX_NONE, Outside));
+				Alive.Add(true);
+				CavityStamps.Add(INDEX_NONE);
+				NewTriangles.Add(NewTriangle);
+
+				if (Outside != INDEX_NONE)
+				{
+					for (int32 OutsideEdge = 0; OutsideEdge < 3; OutsideEdge++)
+					{
+						if (Neighbors[Outside][OutsideEdge] == CavityTriangle)
+						{
+							Neighbors[Outside][OutsideEdge] = NewTriangle;
+						}
+					}
+				}
+			}
+		}
+
+		// The fan around the point: (A, B, P) is followed by the triangle starting at B
+		for (const int32 NewTriangle : NewTriangles)
+		{
+			for (const int32 NextTriangle : NewTriangles)
+			{
+				if (Vertices[NextTriangle].X == Vertices[NewTriangle].Y)
+				{
+					Neighbors[NewTriangle].X = NextTriangle;
+					Neighbors[NextTriangle].Y = NewTriangle;
+					break;
+				}
+			}
+		}
+
+		LastTriangle = NewTriangles[0];
+	}
+
+	// Keep the triangles between the points, the ones touching the super triangle are dropped
+	TArray<int32> Remap;
+	Remap.Init(INDEX_NONE, Vertices.Num());
+	for (int32 Triangle = 0; Triangle < Vertices.Num(); Triangle++)
+	{
+		if (Alive[Triangle] && Vertices[Triangle].X < NumPoints && Vertices[Triangle].Y < NumPoints && Vertices[Triangle].Z < NumPoints)
+		{
+			Remap[Triangle] = this->TriangleVertices.Add(Vertices[Triangle]);
+		}
+	}
+
+	this->TriangleNeighbors.SetNumUninitialized(this->TriangleVertices.Num());
+	for (int32 Triangle = 0; Triangle < Vertices.Num(); Triangle++)
+	{
+		const int32 NewTriangle = Remap[Triangle];
+		if (NewTriangle == INDEX_NONE)
+		{
+			continue;
+		}
+
+		for (int32 Edge = 0; Edge < 3; Edge++)
+		{
+			const int32 Neighbor = Neighbors[Triangle][Edge];
+			this->TriangleNeighbors[NewTriangle][Edge] = (Neighbor == INDEX_NONE) ? INDEX_NONE : Remap[Neighbor];
+			if (this->TriangleNeighbors[NewTriangle][Edge] == INDEX_NONE)
+			{
+				this->HullEdges.Add(NewTriangle * 3 + Edge);
+			}
+			this->VertexTriangles[Vertices[Triangle][Edge]] = NewTriangle;
+		}
+	}
+
+	if (!this->IsBuilt())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[FPT_ElectrodeTriangulation::Build] The %d points are collinear, no triangle could be built."), NumPoints);
+		this->Reset();
+		return false;
+	}
+
+	// Inverse of the edge basis [B - A, C - A] per triangle, so the weights of a point need no division
+	const int32 NumTriangles = this->GetNumTriangles();
+	this->TriangleOriginX.SetNumUninitialized(NumTriangles);
+	this->TriangleOriginY.SetNumUninitialized(NumTriangles);
+	this->InverseBasisXX.SetNumUninitialized(NumTriangles);
+	this->InverseBasisXY.SetNumUninitialized(NumTriangles);
+	this->InverseBasisYX.SetNumUninitialized(NumTriangles);
+	this->InverseBasisYY.SetNumUninitialized(NumTriangles);
+	for (int32 Triangle = 0; Triangle < NumTriangles; Triangle++)
+	{
+		const FVector2D& A = this->PlanePositions[this->TriangleVertices[Triangle].X];
+		const FVector2D EdgeB = this->PlanePositions[this->TriangleVertices[Triangle].Y] - A;
+		const FVector2D EdgeC = this->PlanePositions[this->TriangleVertices[Triangle].Z] - A;
+		const double InvDeterminant = 1.0 / (EdgeB.X * EdgeC.Y - EdgeC.X * EdgeB.Y);
+
+		this->TriangleOriginX[Triangle] = A.X;
+		this->TriangleOriginY[Triangle] = A.Y;
+		this->InverseBasisXX[Triangle] = EdgeC.Y * InvDeterminant;
+		this->InverseBasisXY[Triangle] = -EdgeC.X * InvDeterminant;
+		this->InverseBasisYX[Triangle] = -EdgeB.Y * InvDeterminant;
+		this->InverseBasisYY[Triangle] = EdgeB.X * InvDeterminant;
+	}
+	return true;
+}
+
+void FPT_ElectrodeTriangulation::Reset()
+{
+	this->PlaneOrigin = FVector::ZeroVector;
+	this->PlaneAxisU = FVector::ForwardVector;
+	this->PlaneAxisV = FVector::RightVector;
+	this->PlanePositions.Empty();
+	this->TriangleVertices.Empty();
+	this->TriangleNeighbors.Empty();
+	this->VertexTriangles.Empty();
+	this->HullEdges.Empty();
+	this->TriangleOriginX.Empty();
+	this->TriangleOriginY.Empty();
+	this->InverseBasisXX.Empty();
+	this->InverseBasisXY.Empty();
+	this->InverseBasisYX.Empty();
+	this->InverseBasisYY.Empty();
+}
+
+int32 FPT_ElectrodeTriangulation::Locate(const FVector& InPoint, const int32 InStartTriangle, const int32 InStartVertex, int32* OutVertices, double* OutWeights, bool& OutIsInside) const
+{
+	OutIsInside = false;
+	if (!this->IsBuilt())
+	{
+		return INDEX_NONE;
+	}
+
+	int32 StartTriangle = InStartTriangle;
+	if (!this->TriangleVertices.IsValidIndex(StartTriangle) && this->VertexTriangles.IsValidIndex(InStartVertex))
+	{
+		StartTriangle = this->VertexTriangles[InStartVertex];
+	}
+
+	const FVector2D Point = this->Project(InPoint);
+	const int32 Triangle = this->Walk(Point, StartTriangle, OutIsInside);
+	if (!OutIsInside)
+	{
+		return this->ClampToHull(Point, OutVertices, OutWeights);
+	}
+
+	this->CalculateWeights(Triangle, Point, OutWeights);
+	for (int32 Corner = 0; Corner < 3; Corner++)
+	{
+		OutVertices[Corner] = this->TriangleVertices[Triangle][Corner];
+	}
+	return Triangle;
+}
+
+void FPT_ElectrodeTriangulation::LocateBatch(const TArray<FVector>& InPoints, TArray<int32>& OutTriangles, TArray<double>& OutWeightsA, TArray<double>& OutWeightsB, TArray<double>& OutWeightsC) const
+{
+	const int32 NumPoints = InPoints.Num();
+	OutTriangles.Init(INDEX_NONE, NumPoints);
+	OutWeightsA.SetNumZeroed(NumPoints);
+	OutWeightsB.SetNumZeroed(NumPoints);
+	OutWeightsC.SetNumZeroed(NumPoints);
+
+	if (!this->IsBuilt())
+	{
+		return;
+	}
+
+	constexpr int32 BlockSize = 256;
+	const int32 NumBlocks = FMath::DivideAndRoundUp(NumPoints, BlockSize);
+	ParallelFor(NumBlocks, [this, &InPoints, NumPoints, &OutTriangles, &OutWeightsA, &OutWeightsB, &OutWeightsC](const int32 Block)
+	{
+		const int32 Begin = Block * BlockSize;
+		const int32 Num = FMath::Min(BlockSize, NumPoints - Begin);
+
+		double PointX[BlockSize];
+		double PointY[BlockSize];
+		bool IsInside[BlockSize];
+		int32* Triangles = OutTriangles.GetData() + Begin;
+
+		// Consecutive points of a trajectory or lattice sweep are close, every walk starts at the previous triangle
+		int32 Triangle = INDEX_NONE;
+		for (int32 i = 0; i < Num; i++)
+		{
+			const FVector2D Point = this->Project(InPoints[Begin + i]);
+			PointX[i] = Point.X;
+			PointY[i] = Point.Y;
+			Triangle = this->Walk(Point, Triangle, IsInside[i]);
+			Triangles[i] = Triangle;
+		}
+
+		// Branch-free weights from the precomputed inverse bases
+		const double* OriginX = this->TriangleOriginX.GetData();
+		const double* OriginY = this->TriangleOriginY.GetData();
+		const double* InverseXX = this->InverseBasisXX.GetData();
+		const double* InverseXY = this->InverseBasisXY.GetData();
+		const double* InverseYX = this->InverseBasisYX.GetData();
+		const double* InverseYY = this->InverseBasisYY.GetData();
+		double* WeightsA = OutWeightsA.GetData() + Begin;
+		double* WeightsB = OutWeightsB.GetData() + Begin;
+		double* WeightsC = OutWeightsC.GetData() + Begin;
+		for (int32 i = 0; i < Num; i++)
+		{
+			const int32 T = Triangles[i];
+			const double DX = PointX[i] - OriginX[T];
+			const double DY = PointY[i] - OriginY[T];
+			const double S = FMath::Max(InverseXX[T] * DX + InverseXY[T] * DY, 0.0);
+			const double U = FMath::Max(InverseYX[T] * DX + InverseYY[T] * DY, 0.0);
+			const double R = FMath::Max(1.0 - S - U, 0.0);
+			const double InvSum = 1.0 / (R + S + U);
+			WeightsA[i] = R * InvSum;
+			WeightsB[i] = S * InvSum;
+			WeightsC[i] = U * InvSum;
+		}
+
+		// Points outside of the hull are clamped to its border
+		for (int32 i = 0; i < Num; i++)
+		{
+			if (!IsInside[i])
+			{
+				int32 Vertices[3];
+				double Weights[3];
+				Triangles[i] = this->ClampToHull(FVector2D(PointX[i], PointY[i]), Vertices, Weights);
+				WeightsA[i] = Weights[0];
+				WeightsB[i] = Weights[1];
+				WeightsC[i] = Weights[2];
+			}
+		}
+	});
+}
+
+int32 FPT_ElectrodeTriangulation::Walk(const FVector2D& InPoint, const int32 InStartTriangle, bool& OutIsInside) const
+{
+	int32 Triangle = this->TriangleVertices.IsValidIndex(InStartTriangle) ? InStartTriangle : 0;
+
+	// Visibility walk, the first tested edge rotates every step so the walk cannot cycle
+	for (int32 Step = 0; Step <= this->GetNumTriangles(); Step++)
+	{
+		const FIntVector& Corners = this->TriangleVertices[Triangle];
+		int32 ExitEdge = INDEX_NONE;
+		for (int32 k = 0; k < 3; k++)
+		{
+			const int32 Edge = (k + Step) % 3;
+			if (IsOutsideEdge(this->PlanePositions[Corners[(Edge + 1) % 3]], this->PlanePositions[Corners[(Edge + 2) % 3]], InPoint))
+			{
+				ExitEdge = Edge;
+				break;
+			}
+		}
+
+		if (ExitEdge == INDEX_NONE)
+		{
+			OutIsInside = true;
+			return Triangle;
+		}
+
+		if (this->TriangleNeighbors[Triangle][ExitEdge] == INDEX_NONE)
+		{
+			break;
+		}
+		Triangle = this->TriangleNeighbors[Triangle][ExitEdge];
+	}
+
+	OutIsInside = false;
+	return Triangle;
+}
+
+void FPT_ElectrodeTriangulation::CalculateWeights(const int32 InTriangle, const FVector2D& InPoint, double* OutWeights) const
+{
+	const double DX = InPoint.X - this->TriangleOriginX[InTriangle];
+	const double DY = InPoint.Y - this->TriangleOriginY[InTriangle];
+	const double S = FMath::Max(this->InverseBasisXX[InTriangle] * DX + this->InverseBasisXY[InTriangle] * DY, 0.0);
+	const double U = FMath::Max(this->InverseBasisYX[InTriangle] * DX + this->InverseBasisYY[InTriangle] * DY, 0.0);
+	const double R = FMath::Max(1.0 - S - U, 0.0);
+	const double InvSum = 1.0 / (R + S + U);
+
+	OutWeights[0] = R * InvSum;
+	OutWeights[1] = S * InvSum;
+	OutWeights[2] = U * InvSum;
+}
+
+int32 FPT_ElectrodeTriangulation::ClampToHull(const FVector2D& InPoint, int32* OutVertices, double* OutWeights) const
+{
+	int32 NearestEdge = this->HullEdges[0];
+	double NearestParameter = 0.0;
+	double NearestDistanceSquared = UE_DOUBLE_BIG_NUMBER;
+
+	for (const int32 HullEdge : this->HullEdges)
+	{
+		const FIntVector& Corners = this->TriangleVertices[HullEdge / 3];
+		const FVector2D& A = this->PlanePositions[Corners[(HullEdge % 3 + 1) % 3]];
+		const FVector2D& B = this->PlanePositions[Corners[(HullEdge % 3 + 2) % 3]];
+		const FVector2D Edge = B - A;
+		const double Parameter = FMath::Clamp(FVector2D::DotProduct(InPoint - A, Edge) / FMath::Max(Edge.SizeSquared(), UE_DOUBLE_SMALL_NUMBER), 0.0, 1.0);
+		const double DistanceSquared = FVector2D::DistSquared(InPoint, A + Parameter * Edge);
+
+		if (DistanceSquared < NearestDistanceSquared)
+		{
+			NearestDistanceSquared = DistanceSquared;
+			NearestEdge = HullEdge;
+			NearestParameter = Parameter;
+		}
+	}
+
+	const int32 Triangle = NearestEdge / 3;
+	const int32 OppositeCorner = NearestEdge % 3;
+	for (int32 Corner = 0; Corner < 3; Corner++)
+	{
+		OutVertices[Corner] = this->TriangleVertices[Triangle][Corner];
+	}
+	OutWeights[OppositeCorner] = 0.0;
+	OutWeights[(OppositeCorner + 1) % 3] = 1.0 - NearestParameter;
+	OutWeights[(OppositeCorner + 2) % 3] = NearestParameter;
+	return Triangle;
+}
@@ -0,0 +1,131 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_ElectrodeTriangulation.h
+ * @brief Header file for the FPT_ElectrodeTriangulation class.
+ *
+ * This file contains the declaration of the FPT_ElectrodeTriangulation class, a Delaunay triangulation of the electrode
+ * positions that locates the triangle enclosing a point on the electrode area.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @class FPT_ElectrodeTriangulation
+ * @brief A Delaunay triangulation of electrode positions projected onto their best fitting plane.
+ *
+ * The triangulation is built incrementally (Bowyer-Watson): every point is located by walking from the last inserted
+ * one, then the triangles whose circumcircle contains it are replaced by a fan around it. Points are located by a
+ * visibility walk across the edges that separate the current triangle from the point. Started at the triangle of the
+ * previous query, consecutive queries of a drag only cross a few edges. Points outside of the convex hull are clamped
+ * to the nearest hull edge, so a query always yields a triangle with non-negative weights. The inverse edge basis of
+ * every triangle is precomputed, so the weights of a located point cost two multiply-adds each.
+ *
+ * All queries are const and can be issued from several threads at the same time.
+ */
+class PLANNINGTOOL_ET_API FPT_ElectrodeTriangulation
+{
+public:
+	/**
+	 * @brief Builds the triangulation. Duplicate points are left out.
+	 * @param InPositions The positions to triangulate.
+	 * @return True if at least one triangle could be built, false if the points are collinear or fewer than three.
+	 */
+	bool Build(const TArray<FVector>& InPositions);
+
+	/**
+	 * @brief Releases all data.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Locates the triangle enclosing a point.
+	 * @param InPoint The query point, projected onto the triangulation plane.
+	 * @param InStartTriangle The triangle to start the walk at, e.g. the result of the previous query. INDEX_NONE to start at InStartVertex.
+	 * @param InStartVertex A vertex close to the point, e.g. the nearest electrode. Used if InStartTriangle is invalid.
+	 * @param OutVertices Receives the indices of the three corner points, in the order passed to Build().
+	 * @param OutWeights Receives the non-negative barycentric weights of the corners, summing up to one.
+	 * @param OutIsInside Receives whether the point lies inside the convex hull. Outside, one weight is zero.
+	 * @return The index of the triangle, INDEX_NONE if the triangulation is empty.
+	 */
+	int32 Locate(const FVector& InPoint, const int32 InStartTriangle, const int32 InStartVertex, int32* OutVertices, double* OutWeights, bool& OutIsInside) const;
+
+	/**
+	 * @brief Locates many points in parallel.
+	 *
+	 * The points are processed in blocks, every walk starts at the triangle of the previous point of its block, so
+	 * trajectories and lattice sweeps in their natural order need only a few steps per point. The weights of a block are
+	 * then evaluated in one branch-free loop over the precomputed inverse bases.
+	 *
+	 * @param InPoints The query points, projected onto the triangulation plane.
+	 * @param OutTriangles Receives the triangle of every point. The corners follow from GetTriangleVertices().
+	 * @param OutWeightsA Receives the weight of the first corner of every point.
+	 * @param OutWeightsB Receives the weight of the second corner of every point.
+	 * @param OutWeightsC Receives the weight of the third corner of every point.
+	 */
+	void LocateBatch(const TArray<FVector>& InPoints, TArray<int32>& OutTriangles, TArray<double>& OutWeightsA, TArray<double>& OutWeightsB, TArray<double>& OutWeightsC) const;
+
+	/** @brief Whether the triangulation holds at least one triangle. */
+	bool IsBuilt() const { return this->TriangleVertices.Num() > 0; }
+
+	/** @brief Gets the number of triangles. */
+	int32 GetNumTriangles() const { return this->TriangleVertices.Num(); }
+
+	/** @brief Gets the corner point indices of a triangle, counterclockwise in the plane. */
+	const FIntVector& GetTriangleVertices(const int32 InTriangle) const { return this->TriangleVertices[InTriangle]; }
+
+	/** @brief Projects a point onto the triangulation plane. */
+	FVector2D Project(const FVector& InPoint) const { const FVector Offset = InPoint - this->PlaneOrigin; return FVector2D(FVector::DotProduct(Offset, this->PlaneAxisU), FVector::DotProduct(Offset, this->PlaneAxisV)); }
+
+	/** @brief Gets the projected position of a point passed to Build(). */
+	const FVector2D& GetPlanePosition(const int32 InVertex) const { return this->PlanePositions[InVertex]; }
+
+private:
+	/** @brief Fits the plane through the points and projects them onto it. */
+	bool FitPlane(const TArray<FVector>& InPositions);
+
+	/** @brief Walks from a triangle towards a point, returns the triangle containing it or the one where the walk left the hull. */
+	int32 Walk(const FVector2D& InPoint, const int32 InStartTriangle, bool& OutIsInside) const;
+
+	/** @brief Non-negative barycentric weights of a point inside a triangle from its inverse basis. */
+	void CalculateWeights(const int32 InTriangle, const FVector2D& InPoint, double* OutWeights) const;
+
+	/** @brief Clamps a point outside of the convex hull to the nearest hull edge. */
+	int32 ClampToHull(const FVector2D& InPoint, int32* OutVertices, double* OutWeights) const;
+
+	/** @brief Origin of the triangulation plane, the centroid of the points. */
+	FVector PlaneOrigin = FVector::ZeroVector;
+
+	/** @brief First in-plane axis, the direction of the largest spread. */
+	FVector PlaneAxisU = FVector::ForwardVector;
+
+	/** @brief Second in-plane axis. */
+	FVector PlaneAxisV = FVector::RightVector;
+
+	/** @brief Projected position per point. */
+	TArray<FVector2D> PlanePositions;
+
+	/** @brief Corner points per triangle, counterclockwise. */
+	TArray<FIntVector> TriangleVertices;
+
+	/** @brief Neighbor triangle across the edge opposite of every corner, INDEX_NONE on the convex hull. */
+	TArray<FIntVector> TriangleNeighbors;
+
+	/** @brief One triangle per point, INDEX_NONE for left out duplicates. */
+	TArray<int32> VertexTriangles;
+
+	/** @brief Hull edges as triangle * 3 + opposite corner. */
+	TArray<int32> HullEdges;
+
+	/** @brief First corner per triangle in plane coordinates. */
+	TArray<double> TriangleOriginX;
+	TArray<double> TriangleOriginY;
+
+	/** @brief Inverse of the edge basis [B - A, C - A] per triangle, row-major. */
+	TArray<double> InverseBasisXX;
+	TArray<double> InverseBasisXY;
+	TArray<double> InverseBasisYX;
+	TArray<double> InverseBasisYY;
+};
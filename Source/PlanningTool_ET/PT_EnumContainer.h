@@ -42,3 +42,82 @@ enum class ESlicingType : uint8
     Y,  /**< Slicing along the Y axis */
     Z   /**< Slicing along the Z axis */
 };
+
+/**
+ * @brief Enum representing the interpolation mode between simulated electrodes.
+ */
+UENUM(BlueprintType)
+enum class EInterpolationMode : uint8
+{
+    Barycentric,        /**< Barycentric weights of the three nearest electrodes */
+    InverseDistance,    /**< Inverse distance weights of the k nearest electrodes */
+    RadialBasis,        /**< Local radial basis function weights of the k nearest electrodes */
+    Bilinear            /**< Bilinear weights of the four corner electrodes of the enclosing grid cell */
+};
+
+/**
+ * @brief Enum representing the score used to rank candidate positions for new simulations.
+ */
+UENUM(BlueprintType)
+enum class ESamplingScore : uint8
+{
+    NeighborDisagreement,   /**< Spread of the ROI mean magnitudes of the neighboring electrodes */
+    LeaveOneOutError        /**< Leave-one-out interpolation error of the neighboring electrodes */
+};
+
+/**
+ * @brief Enum representing the ROI metric maximized by the electrode position optimizer.
+ */
+UENUM(BlueprintType)
+enum class EOptimizationObjective : uint8
+{
+    MeanMagnitude,          /**< Mean magnitude over the ROI cells of the chosen tags */
+    VolumeAboveThreshold,   /**< Fraction of the ROI cells of the chosen tags whose magnitude exceeds a threshold */
+    DirectionalComponent,   /**< Mean vector field component along a direction over the ROI cells of the chosen tags */
+    NormalComponent         /**< Mean vector field component along the surface normal over the ROI surface vertices */
+};
+
+/**
+ * @brief Enum representing how the colors of the cells adjacent to a vertex are averaged.
+ */
+UENUM(BlueprintType)
+enum class EVertexAveraging : uint8
+{
+    Uniform,            /**< Every adjacent cell has the same weight */
+    Volume,             /**< Cells are weighted by their tetra volume */
+    InverseDistance     /**< Cells are weighted by the inverse distance between the vertex and the cell centroid */
+};
+
+/**
+ * @brief Enum representing the subsystem a memory consumer belongs to.
+ */
+UENUM(BlueprintType)
+enum class EMemorySubsystem : uint8
+{
+    Simulation,     /**< Simulation ensembles, surface mappings and resident workspace datasets */
+    Mesh,           /**< Vertex, color, normal and triangle index arrays of the 3D actors */
+    Tetra,          /**< Raw tetrahedron arrays of the volume tags */
+    PointCloud      /**< Lidar point clouds of the volume tags */
+};
+
+/**
+ * @brief Enum representing the validation state of an electrode, written to the per-instance data of the electrode renderer.
+ */
+UENUM(BlueprintType)
+enum class EElectrodeValidationState : uint8
+{
+    Pending,    /**< The electrode has not been validated yet */
+    Succeeded,  /**< The simulation of the electrode succeeded */
+    Failed      /**< The simulation of the electrode failed */
+};
+
+/**
+ * @brief Enum representing how the normals of the triangles adjacent to a vertex are weighted in its vertex normal.
+ */
+UENUM(BlueprintType)
+enum class ENormalWeighting : uint8
+{
+    Uniform,    /**< Every adjacent triangle has the same weight */
+    Area,       /**< Triangles are weighted by their area */
+    Angle       /**< Triangles are weighted by their corner angle at the vertex */
+};
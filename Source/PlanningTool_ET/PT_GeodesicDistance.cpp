@@ -0,0 +1,465 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_GeodesicDistance.h"
+#include "Algo/Sort.h"
+
+/** Relative residual at which the conjugate gradient solves stop. */
+static constexpr double SolverTolerance = 1e-6;
+
+/** Upper bound of conjugate gradient iterations per solve. */
+static constexpr int32 MaxSolverIterations = 2000;
+
+/** Weight of the area term that makes the Poisson system definite, relative to the diffusion time. */
+static constexpr double PoissonRegularization = 1e-6;
+
+/** An off-diagonal Laplacian entry while the sparse matrix is assembled. */
+struct FGeodesicEdge
+{
+	int32 Row;
+	int32 Column;
+	double Weight;
+};
+
+bool FPT_GeodesicDistance::Build(const FPT_MeshBufferPtr& InMesh, const double InTimeFactor)
+{
+	this->Reset();
+	if (!InMesh.IsValid())
+	{
+		return false;
+	}
+
+	const TArray<FVector>& InVertexArray = InMesh->GetVertexArray();
+	const TArray<int32>& InTriangleIndexArray = InMesh->GetTriangleIndexArray();
+	const int32 NumVertices = InVertexArray.Num();
+	const int32 NumInputTriangles = InTriangleIndexArray.Num() / 3;
+	TArray<double> VertexAreaArray;
+	VertexAreaArray.Init(0.0, NumVertices);
+	TArray<FGeodesicEdge> Edges;
+	Edges.Reserve(NumInputTriangles * 6);
+	this->Triangles.Reserve(NumInputTriangles);
+	this->TriangleHalfCotangents.Reserve(NumInputTriangles);
+	this->TriangleGradients.Reserve(NumInputTriangles * 3);
+
+	double EdgeLengthSum = 0.0;
+	for (int32 Triangle = 0; Triangle < NumInputTriangles; Triangle++)
+	{
+		const FIntVector Corners(InTriangleIndexArray[Triangle * 3], InTriangleIndexArray[Triangle * 3 + 1], InTriangleIndexArray[Triangle * 3 + 2]);
+		if (!InVertexArray.IsValidIndex(Corners.X) || !InVertexArray.IsValidIndex(Corners.Y) || !InVertexArray.IsValidIndex(Corners.Z))
+		{
+			continue;
+		}
+
+		const FVector& A = InVertexArray[Corners.X];
+		const FVector& B = InVertexArray[Corners.Y];
+		const FVector& C = InVertexArray[Corners.Z];
+		const FVector Cross = FVector::CrossProduct(B - A, C - A);
+		const double DoubleArea = Cross.Size();
+		if (DoubleArea <= UE_DOUBLE_SMALL_NUMBER)
+		{
+			continue;
+		}
+
+		// The cotangent of a corner is the dot product of its edges over their cross product, which is twice the area
+		const FVector HalfCotangents(
+			0.5 * FVector::DotProduct(B - A, C - A) / DoubleArea,
+			0.5 * FVector::DotProduct(C - B, A - B) / DoubleArea,
+			0.5 * FVector::DotProduct(A - C, B - C) / DoubleArea);
+
+		// The gradient of a barycentric coordinate is the rotated opposite edge over twice the area
+		const FVector Normal = Cross / DoubleArea;
+		this->TriangleGradients.Add(FVector::CrossProduct(Normal, C - B) / DoubleArea);
+		this->TriangleGradients.Add(FVector::CrossProduct(Normal, A - C) / DoubleArea);
+		this->TriangleGradients.Add(FVector::CrossProduct(Normal, B - A) / DoubleArea);
+		this->Triangles.Add(Corners);
+		this->TriangleHalfCotangents.Add(HalfCotangents);
+
+		const double VertexArea = DoubleArea / 6.0;
+		VertexAreaArray[Corners.X] += VertexArea;
+		VertexAreaArray[Corners.Y] += VertexArea;
+		VertexAreaArray[Corners.Z] += VertexArea;
+
+		// Every edge is weighted with the cotangent of the corner opposite of it
+		Edges.Add({ Corners.Y, Corners.Z, HalfCotangents.X });
+		Edges.Add({ Corners.Z, Corners.Y, HalfCotangents.X });
+		Edges.Add({ Corners.Z, Corners.X, HalfCotangents.Y });
+		Edges.Add({ Corners.X, Corners.Z, HalfCotangents.Y });
+		Edges.Add({ Corners.X, Corners.Y, HalfCotangents.Z });
+		Edges.Add({ Corners.Y, Corners.X, HalfCotangents.Z });
+
+		EdgeLengthSum += FVector::Dist(A, B) + FVector::Dist(B, C) + FVector::Dist(C, A);
+	}
+
+	if (this->Triangles.IsEmpty())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[FPT_GeodesicDistance::Build] The mesh has no valid triangles."));
+		this->Reset();
+		return false;
+	}
+
+	this->MeanEdgeLength = EdgeLengthSum / (3.0 * this->Triangles.Num());
+	const double Time = FMath::Max(InTimeFactor, UE_DOUBLE_SMALL_NUMBER) * this->MeanEdgeLength * this->MeanEdgeLength;
+
+	Algo::Sort(Edges, [](const FGeodesicEdge& A, const FGeodesicEdge& B) { return A.Row < B.Row || (A.Row == B.Row && A.Column < B.Column); });
+
+	// Rows in compressed sparse row layout, the diagonal inserted at its sorted position
+	TArray<double> LaplacianValues;
+	this->RowStarts.SetNumUninitialized(NumVertices + 1);
+	this->DiagonalIndices.SetNumUninitialized(NumVertices);
+	this->Columns.Reserve(Edges.Num() / 2 + NumVertices);
+	LaplacianValues.Reserve(Edges.Num() / 2 + NumVertices);
+
+	int32 Edge = 0;
+	for (int32 Row = 0; Row < NumVertices; Row++)
+	{
+		this->RowStarts[Row] = this->Columns.Num();
+		this->DiagonalIndices[Row] = INDEX_NONE;
+		double DiagonalValue = 0.0;
+		while (Edge < Edges.Num() && Edges[Edge].Row == Row)
+		{
+			const int32 Column = Edges[Edge].Column;
+			double Weight = 0.0;
+			for (; Edge < Edges.Num() && Edges[Edge].Row == Row && Edges[Edge].Column == Column; Edge++)
+			{
+				Weight += Edges[Edge].Weight;
+			}
+
+			if (Column > Row && this->DiagonalIndices[Row] == INDEX_NONE)
+			{
+				this->DiagonalIndices[Row] = this->Columns.Add(Row);
+				LaplacianValues.Add(0.0);
+			}
+			this->Columns.Add(Column);
+			LaplacianValues.Add(-Weight);
+			DiagonalValue += Weight;
+		}
+
+		if (this->DiagonalIndices[Row] == INDEX_NONE)
+		{
+			this->DiagonalIndices[Row] = this->Columns.Add(Row);
+			LaplacianValues.Add(0.0);
+		}
+		LaplacianValues[this->DiagonalIndices[Row]] = DiagonalValue;
+	}
+	this->RowStarts[NumVertices] = this->Columns.Num();
+
+	this->HeatValues.SetNumUninitialized(LaplacianValues.Num());
+	this->PoissonValues.SetNumUninitialized(LaplacianValues.Num());
+	for (int32 Entry = 0; Entry < LaplacianValues.Num(); Entry++)
+	{
+		this->HeatValues[Entry] = Time * LaplacianValues[Entry];
+		this->PoissonValues[Entry] = LaplacianValues[Entry];
+	}
+
+	for (int32 Row = 0; Row < NumVertices; Row++)
+	{
+		const int32 Diagonal = this->DiagonalIndices[Row];
+		if (VertexAreaArray[Row] > 0.0)
+		{
+			this->HeatValues[Diagonal] += VertexAreaArray[Row];
+			this->PoissonValues[Diagonal] += PoissonRegularization / Time * VertexAreaArray[Row];
+		}
+		else
+		{
+			// Vertices without triangles decouple as identity rows
+			this->HeatValues[Diagonal] = 1.0;
+			this->PoissonValues[Diagonal] = 1.0;
+		}
+	}
+
+	this->VertexAreas = MoveTemp(VertexAreaArray);
+	if (!this->Factor(this->HeatValues, this->HeatFactor) || !this->Factor(this->PoissonValues, this->PoissonFactor))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_GeodesicDistance::Build] The system matrices could not be factored!"));
+		this->Reset();
+		return false;
+	}
+	this->Mesh = InMesh;
+	return true;
+}
+
+void FPT_GeodesicDistance::Reset()
+{
+	this->Mesh.Reset();
+	this->Triangles.Empty();
+	this->TriangleHalfCotangents.Empty();
+	this->TriangleGradients.Empty();
+	this->VertexAreas.Empty();
+	this->RowStarts.Empty();
+	this->Columns.Empty();
+	this->DiagonalIndices.Empty();
+	this->HeatValues.Empty();
+	this->PoissonValues.Empty();
+	this->HeatFactor.Empty();
+	this->PoissonFactor.Empty();
+	this->MeanEdgeLength = 0.0;
+}
+
+SIZE_T FPT_GeodesicDistance::GetAllocatedSize() const
+{
+	return this->Triangles.GetAllocatedSize() + this->TriangleHalfCotangents.GetAllocatedSize() + this->TriangleGradients.GetAllocatedSize()
+		+ this->VertexAreas.GetAllocatedSize() + this->RowStarts.GetAllocatedSize() + this->Columns.GetAllocatedSize() + this->DiagonalIndices.GetAllocatedSize()
+		+ this->HeatValues.GetAllocatedSize() + this->PoissonValues.GetAllocatedSize() + this->HeatFactor.GetAllocatedSize() + this->PoissonFactor.GetAllocatedSize();
+}
+
+bool FPT_GeodesicDistance::Factor(const TArray<double>& InValues, TArray<double>& OutFactor) const
+{
+	const int32 NumRows = this->RowStarts.Num() - 1;
+	OutFactor.SetNumUninitialized(InValues.Num());
+
+	// Obtuse triangles make the cotangent Laplacian lose diagonal dominance, a growing diagonal shift restores it
+	double Shift = 0.0;
+	for (int32 Attempt = 0; Attempt < 16; Attempt++)
+	{
+		bool bSucceeded = true;
+		for (int32 Row = 0; Row < NumRows && bSucceeded; Row++)
+		{
+			const int32 RowStart = this->RowStarts[Row];
+			const int32 RowDiagonal = this->DiagonalIndices[Row];
+			for (int32 Entry = RowStart; Entry < RowDiagonal; Entry++)
+			{
+				// Only the entries present in both rows contribute, their columns are merged in ascending order
+				const int32 Column = this->Columns[Entry];
+				double Sum = InValues[Entry];
+				int32 EntryA = RowStart;
+				int32 EntryB = this->RowStarts[Column];
+				const int32 ColumnDiagonal = this->DiagonalIndices[Column];
+				while (EntryA < Entry && EntryB < ColumnDiagonal)
+				{
+					const int32 ColumnA = this->Columns[EntryA];
+					const int32 ColumnB = this->Columns[EntryB];
+					if (ColumnA == ColumnB)
+					{
+						Sum -= OutFactor[EntryA++] * OutFactor[EntryB++];
+					}
+					else if (ColumnA < ColumnB)
+					{
+						EntryA++;
+					}
+					else
+					{
+						EntryB++;
+					}
+				}
+				OutFactor[Entry] = Sum / OutFactor[ColumnDiagonal];
+			}
+
+			double Pivot = InValues[RowDiagonal] * (1.0 + Shift);
+			for (int32 Entry = RowStart; Entry < RowDiagonal; Entry++)
+			{
+				Pivot -= OutFactor[Entry] * OutFactor[Entry];
+			}
+			if (Pivot <= 0.0)
+			{
+				bSucceeded = false;
+				break;
+			}
+			OutFactor[RowDiagonal] = FMath::Sqrt(Pivot);
+		}
+
+		if (bSucceeded)
+		{
+			return true;
+		}
+		Shift = (Shift == 0.0) ? 1e-3 : Shift * 4.0;
+	}
+	return false;
+}
+
+void FPT_GeodesicDistance::Multiply(const TArray<double>& InValues, const TArray<double>& InX, TArray<double>& OutY) const
+{
+	const int32 NumRows = this->RowStarts.Num() - 1;
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		double Sum = 0.0;
+		for (int32 Entry = this->RowStarts[Row]; Entry < this->RowStarts[Row + 1]; Entry++)
+		{
+			Sum += InValues[Entry] * InX[this->Columns[Entry]];
+		}
+		OutY[Row] = Sum;
+	}
+}
+
+void FPT_GeodesicDistance::ApplyPreconditioner(const TArray<double>& InFactor, const TArray<double>& InR, TArray<double>& OutZ) const
+{
+	const int32 NumRows = this->RowStarts.Num() - 1;
+
+	// Forward substitution with the lower rows of the factor
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		double Sum = InR[Row];
+		for (int32 Entry = this->RowStarts[Row]; Entry < this->DiagonalIndices[Row]; Entry++)
+		{
+			Sum -= InFactor[Entry] * OutZ[this->Columns[Entry]];
+		}
+		OutZ[Row] = Sum / InFactor[this->DiagonalIndices[Row]];
+	}
+
+	// Backward substitution with the transposed factor, scattering every solved row into the rows above it
+	for (int32 Row = NumRows - 1; Row >= 0; Row--)
+	{
+		OutZ[Row] /= InFactor[this->DiagonalIndices[Row]];
+		for (int32 Entry = this->RowStarts[Row]; Entry < this->DiagonalIndices[Row]; Entry++)
+		{
+			OutZ[this->Columns[Entry]] -= InFactor[Entry] * OutZ[Row];
+		}
+	}
+}
+
+int32 FPT_GeodesicDistance::Solve(const TArray<double>& InValues, const TArray<double>& InFactor, const TArray<double>& InB, TArray<double>& InOutX) const
+{
+	const int32 NumRows = InB.Num();
+	TArray<double> Residual;
+	TArray<double> Preconditioned;
+	TArray<double> Direction;
+	TArray<double> Product;
+	Residual.SetNumUninitialized(NumRows);
+	Preconditioned.SetNumUninitialized(NumRows);
+	Product.SetNumUninitialized(NumRows);
+
+	this->Multiply(InValues, InOutX, Product);
+	double NormB = 0.0;
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		Residual[Row] = InB[Row] - Product[Row];
+		NormB += InB[Row] * InB[Row];
+	}
+	if (NormB <= 0.0)
+	{
+		return 0;
+	}
+
+	this->ApplyPreconditioner(InFactor, Residual, Preconditioned);
+	Direction = Preconditioned;
+	double ResidualDot = 0.0;
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		ResidualDot += Residual[Row] * Preconditioned[Row];
+	}
+
+	const double ToleranceSquared = SolverTolerance * SolverTolerance * NormB;
+	for (int32 Iteration = 0; Iteration < MaxSolverIterations; Iteration++)
+	{
+		this->Multiply(InValues, Direction, Product);
+		double Curvature = 0.0;
+		for (int32 Row = 0; Row < NumRows; Row++)
+		{
+			Curvature += Direction[Row] * Product[Row];
+		}
+		if (Curvature <= 0.0)
+		{
+			return Iteration;
+		}
+
+		const double Step = ResidualDot / Curvature;
+		double ResidualNorm = 0.0;
+		for (int32 Row = 0; Row < NumRows; Row++)
+		{
+			InOutX[Row] += Step * Direction[Row];
+			Residual[Row] -= Step * Product[Row];
+			ResidualNorm += Residual[Row] * Residual[Row];
+		}
+		if (ResidualNorm <= ToleranceSquared)
+		{
+			return Iteration + 1;
+		}
+
+		this->ApplyPreconditioner(InFactor, Residual, Preconditioned);
+		double NextResidualDot = 0.0;
+		for (int32 Row = 0; Row < NumRows; Row++)
+		{
+			NextResidualDot += Residual[Row] * Preconditioned[Row];
+		}
+
+		const double Beta = NextResidualDot / ResidualDot;
+		ResidualDot = NextResidualDot;
+		for (int32 Row = 0; Row < NumRows; Row++)
+		{
+			Direction[Row] = Preconditioned[Row] + Beta * Direction[Row];
+		}
+	}
+
+	UE_LOG(LogTemp, Warning, TEXT("[FPT_GeodesicDistance::Solve] No convergence after %d iterations."), MaxSolverIterations);
+	return MaxSolverIterations;
+}
+
+bool FPT_GeodesicDistance::ComputeDistances(const TArray<int32>& InSourceVertices, const TArray<double>& InSourceWeights, TArray<double>& OutDistances) const
+{
+	OutDistances.Empty();
+	if (!this->IsBuilt())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_GeodesicDistance::ComputeDistances] The operators have not been built!"));
+		return false;
+	}
+	if (InSourceVertices.IsEmpty() || (!InSourceWeights.IsEmpty() && InSourceWeights.Num() != InSourceVertices.Num()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_GeodesicDistance::ComputeDistances] %d sources with %d weights given!"), InSourceVertices.Num(), InSourceWeights.Num());
+		return false;
+	}
+
+	const TArray<FVector>& Positions = this->Mesh->GetVertexArray();
+	const int32 NumVertices = Positions.Num();
+	TArray<double> Heat;
+	Heat.Init(0.0, NumVertices);
+	for (int32 Source = 0; Source < InSourceVertices.Num(); Source++)
+	{
+		if (this->VertexAreas.IsValidIndex(InSourceVertices[Source]) && this->VertexAreas[InSourceVertices[Source]] > 0.0)
+		{
+			Heat[InSourceVertices[Source]] += InSourceWeights.IsEmpty() ? 1.0 : InSourceWeights[Source];
+		}
+	}
+
+	// Diffuse the heat for a short time
+	TArray<double> Temperature;
+	Temperature.Init(0.0, NumVertices);
+	this->Solve(this->HeatValues, this->HeatFactor, Heat, Temperature);
+
+	// Integrated divergence of the normalized negative heat gradient, pointing away from the sources
+	TArray<double> Divergence;
+	Divergence.Init(0.0, NumVertices);
+	for (int32 Triangle = 0; Triangle < this->Triangles.Num(); Triangle++)
+	{
+		const FIntVector& Corners = this->Triangles[Triangle];
+		const FVector Gradient = Temperature[Corners.X] * this->TriangleGradients[Triangle * 3]
+			+ Temperature[Corners.Y] * this->TriangleGradients[Triangle * 3 + 1]
+			+ Temperature[Corners.Z] * this->TriangleGradients[Triangle * 3 + 2];
+		const FVector Field = -Gradient.GetSafeNormal();
+
+		const FVector& A = Positions[Corners.X];
+		const FVector& B = Positions[Corners.Y];
+		const FVector& C = Positions[Corners.Z];
+		const FVector& HalfCotangents = this->TriangleHalfCotangents[Triangle];
+		const double FieldAB = FVector::DotProduct(B - A, Field);
+		const double FieldBC = FVector::DotProduct(C - B, Field);
+		const double FieldCA = FVector::DotProduct(A - C, Field);
+		Divergence[Corners.X] += HalfCotangents.Z * FieldAB - HalfCotangents.Y * FieldCA;
+		Divergence[Corners.Y] += HalfCotangents.X * FieldBC - HalfCotangents.Z * FieldAB;
+		Divergence[Corners.Z] += HalfCotangents.Y * FieldCA - HalfCotangents.X * FieldBC;
+	}
+
+	// The Laplacian is stored positive semi-definite, so the distance solves L * Phi = -Divergence
+	for (double& Value : Divergence)
+	{
+		Value = -Value;
+	}
+
+	TArray<double> Potential;
+	Potential.Init(0.0, NumVertices);
+	this->Solve(this->PoissonValues, this->PoissonFactor, Divergence, Potential);
+
+	double MinPotential = UE_DOUBLE_BIG_NUMBER;
+	for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+	{
+		if (this->VertexAreas[Vertex] > 0.0)
+		{
+			MinPotential = FMath::Min(MinPotential, Potential[Vertex]);
+		}
+	}
+
+	OutDistances.SetNumUninitialized(NumVertices);
+	for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+	{
+		OutDistances[Vertex] = (this->VertexAreas[Vertex] > 0.0) ? Potential[Vertex] - MinPotential : -1.0;
+	}
+	return true;
+}
@@ -0,0 +1,119 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_GeodesicDistance.h
+ * @brief Header file for the FPT_GeodesicDistance class.
+ *
+ * This file contains the declaration of the FPT_GeodesicDistance class, which computes geodesic distances on a triangle
+ * mesh with the heat method.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PT_MeshBuffer.h"
+
+/**
+ * @class FPT_GeodesicDistance
+ * @brief Geodesic distances on a triangle mesh by the heat method (Crane et al., Geodesics in Heat).
+ *
+ * A query diffuses heat from the sources for a short time, normalizes the negative heat gradient per triangle and
+ * recovers the distance whose gradient best matches it by a Poisson solve. Everything that does not depend on the
+ * sources is precomputed by Build(): the vertex adjacency, the cotangent Laplacian, the lumped vertex areas, the
+ * gradient basis per triangle and the incomplete Cholesky factors of both system matrices. A query then costs two
+ * preconditioned conjugate gradient solves and two passes over the triangles.
+ *
+ * The vertices are read from the shared mesh buffer, which the operators keep alive instead of copying it. The mesh is
+ * expected to be connected, distances in components without a source are meaningless. All queries are const and can
+ * be issued from several threads at the same time.
+ */
+class PLANNINGTOOL_ET_API FPT_GeodesicDistance
+{
+public:
+	/**
+	 * @brief Precomputes the operators and factors of a mesh.
+	 * @param InMesh The mesh, referenced by the operators.
+	 * @param InTimeFactor The diffusion time in squared mean edge lengths. Larger values smooth the distances.
+	 * @return True if the mesh has at least one non-degenerate triangle.
+	 */
+	bool Build(const FPT_MeshBufferPtr& InMesh, const double InTimeFactor = 1.0);
+
+	/**
+	 * @brief Releases all data.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Computes the distance of every vertex to the nearest source.
+	 * @param InSourceVertices The source vertices.
+	 * @param InSourceWeights The heat of every source, e.g. the barycentric weights of a point inside a triangle. Empty for one each.
+	 * @param OutDistances Receives the distance per vertex, -1 for vertices without triangles.
+	 * @return True if the distances could be computed.
+	 */
+	bool ComputeDistances(const TArray<int32>& InSourceVertices, const TArray<double>& InSourceWeights, TArray<double>& OutDistances) const;
+
+	/** @brief Whether the operators have been built. */
+	bool IsBuilt() const { return this->Mesh.IsValid(); }
+
+	/** @brief Gets the number of vertices. */
+	int32 Num() const { return this->IsBuilt() ? this->Mesh->GetNumVertices() : 0; }
+
+	/** @brief Gets the mesh the operators were built for, invalid if they are not built. */
+	const FPT_MeshBufferPtr& GetMesh() const { return this->Mesh; }
+
+	/** @brief Gets the mean edge length of the mesh. */
+	double GetMeanEdgeLength() const { return this->MeanEdgeLength; }
+
+	/** @brief Gets the number of bytes held by the operators, without the shared mesh. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** @brief Computes OutY = A * InX for a matrix with the sparsity of the Laplacian. */
+	void Multiply(const TArray<double>& InValues, const TArray<double>& InX, TArray<double>& OutY) const;
+
+	/** @brief Solves L * L^T * OutZ = InR with an incomplete Cholesky factor L. */
+	void ApplyPreconditioner(const TArray<double>& InFactor, const TArray<double>& InR, TArray<double>& OutZ) const;
+
+	/** @brief Computes the incomplete Cholesky factor of a matrix, shifting its diagonal until the factorization succeeds. */
+	bool Factor(const TArray<double>& InValues, TArray<double>& OutFactor) const;
+
+	/** @brief Solves A * InOutX = InB by preconditioned conjugate gradients, starting at InOutX. Returns the number of iterations. */
+	int32 Solve(const TArray<double>& InValues, const TArray<double>& InFactor, const TArray<double>& InB, TArray<double>& InOutX) const;
+
+	/** @brief The mesh the operators were built for. */
+	FPT_MeshBufferPtr Mesh;
+
+	/** @brief Vertex indices per non-degenerate triangle. */
+	TArray<FIntVector> Triangles;
+
+	/** @brief Half the cotangent of the angle at every corner per triangle. */
+	TArray<FVector> TriangleHalfCotangents;
+
+	/** @brief Gradient of the barycentric coordinate of every corner per triangle, [Triangle * 3 + Corner]. */
+	TArray<FVector> TriangleGradients;
+
+	/** @brief Lumped area per vertex, zero for vertices without triangles. */
+	TArray<double> VertexAreas;
+
+	/** @brief Start of every row in the sparse matrices, one more than vertices. */
+	TArray<int32> RowStarts;
+
+	/** @brief Column per sparse matrix entry, ascending per row. */
+	TArray<int32> Columns;
+
+	/** @brief Position of the diagonal entry per row. */
+	TArray<int32> DiagonalIndices;
+
+	/** @brief Heat system, area + time * Laplacian. */
+	TArray<double> HeatValues;
+
+	/** @brief Poisson system, Laplacian + a small area term that removes its null space. */
+	TArray<double> PoissonValues;
+
+	/** @brief Incomplete Cholesky factors in the lower part of every row. */
+	TArray<double> HeatFactor;
+	TArray<double> PoissonFactor;
+
+	/** @brief The mean edge length. */
+	double MeanEdgeLength = 0.0;
+};
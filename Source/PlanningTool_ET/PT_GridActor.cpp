@@ -10,6 +10,15 @@ APT_GridActor::APT_GridActor()
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	this->ElectrodeRenderer = CreateDefaultSubobject<UPT_ElectrodeRendererComponent>(TEXT("ElectrodeRenderer"));
+}
+
+void APT_GridActor::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+
+	// The root belongs to the Blueprint subclasses, the renderer is attached below it
+	this->ElectrodeRenderer->AttachToOwnerRoot();
 }
 
 // Called when the game starts or when spawned
@@ -69,6 +78,8 @@ FString APT_GridActor::CreateGridJSON(const FString& InConfigId, const FString&
 
 	JsonObject->SetObjectField(TEXT("Electrodes"), ElectrodesJson);
 
+	this->ElectrodeRenderer->SetElectrodePositions(InElectrodePositionArray);
+
 	return UPT_JSONConverter::SerializeJsonObjectToString(JsonObject);;
 }
 
@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "PT_ElectrodeRendererComponent.h"
 #include "PT_GridActor.generated.h"
 
 UCLASS()
@@ -20,6 +21,9 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called after the Blueprint components are created, attaches the electrode renderer to the root
+	virtual void OnConstruction(const FTransform& Transform) override;
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -42,4 +46,8 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "GRID_SELECTOR")
 	FString CreateGridJSON(const FString& InConfigId, const FString& InPatientId, const TArray<FVector>& InElectrodePositionArray, const TArray<FString>& InElectrodeNameArray, const FVector& InCenterPoint, const double& InCellSize, const TArray<FVector>& InCornerPointArray, const FRotator& InRotation, const int& InRowCount, const int& InColumnCount);
 
+	/** Draws the electrodes of the grid passed to CreateGridJSON as instances of one mesh. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "GRID_SELECTOR")
+	UPT_ElectrodeRendererComponent* ElectrodeRenderer;
+
 };
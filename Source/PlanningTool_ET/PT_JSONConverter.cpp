@@ -181,6 +181,45 @@ void UPT_JSONConverter::ConvertJSONObjectToDoubleArray(const TSharedPtr<FJsonObj
 	}
 }
 
+int32 UPT_JSONConverter::ConvertJSONObjectToDoubleBuffer(const TSharedPtr<FJsonObject>* InJsonObjectPtr, const FString& InArrayFieldName, double* OutBuffer, const int32 InCapacity)
+{
+	const TArray<TSharedPtr<FJsonValue>>* JsonValueArrayPtr;
+	if (!InJsonObjectPtr->Get()->TryGetArrayField(InArrayFieldName, JsonValueArrayPtr))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_JSONConverter::ConvertJSONObjectToDoubleBuffer] FieldName %s does not exist!"), *InArrayFieldName);
+		return -1;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>& JsonValueArray = *JsonValueArrayPtr;
+	const int32 NumValues = FMath::Min(JsonValueArray.Num(), InCapacity);
+	for (int32 Index = 0; Index < NumValues; Index++)
+	{
+		OutBuffer[Index] = JsonValueArray[Index]->AsNumber();
+	}
+	return JsonValueArray.Num();
+}
+
+int32 UPT_JSONConverter::ConvertJSONObjectToVectorBuffers(const TSharedPtr<FJsonObject>* InJsonObjectPtr, const FString& InArrayFieldName, double* OutX, double* OutY, double* OutZ, const int32 InCapacity)
+{
+	const TArray<TSharedPtr<FJsonValue>>* JsonValueArrayPtr;
+	if (!InJsonObjectPtr->Get()->TryGetArrayField(InArrayFieldName, JsonValueArrayPtr))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_JSONConverter::ConvertJSONObjectToVectorBuffers] Field %s not found."), *InArrayFieldName);
+		return -1;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>& JsonValueArray = *JsonValueArrayPtr;
+	const int32 NumValues = FMath::Min(JsonValueArray.Num(), InCapacity);
+	for (int32 Index = 0; Index < NumValues; Index++)
+	{
+		const TArray<TSharedPtr<FJsonValue>>& JsonVectorArray = JsonValueArray[Index]->AsArray();
+		OutX[Index] = JsonVectorArray[0]->AsNumber();
+		OutY[Index] = JsonVectorArray[1]->AsNumber();
+		OutZ[Index] = JsonVectorArray[2]->AsNumber();
+	}
+	return JsonValueArray.Num();
+}
+
 void UPT_JSONConverter::ConvertJSONResponseBodyToIntegerArray(const UPT_HTTPComponent* InHTTPComponent, const FString& InArrayFieldName, TArray<int32>& OutIntegerArray)
 {
 	TSharedPtr<FJsonObject> ResponseObject = InHTTPComponent->GetResponseObject();
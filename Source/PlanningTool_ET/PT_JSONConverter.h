@@ -130,6 +130,34 @@ public:
      */
     static void ConvertJSONObjectToDoubleArray(const TSharedPtr<FJsonObject>* InJsonObjectPtr, const FString& InArrayFieldName, TArray<double>& OutDoubleArray);
 
+    /**
+     * @brief Converts a JSON object to doubles written straight into a preallocated buffer.
+     *
+     * No array is allocated and no JSON value is copied, so several fields can be decoded from different threads at once.
+     *
+     * @param InJsonObjectPtr The JSON object to convert.
+     * @param InArrayFieldName The name of the field in the JSON object to convert.
+     * @param OutBuffer [out] The buffer, receives at most InCapacity values.
+     * @param InCapacity The number of values the buffer holds.
+     * @return The number of values in the field, -1 if the field does not exist.
+     */
+    static int32 ConvertJSONObjectToDoubleBuffer(const TSharedPtr<FJsonObject>* InJsonObjectPtr, const FString& InArrayFieldName, double* OutBuffer, const int32 InCapacity);
+
+    /**
+     * @brief Converts a JSON object to vectors written straight into three preallocated component buffers.
+     *
+     * No array is allocated and no JSON value is copied, so several fields can be decoded from different threads at once.
+     *
+     * @param InJsonObjectPtr The JSON object to convert.
+     * @param InArrayFieldName The name of the field in the JSON object to convert.
+     * @param OutX [out] The buffer of the X components, receives at most InCapacity values.
+     * @param OutY [out] The buffer of the Y components, receives at most InCapacity values.
+     * @param OutZ [out] The buffer of the Z components, receives at most InCapacity values.
+     * @param InCapacity The number of values every buffer holds.
+     * @return The number of vectors in the field, -1 if the field does not exist.
+     */
+    static int32 ConvertJSONObjectToVectorBuffers(const TSharedPtr<FJsonObject>* InJsonObjectPtr, const FString& InArrayFieldName, double* OutX, double* OutY, double* OutZ, const int32 InCapacity);
+
     /**
      * @brief Converts a JSON response body to an array of integers.
      * @param InHTTPComponent A pointer to the UPT_HTTPComponent that contains the HTTP response.
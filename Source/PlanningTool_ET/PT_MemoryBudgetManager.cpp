@@ -0,0 +1,198 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_MemoryBudgetManager.h"
+
+int32 UPT_MemoryBudgetManager::BUDGET_MB = 8192;
+TMap<FString, FPT_MemoryConsumer> UPT_MemoryBudgetManager::CONSUMER_MAP;
+TMap<FString, UPT_MemoryBudgetManager::FReliefHandler> UPT_MemoryBudgetManager::RELIEF_HANDLER_MAP;
+FString UPT_MemoryBudgetManager::LAST_ERROR_MESSAGE;
+bool UPT_MemoryBudgetManager::bIS_RELIEVING = false;
+
+UPT_MemoryBudgetManager::UPT_MemoryBudgetManager()
+{
+    // Constructor logic here
+}
+
+UPT_MemoryBudgetManager::~UPT_MemoryBudgetManager()
+{
+    // Destructor logic here
+}
+
+void UPT_MemoryBudgetManager::SetBudgetMB(const int32 InBudgetMB)
+{
+    BUDGET_MB = FMath::Max(InBudgetMB, 0);
+
+    const int64 BudgetBytes = (int64)BUDGET_MB * 1024 * 1024;
+    if (BUDGET_MB > 0 && GetTotalBytes() > BudgetBytes)
+    {
+        Relieve(GetTotalBytes() - BudgetBytes);
+    }
+}
+
+void UPT_MemoryBudgetManager::ReportUsage(const FString& InName, const EMemorySubsystem InSubsystem, const int64 InBytes)
+{
+    if (InBytes <= 0)
+    {
+        CONSUMER_MAP.Remove(InName);
+        return;
+    }
+
+    FPT_MemoryConsumer& Consumer = CONSUMER_MAP.FindOrAdd(InName);
+    Consumer.Name = InName;
+    Consumer.Subsystem = InSubsystem;
+    Consumer.Bytes = InBytes;
+
+    const int64 BudgetBytes = (int64)BUDGET_MB * 1024 * 1024;
+    if (BUDGET_MB > 0 && !bIS_RELIEVING && GetTotalBytes() > BudgetBytes)
+    {
+        const int64 ExcessBytes = GetTotalBytes() - BudgetBytes;
+        const int64 FreedBytes = Relieve(ExcessBytes);
+        if (FreedBytes < ExcessBytes)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("[UPT_MemoryBudgetManager::ReportUsage] %s pushed the usage over the budget of %d MB, relief freed %s of %s."), *InName, BUDGET_MB, *FormatMB(FreedBytes), *FormatMB(ExcessBytes));
+        }
+    }
+}
+
+void UPT_MemoryBudgetManager::ReleaseUsage(const FString& InName)
+{
+    CONSUMER_MAP.Remove(InName);
+}
+
+bool UPT_MemoryBudgetManager::RequestAllocation(const FString& InName, const EMemorySubsystem InSubsystem, const int64 InAdditionalBytes, FString& OutMessage)
+{
+    OutMessage.Empty();
+    if (BUDGET_MB <= 0)
+    {
+        return true;
+    }
+
+    const int64 BudgetBytes = (int64)BUDGET_MB * 1024 * 1024;
+    if (GetTotalBytes() + InAdditionalBytes > BudgetBytes)
+    {
+        Relieve(GetTotalBytes() + InAdditionalBytes - BudgetBytes);
+    }
+
+    const int64 FreeBytes = BudgetBytes - GetTotalBytes();
+    if (InAdditionalBytes <= FreeBytes)
+    {
+        return true;
+    }
+
+    FString ConsumerList;
+    for (const FPT_MemoryConsumer& TopConsumer : GetTopConsumers(3))
+    {
+        ConsumerList += FString::Printf(TEXT("%s%s (%s)"), ConsumerList.IsEmpty() ? TEXT("") : TEXT(", "), *TopConsumer.Name, *FormatMB(TopConsumer.Bytes));
+    }
+
+    OutMessage = FString::Printf(TEXT("Loading %s data into %s needs %s, but only %s of the %d MB memory budget are free. Largest consumers: %s."),
+        *UEnum::GetDisplayValueAsText(InSubsystem).ToString(), *InName, *FormatMB(InAdditionalBytes), *FormatMB(FMath::Max<int64>(FreeBytes, 0)), BUDGET_MB, ConsumerList.IsEmpty() ? TEXT("none") : *ConsumerList);
+    LAST_ERROR_MESSAGE = OutMessage;
+
+    UE_LOG(LogTemp, Error, TEXT("[UPT_MemoryBudgetManager::RequestAllocation] %s"), *OutMessage);
+    return false;
+}
+
+TArray<FPT_MemoryConsumer> UPT_MemoryBudgetManager::GetTopConsumers(const int32 InCount)
+{
+    TArray<FPT_MemoryConsumer> ConsumerArray;
+    CONSUMER_MAP.GenerateValueArray(ConsumerArray);
+    ConsumerArray.Sort([](const FPT_MemoryConsumer& A, const FPT_MemoryConsumer& B) { return A.Bytes > B.Bytes; });
+
+    if (InCount > 0 && ConsumerArray.Num() > InCount)
+    {
+        ConsumerArray.SetNum(InCount);
+    }
+
+    const double BudgetBytes = (double)BUDGET_MB * 1024 * 1024;
+    for (FPT_MemoryConsumer& Consumer : ConsumerArray)
+    {
+        Consumer.BudgetFraction = BudgetBytes > 0.0 ? Consumer.Bytes / BudgetBytes : 0.0;
+    }
+    return ConsumerArray;
+}
+
+int64 UPT_MemoryBudgetManager::GetTotalBytes()
+{
+    int64 TotalBytes = 0;
+    for (const TPair<FString, FPT_MemoryConsumer>& Pair : CONSUMER_MAP)
+    {
+        TotalBytes += Pair.Value.Bytes;
+    }
+    return TotalBytes;
+}
+
+int64 UPT_MemoryBudgetManager::GetSubsystemBytes(const EMemorySubsystem InSubsystem)
+{
+    int64 SubsystemBytes = 0;
+    for (const TPair<FString, FPT_MemoryConsumer>& Pair : CONSUMER_MAP)
+    {
+        if (Pair.Value.Subsystem == InSubsystem)
+        {
+            SubsystemBytes += Pair.Value.Bytes;
+        }
+    }
+    return SubsystemBytes;
+}
+
+void UPT_MemoryBudgetManager::LogMemoryStats(const int32 InCount)
+{
+    UE_LOG(LogTemp, Log, TEXT("[UPT_MemoryBudgetManager::LogMemoryStats] Total %s of %d MB (Simulation %s, Mesh %s, Tetra %s, PointCloud %s)"),
+        *FormatMB(GetTotalBytes()), BUDGET_MB,
+        *FormatMB(GetSubsystemBytes(EMemorySubsystem::Simulation)), *FormatMB(GetSubsystemBytes(EMemorySubsystem::Mesh)),
+        *FormatMB(GetSubsystemBytes(EMemorySubsystem::Tetra)), *FormatMB(GetSubsystemBytes(EMemorySubsystem::PointCloud)));
+
+    for (const FPT_MemoryConsumer& Consumer : GetTopConsumers(InCount))
+    {
+        UE_LOG(LogTemp, Log, TEXT("[UPT_MemoryBudgetManager::LogMemoryStats]   %s: %s (%.1f%%)"), *Consumer.Name, *FormatMB(Consumer.Bytes), Consumer.BudgetFraction * 100.0);
+    }
+}
+
+void UPT_MemoryBudgetManager::RegisterReliefHandler(const FString& InName, FReliefHandler&& InHandler)
+{
+    RELIEF_HANDLER_MAP.Add(InName, MoveTemp(InHandler));
+}
+
+void UPT_MemoryBudgetManager::UnregisterReliefHandler(const FString& InName)
+{
+    RELIEF_HANDLER_MAP.Remove(InName);
+}
+
+int64 UPT_MemoryBudgetManager::Relieve(const int64 InBytesToFree)
+{
+    if (bIS_RELIEVING || InBytesToFree <= 0)
+    {
+        return 0;
+    }
+    TGuardValue<bool> RelievingGuard(bIS_RELIEVING, true);
+
+    // Largest consumer first, the handlers report their new usage and may unregister themselves
+    TArray<FString> NameArray;
+    RELIEF_HANDLER_MAP.GenerateKeyArray(NameArray);
+    NameArray.Sort([](const FString& A, const FString& B)
+    {
+        const FPT_MemoryConsumer* ConsumerA = CONSUMER_MAP.Find(A);
+        const FPT_MemoryConsumer* ConsumerB = CONSUMER_MAP.Find(B);
+        return (ConsumerA ? ConsumerA->Bytes : 0) > (ConsumerB ? ConsumerB->Bytes : 0);
+    });
+
+    int64 FreedBytes = 0;
+    for (const FString& Name : NameArray)
+    {
+        if (FreedBytes >= InBytesToFree)
+        {
+            break;
+        }
+
+        const FReliefHandler* Handler = RELIEF_HANDLER_MAP.Find(Name);
+        if (Handler)
+        {
+            const FReliefHandler HandlerCopy = *Handler;
+            FreedBytes += FMath::Max<int64>(HandlerCopy(InBytesToFree - FreedBytes), 0);
+        }
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("[UPT_MemoryBudgetManager::Relieve] Freed %s of %s requested."), *FormatMB(FreedBytes), *FormatMB(InBytesToFree));
+    return FreedBytes;
+}
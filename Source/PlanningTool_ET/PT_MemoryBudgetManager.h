@@ -0,0 +1,163 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_MemoryBudgetManager.h
+ * @brief Header file for the UPT_MemoryBudgetManager class.
+ *
+ * This file contains the declaration of the UPT_MemoryBudgetManager class, which accounts the memory held by the
+ * simulation data, the meshes, the tetra arrays and the point clouds against one global budget.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PT_EnumContainer.h"
+#include "PT_StructContainer.h"
+#include "PT_MemoryBudgetManager.generated.h"
+
+/**
+ * @class UPT_MemoryBudgetManager
+ * @brief A class that accounts the memory of all large data holders against a global budget.
+ *
+ * Every holder reports its current bytes under a unique name. Holders that can give memory back, like the simulation
+ * component by evicting resident datasets or compressing the active one, register a relief handler. Once the reported
+ * bytes exceed the budget, the handlers are asked to free the excess, largest consumer first. Loads ask for their
+ * estimated size before allocating and fail with a message naming the largest consumers if relief cannot make room.
+ *
+ * All functions have to be called from the game thread.
+ */
+UCLASS()
+class PLANNINGTOOL_ET_API UPT_MemoryBudgetManager : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    /**
+     * @brief Function that frees memory of a consumer.
+     *
+     * It receives the number of bytes still to be freed and returns the number of bytes it actually freed. It has to
+     * report its new usage itself.
+     */
+    using FReliefHandler = TFunction<int64(const int64 InBytesToFree)>;
+
+    /**
+     * @brief Constructor for UPT_MemoryBudgetManager.
+     */
+    UPT_MemoryBudgetManager();
+
+    /**
+     * @brief Destructor for UPT_MemoryBudgetManager.
+     */
+    ~UPT_MemoryBudgetManager();
+
+    /**
+     * @brief Sets the memory budget and relieves the consumers if they exceed it.
+     * @param InBudgetMB The new budget in megabytes. If not positive, the budget is unlimited.
+     */
+    UFUNCTION(BlueprintCallable, Category = "PT_MemoryBudgetManager")
+    static void SetBudgetMB(const int32 InBudgetMB);
+
+    /**
+     * @brief Gets the memory budget.
+     * @return The budget in megabytes, 0 if unlimited.
+     */
+    UFUNCTION(BlueprintPure, Category = "PT_MemoryBudgetManager")
+    static int32 GetBudgetMB() { return BUDGET_MB; }
+
+    /**
+     * @brief Reports the bytes a consumer currently holds and relieves the consumers if the budget is exceeded.
+     * @param InName The unique name of the consumer.
+     * @param InSubsystem The subsystem the consumer belongs to.
+     * @param InBytes The bytes the consumer holds. A consumer reporting 0 bytes is removed.
+     */
+    UFUNCTION(BlueprintCallable, Category = "PT_MemoryBudgetManager")
+    static void ReportUsage(const FString& InName, const EMemorySubsystem InSubsystem, const int64 InBytes);
+
+    /**
+     * @brief Removes a consumer.
+     * @param InName The unique name of the consumer.
+     */
+    UFUNCTION(BlueprintCallable, Category = "PT_MemoryBudgetManager")
+    static void ReleaseUsage(const FString& InName);
+
+    /**
+     * @brief Checks whether a load fits into the budget before it allocates, relieving the consumers if needed.
+     *
+     * A consumer that replaces its data has to release it and report its usage first, so only the new data is requested.
+     *
+     * @param InName The unique name of the consumer.
+     * @param InSubsystem The subsystem the consumer belongs to, only used for the message.
+     * @param InAdditionalBytes The bytes the load adds to the reported usage.
+     * @param OutMessage Receives the reason if the load does not fit.
+     * @return True if the load fits into the budget.
+     */
+    UFUNCTION(BlueprintCallable, Category = "PT_MemoryBudgetManager")
+    static bool RequestAllocation(const FString& InName, const EMemorySubsystem InSubsystem, const int64 InAdditionalBytes, FString& OutMessage);
+
+    /**
+     * @brief Gets the message of the last rejected allocation.
+     * @return The message, empty if no allocation was rejected yet.
+     */
+    UFUNCTION(BlueprintPure, Category = "PT_MemoryBudgetManager")
+    static FString GetLastErrorMessage() { return LAST_ERROR_MESSAGE; }
+
+    /**
+     * @brief Gets the largest consumers.
+     * @param InCount The maximum number of consumers. If not positive, all consumers are returned.
+     * @return The consumers, largest first.
+     */
+    UFUNCTION(BlueprintCallable, Category = "PT_MemoryBudgetManager")
+    static TArray<FPT_MemoryConsumer> GetTopConsumers(const int32 InCount);
+
+    /**
+     * @brief Gets the bytes held by all consumers.
+     * @return The number of bytes.
+     */
+    UFUNCTION(BlueprintPure, Category = "PT_MemoryBudgetManager")
+    static int64 GetTotalBytes();
+
+    /**
+     * @brief Gets the bytes held by the consumers of one subsystem.
+     * @param InSubsystem The subsystem.
+     * @return The number of bytes.
+     */
+    UFUNCTION(BlueprintPure, Category = "PT_MemoryBudgetManager")
+    static int64 GetSubsystemBytes(const EMemorySubsystem InSubsystem);
+
+    /**
+     * @brief Logs the budget, the bytes per subsystem and the largest consumers.
+     * @param InCount The maximum number of consumers to log.
+     */
+    UFUNCTION(BlueprintCallable, Category = "PT_MemoryBudgetManager")
+    static void LogMemoryStats(const int32 InCount = 10);
+
+    /**
+     * @brief Registers the relief handler of a consumer, replacing a previous one.
+     * @param InName The unique name of the consumer.
+     * @param InHandler The handler.
+     */
+    static void RegisterReliefHandler(const FString& InName, FReliefHandler&& InHandler);
+
+    /**
+     * @brief Removes the relief handler of a consumer.
+     * @param InName The unique name of the consumer.
+     */
+    static void UnregisterReliefHandler(const FString& InName);
+
+private:
+    /**
+     * @brief Asks the relief handlers to free memory, largest consumer first.
+     * @param InBytesToFree The number of bytes to free.
+     * @return The number of bytes freed.
+     */
+    static int64 Relieve(const int64 InBytesToFree);
+
+    /** @brief Formats bytes as megabytes for messages. */
+    static FString FormatMB(const int64 InBytes) { return FString::Printf(TEXT("%.1f MB"), InBytes / (1024.0 * 1024.0)); }
+
+    static int32 BUDGET_MB; ///< The memory budget in megabytes, 0 if unlimited.
+    static TMap<FString, FPT_MemoryConsumer> CONSUMER_MAP; ///< The consumers by name.
+    static TMap<FString, FReliefHandler> RELIEF_HANDLER_MAP; ///< The relief handlers by consumer name.
+    static FString LAST_ERROR_MESSAGE; ///< The message of the last rejected allocation.
+    static bool bIS_RELIEVING; ///< Whether the relief handlers are running, reports made by them do not trigger relief again.
+};
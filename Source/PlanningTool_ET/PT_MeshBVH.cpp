@@ -0,0 +1,493 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_MeshBVH.h"
+#include "Algo/Partition.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+
+/** Maximum number of triangles per leaf. */
+static constexpr int32 MaxLeafTriangles = 4;
+
+/** Number of candidate split planes per node and axis. */
+static constexpr int32 NumSplitBins = 16;
+
+/** Inline capacity of the traversal stack, deeper hierarchies spill to the heap. */
+static constexpr int32 TraversalStackSize = 64;
+
+/** Depth from which nodes are split at the median centroid, which halves them and bounds the depth of the hierarchy. */
+static constexpr int32 MaxSurfaceAreaDepth = 32;
+
+/** Entry distance of a ray into a box, negative if the ray misses it within InMaxDistance. */
+static FORCEINLINE double IntersectBox(const FVector& InMin, const FVector& InMax, const FVector& InOrigin, const FVector& InInvDirection, const double InMaxDistance)
+{
+	const FVector T1 = (InMin - InOrigin) * InInvDirection;
+	const FVector T2 = (InMax - InOrigin) * InInvDirection;
+	const double Near = FMath::Max3(FMath::Min(T1.X, T2.X), FMath::Min(T1.Y, T2.Y), FMath::Min(T1.Z, T2.Z));
+	const double Far = FMath::Min3(FMath::Max(T1.X, T2.X), FMath::Max(T1.Y, T2.Y), FMath::Max(T1.Z, T2.Z));
+	return (Far >= FMath::Max(Near, 0.0) && Near <= InMaxDistance) ? FMath::Max(Near, 0.0) : -1.0;
+}
+
+/** Squared distance between a point and a box, zero inside. */
+static FORCEINLINE double BoxDistanceSquared(const FVector& InMin, const FVector& InMax, const FVector& InPoint)
+{
+	const FVector Outside = (InMin - InPoint).ComponentMax(InPoint - InMax).ComponentMax(FVector::ZeroVector);
+	return Outside.SizeSquared();
+}
+
+/**
+ * Closest point on the triangle (A, A + AB, A + AC) to a point, as the weights U of B and V of C.
+ * Follows Ericson, Real-Time Collision Detection, 5.1.5.
+ */
+static void ClosestPointOnTriangle(const FVector& InPoint, const FVector& InA, const FVector& InAB, const FVector& InAC, double& OutU, double& OutV)
+{
+	const FVector AP = InPoint - InA;
+	const double D1 = FVector::DotProduct(InAB, AP);
+	const double D2 = FVector::DotProduct(InAC, AP);
+	if (D1 <= 0.0 && D2 <= 0.0)
+	{
+		OutU = 0.0;
+		OutV = 0.0;
+		return;
+	}
+
+	const FVector BP = AP - InAB;
+	const double D3 = FVector::DotProduct(InAB, BP);
+	const double D4 = FVector::DotProduct(InAC, BP);
+	if (D3 >= 0.0 && D4 <= D3)
+	{
+		OutU = 1.0;
+		OutV = 0.0;
+		return;
+	}
+
+	const double VC = D1 * D4 - D3 * D2;
+	if (VC <= 0.0 && D1 >= 0.0 && D3 <= 0.0)
+	{
+		OutU = D1 / (D1 - D3);
+		OutV = 0.0;
+		return;
+	}
+
+	const FVector CP = AP - InAC;
+	const double D5 = FVector::DotProduct(InAB, CP);
+	const double D6 = FVector::DotProduct(InAC, CP);
+	if (D6 >= 0.0 && D5 <= D6)
+	{
+		OutU = 0.0;
+		OutV = 1.0;
+		return;
+	}
+
+	const double VB = D5 * D2 - D1 * D6;
+	if (VB <= 0.0 && D2 >= 0.0 && D6 <= 0.0)
+	{
+		OutU = 0.0;
+		OutV = D2 / (D2 - D6);
+		return;
+	}
+
+	const double VA = D3 * D6 - D5 * D4;
+	if (VA <= 0.0 && (D4 - D3) >= 0.0 && (D5 - D6) >= 0.0)
+	{
+		const double W = (D4 - D3) / ((D4 - D3) + (D5 - D6));
+		OutU = 1.0 - W;
+		OutV = W;
+		return;
+	}
+
+	const double InvDenominator = 1.0 / (VA + VB + VC);
+	OutU = VB * InvDenominator;
+	OutV = VC * InvDenominator;
+}
+
+bool FPT_MeshBVH::Build(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray)
+{
+	this->Reset();
+
+	// Triangles referring to missing vertices are left out
+	TArray<FVector> Centroids;
+	TArray<FBox> Bounds;
+	const int32 NumTriangles = InTriangleIndexArray.Num() / 3;
+	Centroids.SetNumUninitialized(NumTriangles);
+	Bounds.SetNumUninitialized(NumTriangles);
+	for (int32 Triangle = 0; Triangle < NumTriangles; Triangle++)
+	{
+		const int32* Corners = InTriangleIndexArray.GetData() + Triangle * 3;
+		if (!InVertexArray.IsValidIndex(Corners[0]) || !InVertexArray.IsValidIndex(Corners[1]) || !InVertexArray.IsValidIndex(Corners[2]))
+		{
+			continue;
+		}
+
+		const FVector& A = InVertexArray[Corners[0]];
+		const FVector& B = InVertexArray[Corners[1]];
+		const FVector& C = InVertexArray[Corners[2]];
+		Centroids[Triangle] = (A + B + C) / 3.0;
+		Bounds[Triangle] = FBox(A.ComponentMin(B).ComponentMin(C), A.ComponentMax(B).ComponentMax(C));
+		this->TriangleIndices.Add(Triangle);
+	}
+
+	if (this->TriangleIndices.IsEmpty())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[FPT_MeshBVH::Build] The mesh has no valid triangles."));
+		return false;
+	}
+
+	FBox RootBounds(ForceInit);
+	for (const int32 Triangle : this->TriangleIndices)
+	{
+		RootBounds += Bounds[Triangle];
+	}
+
+	this->Nodes.Reserve(2 * this->TriangleIndices.Num() / MaxLeafTriangles + 1);
+	FNode& Root = this->Nodes.AddDefaulted_GetRef();
+	Root.Min = RootBounds.Min;
+	Root.Max = RootBounds.Max;
+	Root.FirstChildOrTriangle = 0;
+	Root.NumTriangles = this->TriangleIndices.Num();
+	this->Split(0, 0, Centroids, Bounds);
+
+	// Corner and edges per triangle in leaf order, so the intersection tests need no index lookups
+	this->TriangleCorners.SetNumUninitialized(this->TriangleIndices.Num() * 3);
+	for (int32 Slot = 0; Slot < this->TriangleIndices.Num(); Slot++)
+	{
+		const int32* Corners = InTriangleIndexArray.GetData() + this->TriangleIndices[Slot] * 3;
+		const FVector& A = InVertexArray[Corners[0]];
+		this->TriangleCorners[Slot * 3 + 0] = A;
+		this->TriangleCorners[Slot * 3 + 1] = InVertexArray[Corners[1]] - A;
+		this->TriangleCorners[Slot * 3 + 2] = InVertexArray[Corners[2]] - A;
+	}
+	return true;
+}
+
+void FPT_MeshBVH::Split(const int32 InNode, const int32 InDepth, TArray<FVector>& InOutCentroids, TArray<FBox>& InOutBounds)
+{
+	const int32 First = this->Nodes[InNode].FirstChildOrTriangle;
+	const int32 Num = this->Nodes[InNode].NumTriangles;
+	if (Num <= MaxLeafTriangles)
+	{
+		return;
+	}
+
+	int32* Triangles = this->TriangleIndices.GetData() + First;
+	FBox CentroidBounds(ForceInit);
+	for (int32 i = 0; i < Num; i++)
+	{
+		CentroidBounds += InOutCentroids[Triangles[i]];
+	}
+
+	const FVector Extent = CentroidBounds.GetSize();
+	const int32 Axis = (Extent.X >= Extent.Y && Extent.X >= Extent.Z) ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+	if (Extent[Axis] <= UE_DOUBLE_SMALL_NUMBER)
+	{
+		// All centroids coincide, no plane separates them
+		return;
+	}
+
+	// Surface area heuristic over equally spaced planes along the axis of the largest centroid spread
+	const double BinScale = NumSplitBins / Extent[Axis];
+	const double BinOrigin = CentroidBounds.Min[Axis];
+	auto GetBin = [&InOutCentroids, Axis, BinScale, BinOrigin](const int32 InTriangle)
+	{
+		return FMath::Clamp((int32)((InOutCentroids[InTriangle][Axis] - BinOrigin) * BinScale), 0, NumSplitBins - 1);
+	};
+
+	FBox BinBounds[NumSplitBins];
+	int32 BinCounts[NumSplitBins] = {};
+	for (int32 Bin = 0; Bin < NumSplitBins; Bin++)
+	{
+		BinBounds[Bin] = FBox(ForceInit);
+	}
+	for (int32 i = 0; i < Num; i++)
+	{
+		const int32 Bin = GetBin(Triangles[i]);
+		BinBounds[Bin] += InOutBounds[Triangles[i]];
+		BinCounts[Bin]++;
+	}
+
+	auto GetArea = [](const FBox& InBox)
+	{
+		if (!InBox.IsValid)
+		{
+			return 0.0;
+		}
+		const FVector Size = InBox.GetSize();
+		return Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X;
+	};
+
+	double RightCosts[NumSplitBins];
+	FBox RightBounds(ForceInit);
+	int32 RightCount = 0;
+	for (int32 Bin = NumSplitBins - 1; Bin > 0; Bin--)
+	{
+		RightBounds += BinBounds[Bin];
+		RightCount += BinCounts[Bin];
+		RightCosts[Bin] = RightCount * GetArea(RightBounds);
+	}
+
+	// Deep nodes skip the plane search, a degenerate mesh would otherwise peel off a few triangles per level
+	int32 BestBin = INDEX_NONE;
+	double BestCost = UE_DOUBLE_BIG_NUMBER;
+	FBox LeftBounds(ForceInit);
+	int32 LeftCount = 0;
+	for (int32 Bin = 0; Bin < NumSplitBins - 1 && InDepth < MaxSurfaceAreaDepth; Bin++)
+	{
+		LeftBounds += BinBounds[Bin];
+		LeftCount += BinCounts[Bin];
+		const double Cost = LeftCount * GetArea(LeftBounds) + RightCosts[Bin + 1];
+		if (LeftCount > 0 && LeftCount < Num && Cost < BestCost)
+		{
+			BestCost = Cost;
+			BestBin = Bin;
+		}
+	}
+
+	int32 NumLeft = 0;
+	if (BestBin != INDEX_NONE)
+	{
+		NumLeft = Algo::Partition(Triangles, Num, [&GetBin, BestBin](const int32 InTriangle) { return GetBin(InTriangle) <= BestBin; });
+	}
+
+	// Without a separating plane or below the surface area depth the triangles are split at the median centroid
+	if (NumLeft == 0 || NumLeft == Num)
+	{
+		Algo::Sort(MakeArrayView(Triangles, Num), [&InOutCentroids, Axis](const int32 A, const int32 B) { return InOutCentroids[A][Axis] < InOutCentroids[B][Axis]; });
+		NumLeft = Num / 2;
+	}
+
+	const int32 LeftChild = this->Nodes.Num();
+	this->Nodes.AddDefaulted(2);
+	for (int32 Child = 0; Child < 2; Child++)
+	{
+		FNode& ChildNode = this->Nodes[LeftChild + Child];
+		ChildNode.FirstChildOrTriangle = (Child == 0) ? First : First + NumLeft;
+		ChildNode.NumTriangles = (Child == 0) ? NumLeft : Num - NumLeft;
+
+		FBox ChildBounds(ForceInit);
+		for (int32 i = 0; i < ChildNode.NumTriangles; i++)
+		{
+			ChildBounds += InOutBounds[this->TriangleIndices[ChildNode.FirstChildOrTriangle + i]];
+		}
+		ChildNode.Min = ChildBounds.Min;
+		ChildNode.Max = ChildBounds.Max;
+	}
+
+	this->Nodes[InNode].FirstChildOrTriangle = LeftChild;
+	this->Nodes[InNode].NumTriangles = 0;
+
+	this->Split(LeftChild, InDepth + 1, InOutCentroids, InOutBounds);
+	this->Split(LeftChild + 1, InDepth + 1, InOutCentroids, InOutBounds);
+}
+
+void FPT_MeshBVH::Reset()
+{
+	this->Nodes.Empty();
+	this->TriangleCorners.Empty();
+	this->TriangleIndices.Empty();
+}
+
+void FPT_MeshBVH::FillHit(const int32 InSlot, const double InU, const double InV, const double InDistance, const FVector& InFacing, FPT_MeshHit& OutHit) const
+{
+	const FVector& A = this->TriangleCorners[InSlot * 3 + 0];
+	const FVector& AB = this->TriangleCorners[InSlot * 3 + 1];
+	const FVector& AC = this->TriangleCorners[InSlot * 3 + 2];
+
+	OutHit.Triangle = this->TriangleIndices[InSlot];
+	OutHit.Distance = InDistance;
+	OutHit.Position = A + InU * AB + InV * AC;
+	OutHit.Barycentric = FVector(1.0 - InU - InV, InU, InV);
+	OutHit.Normal = FVector::CrossProduct(AB, AC).GetSafeNormal();
+	if (FVector::DotProduct(OutHit.Normal, InFacing) < 0.0)
+	{
+		OutHit.Normal = -OutHit.Normal;
+	}
+}
+
+bool FPT_MeshBVH::Raycast(const FVector& InOrigin, const FVector& InDirection, const double InMaxDistance, FPT_MeshHit& OutHit) const
+{
+	OutHit = FPT_MeshHit();
+	const FVector Direction = InDirection.GetSafeNormal();
+	if (!this->IsBuilt() || Direction.IsZero())
+	{
+		return false;
+	}
+
+	// Zero components get a huge inverse instead of infinity, so origins on a slab plane do not produce NaN
+	const FVector InvDirection(
+		Direction.X != 0.0 ? 1.0 / Direction.X : UE_DOUBLE_BIG_NUMBER,
+		Direction.Y != 0.0 ? 1.0 / Direction.Y : UE_DOUBLE_BIG_NUMBER,
+		Direction.Z != 0.0 ? 1.0 / Direction.Z : UE_DOUBLE_BIG_NUMBER);
+
+	double BestDistance = InMaxDistance;
+	int32 BestSlot = INDEX_NONE;
+	double BestU = 0.0;
+	double BestV = 0.0;
+
+	TArray<int32, TInlineAllocator<TraversalStackSize>> Stack;
+	if (IntersectBox(this->Nodes[0].Min, this->Nodes[0].Max, InOrigin, InvDirection, BestDistance) >= 0.0)
+	{
+		Stack.Push(0);
+	}
+
+	while (Stack.Num() > 0)
+	{
+		const FNode& Node = this->Nodes[Stack.Pop(false)];
+		if (Node.IsLeaf())
+		{
+			// Two-sided Moeller-Trumbore
+			for (int32 Slot = Node.FirstChildOrTriangle; Slot < Node.FirstChildOrTriangle + Node.NumTriangles; Slot++)
+			{
+				const FVector& A = this->TriangleCorners[Slot * 3 + 0];
+				const FVector& AB = this->TriangleCorners[Slot * 3 + 1];
+				const FVector& AC = this->TriangleCorners[Slot * 3 + 2];
+
+				const FVector P = FVector::CrossProduct(Direction, AC);
+				const double Determinant = FVector::DotProduct(AB, P);
+				if (FMath::Abs(Determinant) <= UE_DOUBLE_SMALL_NUMBER)
+				{
+					continue;
+				}
+
+				const double InvDeterminant = 1.0 / Determinant;
+				const FVector T = InOrigin - A;
+				const double U = FVector::DotProduct(T, P) * InvDeterminant;
+				if (U < 0.0 || U > 1.0)
+				{
+					continue;
+				}
+
+				const FVector Q = FVector::CrossProduct(T, AB);
+				const double V = FVector::DotProduct(Direction, Q) * InvDeterminant;
+				if (V < 0.0 || U + V > 1.0)
+				{
+					continue;
+				}
+
+				const double Distance = FVector::DotProduct(AC, Q) * InvDeterminant;
+				if (Distance >= 0.0 && Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					BestSlot = Slot;
+					BestU = U;
+					BestV = V;
+				}
+			}
+			continue;
+		}
+
+		// The nearer child is pushed last, so it is visited first and shortens the ray for the other one
+		const int32 Left = Node.FirstChildOrTriangle;
+		const double LeftDistance = IntersectBox(this->Nodes[Left].Min, this->Nodes[Left].Max, InOrigin, InvDirection, BestDistance);
+		const double RightDistance = IntersectBox(this->Nodes[Left + 1].Min, this->Nodes[Left + 1].Max, InOrigin, InvDirection, BestDistance);
+		const bool bIsLeftNearer = LeftDistance >= 0.0 && (RightDistance < 0.0 || LeftDistance <= RightDistance);
+		const int32 Near = bIsLeftNearer ? Left : Left + 1;
+		const int32 Far = bIsLeftNearer ? Left + 1 : Left;
+		if ((bIsLeftNearer ? RightDistance : LeftDistance) >= 0.0)
+		{
+			Stack.Push(Far);
+		}
+		if ((bIsLeftNearer ? LeftDistance : RightDistance) >= 0.0)
+		{
+			Stack.Push(Near);
+		}
+	}
+
+	if (BestSlot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	this->FillHit(BestSlot, BestU, BestV, BestDistance, -Direction, OutHit);
+	return true;
+}
+
+bool FPT_MeshBVH::FindClosestPoint(const FVector& InPoint, const double InMaxDistance, FPT_MeshHit& OutHit) const
+{
+	OutHit = FPT_MeshHit();
+	if (!this->IsBuilt())
+	{
+		return false;
+	}
+
+	double BestDistanceSquared = InMaxDistance * InMaxDistance;
+	int32 BestSlot = INDEX_NONE;
+	double BestU = 0.0;
+	double BestV = 0.0;
+
+	TArray<int32, TInlineAllocator<TraversalStackSize>> Stack;
+	Stack.Push(0);
+
+	while (Stack.Num() > 0)
+	{
+		const FNode& Node = this->Nodes[Stack.Pop(false)];
+		if (BoxDistanceSquared(Node.Min, Node.Max, InPoint) > BestDistanceSquared)
+		{
+			continue;
+		}
+
+		if (Node.IsLeaf())
+		{
+			for (int32 Slot = Node.FirstChildOrTriangle; Slot < Node.FirstChildOrTriangle + Node.NumTriangles; Slot++)
+			{
+				const FVector& A = this->TriangleCorners[Slot * 3 + 0];
+				const FVector& AB = this->TriangleCorners[Slot * 3 + 1];
+				const FVector& AC = this->TriangleCorners[Slot * 3 + 2];
+
+				double U = 0.0;
+				double V = 0.0;
+				ClosestPointOnTriangle(InPoint, A, AB, AC, U, V);
+				const double DistanceSquared = FVector::DistSquared(InPoint, A + U * AB + V * AC);
+				if (DistanceSquared < BestDistanceSquared)
+				{
+					BestDistanceSquared = DistanceSquared;
+					BestSlot = Slot;
+					BestU = U;
+					BestV = V;
+				}
+			}
+			continue;
+		}
+
+		const int32 Left = Node.FirstChildOrTriangle;
+		const double LeftDistanceSquared = BoxDistanceSquared(this->Nodes[Left].Min, this->Nodes[Left].Max, InPoint);
+		const double RightDistanceSquared = BoxDistanceSquared(this->Nodes[Left + 1].Min, this->Nodes[Left + 1].Max, InPoint);
+		const bool bIsLeftNearer = LeftDistanceSquared <= RightDistanceSquared;
+		Stack.Push(bIsLeftNearer ? Left + 1 : Left);
+		Stack.Push(bIsLeftNearer ? Left : Left + 1);
+	}
+
+	if (BestSlot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	const FVector& A = this->TriangleCorners[BestSlot * 3 + 0];
+	const FVector Position = A + BestU * this->TriangleCorners[BestSlot * 3 + 1] + BestV * this->TriangleCorners[BestSlot * 3 + 2];
+	this->FillHit(BestSlot, BestU, BestV, FMath::Sqrt(BestDistanceSquared), InPoint - Position, OutHit);
+	return true;
+}
+
+void FPT_MeshBVH::RaycastBatch(const TArray<FVector>& InOrigins, const TArray<FVector>& InDirections, const double InMaxDistance, TArray<FPT_MeshHit>& OutHits) const
+{
+	OutHits.SetNum(InOrigins.Num());
+	if (InDirections.Num() != 1 && InDirections.Num() != InOrigins.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_MeshBVH::RaycastBatch] %d directions given for %d rays!"), InDirections.Num(), InOrigins.Num());
+		OutHits.Init(FPT_MeshHit(), InOrigins.Num());
+		return;
+	}
+
+	ParallelFor(InOrigins.Num(), [this, &InOrigins, &InDirections, InMaxDistance, &OutHits](const int32 RayIndex)
+	{
+		this->Raycast(InOrigins[RayIndex], InDirections[InDirections.Num() == 1 ? 0 : RayIndex], InMaxDistance, OutHits[RayIndex]);
+	});
+}
+
+void FPT_MeshBVH::FindClosestPointBatch(const TArray<FVector>& InPoints, const double InMaxDistance, TArray<FPT_MeshHit>& OutHits) const
+{
+	OutHits.SetNum(InPoints.Num());
+	ParallelFor(InPoints.Num(), [this, &InPoints, InMaxDistance, &OutHits](const int32 PointIndex)
+	{
+		this->FindClosestPoint(InPoints[PointIndex], InMaxDistance, OutHits[PointIndex]);
+	});
+}
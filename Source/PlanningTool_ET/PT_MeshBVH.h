@@ -0,0 +1,136 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_MeshBVH.h
+ * @brief Header file for the FPT_MeshBVH class.
+ *
+ * This file contains the declaration of the FPT_MeshBVH class, a bounding volume hierarchy over the triangles of a mesh
+ * that answers ray and closest point queries on the CPU, without the collision of the physics engine.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * @struct FPT_MeshHit
+ * @brief The result of a ray or closest point query.
+ */
+struct PLANNINGTOOL_ET_API FPT_MeshHit
+{
+	/** @brief The index of the hit triangle in the triangle index array, INDEX_NONE if nothing was hit. */
+	int32 Triangle = INDEX_NONE;
+
+	/** @brief The distance along the ray, or between the query point and the closest point. */
+	double Distance = 0.0;
+
+	/** @brief The hit position. */
+	FVector Position = FVector::ZeroVector;
+
+	/** @brief The unit face normal, facing the ray origin or the query point. */
+	FVector Normal = FVector::ZeroVector;
+
+	/** @brief The barycentric weights of the three triangle corners at the hit position. */
+	FVector Barycentric = FVector::ZeroVector;
+
+	/** @brief Whether something was hit. */
+	bool IsValid() const { return this->Triangle != INDEX_NONE; }
+};
+
+/**
+ * @class FPT_MeshBVH
+ * @brief A bounding volume hierarchy over the triangles of a mesh.
+ *
+ * The hierarchy is built top-down, every node is split at the cheapest of several candidate planes by the surface area
+ * heuristic. The triangles are stored in leaf order, so a leaf reads its triangles from consecutive memory. Rays are
+ * intersected two-sided. The hierarchy is built once per mesh, all queries are const and can be issued from several
+ * threads at the same time. Positions are in the space of the vertices passed to Build().
+ */
+class PLANNINGTOOL_ET_API FPT_MeshBVH
+{
+public:
+	/**
+	 * @brief Builds the hierarchy.
+	 * @param InVertexArray The mesh vertices.
+	 * @param InTriangleIndexArray Three vertex indices per triangle.
+	 * @return True if the mesh has at least one triangle.
+	 */
+	bool Build(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray);
+
+	/**
+	 * @brief Releases all data.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Finds the first triangle hit by a ray.
+	 * @param InOrigin The ray origin.
+	 * @param InDirection The ray direction, does not have to be normalized.
+	 * @param InMaxDistance The length of the ray.
+	 * @param OutHit Receives the nearest hit.
+	 * @return True if a triangle was hit.
+	 */
+	bool Raycast(const FVector& InOrigin, const FVector& InDirection, const double InMaxDistance, FPT_MeshHit& OutHit) const;
+
+	/**
+	 * @brief Finds the closest point on the mesh.
+	 * @param InPoint The query point.
+	 * @param InMaxDistance Points farther away are not considered.
+	 * @param OutHit Receives the closest point.
+	 * @return True if a point within InMaxDistance was found.
+	 */
+	bool FindClosestPoint(const FVector& InPoint, const double InMaxDistance, FPT_MeshHit& OutHit) const;
+
+	/**
+	 * @brief Casts many rays in parallel.
+	 * @param InOrigins The ray origins.
+	 * @param InDirections The ray directions, one per origin or a single one shared by all rays.
+	 * @param InMaxDistance The length of every ray.
+	 * @param OutHits Receives one hit per ray.
+	 */
+	void RaycastBatch(const TArray<FVector>& InOrigins, const TArray<FVector>& InDirections, const double InMaxDistance, TArray<FPT_MeshHit>& OutHits) const;
+
+	/**
+	 * @brief Finds the closest points of many query points in parallel.
+	 * @param InPoints The query points.
+	 * @param InMaxDistance Points farther away are not considered.
+	 * @param OutHits Receives one closest point per query point.
+	 */
+	void FindClosestPointBatch(const TArray<FVector>& InPoints, const double InMaxDistance, TArray<FPT_MeshHit>& OutHits) const;
+
+	/** @brief Whether the hierarchy holds at least one triangle. */
+	bool IsBuilt() const { return this->Nodes.Num() > 0; }
+
+	/** @brief Gets the bounding box of the mesh. */
+	FBox GetBounds() const { return this->IsBuilt() ? FBox(this->Nodes[0].Min, this->Nodes[0].Max) : FBox(ForceInit); }
+
+	/** @brief Gets the number of bytes held by the hierarchy. */
+	SIZE_T GetAllocatedSize() const { return this->Nodes.GetAllocatedSize() + this->TriangleCorners.GetAllocatedSize() + this->TriangleIndices.GetAllocatedSize(); }
+
+private:
+	/** @brief A node of the hierarchy. Inner nodes store their first child, the second one follows it. */
+	struct FNode
+	{
+		FVector Min;
+		FVector Max;
+		int32 FirstChildOrTriangle = 0;
+		int32 NumTriangles = 0;
+
+		bool IsLeaf() const { return this->NumTriangles > 0; }
+	};
+
+	/** @brief Splits a node into two children, recursing until the leaves are small. Deep nodes are split at the median. */
+	void Split(const int32 InNode, const int32 InDepth, TArray<FVector>& InOutCentroids, TArray<FBox>& InOutBounds);
+
+	/** @brief Fills the hit of a triangle from its barycentric weights. */
+	void FillHit(const int32 InSlot, const double InU, const double InV, const double InDistance, const FVector& InFacing, FPT_MeshHit& OutHit) const;
+
+	/** @brief The nodes, the root first. */
+	TArray<FNode> Nodes;
+
+	/** @brief Corner A, edge AB and edge AC per triangle in leaf order, [Slot * 3 + k]. */
+	TArray<FVector> TriangleCorners;
+
+	/** @brief Index in the triangle index array (divided by three) per triangle in leaf order. */
+	TArray<int32> TriangleIndices;
+};
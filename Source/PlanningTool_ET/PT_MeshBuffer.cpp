@@ -0,0 +1,84 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_MeshBuffer.h"
+
+FPT_MeshBufferPtr FPT_MeshBuffer::Create(TArray<FVector>&& InVertexArray, TArray<FVector>&& InNormalArray, TArray<int32>&& InTriangleIndexArray)
+{
+	// A buffer may hold normals only, e.g. normals set by a Blueprint without their mesh
+	if (InVertexArray.Num() > 0 && InNormalArray.Num() > 0 && InNormalArray.Num() != InVertexArray.Num())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[FPT_MeshBuffer::Create] %d normals do not match %d vertices, the normals are dropped."), InNormalArray.Num(), InVertexArray.Num());
+		InNormalArray.Empty();
+	}
+
+	TSharedRef<FPT_MeshBuffer, ESPMode::ThreadSafe> Buffer = MakeShared<FPT_MeshBuffer, ESPMode::ThreadSafe>();
+	Buffer->VertexArray = MoveTemp(InVertexArray);
+	Buffer->NormalArray = MoveTemp(InNormalArray);
+	Buffer->TriangleIndexArray = MoveTemp(InTriangleIndexArray);
+	return Buffer;
+}
+
+const FPT_MeshBuffer& FPT_MeshBuffer::GetEmpty()
+{
+	static const FPT_MeshBuffer EmptyBuffer;
+	return EmptyBuffer;
+}
+
+SIZE_T FPT_MeshBuffer::GetUnsharedSize(const FPT_MeshBufferPtr& InBuffer)
+{
+	return InBuffer.IsValid() && InBuffer.IsUnique() ? InBuffer->GetAllocatedSize() : 0;
+}
+
+void FPT_MeshBuffer::CreatePointCloudArray(const TArray<int32>& InVertexIndexArray, const TArray<FLinearColor>& InVertexColorArray, TArray<FLidarPointCloudPoint>& OutPointCloudArray) const
+{
+	OutPointCloudArray.Empty(InVertexIndexArray.Num());
+	for (const int32 Index : InVertexIndexArray)
+	{
+		if (this->VertexArray.IsValidIndex(Index) && InVertexColorArray.IsValidIndex(Index))
+		{
+			const FVector& Vertex = this->VertexArray[Index];
+			const FLinearColor& Color = InVertexColorArray[Index];
+			OutPointCloudArray.Add(FLidarPointCloudPoint(Vertex.X, Vertex.Y, Vertex.Z, Color.R, Color.G, Color.B));
+		}
+	}
+}
+
+SIZE_T FPT_MeshBuffer::GetAllocatedSize() const
+{
+	return sizeof(FPT_MeshBuffer) + this->VertexArray.GetAllocatedSize() + this->NormalArray.GetAllocatedSize() + this->TriangleIndexArray.GetAllocatedSize();
+}
+
+UPT_MeshBufferHandle* UPT_MeshBufferHandle::Create(UObject* InOuter, const FPT_MeshBufferPtr& InBuffer)
+{
+	UPT_MeshBufferHandle* Handle = NewObject<UPT_MeshBufferHandle>(InOuter);
+	Handle->Buffer = InBuffer;
+	return Handle;
+}
+
+FVector UPT_MeshBufferHandle::GetVertex(const int32& InIndex) const
+{
+	const TArray<FVector>& VertexArray = this->GetBuffer().GetVertexArray();
+	return VertexArray.IsValidIndex(InIndex) ? VertexArray[InIndex] : FVector::ZeroVector;
+}
+
+FVector UPT_MeshBufferHandle::GetNormal(const int32& InIndex) const
+{
+	const TArray<FVector>& NormalArray = this->GetBuffer().GetNormalArray();
+	return NormalArray.IsValidIndex(InIndex) ? NormalArray[InIndex] : FVector::ZeroVector;
+}
+
+void UPT_MeshBufferHandle::GetVertices(const TArray<int32>& InVertexIndexArray, TArray<FVector>& OutVertexArray) const
+{
+	const TArray<FVector>& VertexArray = this->GetBuffer().GetVertexArray();
+	OutVertexArray.SetNumUninitialized(InVertexIndexArray.Num());
+	for (int32 i = 0; i < InVertexIndexArray.Num(); i++)
+	{
+		OutVertexArray[i] = VertexArray.IsValidIndex(InVertexIndexArray[i]) ? VertexArray[InVertexIndexArray[i]] : FVector::ZeroVector;
+	}
+}
+
+void UPT_MeshBufferHandle::CreatePointCloudArray(const TArray<int32>& InVertexIndexArray, const TArray<FLinearColor>& InVertexColorArray, TArray<FLidarPointCloudPoint>& OutPointCloudArray) const
+{
+	this->GetBuffer().CreatePointCloudArray(InVertexIndexArray, InVertexColorArray, OutPointCloudArray);
+}
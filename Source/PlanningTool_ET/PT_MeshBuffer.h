@@ -0,0 +1,194 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_MeshBuffer.h
+ * @brief Header file for the FPT_MeshBuffer class and the UPT_MeshBufferHandle class.
+ *
+ * This file contains the declaration of the FPT_MeshBuffer class, an immutable mesh shared by reference counting
+ * between the mesh actors, the simulation component and the point cloud code, and of the UPT_MeshBufferHandle class,
+ * which gives Blueprints access to one buffer without copying it.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include <LidarPointCloudShared.h>
+#include "PT_MeshBuffer.generated.h"
+
+class FPT_MeshBuffer;
+
+/** @brief A shared reference to an immutable mesh buffer. */
+typedef TSharedPtr<const FPT_MeshBuffer, ESPMode::ThreadSafe> FPT_MeshBufferPtr;
+
+/**
+ * @class FPT_MeshBuffer
+ * @brief The vertices, normals and triangle indices of one loaded mesh, immutable once created.
+ *
+ * A buffer is created by moving the loaded arrays in and is only handed out as a const shared pointer, so every
+ * holder reads the same memory and no holder can change it under the others. Reloading a mesh creates a new buffer;
+ * the old one is freed when its last holder, e.g. a worker thread or a Blueprint handle, lets go of it.
+ */
+class PLANNINGTOOL_ET_API FPT_MeshBuffer
+{
+public:
+	/**
+	 * @brief Creates a buffer by moving the arrays in.
+	 * @param InVertexArray The vertices.
+	 * @param InNormalArray The vertex normals, one per vertex, empty, or alone without vertices.
+	 * @param InTriangleIndexArray Three vertex indices per triangle, may be empty, e.g. for multi meshes keeping their triangles per tag.
+	 * @return The shared buffer.
+	 */
+	static FPT_MeshBufferPtr Create(TArray<FVector>&& InVertexArray, TArray<FVector>&& InNormalArray, TArray<int32>&& InTriangleIndexArray);
+
+	/** @brief Gets a buffer without data, used where no mesh is loaded. */
+	static const FPT_MeshBuffer& GetEmpty();
+
+	/**
+	 * @brief Gets the bytes of a buffer that is not shared, so shared buffers are only reported by their owner.
+	 * @param InBuffer The buffer, may be invalid.
+	 * @return The number of bytes, 0 if the buffer is invalid or shared.
+	 */
+	static SIZE_T GetUnsharedSize(const FPT_MeshBufferPtr& InBuffer);
+
+	/** @brief Gets the vertices. */
+	const TArray<FVector>& GetVertexArray() const { return this->VertexArray; }
+
+	/** @brief Gets the vertex normals. */
+	const TArray<FVector>& GetNormalArray() const { return this->NormalArray; }
+
+	/** @brief Gets the triangle indices. */
+	const TArray<int32>& GetTriangleIndexArray() const { return this->TriangleIndexArray; }
+
+	/** @brief Gets the number of vertices. */
+	int32 GetNumVertices() const { return this->VertexArray.Num(); }
+
+	/** @brief Gets the number of triangles. */
+	int32 GetNumTriangles() const { return this->TriangleIndexArray.Num() / 3; }
+
+	/**
+	 * @brief Creates the points of a point cloud from a subset of the vertices.
+	 * @param InVertexIndexArray The vertices of the point cloud. Indices out of range are left out.
+	 * @param InVertexColorArray The color of every vertex of the buffer.
+	 * @param OutPointCloudArray Receives one point per valid vertex index.
+	 */
+	void CreatePointCloudArray(const TArray<int32>& InVertexIndexArray, const TArray<FLinearColor>& InVertexColorArray, TArray<FLidarPointCloudPoint>& OutPointCloudArray) const;
+
+	/** @brief Gets the number of bytes held by the buffer. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** @brief The vertices. */
+	TArray<FVector> VertexArray;
+
+	/** @brief The vertex normals. */
+	TArray<FVector> NormalArray;
+
+	/** @brief Three vertex indices per triangle. */
+	TArray<int32> TriangleIndexArray;
+};
+
+/**
+ * @class UPT_MeshBufferHandle
+ * @brief A Blueprint handle to one immutable mesh buffer.
+ *
+ * The handle keeps its buffer alive, so a Blueprint can hold on to a mesh while the actor already loaded the next one.
+ * Single elements and subsets are read without copying the buffer, the Copy functions copy it on purpose, e.g. for
+ * creating a procedural mesh section.
+ */
+UCLASS(BlueprintType)
+class PLANNINGTOOL_ET_API UPT_MeshBufferHandle : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * @brief Creates a handle to a buffer.
+	 * @param InOuter The owner of the handle.
+	 * @param InBuffer The buffer.
+	 * @return The new handle.
+	 */
+	static UPT_MeshBufferHandle* Create(UObject* InOuter, const FPT_MeshBufferPtr& InBuffer);
+
+	/** @brief Gets the shared buffer, may be invalid. */
+	const FPT_MeshBufferPtr& GetBufferPtr() const { return this->Buffer; }
+
+	/** @brief Gets the buffer, or an empty buffer if the handle has none. */
+	const FPT_MeshBuffer& GetBuffer() const { return this->Buffer.IsValid() ? *this->Buffer : FPT_MeshBuffer::GetEmpty(); }
+
+	/**
+	 * @brief Checks whether the handle holds a buffer.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
+	bool HasBuffer() const { return this->Buffer.IsValid(); }
+
+	/**
+	 * @brief Gets the number of vertices of the buffer.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
+	int32 GetNumVertices() const { return this->GetBuffer().GetNumVertices(); }
+
+	/**
+	 * @brief Gets the number of triangles of the buffer.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
+	int32 GetNumTriangles() const { return this->GetBuffer().GetNumTriangles(); }
+
+	/**
+	 * @brief Gets one vertex.
+	 * @param InIndex The vertex index.
+	 * @return The vertex, zero if the index is out of range.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
+	FVector GetVertex(const int32& InIndex) const;
+
+	/**
+	 * @brief Gets the normal of one vertex.
+	 * @param InIndex The vertex index.
+	 * @return The normal, zero if the index is out of range or the buffer has no normals.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
+	FVector GetNormal(const int32& InIndex) const;
+
+	/**
+	 * @brief Gets a subset of the vertices.
+	 * @param InVertexIndexArray The vertex indices.
+	 * @param OutVertexArray Receives one vertex per index, zero for indices out of range.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void GetVertices(const TArray<int32>& InVertexIndexArray, TArray<FVector>& OutVertexArray) const;
+
+	/**
+	 * @brief Copies all vertices.
+	 * @param OutVertexArray Receives the vertices.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void CopyVertexArray(TArray<FVector>& OutVertexArray) const { OutVertexArray = this->GetBuffer().GetVertexArray(); }
+
+	/**
+	 * @brief Copies all vertex normals.
+	 * @param OutNormalArray Receives the normals.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void CopyNormalArray(TArray<FVector>& OutNormalArray) const { OutNormalArray = this->GetBuffer().GetNormalArray(); }
+
+	/**
+	 * @brief Copies all triangle indices.
+	 * @param OutTriangleIndexArray Receives the triangle indices.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void CopyTriangleIndexArray(TArray<int32>& OutTriangleIndexArray) const { OutTriangleIndexArray = this->GetBuffer().GetTriangleIndexArray(); }
+
+	/**
+	 * @brief Creates the points of a point cloud from a subset of the vertices.
+	 * @param InVertexIndexArray The vertices of the point cloud.
+	 * @param InVertexColorArray The color of every vertex of the buffer.
+	 * @param OutPointCloudArray Receives one point per valid vertex index.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void CreatePointCloudArray(const TArray<int32>& InVertexIndexArray, const TArray<FLinearColor>& InVertexColorArray, TArray<FLidarPointCloudPoint>& OutPointCloudArray) const;
+
+private:
+	/** @brief The buffer kept alive by the handle. */
+	FPT_MeshBufferPtr Buffer;
+};
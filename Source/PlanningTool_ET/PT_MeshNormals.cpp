@@ -0,0 +1,144 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_MeshNormals.h"
+#include "Async/ParallelFor.h"
+
+/** Number of vertices or triangles per parallel work item. */
+static constexpr int32 NormalBatchSize = 4096;
+
+void FPT_MeshNormals::Build(const int32 InNumVertices, const TArray<int32>& InTriangleIndexArray)
+{
+	this->Build(InNumVertices, TArray<TArrayView<const int32>>({ TArrayView<const int32>(InTriangleIndexArray) }));
+}
+
+void FPT_MeshNormals::Build(const int32 InNumVertices, const TArray<TArrayView<const int32>>& InTriangleIndexArrays)
+{
+	this->Reset();
+
+	// Triangles referring to missing vertices are left out
+	for (const TArrayView<const int32>& TriangleIndexArray : InTriangleIndexArrays)
+	{
+		if (TriangleIndexArray.Num() % 3 != 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("[FPT_MeshNormals::Build] %d triangle indices are not a multiple of three."), TriangleIndexArray.Num());
+		}
+
+		for (int32 i = 0; i + 2 < TriangleIndexArray.Num(); i += 3)
+		{
+			const int32 A = TriangleIndexArray[i];
+			const int32 B = TriangleIndexArray[i + 1];
+			const int32 C = TriangleIndexArray[i + 2];
+			if (A >= 0 && A < InNumVertices && B >= 0 && B < InNumVertices && C >= 0 && C < InNumVertices)
+			{
+				this->TriangleCorners.Append({ A, B, C });
+			}
+		}
+	}
+
+	// Counting sort of the corners by vertex
+	this->VertexCornerStarts.Init(0, InNumVertices + 1);
+	for (const int32 Vertex : this->TriangleCorners)
+	{
+		this->VertexCornerStarts[Vertex + 1]++;
+	}
+	for (int32 Vertex = 0; Vertex < InNumVertices; Vertex++)
+	{
+		this->VertexCornerStarts[Vertex + 1] += this->VertexCornerStarts[Vertex];
+	}
+
+	TArray<int32> Fill(this->VertexCornerStarts.GetData(), InNumVertices);
+	this->VertexCorners.SetNumUninitialized(this->TriangleCorners.Num());
+	for (int32 Corner = 0; Corner < this->TriangleCorners.Num(); Corner++)
+	{
+		this->VertexCorners[Fill[this->TriangleCorners[Corner]]++] = Corner;
+	}
+}
+
+void FPT_MeshNormals::Reset()
+{
+	this->TriangleCorners.Empty();
+	this->VertexCornerStarts.Empty();
+	this->VertexCorners.Empty();
+}
+
+void FPT_MeshNormals::Compute(const TArray<FVector>& InVertexArray, const ENormalWeighting InWeighting, const bool bInInvert, TArray<FVector>& OutNormalArray) const
+{
+	const int32 NumVertices = this->GetNumVertices();
+	OutNormalArray.Init(FVector::ZeroVector, NumVertices);
+	if (InVertexArray.Num() != NumVertices)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_MeshNormals::Compute] The adjacency was built for %d vertices, %d given!"), NumVertices, InVertexArray.Num());
+		return;
+	}
+
+	// The cross product is twice the area long, area weighting keeps it, the other weightings normalize it
+	const int32 NumTriangles = this->TriangleCorners.Num() / 3;
+	TArray<FVector> TriangleNormals;
+	TriangleNormals.SetNumUninitialized(NumTriangles);
+	ParallelFor(FMath::DivideAndRoundUp(NumTriangles, NormalBatchSize), [this, &InVertexArray, InWeighting, NumTriangles, &TriangleNormals](const int32 Batch)
+	{
+		const int32 End = FMath::Min((Batch + 1) * NormalBatchSize, NumTriangles);
+		for (int32 Triangle = Batch * NormalBatchSize; Triangle < End; Triangle++)
+		{
+			const FVector& A = InVertexArray[this->TriangleCorners[Triangle * 3]];
+			const FVector Normal = FVector::CrossProduct(InVertexArray[this->TriangleCorners[Triangle * 3 + 1]] - A, InVertexArray[this->TriangleCorners[Triangle * 3 + 2]] - A);
+			TriangleNormals[Triangle] = (InWeighting == ENormalWeighting::Area) ? Normal : Normal.GetSafeNormal();
+		}
+	});
+
+	const double Sign = bInInvert ? -1.0 : 1.0;
+	ParallelFor(FMath::DivideAndRoundUp(NumVertices, NormalBatchSize), [this, &InVertexArray, InWeighting, NumVertices, Sign, &TriangleNormals, &OutNormalArray](const int32 Batch)
+	{
+		const int32 End = FMath::Min((Batch + 1) * NormalBatchSize, NumVertices);
+		for (int32 Vertex = Batch * NormalBatchSize; Vertex < End; Vertex++)
+		{
+			FVector Sum = FVector::ZeroVector;
+			for (int32 Entry = this->VertexCornerStarts[Vertex]; Entry < this->VertexCornerStarts[Vertex + 1]; Entry++)
+			{
+				const int32 Corner = this->VertexCorners[Entry];
+				const int32 Triangle = Corner / 3;
+				if (InWeighting == ENormalWeighting::Angle)
+				{
+					const int32 First = Triangle * 3;
+					const FVector& Position = InVertexArray[Vertex];
+					const FVector EdgeNext = InVertexArray[this->TriangleCorners[First + (Corner - First + 1) % 3]] - Position;
+					const FVector EdgePrevious = InVertexArray[this->TriangleCorners[First + (Corner - First + 2) % 3]] - Position;
+					const double Angle = FMath::Atan2(FVector::CrossProduct(EdgeNext, EdgePrevious).Size(), FVector::DotProduct(EdgeNext, EdgePrevious));
+					Sum += Angle * TriangleNormals[Triangle];
+				}
+				else
+				{
+					Sum += TriangleNormals[Triangle];
+				}
+			}
+			OutNormalArray[Vertex] = Sign * Sum.GetSafeNormal();
+		}
+	});
+}
+
+void FPT_MeshNormals::Calculate(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray, const ENormalWeighting InWeighting, const bool bInInvert, TArray<FVector>& OutNormalArray)
+{
+	FPT_MeshNormals Kernel;
+	Kernel.Build(InVertexArray.Num(), InTriangleIndexArray);
+	Kernel.Compute(InVertexArray, InWeighting, bInInvert, OutNormalArray);
+}
+
+void FPT_MeshNormals::CalculateByScattering(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray, const bool bInInvert, TArray<FVector>& OutNormalArray)
+{
+	OutNormalArray.Init(FVector::ZeroVector, InVertexArray.Num());
+	for (int32 i = 0; i + 2 < InTriangleIndexArray.Num(); i += 3)
+	{
+		const FVector& A = InVertexArray[InTriangleIndexArray[i]];
+		const FVector Normal = FVector::CrossProduct(InVertexArray[InTriangleIndexArray[i + 1]] - A, InVertexArray[InTriangleIndexArray[i + 2]] - A);
+		OutNormalArray[InTriangleIndexArray[i]] += Normal;
+		OutNormalArray[InTriangleIndexArray[i + 1]] += Normal;
+		OutNormalArray[InTriangleIndexArray[i + 2]] += Normal;
+	}
+
+	const double Sign = bInInvert ? -1.0 : 1.0;
+	for (FVector& Normal : OutNormalArray)
+	{
+		Normal = Sign * Normal.GetSafeNormal();
+	}
+}
@@ -0,0 +1,80 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_MeshNormals.h
+ * @brief Header file for the FPT_MeshNormals class.
+ *
+ * This file contains the declaration of the FPT_MeshNormals class, the vertex normal kernel shared by all mesh actors.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PT_EnumContainer.h"
+
+/**
+ * @class FPT_MeshNormals
+ * @brief Computes vertex normals from a precomputed vertex to triangle adjacency.
+ *
+ * Build() records the triangles around every vertex once per topology. Compute() then runs two parallel passes: one
+ * over the triangles for their normals and one over the vertices, gathering the normals of their own triangles. Every
+ * thread only writes the normals of its own vertices, so no atomics or locks are needed and the result does not depend
+ * on the thread count. The adjacency can be reused as long as the triangles do not change, e.g. while vertices move.
+ */
+class PLANNINGTOOL_ET_API FPT_MeshNormals
+{
+public:
+	/**
+	 * @brief Builds the adjacency of one triangle index array.
+	 * @param InNumVertices The number of vertices.
+	 * @param InTriangleIndexArray Three vertex indices per triangle.
+	 */
+	void Build(const int32 InNumVertices, const TArray<int32>& InTriangleIndexArray);
+
+	/**
+	 * @brief Builds the adjacency of several triangle index arrays sharing one vertex array, e.g. the tags of a multi mesh.
+	 * @param InNumVertices The number of vertices.
+	 * @param InTriangleIndexArrays The triangle index arrays.
+	 */
+	void Build(const int32 InNumVertices, const TArray<TArrayView<const int32>>& InTriangleIndexArrays);
+
+	/**
+	 * @brief Releases all data.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Computes the unit vertex normals. Vertices without triangles get a zero normal.
+	 * @param InVertexArray The vertices, as many as passed to Build().
+	 * @param InWeighting How the triangle normals are weighted.
+	 * @param bInInvert Whether the normals point against the triangle winding.
+	 * @param OutNormalArray Receives one normal per vertex.
+	 */
+	void Compute(const TArray<FVector>& InVertexArray, const ENormalWeighting InWeighting, const bool bInInvert, TArray<FVector>& OutNormalArray) const;
+
+	/**
+	 * @brief Builds the adjacency and computes the normals in one call, for meshes whose normals are computed once.
+	 */
+	static void Calculate(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray, const ENormalWeighting InWeighting, const bool bInInvert, TArray<FVector>& OutNormalArray);
+
+	/**
+	 * @brief Computes area weighted normals by scattering every triangle normal to its corners. Used as the reference of benchmarks.
+	 */
+	static void CalculateByScattering(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray, const bool bInInvert, TArray<FVector>& OutNormalArray);
+
+	/** @brief Whether the adjacency has been built. */
+	bool IsBuilt() const { return this->VertexCornerStarts.Num() > 0; }
+
+	/** @brief Gets the number of vertices the adjacency was built for. */
+	int32 GetNumVertices() const { return FMath::Max(this->VertexCornerStarts.Num() - 1, 0); }
+
+private:
+	/** @brief Vertex indices of all valid triangles, three per triangle. */
+	TArray<int32> TriangleCorners;
+
+	/** @brief Start of the corners of every vertex in VertexCorners, one more than vertices. */
+	TArray<int32> VertexCornerStarts;
+
+	/** @brief The corners around every vertex as triangle * 3 + corner. */
+	TArray<int32> VertexCorners;
+};
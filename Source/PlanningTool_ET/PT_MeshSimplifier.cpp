@@ -0,0 +1,402 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_MeshSimplifier.h"
+#include "PT_MeshNormals.h"
+
+/** Smallest cosine between the normals of a triangle before and after a collapse. */
+static constexpr double MinNormalCosine = 0.2;
+
+/** Number of collapses between two checks of the cancel flag. */
+static constexpr int32 CancelCheckInterval = 1024;
+
+/** Orders the heap by ascending collapse cost. */
+struct FCollapseCostLess
+{
+	template <typename T>
+	bool operator()(const T& A, const T& B) const { return A.Cost < B.Cost; }
+};
+
+int32 FPT_MeshLOD::GetNumTriangles() const
+{
+	int32 NumTriangles = 0;
+	for (const TArray<int32>& TriangleIndexArray : this->TriangleIndexArrays)
+	{
+		NumTriangles += TriangleIndexArray.Num() / 3;
+	}
+	return NumTriangles;
+}
+
+SIZE_T FPT_MeshLOD::GetAllocatedSize() const
+{
+	SIZE_T Bytes = this->VertexIndexMap.GetAllocatedSize() + this->VertexArray.GetAllocatedSize() + this->NormalArray.GetAllocatedSize() + this->TriangleIndexArrays.GetAllocatedSize();
+	for (const TArray<int32>& TriangleIndexArray : this->TriangleIndexArrays)
+	{
+		Bytes += TriangleIndexArray.GetAllocatedSize();
+	}
+	return Bytes;
+}
+
+void FPT_MeshSimplifier::FQuadric::AddPlane(const FVector& InNormal, const double InDistance, const double InWeight)
+{
+	this->Values[0] += InWeight * InNormal.X * InNormal.X;
+	this->Values[1] += InWeight * InNormal.X * InNormal.Y;
+	this->Values[2] += InWeight * InNormal.X * InNormal.Z;
+	this->Values[3] += InWeight * InNormal.X * InDistance;
+	this->Values[4] += InWeight * InNormal.Y * InNormal.Y;
+	this->Values[5] += InWeight * InNormal.Y * InNormal.Z;
+	this->Values[6] += InWeight * InNormal.Y * InDistance;
+	this->Values[7] += InWeight * InNormal.Z * InNormal.Z;
+	this->Values[8] += InWeight * InNormal.Z * InDistance;
+	this->Values[9] += InWeight * InDistance * InDistance;
+}
+
+void FPT_MeshSimplifier::FQuadric::Add(const FQuadric& InOther)
+{
+	for (int32 i = 0; i < 10; i++)
+	{
+		this->Values[i] += InOther.Values[i];
+	}
+}
+
+double FPT_MeshSimplifier::FQuadric::Evaluate(const FVector& InPosition) const
+{
+	const double X = InPosition.X;
+	const double Y = InPosition.Y;
+	const double Z = InPosition.Z;
+	return this->Values[0] * X * X + 2.0 * this->Values[1] * X * Y + 2.0 * this->Values[2] * X * Z + 2.0 * this->Values[3] * X
+		+ this->Values[4] * Y * Y + 2.0 * this->Values[5] * Y * Z + 2.0 * this->Values[6] * Y
+		+ this->Values[7] * Z * Z + 2.0 * this->Values[8] * Z + this->Values[9];
+}
+
+FPT_MeshSimplifier::FPT_MeshSimplifier(const TArray<FVector>& InVertexArray, const TArray<TArray<int32>>& InTriangleIndexArrays)
+{
+	const int32 NumVertices = InVertexArray.Num();
+	this->Positions = InVertexArray;
+	this->Quadrics.SetNum(NumVertices);
+	this->VertexTriangles.SetNum(NumVertices);
+	this->VertexStamps.Init(0, NumVertices);
+	this->LockedVertices.Init(false, NumVertices);
+	this->RemovedVertices.Init(false, NumVertices);
+	this->NumTags = InTriangleIndexArrays.Num();
+
+	for (int32 Tag = 0; Tag < InTriangleIndexArrays.Num(); Tag++)
+	{
+		const TArray<int32>& TriangleIndexArray = InTriangleIndexArrays[Tag];
+		for (int32 i = 0; i + 2 < TriangleIndexArray.Num(); i += 3)
+		{
+			const FIntVector Corners(TriangleIndexArray[i], TriangleIndexArray[i + 1], TriangleIndexArray[i + 2]);
+			if (!InVertexArray.IsValidIndex(Corners.X) || !InVertexArray.IsValidIndex(Corners.Y) || !InVertexArray.IsValidIndex(Corners.Z)
+				|| Corners.X == Corners.Y || Corners.Y == Corners.Z || Corners.Z == Corners.X)
+			{
+				continue;
+			}
+
+			const int32 Triangle = this->Triangles.Add(Corners);
+			this->TriangleTags.Add(Tag);
+
+			const FVector& A = InVertexArray[Corners.X];
+			const FVector Cross = FVector::CrossProduct(InVertexArray[Corners.Y] - A, InVertexArray[Corners.Z] - A);
+			const double DoubleArea = Cross.Size();
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				this->VertexTriangles[Corners[Corner]].Add(Triangle);
+				if (DoubleArea > UE_DOUBLE_SMALL_NUMBER)
+				{
+					const FVector Normal = Cross / DoubleArea;
+					this->Quadrics[Corners[Corner]].AddPlane(Normal, -FVector::DotProduct(Normal, A), 0.5 * DoubleArea);
+				}
+			}
+		}
+	}
+
+	this->RemovedTriangles.Init(false, this->Triangles.Num());
+	this->NumAliveTriangles = this->Triangles.Num();
+
+	// On a closed manifold every neighbor shares exactly two triangles with a vertex, any other count marks a border
+	for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+	{
+		const TArray<int32, TInlineAllocator<8>>& AdjacentTriangles = this->VertexTriangles[Vertex];
+		if (AdjacentTriangles.IsEmpty())
+		{
+			this->LockedVertices[Vertex] = true;
+			continue;
+		}
+
+		TArray<TPair<int32, int32>, TInlineAllocator<16>> NeighborCounts;
+		bool bIsLocked = false;
+		for (const int32 Triangle : AdjacentTriangles)
+		{
+			bIsLocked |= this->TriangleTags[Triangle] != this->TriangleTags[AdjacentTriangles[0]];
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const int32 Neighbor = this->Triangles[Triangle][Corner];
+				if (Neighbor == Vertex)
+				{
+					continue;
+				}
+
+				TPair<int32, int32>* Entry = NeighborCounts.FindByPredicate([Neighbor](const TPair<int32, int32>& InEntry) { return InEntry.Key == Neighbor; });
+				if (Entry)
+				{
+					Entry->Value++;
+				}
+				else
+				{
+					NeighborCounts.Add(TPair<int32, int32>(Neighbor, 1));
+				}
+			}
+		}
+
+		for (const TPair<int32, int32>& Entry : NeighborCounts)
+		{
+			bIsLocked |= Entry.Value != 2;
+		}
+		this->LockedVertices[Vertex] = bIsLocked;
+	}
+
+	// Interior edges appear in both winding directions, pushing the ascending one visits each of them once
+	this->Heap.Reserve(this->Triangles.Num() * 3 / 2);
+	for (const FIntVector& Corners : this->Triangles)
+	{
+		for (int32 Corner = 0; Corner < 3; Corner++)
+		{
+			const int32 A = Corners[Corner];
+			const int32 B = Corners[(Corner + 1) % 3];
+			if (A < B)
+			{
+				this->PushCollapse(A, B);
+			}
+		}
+	}
+}
+
+void FPT_MeshSimplifier::PushCollapse(const int32 InVertexA, const int32 InVertexB)
+{
+	if (this->RemovedVertices[InVertexA] || this->RemovedVertices[InVertexB] || (this->LockedVertices[InVertexA] && this->LockedVertices[InVertexB]))
+	{
+		return;
+	}
+
+	FQuadric Quadric = this->Quadrics[InVertexA];
+	Quadric.Add(this->Quadrics[InVertexB]);
+	const double CostRemoveA = this->LockedVertices[InVertexA] ? UE_DOUBLE_BIG_NUMBER : Quadric.Evaluate(this->Positions[InVertexB]);
+	const double CostRemoveB = this->LockedVertices[InVertexB] ? UE_DOUBLE_BIG_NUMBER : Quadric.Evaluate(this->Positions[InVertexA]);
+
+	const bool bRemoveA = CostRemoveA <= CostRemoveB;
+	FCollapse Collapse;
+	Collapse.Cost = bRemoveA ? CostRemoveA : CostRemoveB;
+	Collapse.RemovedVertex = bRemoveA ? InVertexA : InVertexB;
+	Collapse.KeptVertex = bRemoveA ? InVertexB : InVertexA;
+	Collapse.RemovedStamp = this->VertexStamps[Collapse.RemovedVertex];
+	Collapse.KeptStamp = this->VertexStamps[Collapse.KeptVertex];
+	this->Heap.HeapPush(Collapse, FCollapseCostLess());
+}
+
+void FPT_MeshSimplifier::GetNeighbors(const int32 InVertex, TArray<int32, TInlineAllocator<16>>& OutNeighbors) const
+{
+	OutNeighbors.Reset();
+	for (const int32 Triangle : this->VertexTriangles[InVertex])
+	{
+		for (int32 Corner = 0; Corner < 3; Corner++)
+		{
+			const int32 Neighbor = this->Triangles[Triangle][Corner];
+			if (Neighbor != InVertex)
+			{
+				OutNeighbors.AddUnique(Neighbor);
+			}
+		}
+	}
+}
+
+bool FPT_MeshSimplifier::CanCollapse(const int32 InRemovedVertex, const int32 InKeptVertex) const
+{
+	int32 NumSharedTriangles = 0;
+	for (const int32 Triangle : this->VertexTriangles[InRemovedVertex])
+	{
+		const FIntVector& Corners = this->Triangles[Triangle];
+		NumSharedTriangles += (Corners.X == InKeptVertex || Corners.Y == InKeptVertex || Corners.Z == InKeptVertex) ? 1 : 0;
+	}
+	if (NumSharedTriangles == 0)
+	{
+		return false;
+	}
+
+	// Link condition: the vertices adjacent to both are exactly the tips of the triangles on the edge
+	TArray<int32, TInlineAllocator<16>> RemovedNeighbors;
+	TArray<int32, TInlineAllocator<16>> KeptNeighbors;
+	this->GetNeighbors(InRemovedVertex, RemovedNeighbors);
+	this->GetNeighbors(InKeptVertex, KeptNeighbors);
+	int32 NumCommonNeighbors = 0;
+	for (const int32 Neighbor : RemovedNeighbors)
+	{
+		NumCommonNeighbors += KeptNeighbors.Contains(Neighbor) ? 1 : 0;
+	}
+	if (NumCommonNeighbors != NumSharedTriangles)
+	{
+		return false;
+	}
+
+	const FVector& KeptPosition = this->Positions[InKeptVertex];
+	for (const int32 Triangle : this->VertexTriangles[InRemovedVertex])
+	{
+		const FIntVector& Corners = this->Triangles[Triangle];
+		if (Corners.X == InKeptVertex || Corners.Y == InKeptVertex || Corners.Z == InKeptVertex)
+		{
+			continue;
+		}
+
+		FVector Before[3];
+		FVector After[3];
+		for (int32 Corner = 0; Corner < 3; Corner++)
+		{
+			Before[Corner] = this->Positions[Corners[Corner]];
+			After[Corner] = (Corners[Corner] == InRemovedVertex) ? KeptPosition : Before[Corner];
+		}
+
+		const FVector NormalBefore = FVector::CrossProduct(Before[1] - Before[0], Before[2] - Before[0]);
+		const FVector NormalAfter = FVector::CrossProduct(After[1] - After[0], After[2] - After[0]);
+		if (NormalAfter.SizeSquared() <= UE_DOUBLE_SMALL_NUMBER * NormalBefore.SizeSquared())
+		{
+			return false;
+		}
+		if (FVector::DotProduct(NormalBefore.GetSafeNormal(), NormalAfter.GetSafeNormal()) < MinNormalCosine)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void FPT_MeshSimplifier::Collapse(const int32 InRemovedVertex, const int32 InKeptVertex)
+{
+	for (const int32 Triangle : this->VertexTriangles[InRemovedVertex])
+	{
+		FIntVector& Corners = this->Triangles[Triangle];
+		if (Corners.X == InKeptVertex || Corners.Y == InKeptVertex || Corners.Z == InKeptVertex)
+		{
+			this->RemovedTriangles[Triangle] = true;
+			this->NumAliveTriangles--;
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				if (Corners[Corner] != InRemovedVertex)
+				{
+					this->VertexTriangles[Corners[Corner]].RemoveSingleSwap(Triangle, false);
+				}
+			}
+		}
+		else
+		{
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				if (Corners[Corner] == InRemovedVertex)
+				{
+					Corners[Corner] = InKeptVertex;
+				}
+			}
+			this->VertexTriangles[InKeptVertex].Add(Triangle);
+		}
+	}
+
+	this->VertexTriangles[InRemovedVertex].Empty();
+	this->RemovedVertices[InRemovedVertex] = true;
+	this->Quadrics[InKeptVertex].Add(this->Quadrics[InRemovedVertex]);
+	this->VertexStamps[InKeptVertex]++;
+
+	// The quadric of the kept vertex changed, so all of its edges get new candidates
+	TArray<int32, TInlineAllocator<16>> Neighbors;
+	this->GetNeighbors(InKeptVertex, Neighbors);
+	for (const int32 Neighbor : Neighbors)
+	{
+		this->PushCollapse(InKeptVertex, Neighbor);
+	}
+}
+
+bool FPT_MeshSimplifier::Simplify(const int32 InTargetTriangles, const FThreadSafeBool* InCancelFlag)
+{
+	int32 NumIterations = 0;
+	while (this->NumAliveTriangles > InTargetTriangles && this->Heap.Num() > 0)
+	{
+		if (InCancelFlag && (++NumIterations % CancelCheckInterval) == 0 && *InCancelFlag)
+		{
+			return false;
+		}
+
+		FCollapse Candidate;
+		this->Heap.HeapPop(Candidate, FCollapseCostLess(), false);
+		if (this->RemovedVertices[Candidate.RemovedVertex] || this->RemovedVertices[Candidate.KeptVertex]
+			|| this->VertexStamps[Candidate.RemovedVertex] != Candidate.RemovedStamp || this->VertexStamps[Candidate.KeptVertex] != Candidate.KeptStamp)
+		{
+			continue;
+		}
+
+		if (this->CanCollapse(Candidate.RemovedVertex, Candidate.KeptVertex))
+		{
+			this->Collapse(Candidate.RemovedVertex, Candidate.KeptVertex);
+		}
+	}
+	return true;
+}
+
+void FPT_MeshSimplifier::ExtractLOD(const ENormalWeighting InWeighting, const bool bInInvertNormals, FPT_MeshLOD& OutLOD) const
+{
+	OutLOD = FPT_MeshLOD();
+
+	// LOD vertices keep the order of the full resolution vertices
+	TArray<int32> LODIndices;
+	LODIndices.Init(INDEX_NONE, this->Positions.Num());
+	for (int32 Triangle = 0; Triangle < this->Triangles.Num(); Triangle++)
+	{
+		if (!this->RemovedTriangles[Triangle])
+		{
+			LODIndices[this->Triangles[Triangle].X] = 0;
+			LODIndices[this->Triangles[Triangle].Y] = 0;
+			LODIndices[this->Triangles[Triangle].Z] = 0;
+		}
+	}
+
+	for (int32 Vertex = 0; Vertex < this->Positions.Num(); Vertex++)
+	{
+		if (LODIndices[Vertex] != INDEX_NONE)
+		{
+			LODIndices[Vertex] = OutLOD.VertexIndexMap.Add(Vertex);
+			OutLOD.VertexArray.Add(this->Positions[Vertex]);
+		}
+	}
+
+	OutLOD.TriangleIndexArrays.SetNum(this->NumTags);
+	for (int32 Triangle = 0; Triangle < this->Triangles.Num(); Triangle++)
+	{
+		if (!this->RemovedTriangles[Triangle])
+		{
+			const FIntVector& Corners = this->Triangles[Triangle];
+			OutLOD.TriangleIndexArrays[this->TriangleTags[Triangle]].Append({ LODIndices[Corners.X], LODIndices[Corners.Y], LODIndices[Corners.Z] });
+		}
+	}
+
+	TArray<TArrayView<const int32>> TriangleIndexArrays;
+	for (const TArray<int32>& TriangleIndexArray : OutLOD.TriangleIndexArrays)
+	{
+		TriangleIndexArrays.Add(TriangleIndexArray);
+	}
+
+	FPT_MeshNormals Kernel;
+	Kernel.Build(OutLOD.VertexArray.Num(), TriangleIndexArrays);
+	Kernel.Compute(OutLOD.VertexArray, InWeighting, bInInvertNormals, OutLOD.NormalArray);
+}
+
+bool FPT_MeshSimplifier::GenerateLODChain(const TArray<FVector>& InVertexArray, const TArray<TArray<int32>>& InTriangleIndexArrays, const TArray<float>& InTriangleRatios, const ENormalWeighting InWeighting, const bool bInInvertNormals, const FThreadSafeBool* InCancelFlag, TArray<FPT_MeshLOD>& OutLODs)
+{
+	OutLODs.Empty();
+	FPT_MeshSimplifier Simplifier(InVertexArray, InTriangleIndexArrays);
+	for (const float TriangleRatio : InTriangleRatios)
+	{
+		const int32 TargetTriangles = FMath::Max(1, FMath::RoundToInt32(Simplifier.GetNumInitialTriangles() * FMath::Clamp(TriangleRatio, 0.f, 1.f)));
+		if (!Simplifier.Simplify(TargetTriangles, InCancelFlag))
+		{
+			return false;
+		}
+		Simplifier.ExtractLOD(InWeighting, bInInvertNormals, OutLODs.AddDefaulted_GetRef());
+	}
+	return true;
+}
@@ -0,0 +1,167 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_MeshSimplifier.h
+ * @brief Header file for the FPT_MeshSimplifier class.
+ *
+ * This file contains the declaration of the FPT_MeshSimplifier class, which reduces a mesh by quadric error edge
+ * collapses, and of the FPT_MeshLOD struct holding one reduced level of detail.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "PT_EnumContainer.h"
+
+/**
+ * @struct FPT_MeshLOD
+ * @brief One reduced level of detail of a mesh.
+ */
+struct PLANNINGTOOL_ET_API FPT_MeshLOD
+{
+	/** @brief The full resolution vertex index per LOD vertex, used to carry vertex colors over. */
+	TArray<int32> VertexIndexMap;
+
+	/** @brief The LOD vertices, a subset of the full resolution vertices. */
+	TArray<FVector> VertexArray;
+
+	/** @brief The vertex normals of the LOD. */
+	TArray<FVector> NormalArray;
+
+	/** @brief The triangle indices into VertexArray, one array per tag of the full resolution mesh. */
+	TArray<TArray<int32>> TriangleIndexArrays;
+
+	/** @brief Gets the number of triangles over all tags. */
+	int32 GetNumTriangles() const;
+
+	/** @brief Gets the number of bytes held by the LOD. */
+	SIZE_T GetAllocatedSize() const;
+};
+
+/**
+ * @class FPT_MeshSimplifier
+ * @brief Reduces a mesh by collapsing edges in the order of their quadric error (Garland and Heckbert).
+ *
+ * Every vertex accumulates the area weighted planes of its triangles. An edge collapses one of its vertices into the
+ * other, so the reduced vertices are always a subset of the original ones and keep their indices through a map. The
+ * cost of a collapse is the summed quadric of both vertices evaluated at the kept position. Vertices on open borders,
+ * on non-manifold edges and between triangles of different tags are never removed, so the outlines of all tags are
+ * preserved. Collapses that would flip a triangle or pinch the surface are rejected.
+ *
+ * A simplifier owns a copy of the mesh and can be run on any thread.
+ */
+class PLANNINGTOOL_ET_API FPT_MeshSimplifier
+{
+public:
+	/**
+	 * @brief Copies a mesh and prepares its quadrics and collapse candidates.
+	 * @param InVertexArray The vertices shared by all tags.
+	 * @param InTriangleIndexArrays The triangle indices per tag.
+	 */
+	FPT_MeshSimplifier(const TArray<FVector>& InVertexArray, const TArray<TArray<int32>>& InTriangleIndexArrays);
+
+	/**
+	 * @brief Collapses edges until at most a number of triangles is left or no valid collapse remains.
+	 * @param InTargetTriangles The number of triangles to reduce to.
+	 * @param InCancelFlag Checked between collapses, stops the reduction when set. May be nullptr.
+	 * @return False if the reduction was canceled.
+	 */
+	bool Simplify(const int32 InTargetTriangles, const FThreadSafeBool* InCancelFlag = nullptr);
+
+	/**
+	 * @brief Extracts the current state of the reduction as a level of detail.
+	 * @param InWeighting How the triangle normals are weighted in the LOD normals.
+	 * @param bInInvertNormals Whether the LOD normals point against the triangle winding, like the full resolution ones.
+	 * @param OutLOD Receives the LOD.
+	 */
+	void ExtractLOD(const ENormalWeighting InWeighting, const bool bInInvertNormals, FPT_MeshLOD& OutLOD) const;
+
+	/** @brief Gets the number of triangles left. */
+	int32 GetNumTriangles() const { return this->NumAliveTriangles; }
+
+	/** @brief Gets the number of triangles of the full resolution mesh. */
+	int32 GetNumInitialTriangles() const { return this->Triangles.Num(); }
+
+	/**
+	 * @brief Reduces a mesh to a chain of levels of detail in one pass.
+	 * @param InVertexArray The vertices shared by all tags.
+	 * @param InTriangleIndexArrays The triangle indices per tag.
+	 * @param InTriangleRatios The fraction of triangles kept per LOD, descending.
+	 * @param InWeighting How the triangle normals are weighted in the LOD normals.
+	 * @param bInInvertNormals Whether the LOD normals point against the triangle winding.
+	 * @param InCancelFlag Checked between collapses. May be nullptr.
+	 * @param OutLODs Receives one LOD per ratio.
+	 * @return False if the reduction was canceled.
+	 */
+	static bool GenerateLODChain(const TArray<FVector>& InVertexArray, const TArray<TArray<int32>>& InTriangleIndexArrays, const TArray<float>& InTriangleRatios, const ENormalWeighting InWeighting, const bool bInInvertNormals, const FThreadSafeBool* InCancelFlag, TArray<FPT_MeshLOD>& OutLODs);
+
+private:
+	/** @brief A symmetric 4x4 error quadric in upper triangle order. */
+	struct FQuadric
+	{
+		double Values[10] = {};
+
+		void AddPlane(const FVector& InNormal, const double InDistance, const double InWeight);
+		void Add(const FQuadric& InOther);
+		double Evaluate(const FVector& InPosition) const;
+	};
+
+	/** @brief A collapse candidate in the heap, invalid once the stamp of either vertex changed. */
+	struct FCollapse
+	{
+		double Cost;
+		int32 RemovedVertex;
+		int32 KeptVertex;
+		uint32 RemovedStamp;
+		uint32 KeptStamp;
+	};
+
+	/** @brief Pushes the cheaper direction of collapsing an edge, if any direction is allowed. */
+	void PushCollapse(const int32 InVertexA, const int32 InVertexB);
+
+	/** @brief Checks the link condition and the triangle orientations of a collapse. */
+	bool CanCollapse(const int32 InRemovedVertex, const int32 InKeptVertex) const;
+
+	/** @brief Collapses a vertex into another and pushes the new candidates around the kept vertex. */
+	void Collapse(const int32 InRemovedVertex, const int32 InKeptVertex);
+
+	/** @brief Collects the distinct neighbors of a vertex. */
+	void GetNeighbors(const int32 InVertex, TArray<int32, TInlineAllocator<16>>& OutNeighbors) const;
+
+	/** @brief The vertex positions. */
+	TArray<FVector> Positions;
+
+	/** @brief The error quadric per vertex. */
+	TArray<FQuadric> Quadrics;
+
+	/** @brief The triangles around every vertex. */
+	TArray<TArray<int32, TInlineAllocator<8>>> VertexTriangles;
+
+	/** @brief Incremented whenever the quadric or the neighborhood of a vertex changes. */
+	TArray<uint32> VertexStamps;
+
+	/** @brief Whether a vertex may not be removed. */
+	TArray<bool> LockedVertices;
+
+	/** @brief Whether a vertex was collapsed into another. */
+	TArray<bool> RemovedVertices;
+
+	/** @brief The corners per triangle. */
+	TArray<FIntVector> Triangles;
+
+	/** @brief The tag per triangle. */
+	TArray<int32> TriangleTags;
+
+	/** @brief Whether a triangle was removed by a collapse. */
+	TArray<bool> RemovedTriangles;
+
+	/** @brief The number of tags. */
+	int32 NumTags = 0;
+
+	/** @brief The number of triangles not removed. */
+	int32 NumAliveTriangles = 0;
+
+	/** @brief Binary min heap of collapse candidates. */
+	TArray<FCollapse> Heap;
+};
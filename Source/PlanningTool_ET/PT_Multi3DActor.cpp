@@ -124,32 +124,38 @@ void APT_Multi3DActor::ConvertJSONObjectToTetraArray(const TSharedPtr<FJsonObjec
 	}
 }
 
-void APT_Multi3DActor::CalculateNormalsForMultiMesh(TArray<FVector>& OutNormalArray)
+void APT_Multi3DActor::CalculateNormalsForMultiMesh(const TArray<FVector>& InVertexArray, TArray<FVector>& OutNormalArray) const
 {
-	OutNormalArray.Init(FVector(0.0f, 0.0f, 0.0f), this->VertexArray.Num());
-
-	for(const FPT_MeshData MeshData : this->MeshDataPerTagArray)
+	// The tags share the vertex array, so one adjacency over all their triangles gathers across tag borders
+	TArray<TArrayView<const int32>> TriangleIndexArrays;
+	TriangleIndexArrays.Reserve(this->MeshDataPerTagArray.Num());
+	for (const FPT_MeshData& MeshData : this->MeshDataPerTagArray)
 	{
-		for (int32 i = 0; i < MeshData.TriangleIndexArray.Num(); i += 3)
-		{
-			FVector Vertex0 = this->VertexArray[MeshData.TriangleIndexArray[i]];
-			FVector Vertex1 = this->VertexArray[MeshData.TriangleIndexArray[i + 1]];
-			FVector Vertex2 = this->VertexArray[MeshData.TriangleIndexArray[i + 2]];
+		TriangleIndexArrays.Add(MeshData.TriangleIndexArray);
+	}
 
-			FVector Edge1 = Vertex1 - Vertex0;
-			FVector Edge2 = Vertex2 - Vertex0;
+	FPT_MeshNormals Kernel;
+	Kernel.Build(InVertexArray.Num(), TriangleIndexArrays);
+	Kernel.Compute(InVertexArray, this->NormalWeighting, true, OutNormalArray);
+}
 
-			FVector Normal = FVector::CrossProduct(Edge1, Edge2);
+void APT_Multi3DActor::LoadMultiMeshBuffer(const UPT_HTTPComponent* InHTTPComponent, const TArray<FString>& InMeshTagArray, const TArray<FString>& InMeshDescriptionArray, TArray<FVector>& OutVertexArray, TArray<FVector>& OutNormalArray, TArray<FPT_MeshData>& OutMeshDataArray)
+{
+	// The loaded arrays are moved into the shared buffer, the outputs only get copies if requested
+	TArray<FVector> LoadedVertexArray;
+	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", LoadedVertexArray);
+	this->VertexColorArray.Init(FLinearColor().White, LoadedVertexArray.Num());
+	this->ConvertJSONResponseBodyToMultiMesh(InHTTPComponent, "meshes", InMeshTagArray, InMeshDescriptionArray, this->MeshDataPerTagArray);
 
-			OutNormalArray[MeshData.TriangleIndexArray[i]] -= Normal;
-			OutNormalArray[MeshData.TriangleIndexArray[i + 1]] -= Normal;
-			OutNormalArray[MeshData.TriangleIndexArray[i + 2]] -= Normal;
-		}
-	}
+	TArray<FVector> LoadedNormalArray;
+	this->CalculateNormalsForMultiMesh(LoadedVertexArray, LoadedNormalArray);
+	this->SetMeshBuffer(MoveTemp(LoadedVertexArray), MoveTemp(LoadedNormalArray), TArray<int32>());
 
-	for (int32 i = 0; i < OutNormalArray.Num(); i++)
+	if (this->bOutputMeshArrays)
 	{
-		OutNormalArray[i].Normalize();
+		OutVertexArray = this->GetMesh().GetVertexArray();
+		OutNormalArray = this->GetMesh().GetNormalArray();
+		OutMeshDataArray = this->MeshDataPerTagArray;
 	}
 }
 
@@ -164,27 +170,35 @@ void APT_Multi3DActor::GetMultiMeshAndMultiVolumeFromJSONResponseBody(const UPT_
 	OutVolumeDataArray.Empty();
 	OutNormalArray.Empty();
 
-	this->VertexArray.Empty();
+	this->ResetMeshBuffer();
 	this->TetraDataPerTagArray.Empty();
 	this->MeshDataPerTagArray.Empty();
+	this->ResetMeshLODs();
+	this->PointCloudBytes = 0;
+	this->ReportMemoryUsage();
 
-	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", OutVertexArray);
-	this->VertexArray = OutVertexArray;
-	this->VertexColorArray.Init(FLinearColor().White, this->VertexArray.Num());
+	if (!this->RequestMeshAllocation(InHTTPComponent))
+	{
+		return;
+	}
 
 	UPT_JSONConverter::ConvertJSONResponseBodyToStringArray(InHTTPComponent, "mesh_tags", OutMeshTagArray);
 	UPT_JSONConverter::ConvertJSONResponseBodyToStringArray(InHTTPComponent, "mesh_descriptions", OutMeshDescriptionArray);
-	this->ConvertJSONResponseBodyToMultiMesh(InHTTPComponent, "meshes", OutMeshTagArray, OutMeshDescriptionArray, OutMeshDataArray);
-	this->MeshDataPerTagArray = OutMeshDataArray;
-
-	this->CalculateNormalsForMultiMesh(OutNormalArray);
+	this->LoadMultiMeshBuffer(InHTTPComponent, OutMeshTagArray, OutMeshDescriptionArray, OutVertexArray, OutNormalArray, OutMeshDataArray);
 
 	MeshDataLoadedCallbackEvent.Broadcast();
 
+	if (this->bGenerateMeshLODs)
+	{
+		this->GenerateMeshLODs();
+	}
+
 	UPT_JSONConverter::ConvertJSONResponseBodyToStringArray(InHTTPComponent, "volume_tags", OutVolumeTagArray);
-	this->ConvertJSONResponseBodyToMultiVolume(InHTTPComponent, "volumes", OutVolumeTagArray, OutVertexArray, this->VertexColorArray, OutVolumeDataArray);
+	this->ConvertJSONResponseBodyToMultiVolume(InHTTPComponent, "volumes", OutVolumeTagArray, this->GetMesh().GetVertexArray(), this->VertexColorArray, OutVolumeDataArray);
 	UPT_JSONConverter::ConvertJSONResponseBodyToStringArray(InHTTPComponent, "volume_descriptions", OutVolumeDescriptionArray);
 	this->ConvertJSONResponseBodyToTetraArray(InHTTPComponent, "volumes_raw", OutVolumeTagArray, this->TetraDataPerTagArray);
+	this->PointCloudBytes = CalculatePointCloudBytes(OutVolumeDataArray);
+	this->ReportMemoryUsage();
 
 	VolumeDataLoadedCallbackEvent.Broadcast();
 }
@@ -197,21 +211,27 @@ void APT_Multi3DActor::GetMultiMeshFromJSONResponseBody(const UPT_HTTPComponent*
 	OutMeshDataArray.Empty();
 	OutNormalArray.Empty();
 
-	this->VertexArray.Empty();
+	this->ResetMeshBuffer();
 	this->MeshDataPerTagArray.Empty();
+	this->ResetMeshLODs();
+	this->ReportMemoryUsage();
 
-	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", OutVertexArray);
-	this->VertexArray = OutVertexArray;
-	this->VertexColorArray.Init(FLinearColor().White, this->VertexArray.Num());
+	if (!this->RequestMeshAllocation(InHTTPComponent))
+	{
+		return;
+	}
 
 	UPT_JSONConverter::ConvertJSONResponseBodyToStringArray(InHTTPComponent, "mesh_tags", OutMeshTagArray);
 	UPT_JSONConverter::ConvertJSONResponseBodyToStringArray(InHTTPComponent, "mesh_descriptions", OutMeshDescriptionArray);
-	this->ConvertJSONResponseBodyToMultiMesh(InHTTPComponent, "meshes", OutMeshTagArray, OutMeshDescriptionArray, OutMeshDataArray);
-	this->MeshDataPerTagArray = OutMeshDataArray;
-
-	this->CalculateNormalsForMultiMesh(OutNormalArray);
+	this->LoadMultiMeshBuffer(InHTTPComponent, OutMeshTagArray, OutMeshDescriptionArray, OutVertexArray, OutNormalArray, OutMeshDataArray);
+	this->ReportMemoryUsage();
 
 	MeshDataLoadedCallbackEvent.Broadcast();
+
+	if (this->bGenerateMeshLODs)
+	{
+		this->GenerateMeshLODs();
+	}
 }
 
 void APT_Multi3DActor::GetMultiVolumeFromJSONResponseBody(const UPT_HTTPComponent* InHTTPComponent, TArray<FVector>& OutVertexArray, TArray<FString>& OutVolumeTagArray, TArray<FString>& OutVolumeDescriptionArray, TArray<FPT_VolumeData>& OutVolumeDataArray)
@@ -221,24 +241,73 @@ void APT_Multi3DActor::GetMultiVolumeFromJSONResponseBody(const UPT_HTTPComponen
 	OutVolumeDescriptionArray.Empty();
 	OutVolumeDataArray.Empty();
 
-	this->VertexArray.Empty();
+	this->ResetMeshBuffer();
 	this->TetraDataPerTagArray.Empty();
+	this->PointCloudBytes = 0;
+	this->ReportMemoryUsage();
+
+	if (!this->RequestMeshAllocation(InHTTPComponent))
+	{
+		return;
+	}
 
-	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", OutVertexArray);
-	this->VertexArray = OutVertexArray;
-	this->VertexColorArray.Init(FLinearColor().White, this->VertexArray.Num());
+	TArray<FVector> LoadedVertexArray;
+	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", LoadedVertexArray);
+	this->VertexColorArray.Init(FLinearColor().White, LoadedVertexArray.Num());
+	this->SetMeshBuffer(MoveTemp(LoadedVertexArray), TArray<FVector>(), TArray<int32>());
+	if (this->bOutputMeshArrays)
+	{
+		OutVertexArray = this->GetMesh().GetVertexArray();
+	}
 
 	UPT_JSONConverter::ConvertJSONResponseBodyToStringArray(InHTTPComponent, "volume_tags", OutVolumeTagArray);
-	this->ConvertJSONResponseBodyToMultiVolume(InHTTPComponent, "volumes", OutVolumeTagArray, OutVertexArray, this->VertexColorArray, OutVolumeDataArray);
+	this->ConvertJSONResponseBodyToMultiVolume(InHTTPComponent, "volumes", OutVolumeTagArray, this->GetMesh().GetVertexArray(), this->VertexColorArray, OutVolumeDataArray);
 	UPT_JSONConverter::ConvertJSONResponseBodyToStringArray(InHTTPComponent, "volume_descriptions", OutVolumeDescriptionArray);
 	this->ConvertJSONResponseBodyToTetraArray(InHTTPComponent, "volumes_raw", OutVolumeTagArray, this->TetraDataPerTagArray);
+	this->PointCloudBytes = CalculatePointCloudBytes(OutVolumeDataArray);
+	this->ReportMemoryUsage();
 
 	VolumeDataLoadedCallbackEvent.Broadcast();
 }
 
 void APT_Multi3DActor::ResetMulti3DActorArrays()
 {
-	this->ResetSingle3DActorArrays();
 	this->TetraDataPerTagArray.Empty();
 	this->MeshDataPerTagArray.Empty();
+	this->ResetSingle3DActorArrays();
+}
+
+void APT_Multi3DActor::GetLODSourceMeshData(TArray<FPT_MeshData>& OutMeshDataArray) const
+{
+	OutMeshDataArray = this->MeshDataPerTagArray;
+}
+
+int64 APT_Multi3DActor::GetMeshBytes() const
+{
+	int64 MeshBytes = Super::GetMeshBytes() + this->MeshDataPerTagArray.GetAllocatedSize();
+	for (const FPT_MeshData& MeshData : this->MeshDataPerTagArray)
+	{
+		MeshBytes += MeshData.TriangleIndexArray.GetAllocatedSize();
+	}
+	return MeshBytes;
+}
+
+int64 APT_Multi3DActor::GetTetraBytes() const
+{
+	int64 TetraBytes = this->TetraDataPerTagArray.GetAllocatedSize();
+	for (const TArray<FPT_TetraData>& TetraDataArray : this->TetraDataPerTagArray)
+	{
+		TetraBytes += TetraDataArray.GetAllocatedSize();
+	}
+	return TetraBytes;
+}
+
+int64 APT_Multi3DActor::CalculatePointCloudBytes(const TArray<FPT_VolumeData>& InVolumeDataArray)
+{
+	int64 TotalBytes = 0;
+	for (const FPT_VolumeData& VolumeData : InVolumeDataArray)
+	{
+		TotalBytes += VolumeData.PointCloudArray.GetAllocatedSize() + VolumeData.VertexIndexArray.GetAllocatedSize();
+	}
+	return TotalBytes;
 }
@@ -145,11 +145,27 @@ public:
 	/**
 	 * @brief Calculates normals for multiple meshes.
 	 *
-	 * This function takes an output array of normals and calculates the normals for multiple meshes.
+	 * This function calculates the normals of the vertices shared by the meshes of all tags in MeshDataPerTagArray.
 	 *
+	 * @param InVertexArray The vertices the triangle indices of the tags refer to.
 	 * @param OutNormalArray An array of normals to which the function will add new normals.
 	 */
-	void CalculateNormalsForMultiMesh(TArray<FVector>& OutNormalArray);
+	void CalculateNormalsForMultiMesh(const TArray<FVector>& InVertexArray, TArray<FVector>& OutNormalArray) const;
+
+	/**
+	 * @brief Loads the shared vertices and the meshes of all tags from a JSON response body into the mesh buffer.
+	 *
+	 * The vertices and normals are moved into the shared mesh buffer and the meshes into MeshDataPerTagArray. The
+	 * output arrays only receive copies if bOutputMeshArrays is set.
+	 *
+	 * @param InHTTPComponent The HTTP component holding the response.
+	 * @param InMeshTagArray The mesh tags.
+	 * @param InMeshDescriptionArray The mesh descriptions.
+	 * @param OutVertexArray Receives a copy of the vertices.
+	 * @param OutNormalArray Receives a copy of the normals.
+	 * @param OutMeshDataArray Receives a copy of the meshes per tag.
+	 */
+	void LoadMultiMeshBuffer(const UPT_HTTPComponent* InHTTPComponent, const TArray<FString>& InMeshTagArray, const TArray<FString>& InMeshDescriptionArray, TArray<FVector>& OutVertexArray, TArray<FVector>& OutNormalArray, TArray<FPT_MeshData>& OutMeshDataArray);
 
 	/**
 	 * @brief Extracts both mesh and volume data from a JSON response body.
@@ -213,9 +229,33 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
 	void ResetMulti3DActorArrays();
 
-public:
+protected:
+	/**
+	 * @brief Gets the bytes held by the shared vertex arrays and the triangle indices of every tag.
+	 * @return The number of bytes.
+	 */
+	virtual int64 GetMeshBytes() const override;
+
+	/**
+	 * @brief Gets the bytes held by the tetrahedral data of every tag.
+	 * @return The number of bytes.
+	 */
+	virtual int64 GetTetraBytes() const override;
+
+	/**
+	 * @brief Gets the triangles of every tag, so the levels of detail keep the tag borders.
+	 * @param OutMeshDataArray Receives the mesh data per tag.
+	 */
+	virtual void GetLODSourceMeshData(TArray<FPT_MeshData>& OutMeshDataArray) const override;
 
 private:
+	/**
+	 * @brief Sums the point cloud bytes of the volumes of a load.
+	 * @param InVolumeDataArray The volumes.
+	 * @return The number of bytes.
+	 */
+	static int64 CalculatePointCloudBytes(const TArray<FPT_VolumeData>& InVolumeDataArray);
+
 	/**
 	 * @brief A two-dimensional dynamic array storing tetrahedral data.
 	 *
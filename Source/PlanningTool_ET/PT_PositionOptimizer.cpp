@@ -0,0 +1,340 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_PositionOptimizer.h"
+#include "PT_ElectrodeEnsemble.h"
+#include "PT_ElectrodeInterpolator.h"
+#include "Async/ParallelFor.h"
+
+/** Number of best sweep nodes the refinement is started from. */
+static constexpr int32 OptimizerNumStarts = 4;
+
+bool FPT_PositionOptimizer::SetupFrame(const FPT_ElectrodeInterpolator& InInterpolator, const EInterpolationMode InMode, const TArray<FVector>& InCornerPoints, const EOptimizationObjective InObjective)
+{
+	this->EnsemblePerTagArray = nullptr;
+	this->Interpolator = &InInterpolator;
+	this->Mode = InMode;
+	this->Objective = InObjective;
+	this->Threshold = 0.0;
+	this->TagIndexArray.Empty();
+	this->ElectrodeValueArray.Empty();
+	this->TotalCells = 0;
+
+	if (!InInterpolator.IsBuilt())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_PositionOptimizer::SetupFrame] Interpolator not built!"));
+		return false;
+	}
+
+	if (!FPT_ElectrodeInterpolator::CalculateGridAxes(InCornerPoints, this->Origin, this->AxisU, this->AxisV, this->LengthU, this->LengthV))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_PositionOptimizer::SetupFrame] Grid corner points missing or degenerate!"));
+		return false;
+	}
+
+	return true;
+}
+
+bool FPT_PositionOptimizer::SetupElectrodeValues(const FPT_ElectrodeInterpolator& InInterpolator, const EInterpolationMode InMode, const TArray<FVector>& InCornerPoints, const EOptimizationObjective InObjective, const TArray<double>& InElectrodeValueArray)
+{
+	if (!this->SetupFrame(InInterpolator, InMode, InCornerPoints, InObjective) || InElectrodeValueArray.IsEmpty())
+	{
+		this->TotalCells = 0;
+		return false;
+	}
+
+	this->ElectrodeValueArray = InElectrodeValueArray;
+	this->TotalCells = 1;
+	return true;
+}
+
+bool FPT_PositionOptimizer::Setup(const TArray<FPT_TagEnsemble>& InEnsemblePerTagArray, const FPT_ElectrodeInterpolator& InInterpolator, const EInterpolationMode InMode, const TArray<FVector>& InCornerPoints, const EOptimizationObjective InObjective, const TArray<int32>& InTagIndexArray, const double InThreshold, const FVector& InDirection)
+{
+	if (!this->SetupFrame(InInterpolator, InMode, InCornerPoints, InObjective))
+	{
+		return false;
+	}
+
+	this->EnsemblePerTagArray = &InEnsemblePerTagArray;
+	this->Threshold = InThreshold;
+
+	if (InEnsemblePerTagArray.IsEmpty() || InObjective == EOptimizationObjective::NormalComponent)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_PositionOptimizer::Setup] No simulation data loaded or objective needs per electrode values!"));
+		return false;
+	}
+
+	for (int32 TagIndex = 0; TagIndex < InEnsemblePerTagArray.Num(); TagIndex++)
+	{
+		if ((InTagIndexArray.IsEmpty() || InTagIndexArray.Contains(TagIndex)) && InEnsemblePerTagArray[TagIndex].GetNumCells() > 0)
+		{
+			this->TagIndexArray.Add(TagIndex);
+			this->TotalCells += InEnsemblePerTagArray[TagIndex].GetNumCells();
+		}
+	}
+
+	if (this->TotalCells == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_PositionOptimizer::Setup] The chosen tags hold no ROI cells!"));
+		return false;
+	}
+
+	if (InObjective == EOptimizationObjective::VolumeAboveThreshold)
+	{
+		return true;
+	}
+
+	// The ROI mean of a blend is the blend of the ROI means, so the linear objectives need one value per electrode
+	const FVector Direction = InDirection.GetSafeNormal();
+	if (InObjective == EOptimizationObjective::DirectionalComponent && Direction.IsZero())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_PositionOptimizer::Setup] Direction of the directional objective is zero!"));
+		return false;
+	}
+
+	TArray<double> MeanArray;
+	for (const int32 TagIndex : this->TagIndexArray)
+	{
+		const FPT_TagEnsemble& Ensemble = InEnsemblePerTagArray[TagIndex];
+		const double CellShare = (double)Ensemble.GetNumCells() / this->TotalCells;
+		this->ElectrodeValueArray.SetNumZeroed(FMath::Max(this->ElectrodeValueArray.Num(), Ensemble.GetNumElectrodes()));
+
+		if (InObjective == EOptimizationObjective::MeanMagnitude)
+		{
+			Ensemble.CalculateChannelMeans(FPT_TagEnsemble::MagnitudeChannel, MeanArray);
+			for (int32 ElectrodeIndex = 0; ElectrodeIndex < MeanArray.Num(); ElectrodeIndex++)
+			{
+				this->ElectrodeValueArray[ElectrodeIndex] += CellShare * MeanArray[ElectrodeIndex];
+			}
+		}
+		else
+		{
+			for (int32 Component = 0; Component < 3; Component++)
+			{
+				Ensemble.CalculateChannelMeans(FPT_TagEnsemble::VectorChannel + Component, MeanArray);
+				for (int32 ElectrodeIndex = 0; ElectrodeIndex < MeanArray.Num(); ElectrodeIndex++)
+				{
+					this->ElectrodeValueArray[ElectrodeIndex] += CellShare * Direction[Component] * MeanArray[ElectrodeIndex];
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+double FPT_PositionOptimizer::Evaluate(const double InU, const double InV) const
+{
+	const FVector Point = this->GetPosition(FMath::Clamp(InU, 0.0, this->LengthU), FMath::Clamp(InV, 0.0, this->LengthV));
+
+	int32 ElectrodeIndices[FPT_ElectrodeInterpolator::MaxNeighborCount];
+	double Weights[FPT_ElectrodeInterpolator::MaxNeighborCount];
+	const int32 NumWeights = this->Interpolator->CalculateWeights(this->Mode, Point, ElectrodeIndices, Weights);
+
+	double Value = 0.0;
+	if (this->Objective == EOptimizationObjective::VolumeAboveThreshold)
+	{
+		int64 Count = 0;
+		for (const int32 TagIndex : this->TagIndexArray)
+		{
+			Count += (*this->EnsemblePerTagArray)[TagIndex].CountCellsAboveThreshold(ElectrodeIndices, Weights, NumWeights, this->Threshold);
+		}
+		Value = (double)Count / this->TotalCells;
+	}
+	else
+	{
+		for (int32 i = 0; i < NumWeights; i++)
+		{
+			if (this->ElectrodeValueArray.IsValidIndex(ElectrodeIndices[i]))
+			{
+				Value += Weights[i] * this->ElectrodeValueArray[ElectrodeIndices[i]];
+			}
+		}
+	}
+
+	return Value;
+}
+
+int32 FPT_PositionOptimizer::RefineNelderMead(double& InOutU, double& InOutV, double& OutValue, const double InStepU, const double InStepV, const int32 InMaxIterations, const double InTolerance) const
+{
+	// The simplex is minimized on the negated objective, vertices outside the grid are clamped back onto it
+	auto Clamp = [this](double& U, double& V)
+	{
+		U = FMath::Clamp(U, 0.0, this->LengthU);
+		V = FMath::Clamp(V, 0.0, this->LengthV);
+	};
+
+	double U[3] = { InOutU, InOutU + (InOutU + InStepU <= this->LengthU ? InStepU : -InStepU), InOutU };
+	double V[3] = { InOutV, InOutV, InOutV + (InOutV + InStepV <= this->LengthV ? InStepV : -InStepV) };
+	double F[3];
+	for (int32 i = 0; i < 3; i++)
+	{
+		Clamp(U[i], V[i]);
+		F[i] = -this->Evaluate(U[i], V[i]);
+	}
+	int32 NumEvaluations = 3;
+
+	for (int32 Iteration = 0; Iteration < InMaxIterations; Iteration++)
+	{
+		// Order the vertices best, middle, worst
+		for (int32 i = 0; i < 2; i++)
+		{
+			for (int32 j = 0; j < 2 - i; j++)
+			{
+				if (F[j] > F[j + 1])
+				{
+					Swap(F[j], F[j + 1]);
+					Swap(U[j], U[j + 1]);
+					Swap(V[j], V[j + 1]);
+				}
+			}
+		}
+
+		const double Size = FMath::Max(FMath::Abs(U[2] - U[0]) + FMath::Abs(V[2] - V[0]), FMath::Abs(U[1] - U[0]) + FMath::Abs(V[1] - V[0]));
+		if (Size < InTolerance)
+		{
+			break;
+		}
+
+		const double CentroidU = 0.5 * (U[0] + U[1]);
+		const double CentroidV = 0.5 * (V[0] + V[1]);
+
+		double ReflectedU = 2.0 * CentroidU - U[2];
+		double ReflectedV = 2.0 * CentroidV - V[2];
+		Clamp(ReflectedU, ReflectedV);
+		const double ReflectedF = -this->Evaluate(ReflectedU, ReflectedV);
+		NumEvaluations++;
+
+		if (ReflectedF < F[0])
+		{
+			double ExpandedU = 3.0 * CentroidU - 2.0 * U[2];
+			double ExpandedV = 3.0 * CentroidV - 2.0 * V[2];
+			Clamp(ExpandedU, ExpandedV);
+			const double ExpandedF = -this->Evaluate(ExpandedU, ExpandedV);
+			NumEvaluations++;
+
+			const bool bUseExpanded = ExpandedF < ReflectedF;
+			U[2] = bUseExpanded ? ExpandedU : ReflectedU;
+			V[2] = bUseExpanded ? ExpandedV : ReflectedV;
+			F[2] = bUseExpanded ? ExpandedF : ReflectedF;
+			continue;
+		}
+
+		if (ReflectedF < F[1])
+		{
+			U[2] = ReflectedU;
+			V[2] = ReflectedV;
+			F[2] = ReflectedF;
+			continue;
+		}
+
+		// Contract towards the better of the reflected and the worst vertex
+		const bool bOutside = ReflectedF < F[2];
+		const double ContractedU = bOutside ? CentroidU + 0.5 * (ReflectedU - CentroidU) : CentroidU + 0.5 * (U[2] - CentroidU);
+		const double ContractedV = bOutside ? CentroidV + 0.5 * (ReflectedV - CentroidV) : CentroidV + 0.5 * (V[2] - CentroidV);
+		const double ContractedF = -this->Evaluate(ContractedU, ContractedV);
+		NumEvaluations++;
+
+		if (ContractedF < FMath::Min(ReflectedF, F[2]))
+		{
+			U[2] = ContractedU;
+			V[2] = ContractedV;
+			F[2] = ContractedF;
+			continue;
+		}
+
+		// Shrink towards the best vertex
+		for (int32 i = 1; i < 3; i++)
+		{
+			U[i] = U[0] + 0.5 * (U[i] - U[0]);
+			V[i] = V[0] + 0.5 * (V[i] - V[0]);
+			F[i] = -this->Evaluate(U[i], V[i]);
+		}
+		NumEvaluations += 2;
+	}
+
+	int32 Best = 0;
+	for (int32 i = 1; i < 3; i++)
+	{
+		if (F[i] < F[Best])
+		{
+			Best = i;
+		}
+	}
+
+	InOutU = U[Best];
+	InOutV = V[Best];
+	OutValue = -F[Best];
+	return NumEvaluations;
+}
+
+FPT_OptimizationResult FPT_PositionOptimizer::Run(const int32 InSweepResolution, const int32 InMaxIterations, const double InTolerance) const
+{
+	FPT_OptimizationResult Result;
+	if (!this->Interpolator || this->TotalCells == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[FPT_PositionOptimizer::Run] Optimizer not set up!"));
+		return Result;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 Resolution = FMath::Max(InSweepResolution, 2);
+	const int32 NumNodes = Resolution * Resolution;
+	const double StepU = this->LengthU / (Resolution - 1);
+	const double StepV = this->LengthV / (Resolution - 1);
+	const double Tolerance = InTolerance > 0.0 ? InTolerance : 0.01 * FMath::Max(StepU, StepV);
+
+	// Coarse sweep, every node is independent
+	TArray<double> SweepValueArray;
+	SweepValueArray.SetNumUninitialized(NumNodes);
+	ParallelFor(NumNodes, [&](const int32 Node)
+	{
+		SweepValueArray[Node] = this->Evaluate((Node % Resolution) * StepU, (Node / Resolution) * StepV);
+	});
+
+	TArray<int32> NodeOrder;
+	NodeOrder.SetNumUninitialized(NumNodes);
+	for (int32 Node = 0; Node < NumNodes; Node++)
+	{
+		NodeOrder[Node] = Node;
+	}
+	NodeOrder.Sort([&SweepValueArray](const int32 A, const int32 B) { return SweepValueArray[A] > SweepValueArray[B]; });
+
+	// Refinement from the best nodes, so a single local maximum of the sweep does not decide the result
+	const int32 NumStarts = FMath::Min(OptimizerNumStarts, NumNodes);
+	double StartU[OptimizerNumStarts];
+	double StartV[OptimizerNumStarts];
+	double StartValue[OptimizerNumStarts];
+	int32 StartEvaluations[OptimizerNumStarts];
+	ParallelFor(NumStarts, [&](const int32 Start)
+	{
+		StartU[Start] = (NodeOrder[Start] % Resolution) * StepU;
+		StartV[Start] = (NodeOrder[Start] / Resolution) * StepV;
+		StartEvaluations[Start] = this->RefineNelderMead(StartU[Start], StartV[Start], StartValue[Start], 0.5 * StepU, 0.5 * StepV, InMaxIterations, Tolerance);
+	});
+
+	int32 BestStart = 0;
+	Result.NumEvaluations = NumNodes;
+	for (int32 Start = 0; Start < NumStarts; Start++)
+	{
+		Result.NumEvaluations += StartEvaluations[Start];
+		if (StartValue[Start] > StartValue[BestStart])
+		{
+			BestStart = Start;
+		}
+	}
+
+	Result.bIsValid = true;
+	Result.Position = this->GetPosition(StartU[BestStart], StartV[BestStart]);
+	Result.ObjectiveValue = StartValue[BestStart];
+	Result.SweepObjectiveValue = SweepValueArray[NodeOrder[0]];
+
+	int32 ElectrodeIndices[FPT_ElectrodeInterpolator::MaxNeighborCount];
+	double Weights[FPT_ElectrodeInterpolator::MaxNeighborCount];
+	const int32 NumWeights = this->Interpolator->CalculateWeights(this->Mode, Result.Position, ElectrodeIndices, Weights);
+	Result.ElectrodeIndexArray.Append(ElectrodeIndices, NumWeights);
+	Result.WeightArray.Append(Weights, NumWeights);
+
+	Result.ElapsedMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+	return Result;
+}
@@ -0,0 +1,141 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_PositionOptimizer.h
+ * @brief Header file for the FPT_PositionOptimizer class.
+ *
+ * This file contains the declaration of the FPT_PositionOptimizer class, which searches the electrode plane for the
+ * position that maximizes a field metric in the ROI.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PT_EnumContainer.h"
+#include "PT_StructContainer.h"
+
+class FPT_TagEnsemble;
+class FPT_ElectrodeInterpolator;
+
+/**
+ * @class FPT_PositionOptimizer
+ * @brief Maximizes a ROI field metric over the electrode plane.
+ *
+ * The optimizer runs a coarse parallel sweep over the grid rectangle, followed by a Nelder-Mead refinement started
+ * from the best sweep nodes. Every objective evaluation works on the stack only: the mean magnitude and directional
+ * objectives are linear in the electrode weights and reduce to one precomputed value per electrode, the threshold
+ * objective blends the magnitude block by block without an output buffer.
+ *
+ * The optimizer references the ensembles and the interpolator passed to Setup(), both have to outlive it.
+ */
+class PLANNINGTOOL_ET_API FPT_PositionOptimizer
+{
+public:
+	/**
+	 * @brief Prepares the objective.
+	 * @param InEnsemblePerTagArray The simulation data of every tag.
+	 * @param InInterpolator The interpolator over the simulated electrodes.
+	 * @param InMode The interpolation mode used to blend the electrodes.
+	 * @param InCornerPoints The four corner points of the electrode grid, bounding the search area.
+	 * @param InObjective The objective to maximize.
+	 * @param InTagIndexArray The tags the objective is evaluated on. If empty, all tags are used.
+	 * @param InThreshold The magnitude threshold of the VolumeAboveThreshold objective.
+	 * @param InDirection The direction of the DirectionalComponent objective.
+	 * @return True if the optimizer is ready.
+	 */
+	bool Setup(const TArray<FPT_TagEnsemble>& InEnsemblePerTagArray, const FPT_ElectrodeInterpolator& InInterpolator, const EInterpolationMode InMode, const TArray<FVector>& InCornerPoints, const EOptimizationObjective InObjective, const TArray<int32>& InTagIndexArray, const double InThreshold, const FVector& InDirection);
+
+	/**
+	 * @brief Prepares an objective that the caller has already reduced to one value per electrode.
+	 *
+	 * Any objective that is linear in the blended field, like the mean normal component over the ROI surface, is the
+	 * weighted sum of its per electrode values and can be optimized this way.
+	 *
+	 * @param InInterpolator The interpolator over the simulated electrodes.
+	 * @param InMode The interpolation mode used to blend the electrodes.
+	 * @param InCornerPoints The four corner points of the electrode grid, bounding the search area.
+	 * @param InObjective The objective the values belong to, only used for reporting.
+	 * @param InElectrodeValueArray The objective value of every electrode, indexed by the electrode index.
+	 * @return True if the optimizer is ready.
+	 */
+	bool SetupElectrodeValues(const FPT_ElectrodeInterpolator& InInterpolator, const EInterpolationMode InMode, const TArray<FVector>& InCornerPoints, const EOptimizationObjective InObjective, const TArray<double>& InElectrodeValueArray);
+
+	/**
+	 * @brief Runs the sweep and the refinement.
+	 * @param InSweepResolution The number of sweep nodes along every grid edge.
+	 * @param InMaxIterations The maximum number of Nelder-Mead iterations per start.
+	 * @param InTolerance The simplex size in world units at which the refinement stops. If not positive, a hundredth of the sweep spacing is used.
+	 * @return The optimal position with the electrodes and weights of the interpolation mode there.
+	 */
+	FPT_OptimizationResult Run(const int32 InSweepResolution, const int32 InMaxIterations, const double InTolerance) const;
+
+	/**
+	 * @brief Evaluates the objective at a position in grid coordinates. Does not allocate and can be called from any thread.
+	 * @param InU The coordinate along the first grid edge, clamped to the grid.
+	 * @param InV The coordinate along the second grid edge, clamped to the grid.
+	 * @return The objective value.
+	 */
+	double Evaluate(const double InU, const double InV) const;
+
+	/** @brief Converts grid coordinates to a world position. */
+	FVector GetPosition(const double InU, const double InV) const { return this->Origin + InU * this->AxisU + InV * this->AxisV; }
+
+private:
+	/**
+	 * @brief Resets the objective and sets up the search frame shared by both setup variants.
+	 * @return True if the interpolator is built and the corner points span a plane.
+	 */
+	bool SetupFrame(const FPT_ElectrodeInterpolator& InInterpolator, const EInterpolationMode InMode, const TArray<FVector>& InCornerPoints, const EOptimizationObjective InObjective);
+
+	/**
+	 * @brief Refines a start position with the Nelder-Mead method.
+	 * @param InOutU The coordinate along the first grid edge.
+	 * @param InOutV The coordinate along the second grid edge.
+	 * @param OutValue The objective value at the refined position.
+	 * @param InStepU The initial simplex edge along the first grid edge.
+	 * @param InStepV The initial simplex edge along the second grid edge.
+	 * @param InMaxIterations The maximum number of iterations.
+	 * @param InTolerance The simplex size at which the refinement stops.
+	 * @return The number of objective evaluations.
+	 */
+	int32 RefineNelderMead(double& InOutU, double& InOutV, double& OutValue, const double InStepU, const double InStepV, const int32 InMaxIterations, const double InTolerance) const;
+
+	/** @brief The simulation data of every tag. */
+	const TArray<FPT_TagEnsemble>* EnsemblePerTagArray = nullptr;
+
+	/** @brief The interpolator over the simulated electrodes. */
+	const FPT_ElectrodeInterpolator* Interpolator = nullptr;
+
+	/** @brief The interpolation mode used to blend the electrodes. */
+	EInterpolationMode Mode = EInterpolationMode::Barycentric;
+
+	/** @brief The objective to maximize. */
+	EOptimizationObjective Objective = EOptimizationObjective::MeanMagnitude;
+
+	/** @brief The tags the objective is evaluated on. */
+	TArray<int32> TagIndexArray;
+
+	/** @brief The objective value of every electrode for the linear objectives, indexed by the electrode index. */
+	TArray<double> ElectrodeValueArray;
+
+	/** @brief The magnitude threshold of the VolumeAboveThreshold objective. */
+	double Threshold = 0.0;
+
+	/** @brief The total number of ROI cells of the chosen tags, 1 for objectives given per electrode. */
+	int64 TotalCells = 0;
+
+	/** @brief First grid corner point. */
+	FVector Origin = FVector::ZeroVector;
+
+	/** @brief Unit vector along the first grid edge. */
+	FVector AxisU = FVector::ForwardVector;
+
+	/** @brief Unit vector along the second grid edge. */
+	FVector AxisV = FVector::RightVector;
+
+	/** @brief Length of the first grid edge. */
+	double LengthU = 0.0;
+
+	/** @brief Length of the second grid edge. */
+	double LengthV = 0.0;
+};
@@ -43,6 +43,7 @@ void APT_ROIActor::BeginPlay()
     this->CalculateNormalsManually();
 
     this->GenerateBoxMesh();
+    this->CommitROIEdit();
 
     if (APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
     {
@@ -54,6 +55,8 @@ void APT_ROIActor::BeginPlay()
         if (UEnhancedInputComponent* EnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerController->InputComponent))
         {
             EnhancedInputComponent->BindAction(this->IA_MoveBox, ETriggerEvent::Triggered, this, &APT_ROIActor::OnMoveROI);
+            EnhancedInputComponent->BindAction(this->IA_MoveBox, ETriggerEvent::Completed, this, &APT_ROIActor::CommitROIEdit);
+            EnhancedInputComponent->BindAction(this->IA_MoveBox, ETriggerEvent::Canceled, this, &APT_ROIActor::CommitROIEdit);
         }
     }
 }
@@ -124,9 +127,23 @@ void APT_ROIActor::GenerateBoxMesh()
     // Update the ProceduralMesh
     this->ProceduralMesh->CreateMeshSection_LinearColor(0, this->VertexArray, this->TriangleIndexArray, this->NormalArray, UV0, VertexColors, Tangents, true);
     this->ProceduralMesh->SetMaterial(0, this->Material);
+
+    // The shared buffer and its handle are only replaced when the edit is committed, not on every drag step
+    this->bIsMeshBufferStale = true;
     this->RoiChangedEvent.Broadcast();
 }
 
+void APT_ROIActor::CommitROIEdit()
+{
+    if (!this->bIsMeshBufferStale)
+    {
+        return;
+    }
+
+    this->SetMeshBuffer(CopyTemp(this->VertexArray), CopyTemp(this->NormalArray), CopyTemp(this->TriangleIndexArray));
+    this->bIsMeshBufferStale = false;
+}
+
 void APT_ROIActor::ApplyTransformations(const FVector& NewSize, const FVector& NewPosition, const FRotator& NewRotation)
 {
     //// Setzen der Standardwerte
@@ -220,18 +237,21 @@ void APT_ROIActor::SetROISize(const float& InSizeX, const float& InSizeY, const
 {
     this->CurrentROISize = FVector(InSizeX, InSizeY, InSizeZ);
     ApplyTransformations(this->CurrentROISize, this->CurrentROIPosition, this->CurrentROIRotation);
+    this->CommitROIEdit();
 }
 
 void APT_ROIActor::SetROIPosition(const float& InPosX, const float& InPosY, const float& InPosZ)
 {
     this->CurrentROIPosition = FVector(InPosX, InPosY, InPosZ);
     ApplyTransformations(this->CurrentROISize, this->CurrentROIPosition, this->CurrentROIRotation);
+    this->CommitROIEdit();
 }
 
 void APT_ROIActor::SetROIRotation(const float& InPitch, const float& InYaw, const float& InRoll)
 {
     this->CurrentROIRotation = FRotator(InPitch, InYaw, InRoll);
     ApplyTransformations(this->CurrentROISize, this->CurrentROIPosition, this->CurrentROIRotation);
+    this->CommitROIEdit();
 }
 
 void APT_ROIActor::OnMoveROI(const FInputActionValue& Value)
@@ -290,51 +310,6 @@ TArray<FVector> APT_ROIActor::GetROIBoundsToWorldSpaceRelativeTo(AActor* OtherAc
 
 void APT_ROIActor::CalculateNormalsManually()
 {
-    // Initialisieren des NormalArray mit Nullvektoren der gleichen Gre wie VertexArray
-    this->NormalArray.Init(FVector(0.0f, 0.0f, 0.0f), this->VertexArray.Num());
-
-    // Sicherstellen, dass die Anzahl der Indizes durch 3 teilbar ist
-    if (this->TriangleIndexArray.Num() % 3 != 0)
-    {
-        UE_LOG(LogTemp, Warning, TEXT("TriangleIndexArray hat keine gltige Anzahl von Indizes."));
-        return;
-    }
-
-    // Durchlaufen jedes Dreiecks und Berechnen der Normalen
-    for (int32 i = 0; i < this->TriangleIndexArray.Num(); i += 3)
-    {
-        // Holen der Indizes der Eckpunkte des Dreiecks
-        int32 Index0 = this->TriangleIndexArray[i];
-        int32 Index1 = this->TriangleIndexArray[i + 1];
-        int32 Index2 = this->TriangleIndexArray[i + 2];
-
-        // Holen der Eckpunkte des Dreiecks
-        FVector Vertex0 = this->VertexArray[Index0];
-        FVector Vertex1 = this->VertexArray[Index1];
-        FVector Vertex2 = this->VertexArray[Index2];
-
-        // Berechnen der Vektoren der Dreiecksseiten
-        FVector Edge1 = Vertex0 - Vertex1;
-        FVector Edge2 = Vertex0 - Vertex2;
-
-        // Berechnen der Normalen durch das Kreuzprodukt der Kanten
-        FVector Normal = FVector::CrossProduct(Edge1, Edge2);
-        if (Normal.IsZero())
-        {
-            UE_LOG(LogTemp, Warning, TEXT("Normal is zero!"));
-        }
-
-        Normal.Normalize();
-
-        // Akkumulieren der Normalen fr jedes Eckpunkt des Dreiecks
-        this->NormalArray[Index0] -= Normal;
-        this->NormalArray[Index1] -= Normal;
-        this->NormalArray[Index2] -= Normal;
-    }
-
-    // Normalisieren der akkumulierten Normalen fr jedes Vertex
-    for (FVector& Normal : this->NormalArray)
-    {
-        Normal.Normalize();
-    }
+    // Every box face contributes with the same weight, so the corner normals point diagonally outwards
+    FPT_MeshNormals::Calculate(this->VertexArray, this->TriangleIndexArray, ENormalWeighting::Uniform, true, this->NormalArray);
 }
@@ -93,11 +93,23 @@ public:
 
     /**
      * @brief Moves the ROI position by the specified amount.
+     *
+     * Only the displayed box follows every move, the mesh buffer is replaced by CommitROIEdit once the drag ends.
+     *
      * @param InNewPosition New position to move the ROI to.
      */
     UFUNCTION(BlueprintCallable, Category = "PT_ROI")
     void MoveROIPosition(const FVector& InNewPosition);
 
+    /**
+     * @brief Publishes the edited box as the mesh buffer of the actor, if it changed since the last commit.
+     *
+     * Called by the size, position and rotation setters and at the end of a drag with IA_MoveBox. Blueprints moving
+     * the ROI with MoveROIPosition call it when their drag ends, so handles are not replaced on every step.
+     */
+    UFUNCTION(BlueprintCallable, Category = "PT_ROI")
+    void CommitROIEdit();
+
     /**
      * @brief Sets the size of the ROI and applies the transformation.
      * @param InSizeX Size in the X dimension.
@@ -191,6 +203,18 @@ private:
      */
     void CalculateNormalsManually();
 
+    /** @brief The corners of the ROI box, changed by every transformation. */
+    TArray<FVector> VertexArray;
+
+    /** @brief The corner normals of the ROI box. */
+    TArray<FVector> NormalArray;
+
+    /** @brief The triangle indices of the ROI box, two triangles per face. */
+    TArray<int32> TriangleIndexArray;
+
+    /** @brief Whether the box changed since the mesh buffer was last published by CommitROIEdit. */
+    bool bIsMeshBufferStale = false;
+
     FVector CurrentROISize;
     FVector CurrentROIPosition;
     FRotator CurrentROIRotation;
@@ -4,6 +4,51 @@
 #include "PT_SimulationComponent.h"
 #include "PT_ConfigManager.h"
 #include "PT_JSONConverter.h"
+#include "PT_ElectrodeAreaActor.h"
+#include "PT_PositionOptimizer.h"
+#include "PT_MemoryBudgetManager.h"
+#include "Async/ParallelFor.h"
+
+/** Returns the milliseconds since a load stage started and starts the next stage. */
+static double EndLoadStage(double& InOutStageStart)
+{
+	const double Now = FPlatformTime::Seconds();
+	const double Milliseconds = (Now - InOutStageStart) * 1000.0;
+	InOutStageStart = Now;
+	return Milliseconds;
+}
+
+/** Number of volume thresholds the interpolation pass accumulates on the stack, more thresholds use the heap. */
+static constexpr int32 InlineVolumeThresholds = 16;
+
+/** Percentiles reported by the normal field analysis. */
+static const double NormalFieldPercentiles[] = { 5.0, 25.0, 50.0, 75.0, 95.0 };
+
+/**
+ * Calculates the angle between a surface normal and a field vector in degrees and the field component along the normal.
+ * A zero field or normal yields 90 degrees and a zero component.
+ */
+static FORCEINLINE double CalculateNormalFieldAngle(const FVector& InNormal, const FVector& InField, double& OutNormalComponent)
+{
+	const FVector UnitNormal = InNormal.GetSafeNormal();
+	OutNormalComponent = FVector::DotProduct(UnitNormal, InField);
+	const double DotProduct = FMath::Clamp(FVector::DotProduct(UnitNormal, InField.GetSafeNormal()), -1.0, 1.0);
+	return FMath::RadiansToDegrees(FMath::Acos(DotProduct));
+}
+
+/** Linear interpolation percentile of sorted data, like UPT_SimulationComponent::CalculatePercentile without the sort. */
+static double CalculateSortedPercentile(const TArray<double>& InSortedData, const double InPercentile)
+{
+	if (InSortedData.IsEmpty())
+	{
+		return 0.0;
+	}
+
+	const double Index = FMath::Clamp(InPercentile / 100.0, 0.0, 1.0) * (InSortedData.Num() - 1);
+	const int32 LowerIndex = FMath::FloorToInt(Index);
+	const int32 UpperIndex = FMath::Min(LowerIndex + 1, InSortedData.Num() - 1);
+	return InSortedData[LowerIndex] + (InSortedData[UpperIndex] - InSortedData[LowerIndex]) * (Index - LowerIndex);
+}
 
 // Sets default values for this component's properties
 UPT_SimulationComponent::UPT_SimulationComponent()
@@ -27,10 +72,25 @@ void UPT_SimulationComponent::BeginPlay()
 	this->MeanMagnitudePerTag.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
 	this->MeanVectorFieldPerTag.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
 
+	// Lets the memory budget manager reclaim resident datasets and lower the precision of the active one
+	TWeakObjectPtr<UPT_SimulationComponent> WeakThis(this);
+	UPT_MemoryBudgetManager::RegisterReliefHandler(this->GetMemoryConsumerName(), [WeakThis](const int64 InBytesToFree) -> int64
+	{
+		return WeakThis.IsValid() ? WeakThis->RelieveMemory(InBytesToFree) : 0;
+	});
+
 	// ...
 	
 }
 
+void UPT_SimulationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UPT_MemoryBudgetManager::UnregisterReliefHandler(this->GetMemoryConsumerName());
+	UPT_MemoryBudgetManager::ReleaseUsage(this->GetMemoryConsumerName());
+
+	Super::EndPlay(EndPlayReason);
+}
+
 
 // Called every frame
 void UPT_SimulationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
@@ -42,6 +102,7 @@ void UPT_SimulationComponent::TickComponent(float DeltaTime, ELevelTick TickType
 
 #include "CoreMinimal.h"
 #include "Algo/Sort.h" // For sorting the array
+#include "Algo/Count.h"
 
 static const TArray<FLinearColor> PlasmaColormap = {
 	FLinearColor(0.050383, 0.029803, 0.527975),
@@ -303,6 +364,160 @@ static const TArray<FLinearColor> PlasmaColormap = {
 };
 
 
+void UPT_SimulationComponent::SetSurfaceNormalArray(const TArray<FVector>& InNormalArray)
+{
+	this->SurfaceMesh = FPT_MeshBuffer::Create(TArray<FVector>(), CopyTemp(InNormalArray), TArray<int32>());
+}
+
+void UPT_SimulationComponent::SetSurfaceMeshBuffer(const UPT_MeshBufferHandle* InMeshBuffer)
+{
+	if (!InMeshBuffer || !InMeshBuffer->HasBuffer())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::SetSurfaceMeshBuffer] No mesh buffer given!"));
+		return;
+	}
+	this->SurfaceMesh = InMeshBuffer->GetBufferPtr();
+}
+
+void UPT_SimulationComponent::SetTetraVolumesPerTag(const int32& InTagIndex, const TArray<FPT_TetraData>& InTetraDataArray, const TArray<FVector>& InVertexArray)
+{
+	if (!this->RoiIndexMappingPerTagArray.IsValidIndex(InTagIndex))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::SetTetraVolumesPerTag] No simulation data loaded for tag index %d!"), InTagIndex);
+		return;
+	}
+
+	if (InTetraDataArray.Num() != this->TagLengthArray[InTagIndex])
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[UPT_SimulationComponent::SetTetraVolumesPerTag] Tag %d has %d cells, got %d tetras!"), InTagIndex, this->TagLengthArray[InTagIndex], InTetraDataArray.Num());
+	}
+
+	TArray<float> TetraVolumeArray;
+	TetraVolumeArray.SetNumZeroed(InTetraDataArray.Num());
+	ParallelFor(InTetraDataArray.Num(), [&](const int32 TetraIndex)
+	{
+		const FPT_TetraData& Tetra = InTetraDataArray[TetraIndex];
+		const int32 A = (int32)Tetra.A;
+		const int32 B = (int32)Tetra.B;
+		const int32 C = (int32)Tetra.C;
+		const int32 D = (int32)Tetra.D;
+		if (!InVertexArray.IsValidIndex(A) || !InVertexArray.IsValidIndex(B) || !InVertexArray.IsValidIndex(C) || !InVertexArray.IsValidIndex(D))
+		{
+			return;
+		}
+
+		const FVector AB = InVertexArray[B] - InVertexArray[A];
+		const FVector AC = InVertexArray[C] - InVertexArray[A];
+		const FVector AD = InVertexArray[D] - InVertexArray[A];
+		TetraVolumeArray[TetraIndex] = (float)(FMath::Abs(FVector::DotProduct(AB, FVector::CrossProduct(AC, AD))) / 6.0);
+	});
+
+	const int32 NumTags = this->RoiIndexMappingPerTagArray.Num();
+	this->RoiCellVolumePerTagArray.SetNum(NumTags);
+	this->TagVolumePerTagArray.SetNumZeroed(NumTags);
+
+	double TagVolume = 0.0;
+	for (const float Volume : TetraVolumeArray)
+	{
+		TagVolume += Volume;
+	}
+	this->TagVolumePerTagArray[InTagIndex] = TagVolume;
+
+	// Reorder to the ensemble order, so the interpolation pass reads the volumes sequentially
+	const TArray<int32>& RoiIndexMapping = this->RoiIndexMappingPerTagArray[InTagIndex];
+	TArray<float>& RoiCellVolumes = this->RoiCellVolumePerTagArray[InTagIndex];
+	RoiCellVolumes.SetNumUninitialized(RoiIndexMapping.Num());
+	for (int32 CurrentIndex = 0; CurrentIndex < RoiIndexMapping.Num(); CurrentIndex++)
+	{
+		RoiCellVolumes[CurrentIndex] = TetraVolumeArray.IsValidIndex(RoiIndexMapping[CurrentIndex]) ? TetraVolumeArray[RoiIndexMapping[CurrentIndex]] : 0.0f;
+	}
+
+	// Geometry of the vertex cell entries of this tag for the weighted vertex averaging
+	ParallelFor(FMath::Max(this->VertexCellRowOffsetArray.Num() - 1, 0), [&](const int32 Row)
+	{
+		const int32 CurrentVertexIndex = this->VerticesInRoiArray[Row];
+		for (int32 Entry = this->VertexCellRowOffsetArray[Row]; Entry < this->VertexCellRowOffsetArray[Row + 1]; Entry++)
+		{
+			const int32 CurrentCellIndex = this->VertexCellIndexArray[Entry];
+			if (this->VertexCellTagArray[Entry] != InTagIndex || !TetraVolumeArray.IsValidIndex(CurrentCellIndex) || !InVertexArray.IsValidIndex(CurrentVertexIndex))
+			{
+				continue;
+			}
+
+			const FPT_TetraData& Tetra = InTetraDataArray[CurrentCellIndex];
+			FVector Centroid = FVector::ZeroVector;
+			for (const double Corner : { Tetra.A, Tetra.B, Tetra.C, Tetra.D })
+			{
+				Centroid += InVertexArray.IsValidIndex((int32)Corner) ? InVertexArray[(int32)Corner] * 0.25 : FVector::ZeroVector;
+			}
+
+			this->VertexCellVolumeArray[Entry] = TetraVolumeArray[CurrentCellIndex];
+			this->VertexCellDistanceArray[Entry] = (float)FVector::Dist(InVertexArray[CurrentVertexIndex], Centroid);
+		}
+	});
+	this->bVertexCellWeightsDirty = true;
+
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::SetTetraVolumesPerTag] Tag %d: Tag Volume %f, %d ROI cells"), InTagIndex, TagVolume, RoiIndexMapping.Num());
+}
+
+FPT_VolumeMetrics UPT_SimulationComponent::GetVolumeMetrics() const
+{
+	FPT_VolumeMetrics Metrics = this->VolumeMetrics;
+	const int32 NumThresholds = Metrics.ThresholdArray.Num();
+
+	Metrics.bHasTetraVolumes = Metrics.NumTags > 0;
+	Metrics.TagVolumePerTagArray.SetNumZeroed(Metrics.NumTags);
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < Metrics.NumTags; CurrentTagIndex++)
+	{
+		const bool bHasVolumes = this->RoiCellVolumePerTagArray.IsValidIndex(CurrentTagIndex) && this->RoiCellVolumePerTagArray[CurrentTagIndex].Num() == this->EnsemblePerTagArray[CurrentTagIndex].GetNumCells();
+		Metrics.bHasTetraVolumes &= bHasVolumes;
+		Metrics.TagVolumePerTagArray[CurrentTagIndex] = bHasVolumes ? this->TagVolumePerTagArray[CurrentTagIndex] : 0.0;
+	}
+
+	Metrics.VolumeAboveThresholdArray.SetNumZeroed(NumThresholds);
+	Metrics.FractionAboveThresholdArray.SetNumZeroed(NumThresholds);
+	Metrics.FractionAboveThresholdPerTagArray.SetNumZeroed(Metrics.NumTags * NumThresholds);
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < Metrics.NumTags; CurrentTagIndex++)
+	{
+		const double TagRoiVolume = Metrics.RoiVolumePerTagArray[CurrentTagIndex];
+		Metrics.RoiVolume += TagRoiVolume;
+		for (int32 k = 0; k < NumThresholds; k++)
+		{
+			const double VolumeAbove = Metrics.VolumeAboveThresholdPerTagArray[CurrentTagIndex * NumThresholds + k];
+			Metrics.VolumeAboveThresholdArray[k] += VolumeAbove;
+			Metrics.FractionAboveThresholdPerTagArray[CurrentTagIndex * NumThresholds + k] = TagRoiVolume > 0.0 ? VolumeAbove / TagRoiVolume : 0.0;
+		}
+	}
+
+	for (int32 k = 0; k < NumThresholds; k++)
+	{
+		Metrics.FractionAboveThresholdArray[k] = Metrics.RoiVolume > 0.0 ? Metrics.VolumeAboveThresholdArray[k] / Metrics.RoiVolume : 0.0;
+	}
+
+	return Metrics;
+}
+
+FLinearColor UPT_SimulationComponent::SamplePlasmaColormap(const double InNormalizedValue)
+{
+	return PlasmaColormap[FMath::Clamp(FMath::RoundToInt(InNormalizedValue * 255), 0, 255)];
+}
+
+// Control points of the cool to warm diverging colormap, from -1 to 1
+static const FLinearColor DivergingColormap[] = {
+	FLinearColor(0.230f, 0.299f, 0.754f),
+	FLinearColor(0.552f, 0.690f, 0.996f),
+	FLinearColor(0.865f, 0.865f, 0.865f),
+	FLinearColor(0.958f, 0.604f, 0.482f),
+	FLinearColor(0.706f, 0.016f, 0.150f)
+};
+
+FLinearColor UPT_SimulationComponent::SampleDivergingColormap(const double InSignedValue)
+{
+	const double Position = (FMath::Clamp(InSignedValue, -1.0, 1.0) + 1.0) * 0.5 * (UE_ARRAY_COUNT(DivergingColormap) - 1);
+	const int32 Lower = FMath::Min(FMath::FloorToInt(Position), (int32)UE_ARRAY_COUNT(DivergingColormap) - 2);
+	return FMath::Lerp(DivergingColormap[Lower], DivergingColormap[Lower + 1], (float)(Position - Lower));
+}
+
 TArray<FLinearColor> UPT_SimulationComponent::MapToPlasmaColormap(
 	const TArray<double>& InData,
 	const int32& InDataTagIndex,
@@ -421,116 +636,185 @@ TArray<FLinearColor> UPT_SimulationComponent::MapToGreyscaleColormap(
 	return GreyscaleColormap;
 }
 
-static void LogVertexTagCellMapping(TMap<int32, TArray<FJsonSerializableArrayInt>> VertexTagCellMapping)
-{
-	for (const auto& MapEntry : VertexTagCellMapping)
-	{
-		int32 Key = MapEntry.Key;
-		const TArray<FJsonSerializableArrayInt>& Array = MapEntry.Value;
-
-		UE_LOG(LogTemp, Log, TEXT("Key: %d"), Key);
-
-		for (int32 Index = 0; Index < Array.Num(); ++Index)
-		{
-			const FJsonSerializableArrayInt& InnerArray = Array[Index]; // This is a TArray<int32>
-
-			FString SerializedArray;
-			for (int32 InnerValue : InnerArray) // Loop through each int32 in the inner array
-			{
-				SerializedArray += FString::FromInt(InnerValue) + TEXT(", ");
-			}
-
-			// Trim the trailing comma and space
-			if (!SerializedArray.IsEmpty())
-			{
-				SerializedArray.RemoveAt(SerializedArray.Len() - 2, 2);
-			}
-
-			UE_LOG(LogTemp, Log, TEXT("    Array[%d]: %s"), Index, *SerializedArray);
-		}
-	}
-}
 TArray<FLinearColor> UPT_SimulationComponent::CalculateVertexColors(const int32& InVertexArrayLength)
 {
 	TArray<FLinearColor> OutVertexColors;
 	OutVertexColors.Init(FLinearColor(0.9f, 0.9f, 0.9f), InVertexArrayLength);
 	this->VectorfieldInRoi.Empty();
+	this->NormalAngleInRoi.Empty();
+	this->NormalComponentInRoi.Empty();
+	this->NormalValidInRoi.Empty();
+
+	if (this->bVertexCellWeightsDirty || this->VertexCellWeightMode != this->VertexAveragingMode)
+	{
+		this->UpdateVertexCellWeights();
+	}
 
-	LogVertexTagCellMapping(this->VertexTagCellMapping);
 	int32 GoodCounter = 0;
 	int32 BadCounter = 0;
-	int32 EmptyCellIndices = 0;
 	int32 InvalidIndices = 0;
-	int32 InvalidMappingIndices = 0;
-	for (const int32 CurrentVertexIndex : this->VerticesInRoiArray)
+	const int32 NumRows = FMath::Max(this->VertexCellRowOffsetArray.Num() - 1, 0);
+	this->VectorfieldInRoi.Reserve(NumRows);
+
+	// The normal field analysis runs in the same pass, every array below stays aligned with VerticesInRoiArray
+	this->NormalAngleInRoi.Init(90.0, NumRows);
+	this->NormalComponentInRoi.Init(0.0, NumRows);
+	this->NormalValidInRoi.Init(false, NumRows);
+	double AngleSum = 0.0;
+	double NormalComponentSum = 0.0;
+	double AbsoluteNormalComponentSum = 0.0;
+	int32 NumNormalVertices = 0;
+	const TArray<FVector>& SurfaceNormalArray = this->GetSurfaceNormalArray();
+
+	for (int32 Row = 0; Row < NumRows; Row++)
 	{
+		const int32 CurrentVertexIndex = this->VerticesInRoiArray[Row];
 		if (!OutVertexColors.IsValidIndex(CurrentVertexIndex))
 		{
 			InvalidIndices++;
+			this->VectorfieldInRoi.Add(FVector::ZeroVector);
+			continue;
+		}
+
+		const int32 Begin = this->VertexCellRowOffsetArray[Row];
+		const int32 End = this->VertexCellRowOffsetArray[Row + 1];
+		if (Begin == End)
+		{
+			BadCounter++;
+			OutVertexColors[CurrentVertexIndex] = FLinearColor::Red; // Fallback color
+			this->VectorfieldInRoi.Add(FVector::ZeroVector);
 			continue;
 		}
 
-		int32 MeanCounter = 0;
-		//double R = 0.0, G = 0.0, B = 0.0;
-		FLinearColor NewColor = FLinearColor(0.f, 0.f, 0.f);
+		// The row weights are normalized, so the weighted sum is the average
+		FLinearColor NewColor = FLinearColor(0.f, 0.f, 0.f, 0.f);
 		FVector Vectorfield = FVector::ZeroVector;
+		for (int32 Entry = Begin; Entry < End; Entry++)
+		{
+			const int32 CurrentTagIndex = this->VertexCellTagArray[Entry];
+			const int32 CurrentCellIndex = this->VertexCellIndexArray[Entry];
+			const float Weight = this->VertexCellWeightArray[Entry];
+
+			NewColor += this->DataColorArrayPerTag[CurrentTagIndex][CurrentCellIndex] * Weight;
+			Vectorfield += this->InterpolatedVectorfieldDataPerTagArray[CurrentTagIndex][CurrentCellIndex] * Weight;
+		}
+
+		GoodCounter++;
+		OutVertexColors[CurrentVertexIndex] = NewColor;
+		this->VectorfieldInRoi.Add(Vectorfield);
+
+		if (SurfaceNormalArray.IsValidIndex(CurrentVertexIndex))
+		{
+			double NormalComponent = 0.0;
+			const double Angle = CalculateNormalFieldAngle(SurfaceNormalArray[CurrentVertexIndex], Vectorfield, NormalComponent);
+			this->NormalAngleInRoi[Row] = Angle;
+			this->NormalComponentInRoi[Row] = NormalComponent;
+			this->NormalValidInRoi[Row] = true;
+
+			AngleSum += Angle;
+			NormalComponentSum += NormalComponent;
+			AbsoluteNormalComponentSum += FMath::Abs(NormalComponent);
+			NumNormalVertices++;
+		}
+	}
+
+	this->NormalFieldReport = FPT_NormalFieldReport();
+	this->NormalFieldReport.NumVertices = NumNormalVertices;
+	if (NumNormalVertices > 0)
+	{
+		this->NormalFieldReport.MeanAngle = AngleSum / NumNormalVertices;
+		this->NormalFieldReport.MeanNormalComponent = NormalComponentSum / NumNormalVertices;
+		this->NormalFieldReport.MeanAbsoluteNormalComponent = AbsoluteNormalComponentSum / NumNormalVertices;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::CalculateVertexColors] Goods: %d, Bads: %d, Invalid Indices: %d, Normal Vertices: %d"), GoodCounter, BadCounter, InvalidIndices, NumNormalVertices);
+	return OutVertexColors;
+}
 
+void UPT_SimulationComponent::BuildVertexCellRows()
+{
+	this->VertexCellRowOffsetArray.Reset();
+	this->VertexCellTagArray.Reset();
+	this->VertexCellIndexArray.Reset();
+
+	this->VertexCellRowOffsetArray.Reserve(this->VerticesInRoiArray.Num() + 1);
+	this->VertexCellRowOffsetArray.Add(0);
+
+	int32 EmptyCellIndices = 0;
+	int32 InvalidMappingIndices = 0;
+	for (const int32 CurrentVertexIndex : this->VerticesInRoiArray)
+	{
+		const TArray<TArray<int32>>* CellIndicesPerTag = this->VertexTagCellMapping.Find(CurrentVertexIndex);
 		for (const int32 CurrentTagIndex : UPT_ConfigManager::GetDataTagVolumeIndexArray())
 		{
-			if (!this->VertexTagCellMapping.Contains(CurrentVertexIndex) ||
-				!this->VertexTagCellMapping[CurrentVertexIndex].IsValidIndex(CurrentTagIndex))
+			if (!CellIndicesPerTag || !CellIndicesPerTag->IsValidIndex(CurrentTagIndex))
 			{
 				InvalidMappingIndices++;
 				continue;
 			}
 
-			const TArray<int32>& CurrentCellIndices = this->VertexTagCellMapping[CurrentVertexIndex][CurrentTagIndex];
-
+			const TArray<int32>& CurrentCellIndices = (*CellIndicesPerTag)[CurrentTagIndex];
 			if (CurrentCellIndices.IsEmpty())
 			{
-				UE_LOG(LogTemp, Warning, TEXT("CurrentCellIndices Empty for Vertex Index: %d, andCurrent Tag Index: %d"), CurrentVertexIndex, CurrentTagIndex);
 				EmptyCellIndices++;
 				continue;
 			}
 
 			for (const int32 CurrentCellIndex : CurrentCellIndices)
 			{
-				const FLinearColor& Color = this->DataColorArrayPerTag[CurrentTagIndex][CurrentCellIndex];
-				//UE_LOG(LogTemp, Log, TEXT("[CalculateVertexColors] Color: [%f, %f, %f]"), Color.R, Color.G, Color.B);
-				NewColor += Color;
+				this->VertexCellTagArray.Add((uint8)CurrentTagIndex);
+				this->VertexCellIndexArray.Add(CurrentCellIndex);
+			}
+		}
+		this->VertexCellRowOffsetArray.Add(this->VertexCellIndexArray.Num());
+	}
 
-				/*R += Color.R;
-				G += Color.G;
-				B += Color.B;*/
+	this->VertexCellVolumeArray.Init(-1.0f, this->VertexCellIndexArray.Num());
+	this->VertexCellDistanceArray.Init(-1.0f, this->VertexCellIndexArray.Num());
+	this->bVertexCellWeightsDirty = true;
 
-				MeanCounter++;
-				Vectorfield += this->InterpolatedVectorfieldDataPerTagArray[CurrentTagIndex][CurrentCellIndex];
-			}
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::BuildVertexCellRows] %d Vertices, %d Entries, Empty Cell Indices: %d, Invalid Mapping Indices: %d"), this->VerticesInRoiArray.Num(), this->VertexCellIndexArray.Num(), EmptyCellIndices, InvalidMappingIndices);
+}
+
+void UPT_SimulationComponent::UpdateVertexCellWeights()
+{
+	const EVertexAveraging Mode = this->VertexAveragingMode;
+	const TArray<float>& SourceArray = Mode == EVertexAveraging::Volume ? this->VertexCellVolumeArray : this->VertexCellDistanceArray;
+	this->VertexCellWeightArray.SetNumUninitialized(this->VertexCellIndexArray.Num());
+
+	ParallelFor(FMath::Max(this->VertexCellRowOffsetArray.Num() - 1, 0), [&](const int32 Row)
+	{
+		const int32 Begin = this->VertexCellRowOffsetArray[Row];
+		const int32 End = this->VertexCellRowOffsetArray[Row + 1];
+
+		// Rows with unknown geometry fall back to uniform weights
+		bool bIsUniform = Mode == EVertexAveraging::Uniform;
+		for (int32 Entry = Begin; Entry < End && !bIsUniform; Entry++)
+		{
+			bIsUniform = SourceArray[Entry] < 0.0f;
 		}
-		if (MeanCounter > 0)
+
+		float WeightSum = 0.0f;
+		for (int32 Entry = Begin; Entry < End; Entry++)
 		{
-			GoodCounter++;
-			//const float InvMeanCounter = 1.0f / MeanCounter;
-			OutVertexColors[CurrentVertexIndex] = NewColor / MeanCounter;
-			/*OutVertexColors[CurrentVertexIndex].R = R / MeanCounter;
-			OutVertexColors[CurrentVertexIndex].G = G / MeanCounter;
-			OutVertexColors[CurrentVertexIndex].B = B / MeanCounter;*/
-			this->VectorfieldInRoi.Add(Vectorfield / MeanCounter);
+			float Weight = 1.0f;
+			if (!bIsUniform)
+			{
+				Weight = Mode == EVertexAveraging::Volume ? SourceArray[Entry] : 1.0f / FMath::Max(SourceArray[Entry], UE_KINDA_SMALL_NUMBER);
+			}
+			this->VertexCellWeightArray[Entry] = Weight;
+			WeightSum += Weight;
 		}
-		else
+
+		const float InvWeightSum = WeightSum > 0.0f ? 1.0f / WeightSum : 0.0f;
+		for (int32 Entry = Begin; Entry < End; Entry++)
 		{
-			BadCounter++;
-			//UE_LOG(LogTemp, Error, TEXT("[CalculateVertexColors] No Color Values for Vertex, assigning fallback color"));
-			OutVertexColors[CurrentVertexIndex] = FLinearColor::Red; // Fallback color
-			this->VectorfieldInRoi.Add(FVector::ZeroVector);
+			this->VertexCellWeightArray[Entry] *= InvWeightSum;
 		}
-		
-	}
-	UE_LOG(LogTemp, Log, TEXT("Goods: %d, Bads: %d"), GoodCounter, BadCounter);
-	UE_LOG(LogTemp, Log, TEXT("Empty Cell Indices: %d"), EmptyCellIndices);
-	UE_LOG(LogTemp, Log, TEXT("Invalid Indices: %d"), InvalidIndices);
-	UE_LOG(LogTemp, Log, TEXT("Invalid Mapping Indices: %d"), InvalidMappingIndices);
-	return OutVertexColors;
+	});
+
+	this->VertexCellWeightMode = Mode;
+	this->bVertexCellWeightsDirty = false;
 }
 
 void UPT_SimulationComponent::BarycentricInterpolation(
@@ -555,45 +839,111 @@ void UPT_SimulationComponent::BarycentricInterpolation(
 	check(FMath::IsNearlyEqual(WeightSum, 1.0, KINDA_SMALL_NUMBER));
 
 	// Daten fr Elektroden A, B und C
-	TArray<double> SimulationMagnitudeDataArrayA, SimulationMagnitudeDataArrayB, SimulationMagnitudeDataArrayC;
-	TArray<FVector> SimulationVectorfieldDataArrayA, SimulationVectorfieldDataArrayB, SimulationVectorfieldDataArrayC;
+	const int32 ElectrodeIndices[3] = { InElectrodeIndexA, InElectrodeIndexB, InElectrodeIndexC };
+	const double Weights[3] = { InWeightA, InWeightB, InWeightC };
+
+	this->BlendEnsemblePerTag(InDataTagIndex, ElectrodeIndices, Weights, 3, OutInterpolatedSimulationMagnitudeDataArray, OutInterpolatedSimulationVectorfieldDataArray, OutMeanMagnitude, OutMeanVectorField);
+}
 
+void UPT_SimulationComponent::BlendEnsemblePerTag(
+	const int32& InDataTagIndex,
+	const int32* InElectrodeIndices,
+	const double* InWeights,
+	const int32 InNum,
+	TArray<double>& OutMagnitudeDataArray,
+	TArray<FVector>& OutVectorfieldDataArray,
+	double& OutMeanMagnitude,
+	FVector& OutMeanVectorField,
+	const bool bInMagnitudeFromVector
+)
+{
+	OutMeanMagnitude = 0.0;
+	OutMeanVectorField = FVector::ZeroVector;
+
+	if (!this->EnsemblePerTagArray.IsValidIndex(InDataTagIndex) || !this->RoiIndexMappingPerTagArray.IsValidIndex(InDataTagIndex))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::BlendEnsemblePerTag] No simulation data for tag index %d."), InDataTagIndex);
+		return;
+	}
 
-	this->GetSimulationDataPerElectrodePerTag(InElectrodeIndexA, InDataTagIndex, SimulationMagnitudeDataArrayA, SimulationVectorfieldDataArrayA);
-	this->GetSimulationDataPerElectrodePerTag(InElectrodeIndexB, InDataTagIndex, SimulationMagnitudeDataArrayB, SimulationVectorfieldDataArrayB);
-	this->GetSimulationDataPerElectrodePerTag(InElectrodeIndexC, InDataTagIndex, SimulationMagnitudeDataArrayC, SimulationVectorfieldDataArrayC);
+	const FPT_TagEnsemble& Ensemble = this->EnsemblePerTagArray[InDataTagIndex];
+	const TArray<int32>& RoiIndexMapping = this->RoiIndexMappingPerTagArray[InDataTagIndex];
+	const int32 NumCells = Ensemble.GetNumCells();
 
-	// Prfung der Datenlngen
-	check(SimulationMagnitudeDataArrayA.Num() == SimulationMagnitudeDataArrayB.Num() && SimulationMagnitudeDataArrayB.Num() == SimulationMagnitudeDataArrayC.Num());
-	check(SimulationVectorfieldDataArrayA.Num() == SimulationVectorfieldDataArrayB.Num() && SimulationVectorfieldDataArrayB.Num() == SimulationVectorfieldDataArrayC.Num());
-	check(SimulationMagnitudeDataArrayA.Num() == SimulationVectorfieldDataArrayA.Num());
+	// Blend on the ROI cells only, the ensemble stores them in the order of the ROI index mapping
+	this->BlendScratchArray.SetNumUninitialized(FPT_TagEnsemble::NumChannels * NumCells, false);
+	const int32 FirstChannel = bInMagnitudeFromVector ? FPT_TagEnsemble::VectorChannel : FPT_TagEnsemble::MagnitudeChannel;
+	Ensemble.Blend(InElectrodeIndices, InWeights, InNum, this->BlendScratchArray.GetData(), FirstChannel);
 
-	// Initialisierung des Ausgabearrays
-	OutInterpolatedSimulationMagnitudeDataArray.SetNumZeroed(SimulationMagnitudeDataArrayA.Num());
-	OutInterpolatedSimulationVectorfieldDataArray.SetNumZeroed(SimulationMagnitudeDataArrayA.Num());
+	OutMagnitudeDataArray.SetNumZeroed(this->TagLengthArray[InDataTagIndex]);
+	OutVectorfieldDataArray.SetNumZeroed(this->TagLengthArray[InDataTagIndex]);
 
-	for(const int32 CurrentCellIndex : this->RoiIndexMappingPerTagArray[InDataTagIndex])
+	// Thresholded volumes are accumulated in the same pass, all thresholds at once
+	const int32 NumTags = this->EnsemblePerTagArray.Num();
+	if (this->VolumeMetrics.ThresholdArray != this->VolumeThresholdArray || this->VolumeMetrics.NumTags != NumTags)
 	{
-		OutInterpolatedSimulationMagnitudeDataArray[CurrentCellIndex] = InWeightA * SimulationMagnitudeDataArrayA[CurrentCellIndex] + InWeightB * SimulationMagnitudeDataArrayB[CurrentCellIndex] + InWeightC * SimulationMagnitudeDataArrayC[CurrentCellIndex];
-		OutInterpolatedSimulationVectorfieldDataArray[CurrentCellIndex] = InWeightA * SimulationVectorfieldDataArrayA[CurrentCellIndex] + InWeightB * SimulationVectorfieldDataArrayB[CurrentCellIndex] + InWeightC * SimulationVectorfieldDataArrayC[CurrentCellIndex];
+		this->VolumeMetrics = FPT_VolumeMetrics();
+		this->VolumeMetrics.ThresholdArray = this->VolumeThresholdArray;
+		this->VolumeMetrics.NumTags = NumTags;
+		this->VolumeMetrics.RoiVolumePerTagArray.SetNumZeroed(NumTags);
+		this->VolumeMetrics.VolumeAboveThresholdPerTagArray.SetNumZeroed(NumTags * this->VolumeThresholdArray.Num());
+	}
 
-		OutMeanMagnitude += OutInterpolatedSimulationMagnitudeDataArray[CurrentCellIndex];
-		OutMeanVectorField += OutInterpolatedSimulationVectorfieldDataArray[CurrentCellIndex];
+	const int32 NumThresholds = this->VolumeMetrics.ThresholdArray.Num();
+	const double* Thresholds = this->VolumeMetrics.ThresholdArray.GetData();
+	TArray<double, TInlineAllocator<InlineVolumeThresholds>> VolumeAboveArray;
+	VolumeAboveArray.SetNumZeroed(NumThresholds);
+	double* VolumeAbove = VolumeAboveArray.GetData();
+	const float* CellVolumes = this->RoiCellVolumePerTagArray.IsValidIndex(InDataTagIndex) && this->RoiCellVolumePerTagArray[InDataTagIndex].Num() == NumCells ? this->RoiCellVolumePerTagArray[InDataTagIndex].GetData() : nullptr;
+	double RoiVolume = 0.0;
+
+	double* Magnitude = this->BlendScratchArray.GetData() + FPT_TagEnsemble::MagnitudeChannel * NumCells;
+	const double* VectorX = this->BlendScratchArray.GetData() + FPT_TagEnsemble::VectorChannel * NumCells;
+	const double* VectorY = VectorX + NumCells;
+	const double* VectorZ = VectorY + NumCells;
+
+	// The magnitude of a sum of fields is the length of the summed vector, not the sum of the magnitudes
+	if (bInMagnitudeFromVector)
+	{
+		for (int32 CurrentIndex = 0; CurrentIndex < NumCells; CurrentIndex++)
+		{
+			Magnitude[CurrentIndex] = FMath::Sqrt(VectorX[CurrentIndex] * VectorX[CurrentIndex] + VectorY[CurrentIndex] * VectorY[CurrentIndex] + VectorZ[CurrentIndex] * VectorZ[CurrentIndex]);
+		}
 	}
 
-	const double InvMeanCounter = 1.0 / this->RoiIndexMappingPerTagArray[InDataTagIndex].Num();
+	for (int32 CurrentIndex = 0; CurrentIndex < NumCells; CurrentIndex++)
+	{
+		const int32 CurrentCellIndex = RoiIndexMapping[CurrentIndex];
+		if (!OutMagnitudeDataArray.IsValidIndex(CurrentCellIndex))
+		{
+			continue;
+		}
+
+		OutMagnitudeDataArray[CurrentCellIndex] = Magnitude[CurrentIndex];
+		OutVectorfieldDataArray[CurrentCellIndex] = FVector(VectorX[CurrentIndex], VectorY[CurrentIndex], VectorZ[CurrentIndex]);
 
+		OutMeanMagnitude += OutMagnitudeDataArray[CurrentCellIndex];
+		OutMeanVectorField += OutVectorfieldDataArray[CurrentCellIndex];
+
+		const double CellVolume = CellVolumes ? CellVolumes[CurrentIndex] : 1.0;
+		RoiVolume += CellVolume;
+		for (int32 k = 0; k < NumThresholds; k++)
+		{
+			VolumeAbove[k] += Magnitude[CurrentIndex] > Thresholds[k] ? CellVolume : 0.0;
+		}
+	}
 
-	if (InvMeanCounter > 0.0)
+	this->VolumeMetrics.RoiVolumePerTagArray[InDataTagIndex] = RoiVolume;
+	for (int32 k = 0; k < NumThresholds; k++)
 	{
-		OutMeanMagnitude *= InvMeanCounter;
-		OutMeanVectorField *= InvMeanCounter;
-		return;
+		this->VolumeMetrics.VolumeAboveThresholdPerTagArray[InDataTagIndex * this->VolumeMetrics.ThresholdArray.Num() + k] = VolumeAbove[k];
 	}
 
-	OutMeanMagnitude = 0.0;
-	OutMeanVectorField = FVector::ZeroVector;
-	return;
+	if (NumCells > 0)
+	{
+		OutMeanMagnitude /= NumCells;
+		OutMeanVectorField /= NumCells;
+	}
 }
 
 void UPT_SimulationComponent::ProcessInterpolation(const int32& InElectrodeIndexA, const int32& InElectrodeIndexB, const int32& InElectrodeIndexC, const double& InWeightA, const double& InWeightB, const double& InWeightC)
@@ -604,72 +954,670 @@ void UPT_SimulationComponent::ProcessInterpolation(const int32& InElectrodeIndex
 	}
 }
 
-double UPT_SimulationComponent::CalculatePercentile(const TArray<double>& InData, const double& InPercentile)
+void UPT_SimulationComponent::ProcessWeightedInterpolation(const TArray<int32>& InElectrodeIndexArray, const TArray<double>& InWeightArray)
 {
-	if (InData.Num() == 0)
+	if (InElectrodeIndexArray.Num() != InWeightArray.Num() || InElectrodeIndexArray.IsEmpty())
 	{
-		return 0.0f; // Rckgabe von 0, wenn Daten leer sind
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessWeightedInterpolation] Got %d electrodes but %d weights!"), InElectrodeIndexArray.Num(), InWeightArray.Num());
+		return;
 	}
 
-	TArray<double> SortedData = InData;
-	SortedData.Sort(); // Sortieren der Daten
-
-	double Index = (InPercentile / 100.0f) * (SortedData.Num() - 1);
-	int32 LowerIndex = FMath::FloorToInt(Index);
-	int32 UpperIndex = FMath::CeilToInt(Index);
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < UPT_ConfigManager::GetDataTagIndexArray().Num(); CurrentTagIndex++)
+	{
+		this->BlendEnsemblePerTag(UPT_ConfigManager::GetDataTagIndexArray()[CurrentTagIndex], InElectrodeIndexArray.GetData(), InWeightArray.GetData(), InElectrodeIndexArray.Num(), this->InterpolatedMagnitudeDataPerTagArray[CurrentTagIndex], this->InterpolatedVectorfieldDataPerTagArray[CurrentTagIndex], this->MeanMagnitudePerTag[CurrentTagIndex], this->MeanVectorFieldPerTag[CurrentTagIndex]);
+	}
+}
 
-	if (LowerIndex == UpperIndex)
+void UPT_SimulationComponent::ProcessSuperposition(const TArray<int32>& InElectrodeIndexArray, const TArray<double>& InAmplitudeArray)
+{
+	if (InElectrodeIndexArray.Num() != InAmplitudeArray.Num())
 	{
-		return SortedData[LowerIndex]; // Rckgabe des Werts, wenn Index ganzzahlig ist
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessSuperposition] Got %d electrodes but %d amplitudes!"), InElectrodeIndexArray.Num(), InAmplitudeArray.Num());
+		return;
 	}
-	else
+
+	this->SuperpositionElectrodeIndexArray = InElectrodeIndexArray;
+	this->SuperpositionAmplitudeArray = InAmplitudeArray;
+	this->EvaluateSuperposition();
+}
+
+void UPT_SimulationComponent::SetSuperpositionChannelAmplitude(const int32& InChannelIndex, const double& InAmplitude)
+{
+	if (!this->SuperpositionAmplitudeArray.IsValidIndex(InChannelIndex))
 	{
-		// Interpolation zwischen den beiden Indizes
-		double LowerValue = SortedData[LowerIndex];
-		double UpperValue = SortedData[UpperIndex];
-		double InterpolatedValue = LowerValue + (UpperValue - LowerValue) * (Index - LowerIndex);
-		return InterpolatedValue;
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::SetSuperpositionChannelAmplitude] Invalid channel index %d!"), InChannelIndex);
+		return;
 	}
+
+	this->SuperpositionAmplitudeArray[InChannelIndex] = InAmplitude;
+	this->EvaluateSuperposition();
 }
 
-double UPT_SimulationComponent::CalculatePercentileForInterpolatedMagnitudeDataPerTagArray(const double& InPercentile)
+void UPT_SimulationComponent::EvaluateSuperposition()
 {
-	TArray<double> SortedData;
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < UPT_ConfigManager::GetDataTagIndexArray().Num(); CurrentTagIndex++)
+	{
+		this->BlendEnsemblePerTag(UPT_ConfigManager::GetDataTagIndexArray()[CurrentTagIndex], this->SuperpositionElectrodeIndexArray.GetData(), this->SuperpositionAmplitudeArray.GetData(), this->SuperpositionElectrodeIndexArray.Num(), this->InterpolatedMagnitudeDataPerTagArray[CurrentTagIndex], this->InterpolatedVectorfieldDataPerTagArray[CurrentTagIndex], this->MeanMagnitudePerTag[CurrentTagIndex], this->MeanVectorFieldPerTag[CurrentTagIndex], true);
+	}
+}
 
-	if (this->InterpolatedMagnitudeDataPerTagArray.Num() == 0)
+void UPT_SimulationComponent::SetResultSlot(const int32& InSlotIndex, const TArray<int32>& InElectrodeIndexArray, const TArray<double>& InWeightArray, const bool& bInIsSuperposition)
+{
+	if (InSlotIndex < 0 || InSlotIndex >= (int32)UE_ARRAY_COUNT(this->ResultSlotArray) || InElectrodeIndexArray.Num() != InWeightArray.Num() || InElectrodeIndexArray.IsEmpty())
 	{
-		return 0.0f; // Rckgabe von 0, wenn Daten leer sind
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::SetResultSlot] Invalid slot %d or got %d electrodes but %d weights!"), InSlotIndex, InElectrodeIndexArray.Num(), InWeightArray.Num());
+		return;
 	}
 
-	auto IsAllZeros = [](const TArray<double>& DataArray) -> bool{
-		for (double Value : DataArray) {
-			if (Value != 0.0) {
-				return false;
-			}
-		}
-		return true;
-	};
+	FResultSlot& Slot = this->ResultSlotArray[InSlotIndex];
+	Slot = FResultSlot();
+	Slot.bIsSet = true;
+	Slot.bIsSuperposition = bInIsSuperposition;
+	Slot.ElectrodeIndexArray = InElectrodeIndexArray;
+	Slot.WeightArray = InWeightArray;
+}
 
-	for(int32 CurrentTagIndex : UPT_ConfigManager::GetDataTagVolumeIndexArray())
+void UPT_SimulationComponent::CaptureResultSlot(const int32& InSlotIndex)
+{
+	if (InSlotIndex < 0 || InSlotIndex >= (int32)UE_ARRAY_COUNT(this->ResultSlotArray) || this->EnsemblePerTagArray.IsEmpty())
 	{
-		TArray<double> CurrentMagnitudeDataArray = this->InterpolatedMagnitudeDataPerTagArray[CurrentTagIndex];
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::CaptureResultSlot] Invalid slot %d or no simulation data loaded!"), InSlotIndex);
+		return;
+	}
 
-		// Skip arrays that are empty or contain only zeros
-		if(CurrentMagnitudeDataArray.Num() == 0 || IsAllZeros(CurrentMagnitudeDataArray))
-		{
-			continue;
-		}
+	FResultSlot& Slot = this->ResultSlotArray[InSlotIndex];
+	Slot = FResultSlot();
+	Slot.bIsSet = true;
+	Slot.bIsCaptured = true;
+	Slot.RoiIndexMappingPerTagArray = this->RoiIndexMappingPerTagArray;
+	Slot.TagLengthArray = this->TagLengthArray;
+	Slot.ChannelDataPerTagArray.SetNum(this->RoiIndexMappingPerTagArray.Num());
 
-		for(int32 CurrentCellIndex : this->RoiIndexMappingPerTagArray[CurrentTagIndex])
+	// Gather the ROI cells of the interpolated data into the compact channel layout of the ensembles
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < this->RoiIndexMappingPerTagArray.Num(); CurrentTagIndex++)
+	{
+		const TArray<int32>& RoiIndexMapping = this->RoiIndexMappingPerTagArray[CurrentTagIndex];
+		const TArray<double>& MagnitudeArray = this->InterpolatedMagnitudeDataPerTagArray[CurrentTagIndex];
+		const TArray<FVector>& VectorfieldArray = this->InterpolatedVectorfieldDataPerTagArray[CurrentTagIndex];
+		const int32 NumCells = RoiIndexMapping.Num();
+
+		TArray<double>& ChannelData = Slot.ChannelDataPerTagArray[CurrentTagIndex];
+		ChannelData.SetNumZeroed(FPT_TagEnsemble::NumChannels * NumCells);
+		for (int32 CurrentIndex = 0; CurrentIndex < NumCells; CurrentIndex++)
 		{
-			if (CurrentMagnitudeDataArray[CurrentCellIndex] != 0.0) {
-				SortedData.Add(CurrentMagnitudeDataArray[CurrentCellIndex]);
+			const int32 CurrentCellIndex = RoiIndexMapping[CurrentIndex];
+			if (!MagnitudeArray.IsValidIndex(CurrentCellIndex) || !VectorfieldArray.IsValidIndex(CurrentCellIndex))
+			{
+				continue;
 			}
+
+			ChannelData[FPT_TagEnsemble::MagnitudeChannel * NumCells + CurrentIndex] = MagnitudeArray[CurrentCellIndex];
+			ChannelData[FPT_TagEnsemble::VectorChannel * NumCells + CurrentIndex] = VectorfieldArray[CurrentCellIndex].X;
+			ChannelData[(FPT_TagEnsemble::VectorChannel + 1) * NumCells + CurrentIndex] = VectorfieldArray[CurrentCellIndex].Y;
+			ChannelData[(FPT_TagEnsemble::VectorChannel + 2) * NumCells + CurrentIndex] = VectorfieldArray[CurrentCellIndex].Z;
 		}
 	}
+}
 
-	if (SortedData.Num() == 0) {
-		return 0.0f; // Return 0 if no valid data was added
+void UPT_SimulationComponent::ClearResultSlots()
+{
+	for (FResultSlot& Slot : this->ResultSlotArray)
+	{
+		Slot = FResultSlot();
+	}
+	this->DifferenceMagnitudeDataPerTagArray.Empty();
+	this->DifferenceVectorfieldDataPerTagArray.Empty();
+	this->DifferenceRoiIndexMappingPerTagArray.Empty();
+	this->DifferenceReport = FPT_DifferenceReport();
+}
+
+const double* UPT_SimulationComponent::EvaluateResultSlot(const FResultSlot& InSlot, const int32 InTagIndex, TArray<double>& InScratchArray) const
+{
+	if (InSlot.bIsCaptured)
+	{
+		return InSlot.ChannelDataPerTagArray.IsValidIndex(InTagIndex) ? InSlot.ChannelDataPerTagArray[InTagIndex].GetData() : nullptr;
+	}
+
+	if (!this->EnsemblePerTagArray.IsValidIndex(InTagIndex))
+	{
+		return nullptr;
+	}
+
+	const FPT_TagEnsemble& Ensemble = this->EnsemblePerTagArray[InTagIndex];
+	const int32 NumCells = Ensemble.GetNumCells();
+	InScratchArray.SetNumUninitialized(FPT_TagEnsemble::NumChannels * NumCells, false);
+	const int32 FirstChannel = InSlot.bIsSuperposition ? FPT_TagEnsemble::VectorChannel : FPT_TagEnsemble::MagnitudeChannel;
+	Ensemble.Blend(InSlot.ElectrodeIndexArray.GetData(), InSlot.WeightArray.GetData(), InSlot.ElectrodeIndexArray.Num(), InScratchArray.GetData(), FirstChannel);
+
+	if (InSlot.bIsSuperposition)
+	{
+		double* Magnitude = InScratchArray.GetData() + FPT_TagEnsemble::MagnitudeChannel * NumCells;
+		const double* VectorX = InScratchArray.GetData() + FPT_TagEnsemble::VectorChannel * NumCells;
+		const double* VectorY = VectorX + NumCells;
+		const double* VectorZ = VectorY + NumCells;
+		for (int32 CurrentIndex = 0; CurrentIndex < NumCells; CurrentIndex++)
+		{
+			Magnitude[CurrentIndex] = FMath::Sqrt(VectorX[CurrentIndex] * VectorX[CurrentIndex] + VectorY[CurrentIndex] * VectorY[CurrentIndex] + VectorZ[CurrentIndex] * VectorZ[CurrentIndex]);
+		}
+	}
+	return InScratchArray.GetData();
+}
+
+FPT_DifferenceReport UPT_SimulationComponent::ProcessDifference()
+{
+	this->DifferenceReport = FPT_DifferenceReport();
+	const FResultSlot& SlotA = this->ResultSlotArray[0];
+	const FResultSlot& SlotB = this->ResultSlotArray[1];
+	if (!SlotA.bIsSet || !SlotB.bIsSet)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessDifference] Both result slots have to be set!"));
+		return this->DifferenceReport;
+	}
+
+	// The loaded data defines the ROI cells, without it both slots have to be captured
+	const bool bHasLoadedData = !this->EnsemblePerTagArray.IsEmpty();
+	if (!bHasLoadedData && (!SlotA.bIsCaptured || !SlotB.bIsCaptured))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessDifference] Blend slots need loaded simulation data!"));
+		return this->DifferenceReport;
+	}
+
+	const TArray<TArray<int32>>& RoiIndexMappingArray = bHasLoadedData ? this->RoiIndexMappingPerTagArray : SlotA.RoiIndexMappingPerTagArray;
+	const TArray<int32>& TagLengths = bHasLoadedData ? this->TagLengthArray : SlotA.TagLengthArray;
+	for (const FResultSlot* Slot : { &SlotA, &SlotB })
+	{
+		if (Slot->bIsCaptured && Slot->RoiIndexMappingPerTagArray != RoiIndexMappingArray)
+		{
+			UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessDifference] A captured slot covers different ROI cells than the compared data!"));
+			return this->DifferenceReport;
+		}
+	}
+
+	// Two linear blends are one blend with the weights of B negated
+	const bool bIsMerged = !SlotA.bIsCaptured && !SlotB.bIsCaptured && !SlotA.bIsSuperposition && !SlotB.bIsSuperposition;
+	FResultSlot MergedSlot;
+	if (bIsMerged)
+	{
+		MergedSlot.ElectrodeIndexArray = SlotA.ElectrodeIndexArray;
+		MergedSlot.ElectrodeIndexArray.Append(SlotB.ElectrodeIndexArray);
+		MergedSlot.WeightArray = SlotA.WeightArray;
+		for (const double Weight : SlotB.WeightArray)
+		{
+			MergedSlot.WeightArray.Add(-Weight);
+		}
+	}
+
+	const int32 NumTags = RoiIndexMappingArray.Num();
+	FPT_DifferenceReport Report;
+	Report.MeanDifferencePerTagArray.SetNumZeroed(NumTags);
+	Report.MeanAbsoluteDifferencePerTagArray.SetNumZeroed(NumTags);
+	Report.RmsDifferencePerTagArray.SetNumZeroed(NumTags);
+	Report.MinDifferencePerTagArray.SetNumZeroed(NumTags);
+	Report.MaxDifferencePerTagArray.SetNumZeroed(NumTags);
+	Report.MeanVectorDifferencePerTagArray.SetNumZeroed(NumTags);
+	this->DifferenceMagnitudeDataPerTagArray.SetNum(NumTags);
+	this->DifferenceVectorfieldDataPerTagArray.SetNum(NumTags);
+	this->DifferenceRoiIndexMappingPerTagArray = RoiIndexMappingArray;
+
+	double Sum = 0.0;
+	double AbsoluteSum = 0.0;
+	double SquaredSum = 0.0;
+	double VectorSum = 0.0;
+	int32 NumIncreased = 0;
+	Report.MinDifference = TNumericLimits<double>::Max();
+	Report.MaxDifference = TNumericLimits<double>::Lowest();
+
+	TArray<double> ScratchArrayB;
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < NumTags; CurrentTagIndex++)
+	{
+		const TArray<int32>& RoiIndexMapping = RoiIndexMappingArray[CurrentTagIndex];
+		const int32 NumCells = RoiIndexMapping.Num();
+		TArray<double>& MagnitudeDifferenceArray = this->DifferenceMagnitudeDataPerTagArray[CurrentTagIndex];
+		TArray<FVector>& VectorfieldDifferenceArray = this->DifferenceVectorfieldDataPerTagArray[CurrentTagIndex];
+		MagnitudeDifferenceArray.Init(0.0, TagLengths.IsValidIndex(CurrentTagIndex) ? TagLengths[CurrentTagIndex] : 0);
+		VectorfieldDifferenceArray.Init(FVector::ZeroVector, MagnitudeDifferenceArray.Num());
+		if (NumCells == 0)
+		{
+			continue;
+		}
+
+		const double* ChannelsA = nullptr;
+		const double* ChannelsB = nullptr;
+		if (bIsMerged)
+		{
+			ChannelsA = this->EvaluateResultSlot(MergedSlot, CurrentTagIndex, this->BlendScratchArray);
+		}
+		else
+		{
+			ChannelsA = this->EvaluateResultSlot(SlotA, CurrentTagIndex, this->BlendScratchArray);
+			ChannelsB = this->EvaluateResultSlot(SlotB, CurrentTagIndex, ScratchArrayB);
+		}
+
+		const bool bCellsMatch = !bHasLoadedData || (this->EnsemblePerTagArray.IsValidIndex(CurrentTagIndex) && this->EnsemblePerTagArray[CurrentTagIndex].GetNumCells() == NumCells);
+		if (!ChannelsA || (!bIsMerged && !ChannelsB) || !bCellsMatch)
+		{
+			UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessDifference] No data for tag %d in one of the slots!"), CurrentTagIndex);
+			this->DifferenceReport = FPT_DifferenceReport();
+			return this->DifferenceReport;
+		}
+
+		// A merged blend already is the difference, B then reads A with a zero factor to keep the loop branch free
+		const double FactorB = ChannelsB ? 1.0 : 0.0;
+		if (!ChannelsB)
+		{
+			ChannelsB = ChannelsA;
+		}
+
+		const double* MagnitudeA = ChannelsA + FPT_TagEnsemble::MagnitudeChannel * NumCells;
+		const double* VectorA = ChannelsA + FPT_TagEnsemble::VectorChannel * NumCells;
+		const double* MagnitudeB = ChannelsB + FPT_TagEnsemble::MagnitudeChannel * NumCells;
+		const double* VectorB = ChannelsB + FPT_TagEnsemble::VectorChannel * NumCells;
+
+		double TagSum = 0.0;
+		double TagAbsoluteSum = 0.0;
+		double TagSquaredSum = 0.0;
+		double TagVectorSum = 0.0;
+		double TagMin = TNumericLimits<double>::Max();
+		double TagMax = TNumericLimits<double>::Lowest();
+		for (int32 CurrentIndex = 0; CurrentIndex < NumCells; CurrentIndex++)
+		{
+			const double MagnitudeDifference = MagnitudeA[CurrentIndex] - FactorB * MagnitudeB[CurrentIndex];
+			const FVector VectorDifference(
+				VectorA[CurrentIndex] - FactorB * VectorB[CurrentIndex],
+				VectorA[NumCells + CurrentIndex] - FactorB * VectorB[NumCells + CurrentIndex],
+				VectorA[2 * NumCells + CurrentIndex] - FactorB * VectorB[2 * NumCells + CurrentIndex]);
+
+			TagSum += MagnitudeDifference;
+			TagAbsoluteSum += FMath::Abs(MagnitudeDifference);
+			TagSquaredSum += MagnitudeDifference * MagnitudeDifference;
+			TagVectorSum += VectorDifference.Size();
+			TagMin = FMath::Min(TagMin, MagnitudeDifference);
+			TagMax = FMath::Max(TagMax, MagnitudeDifference);
+			NumIncreased += MagnitudeDifference > 0.0 ? 1 : 0;
+
+			const int32 CurrentCellIndex = RoiIndexMapping[CurrentIndex];
+			if (MagnitudeDifferenceArray.IsValidIndex(CurrentCellIndex))
+			{
+				MagnitudeDifferenceArray[CurrentCellIndex] = MagnitudeDifference;
+				VectorfieldDifferenceArray[CurrentCellIndex] = VectorDifference;
+			}
+		}
+
+		Report.MeanDifferencePerTagArray[CurrentTagIndex] = TagSum / NumCells;
+		Report.MeanAbsoluteDifferencePerTagArray[CurrentTagIndex] = TagAbsoluteSum / NumCells;
+		Report.RmsDifferencePerTagArray[CurrentTagIndex] = FMath::Sqrt(TagSquaredSum / NumCells);
+		Report.MinDifferencePerTagArray[CurrentTagIndex] = TagMin;
+		Report.MaxDifferencePerTagArray[CurrentTagIndex] = TagMax;
+		Report.MeanVectorDifferencePerTagArray[CurrentTagIndex] = TagVectorSum / NumCells;
+
+		Sum += TagSum;
+		AbsoluteSum += TagAbsoluteSum;
+		SquaredSum += TagSquaredSum;
+		VectorSum += TagVectorSum;
+		Report.MinDifference = FMath::Min(Report.MinDifference, TagMin);
+		Report.MaxDifference = FMath::Max(Report.MaxDifference, TagMax);
+		Report.NumCells += NumCells;
+	}
+
+	if (Report.NumCells == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessDifference] No ROI cells to compare!"));
+		return this->DifferenceReport;
+	}
+
+	Report.bIsValid = true;
+	Report.MeanDifference = Sum / Report.NumCells;
+	Report.MeanAbsoluteDifference = AbsoluteSum / Report.NumCells;
+	Report.RmsDifference = FMath::Sqrt(SquaredSum / Report.NumCells);
+	Report.MeanVectorDifference = VectorSum / Report.NumCells;
+	Report.FractionIncreased = (double)NumIncreased / Report.NumCells;
+	this->DifferenceReport = Report;
+
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::ProcessDifference] %d Cells, Mean %f, Mean Absolute %f, Min %f, Max %f, Merged Blend: %d"), Report.NumCells, Report.MeanDifference, Report.MeanAbsoluteDifference, Report.MinDifference, Report.MaxDifference, bIsMerged);
+	return this->DifferenceReport;
+}
+
+void UPT_SimulationComponent::GetDifferenceDataPerTag(const int32& InTagIndex, TArray<double>& OutMagnitudeDifferenceArray, TArray<FVector>& OutVectorfieldDifferenceArray)
+{
+	if (!this->DifferenceMagnitudeDataPerTagArray.IsValidIndex(InTagIndex))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::GetDifferenceDataPerTag] No difference data for tag index %d."), InTagIndex);
+		OutMagnitudeDifferenceArray.Empty();
+		OutVectorfieldDifferenceArray.Empty();
+		return;
+	}
+
+	OutMagnitudeDifferenceArray = this->DifferenceMagnitudeDataPerTagArray[InTagIndex];
+	OutVectorfieldDifferenceArray = this->DifferenceVectorfieldDataPerTagArray[InTagIndex];
+}
+
+TArray<FLinearColor> UPT_SimulationComponent::MapDifferenceToDivergingColormap(const int32& InTagIndex, const double& InMaxAbsoluteValue)
+{
+	TArray<FLinearColor> OutputColormap;
+	if (!this->DifferenceReport.bIsValid || !this->DifferenceMagnitudeDataPerTagArray.IsValidIndex(InTagIndex))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::MapDifferenceToDivergingColormap] No difference data for tag index %d."), InTagIndex);
+		return OutputColormap;
+	}
+
+	const TArray<double>& MagnitudeDifferenceArray = this->DifferenceMagnitudeDataPerTagArray[InTagIndex];
+	OutputColormap.Init(FLinearColor::Black, MagnitudeDifferenceArray.Num());
+
+	// The colormap is symmetric around zero, so equal increases and decreases get equally saturated colors
+	double MaxAbsoluteValue = InMaxAbsoluteValue;
+	if (MaxAbsoluteValue <= 0.0)
+	{
+		MaxAbsoluteValue = FMath::Max(FMath::Abs(this->DifferenceReport.MinDifferencePerTagArray[InTagIndex]), FMath::Abs(this->DifferenceReport.MaxDifferencePerTagArray[InTagIndex]));
+	}
+	const double InvMaxAbsoluteValue = MaxAbsoluteValue > UE_SMALL_NUMBER ? 1.0 / MaxAbsoluteValue : 0.0;
+
+	for (const int32 CurrentCellIndex : this->DifferenceRoiIndexMappingPerTagArray[InTagIndex])
+	{
+		if (OutputColormap.IsValidIndex(CurrentCellIndex))
+		{
+			OutputColormap[CurrentCellIndex] = SampleDivergingColormap(MagnitudeDifferenceArray[CurrentCellIndex] * InvMaxAbsoluteValue);
+		}
+	}
+	return OutputColormap;
+}
+
+FPT_LeaveOneOutReport UPT_SimulationComponent::RunLeaveOneOutAnalysis(const APT_ElectrodeAreaActor* InElectrodeAreaActor)
+{
+	this->LeaveOneOutReport = FPT_LeaveOneOutReport();
+
+	if (!InElectrodeAreaActor || !InElectrodeAreaActor->GetInterpolator().IsBuilt() || this->EnsemblePerTagArray.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::RunLeaveOneOutAnalysis] Interpolator not built or no simulation data loaded!"));
+		return this->LeaveOneOutReport;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const FPT_ElectrodeInterpolator& Interpolator = InElectrodeAreaActor->GetInterpolator();
+	const EInterpolationMode Mode = InElectrodeAreaActor->InterpolationMode;
+	const int32 NumElectrodes = Interpolator.GetNumElectrodes();
+	const int32 NumTags = this->EnsemblePerTagArray.Num();
+	constexpr int32 MaxWeights = FPT_ElectrodeInterpolator::MaxNeighborCount;
+
+	// Prediction weights of every electrode from all remaining electrodes
+	TArray<int32> WeightElectrodeIndexArray;
+	WeightElectrodeIndexArray.SetNumZeroed(NumElectrodes * MaxWeights);
+	TArray<double> WeightArray;
+	WeightArray.SetNumZeroed(NumElectrodes * MaxWeights);
+	TArray<int32> NumWeightArray;
+	NumWeightArray.SetNumZeroed(NumElectrodes);
+	TArray<bool> FallbackArray;
+	FallbackArray.SetNumZeroed(NumElectrodes);
+
+	ParallelFor(NumElectrodes, [&](const int32 Slot)
+	{
+		// The removed lattice node has no corner weight at its own position, it is predicted from the lattice around it
+		if (Mode == EInterpolationMode::Bilinear && Interpolator.IsGridBuilt())
+		{
+			NumWeightArray[Slot] = Interpolator.CalculateBilinearWeightsWithout(Slot, &WeightElectrodeIndexArray[Slot * MaxWeights], &WeightArray[Slot * MaxWeights]);
+			if (NumWeightArray[Slot] > 0)
+			{
+				return;
+			}
+			FallbackArray[Slot] = true;
+		}
+
+		FPT_ElectrodeInterpolator ReducedInterpolator;
+		ReducedInterpolator.BuildWithout(Interpolator, Interpolator.GetElectrodeIndex(Slot));
+		const EInterpolationMode SlotMode = FallbackArray[Slot] ? EInterpolationMode::InverseDistance : Mode;
+		NumWeightArray[Slot] = ReducedInterpolator.CalculateWeights(SlotMode, Interpolator.GetPosition(Slot), &WeightElectrodeIndexArray[Slot * MaxWeights], &WeightArray[Slot * MaxWeights]);
+	});
+
+	// Error sums per electrode and tag, every pair is an independent task
+	TArray<double> SquaredErrorSumArray;
+	SquaredErrorSumArray.SetNumZeroed(NumElectrodes * NumTags);
+	TArray<double> SquaredMagnitudeSumArray;
+	SquaredMagnitudeSumArray.SetNumZeroed(NumElectrodes * NumTags);
+	TArray<double> MaxErrorArray;
+	MaxErrorArray.SetNumZeroed(NumElectrodes * NumTags);
+
+	ParallelFor(NumElectrodes * NumTags, [&](const int32 TaskIndex)
+	{
+		const int32 Slot = TaskIndex / NumTags;
+		const int32 CurrentTagIndex = TaskIndex % NumTags;
+		const FPT_TagEnsemble& Ensemble = this->EnsemblePerTagArray[CurrentTagIndex];
+		const int32 NumCells = Ensemble.GetNumCells();
+
+		if (NumCells == 0)
+		{
+			return;
+		}
+
+		// Only the magnitude channel (channel 0) is evaluated, so a single channel of storage is enough
+		TArray<double> SimulatedMagnitude;
+		SimulatedMagnitude.SetNumUninitialized(NumCells);
+		TArray<double> PredictedMagnitude;
+		PredictedMagnitude.SetNumUninitialized(NumCells);
+
+		const int32 ElectrodeIndex = Interpolator.GetElectrodeIndex(Slot);
+		const double UnitWeight = 1.0;
+		Ensemble.Blend(&ElectrodeIndex, &UnitWeight, 1, SimulatedMagnitude.GetData(), FPT_TagEnsemble::MagnitudeChannel, FPT_TagEnsemble::MagnitudeChannel);
+		Ensemble.Blend(&WeightElectrodeIndexArray[Slot * MaxWeights], &WeightArray[Slot * MaxWeights], NumWeightArray[Slot], PredictedMagnitude.GetData(), FPT_TagEnsemble::MagnitudeChannel, FPT_TagEnsemble::MagnitudeChannel);
+
+		double SquaredErrorSum = 0.0;
+		double SquaredMagnitudeSum = 0.0;
+		double MaxError = 0.0;
+		for (int32 CurrentCellIndex = 0; CurrentCellIndex < NumCells; CurrentCellIndex++)
+		{
+			const double Error = PredictedMagnitude[CurrentCellIndex] - SimulatedMagnitude[CurrentCellIndex];
+			SquaredErrorSum += Error * Error;
+			SquaredMagnitudeSum += SimulatedMagnitude[CurrentCellIndex] * SimulatedMagnitude[CurrentCellIndex];
+			MaxError = FMath::Max(MaxError, FMath::Abs(Error));
+		}
+
+		SquaredErrorSumArray[TaskIndex] = SquaredErrorSum;
+		SquaredMagnitudeSumArray[TaskIndex] = SquaredMagnitudeSum;
+		MaxErrorArray[TaskIndex] = MaxError;
+	});
+
+	FPT_LeaveOneOutReport& Report = this->LeaveOneOutReport;
+	Report.NumTags = NumTags;
+	Report.RmsErrorPerTagArray.SetNumZeroed(NumElectrodes * NumTags);
+	Report.MaxErrorPerTagArray = MaxErrorArray;
+	Report.FallbackArray = FallbackArray;
+	Report.InterpolationMode = Mode;
+	Report.InterpolatorVersion = InElectrodeAreaActor->GetInterpolatorVersion();
+	Report.NumFallbacks = Algo::Count(FallbackArray, true);
+
+	if (Report.NumFallbacks > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[UPT_SimulationComponent::RunLeaveOneOutAnalysis] %d electrodes have no lattice neighbors and were predicted with inverse distance weighting."), Report.NumFallbacks);
+	}
+
+	for (int32 Slot = 0; Slot < NumElectrodes; Slot++)
+	{
+		double SquaredErrorSum = 0.0;
+		double SquaredMagnitudeSum = 0.0;
+		double MaxError = 0.0;
+		int64 NumCells = 0;
+
+		for (int32 CurrentTagIndex = 0; CurrentTagIndex < NumTags; CurrentTagIndex++)
+		{
+			const int32 TaskIndex = Slot * NumTags + CurrentTagIndex;
+			const int32 NumTagCells = this->EnsemblePerTagArray[CurrentTagIndex].GetNumCells();
+			Report.RmsErrorPerTagArray[TaskIndex] = NumTagCells > 0 ? FMath::Sqrt(SquaredErrorSumArray[TaskIndex] / NumTagCells) : 0.0;
+
+			SquaredErrorSum += SquaredErrorSumArray[TaskIndex];
+			SquaredMagnitudeSum += SquaredMagnitudeSumArray[TaskIndex];
+			MaxError = FMath::Max(MaxError, MaxErrorArray[TaskIndex]);
+			NumCells += NumTagCells;
+		}
+
+		Report.ElectrodeIndexArray.Add(Interpolator.GetElectrodeIndex(Slot));
+		Report.ElectrodePositionArray.Add(Interpolator.GetPosition(Slot));
+		Report.RmsErrorArray.Add(NumCells > 0 ? FMath::Sqrt(SquaredErrorSum / NumCells) : 0.0);
+		Report.RelativeRmsErrorArray.Add(SquaredMagnitudeSum > 0.0 ? FMath::Sqrt(SquaredErrorSum / SquaredMagnitudeSum) : 0.0);
+		Report.MaxErrorArray.Add(MaxError);
+	}
+
+	if (Interpolator.IsGridBuilt())
+	{
+		Report.ErrorMapRows = Interpolator.GetGridRows();
+		Report.ErrorMapColumns = Interpolator.GetGridColumns();
+		Report.ErrorMap.Init(-1.0, Report.ErrorMapRows * Report.ErrorMapColumns);
+
+		for (int32 NodeIndex = 0; NodeIndex < Report.ErrorMap.Num(); NodeIndex++)
+		{
+			const int32 Slot = Interpolator.GetGridSlots()[NodeIndex];
+			if (Slot != INDEX_NONE)
+			{
+				Report.ErrorMap[NodeIndex] = Report.RelativeRmsErrorArray[Slot];
+			}
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::RunLeaveOneOutAnalysis] Evaluated %d electrodes and %d tags in %.3f s"), NumElectrodes, NumTags, FPlatformTime::Seconds() - StartTime);
+	return Report;
+}
+
+void UPT_SimulationComponent::CalculateElectrodeMeanMagnitudes(TArray<double>& OutMeanMagnitudeArray, int32& OutNumElectrodes, int32& OutNumTags) const
+{
+	OutNumTags = this->EnsemblePerTagArray.Num();
+	OutNumElectrodes = OutNumTags > 0 ? this->EnsemblePerTagArray[0].GetNumElectrodes() : 0;
+	OutMeanMagnitudeArray.SetNumZeroed(OutNumElectrodes * OutNumTags);
+
+	TArray<double> MeanPerElectrode;
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < OutNumTags; CurrentTagIndex++)
+	{
+		this->EnsemblePerTagArray[CurrentTagIndex].CalculateChannelMeans(FPT_TagEnsemble::MagnitudeChannel, MeanPerElectrode);
+		for (int32 CurrentElectrodeIndex = 0; CurrentElectrodeIndex < MeanPerElectrode.Num(); CurrentElectrodeIndex++)
+		{
+			OutMeanMagnitudeArray[CurrentElectrodeIndex * OutNumTags + CurrentTagIndex] = MeanPerElectrode[CurrentElectrodeIndex];
+		}
+	}
+}
+
+void UPT_SimulationComponent::CompressSimulationData()
+{
+	const int32 NumTags = this->EnsemblePerTagArray.Num();
+	this->LowRankReport.RankPerTag.SetNumZeroed(NumTags);
+	this->LowRankReport.RelativeErrorPerTag.SetNumZeroed(NumTags);
+	this->LowRankReport.MaxAbsoluteErrorPerTag.SetNumZeroed(NumTags);
+	this->LowRankReport.RawBytes = 0;
+	this->LowRankReport.CompressedBytes = 0;
+
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < NumTags; CurrentTagIndex++)
+	{
+		FPT_TagEnsemble& Ensemble = this->EnsemblePerTagArray[CurrentTagIndex];
+		this->LowRankReport.RawBytes += (int64)Ensemble.GetNumElectrodes() * FPT_TagEnsemble::NumChannels * Ensemble.GetNumCells() * sizeof(double);
+
+		if (!Ensemble.IsCompressed())
+		{
+			double RelativeError = 0.0;
+			double MaxAbsoluteError = 0.0;
+			if (Ensemble.Compress(this->LowRankMaxRank, this->LowRankEnergyThreshold, RelativeError, MaxAbsoluteError))
+			{
+				this->LowRankReport.RelativeErrorPerTag[CurrentTagIndex] = RelativeError;
+				this->LowRankReport.MaxAbsoluteErrorPerTag[CurrentTagIndex] = MaxAbsoluteError;
+				UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::CompressSimulationData] Tag %d: Rank %d, Relative Error %e, Max Absolute Error %e"), CurrentTagIndex, Ensemble.GetRank(), RelativeError, MaxAbsoluteError);
+			}
+		}
+
+		this->LowRankReport.RankPerTag[CurrentTagIndex] = Ensemble.GetRank();
+		this->LowRankReport.CompressedBytes += Ensemble.GetAllocatedSize();
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::CompressSimulationData] Raw Bytes: %lld, Compressed Bytes: %lld"), this->LowRankReport.RawBytes, this->LowRankReport.CompressedBytes);
+	this->ReportMemoryUsage();
+}
+
+FPT_OptimizationResult UPT_SimulationComponent::OptimizeElectrodePosition(const APT_ElectrodeAreaActor* InElectrodeAreaActor, const EOptimizationObjective InObjective, const TArray<int32>& InTagIndexArray, const double& InThreshold, const FVector& InDirection, const int32& InSweepResolution, const int32& InMaxIterations)
+{
+	if (!InElectrodeAreaActor)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::OptimizeElectrodePosition] Electrode area actor is null!"));
+		return FPT_OptimizationResult();
+	}
+
+	FPT_PositionOptimizer Optimizer;
+	if (InObjective == EOptimizationObjective::NormalComponent)
+	{
+		TArray<double> NormalComponentArray;
+		if (!this->CalculateElectrodeNormalComponents(NormalComponentArray) || !Optimizer.SetupElectrodeValues(InElectrodeAreaActor->GetInterpolator(), InElectrodeAreaActor->InterpolationMode, InElectrodeAreaActor->GetGridCornerPoints(), InObjective, NormalComponentArray))
+		{
+			return FPT_OptimizationResult();
+		}
+	}
+	else if (!Optimizer.Setup(this->EnsemblePerTagArray, InElectrodeAreaActor->GetInterpolator(), InElectrodeAreaActor->InterpolationMode, InElectrodeAreaActor->GetGridCornerPoints(), InObjective, InTagIndexArray, InThreshold, InDirection))
+	{
+		return FPT_OptimizationResult();
+	}
+
+	const FPT_OptimizationResult Result = Optimizer.Run(InSweepResolution, InMaxIterations, 0.0);
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::OptimizeElectrodePosition] Objective %f at %s after %d evaluations in %.2f ms"), Result.ObjectiveValue, *Result.Position.ToString(), Result.NumEvaluations, Result.ElapsedMilliseconds);
+	return Result;
+}
+
+double UPT_SimulationComponent::CalculatePercentile(const TArray<double>& InData, const double& InPercentile)
+{
+	if (InData.Num() == 0)
+	{
+		return 0.0f; // Rckgabe von 0, wenn Daten leer sind
+	}
+
+	TArray<double> SortedData = InData;
+	SortedData.Sort(); // Sortieren der Daten
+
+	double Index = (InPercentile / 100.0f) * (SortedData.Num() - 1);
+	int32 LowerIndex = FMath::FloorToInt(Index);
+	int32 UpperIndex = FMath::CeilToInt(Index);
+
+	if (LowerIndex == UpperIndex)
+	{
+		return SortedData[LowerIndex]; // Rckgabe des Werts, wenn Index ganzzahlig ist
+	}
+	else
+	{
+		// Interpolation zwischen den beiden Indizes
+		double LowerValue = SortedData[LowerIndex];
+		double UpperValue = SortedData[UpperIndex];
+		double InterpolatedValue = LowerValue + (UpperValue - LowerValue) * (Index - LowerIndex);
+		return InterpolatedValue;
+	}
+}
+
+double UPT_SimulationComponent::CalculatePercentileForInterpolatedMagnitudeDataPerTagArray(const double& InPercentile)
+{
+	TArray<double> SortedData;
+
+	if (this->InterpolatedMagnitudeDataPerTagArray.Num() == 0)
+	{
+		return 0.0f; // Rckgabe von 0, wenn Daten leer sind
+	}
+
+	auto IsAllZeros = [](const TArray<double>& DataArray) -> bool{
+		for (double Value : DataArray) {
+			if (Value != 0.0) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	for(int32 CurrentTagIndex : UPT_ConfigManager::GetDataTagVolumeIndexArray())
+	{
+		TArray<double> CurrentMagnitudeDataArray = this->InterpolatedMagnitudeDataPerTagArray[CurrentTagIndex];
+
+		// Skip arrays that are empty or contain only zeros
+		if(CurrentMagnitudeDataArray.Num() == 0 || IsAllZeros(CurrentMagnitudeDataArray))
+		{
+			continue;
+		}
+
+		for(int32 CurrentCellIndex : this->RoiIndexMappingPerTagArray[CurrentTagIndex])
+		{
+			if (CurrentMagnitudeDataArray[CurrentCellIndex] != 0.0) {
+				SortedData.Add(CurrentMagnitudeDataArray[CurrentCellIndex]);
+			}
+		}
+	}
+
+	if (SortedData.Num() == 0) {
+		return 0.0f; // Return 0 if no valid data was added
 	}
 	
 
@@ -752,65 +1700,511 @@ void UPT_SimulationComponent::CreateInterpolatedDataJson(const FString& InPatien
 
 void UPT_SimulationComponent::ResetSimulationDataArrays()
 {
-	this->SimulationMagnitudeDataPerElectrodePerTagArray.Empty();
-	this->SimulationVectorfieldDataPerElectrodePerTagArray.Empty();
+	// The surface mapping stays available to the resident datasets of the same patient and ROI
+	if (!this->ActivePatientId.IsEmpty() && !this->VerticesInRoiArray.IsEmpty())
+	{
+		FPT_SurfaceMapping SurfaceMapping;
+		this->MoveSurfaceMappingTo(SurfaceMapping);
+		this->Workspace.StoreSurface(this->ActivePatientId, this->ActiveRoiId, MoveTemp(SurfaceMapping));
+	}
+	this->ActivePatientId.Empty();
+	this->ActiveConfigId.Empty();
+	this->ActiveRoiId.Empty();
+	this->bSurfaceMappingResident = false;
+
+	this->EnsemblePerTagArray.Empty();
+	this->LowRankReport = FPT_LowRankReport();
+	this->RoiCellVolumePerTagArray.Empty();
+	this->TagVolumePerTagArray.Empty();
+	this->RawTetraDataArray.Empty();
+	this->ElectrodeIndexArray.Empty();
+	this->RoiIndexMappingPerTagArray.Empty();
+	this->TagLengthArray.Empty();
+	this->VertexTagCellMapping.Empty();
+	this->VerticesInRoiArray.Empty();
+	this->VertexCellRowOffsetArray.Empty();
+	this->VertexCellTagArray.Empty();
+	this->VertexCellIndexArray.Empty();
+	this->VertexCellVolumeArray.Empty();
+	this->VertexCellDistanceArray.Empty();
+
+	this->ResetDerivedData();
+	this->Workspace.Evict(0, this->GetWorkspaceBudgetBytes());
+	this->ReportMemoryUsage();
+}
+
+void UPT_SimulationComponent::ResetDerivedData()
+{
+	this->SuperpositionElectrodeIndexArray.Empty();
+	this->SuperpositionAmplitudeArray.Empty();
+	this->LeaveOneOutReport = FPT_LeaveOneOutReport();
+	this->VolumeMetrics = FPT_VolumeMetrics();
 
 	this->InterpolatedMagnitudeDataPerTagArray.Empty();
 	this->InterpolatedMagnitudeDataPerTagArray.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
 	this->InterpolatedVectorfieldDataPerTagArray.Empty();
 	this->InterpolatedVectorfieldDataPerTagArray.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
 	this->PerVertexDataArray.Empty();
-	this->RawTetraDataArray.Empty();
-	this->ElectrodeIndexArray.Empty();
-	this->RoiIndexMappingPerTagArray.Empty();
-	this->TagLengthArray.Empty();
 	this->MeanMagnitudePerTag.Empty();
 	this->MeanMagnitudePerTag.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
 	this->MeanVectorFieldPerTag.Empty();
 	this->MeanVectorFieldPerTag.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
 	this->MeanMagnitude = 0.0;
 	this->MeanVectorField = FVector::ZeroVector;
-	this->VertexTagCellMapping.Empty();
-	this->VerticesInRoiArray.Empty();
+	this->VertexCellWeightArray.Empty();
+	this->bVertexCellWeightsDirty = true;
 	this->DataColorArrayPerTag.Empty();
 	this->DataColorArrayPerTag.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
 	this->VectorfieldInRoi.Empty();
+	this->NormalAngleInRoi.Empty();
+	this->NormalComponentInRoi.Empty();
+	this->NormalValidInRoi.Empty();
+	this->NormalFieldReport = FPT_NormalFieldReport();
+
+	// Captured result slots are kept to compare configurations, blends refer to the electrodes of the old data
+	for (FResultSlot& Slot : this->ResultSlotArray)
+	{
+		if (!Slot.bIsCaptured)
+		{
+			Slot = FResultSlot();
+		}
+	}
+	this->DifferenceMagnitudeDataPerTagArray.Empty();
+	this->DifferenceVectorfieldDataPerTagArray.Empty();
+	this->DifferenceRoiIndexMappingPerTagArray.Empty();
+	this->DifferenceReport = FPT_DifferenceReport();
+}
+
+bool UPT_SimulationComponent::SwitchDataset(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId)
+{
+	if (InPatientId.IsEmpty() || InConfigId.IsEmpty() || InRoiId.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::SwitchDataset] Patient, configuration and ROI IDs must not be empty!"));
+		return false;
+	}
+
+	if (InPatientId == this->ActivePatientId && InConfigId == this->ActiveConfigId && InRoiId == this->ActiveRoiId && !this->EnsemblePerTagArray.IsEmpty())
+	{
+		return true;
+	}
+
+	// Park the active dataset, unkeyed data loaded without the workspace is discarded
+	FPT_SimulationDataset Dataset;
+	this->MoveDatasetTo(Dataset);
+	if (!this->ActivePatientId.IsEmpty() && !Dataset.EnsemblePerTagArray.IsEmpty())
+	{
+		this->Workspace.Store(this->ActivePatientId, this->ActiveConfigId, this->ActiveRoiId, MoveTemp(Dataset));
+	}
+
+	// The surface mapping stays checked out while the patient and ROI do not change
+	const bool bIsSameSurface = !this->ActivePatientId.IsEmpty() && InPatientId == this->ActivePatientId && InRoiId == this->ActiveRoiId;
+	if (!bIsSameSurface)
+	{
+		FPT_SurfaceMapping SurfaceMapping;
+		this->MoveSurfaceMappingTo(SurfaceMapping);
+
+		// A surface mesh set before the first switch belongs to the requested patient
+		FPT_MeshBufferPtr UnkeyedSurfaceMesh;
+		if (this->ActivePatientId.IsEmpty())
+		{
+			UnkeyedSurfaceMesh = MoveTemp(SurfaceMapping.SurfaceMesh);
+		}
+		else if (!SurfaceMapping.VerticesInRoiArray.IsEmpty())
+		{
+			this->Workspace.StoreSurface(this->ActivePatientId, this->ActiveRoiId, MoveTemp(SurfaceMapping));
+		}
+
+		SurfaceMapping = FPT_SurfaceMapping();
+		if (this->Workspace.TakeSurface(InPatientId, InRoiId, SurfaceMapping))
+		{
+			this->MoveSurfaceMappingFrom(MoveTemp(SurfaceMapping));
+		}
+		if (!this->SurfaceMesh.IsValid())
+		{
+			this->SurfaceMesh = MoveTemp(UnkeyedSurfaceMesh);
+		}
+	}
+	this->bSurfaceMappingResident = !this->VerticesInRoiArray.IsEmpty();
+
+	this->ActivePatientId = InPatientId;
+	this->ActiveConfigId = InConfigId;
+	this->ActiveRoiId = InRoiId;
+
+	const bool bIsResident = this->Workspace.Take(InPatientId, InConfigId, InRoiId, Dataset);
+	if (bIsResident)
+	{
+		this->MoveDatasetFrom(MoveTemp(Dataset));
+	}
+	this->ResetDerivedData();
+	this->EnforceWorkspaceBudget();
+
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::SwitchDataset] Switched to %s|%s|%s, Resident: %d, Shared Surface Mapping: %d"), *InPatientId, *InConfigId, *InRoiId, bIsResident, this->bSurfaceMappingResident);
+	return bIsResident;
+}
+
+void UPT_SimulationComponent::EvictDataset(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId)
+{
+	if (InPatientId == this->ActivePatientId && InConfigId == this->ActiveConfigId && InRoiId == this->ActiveRoiId)
+	{
+		this->ResetSimulationDataArrays();
+		return;
+	}
+
+	if (!this->Workspace.Remove(InPatientId, InConfigId, InRoiId))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[UPT_SimulationComponent::EvictDataset] %s|%s|%s is not resident."), *InPatientId, *InConfigId, *InRoiId);
+	}
+	this->ReportMemoryUsage();
+}
+
+void UPT_SimulationComponent::ClearWorkspace()
+{
+	this->Workspace.Empty();
+	this->ReportMemoryUsage();
+}
+
+TArray<FPT_WorkspaceEntry> UPT_SimulationComponent::GetWorkspaceEntries() const
+{
+	TArray<FPT_WorkspaceEntry> EntryArray;
+	const int64 ActiveSurfaceBytes = this->GetActiveSurfaceMappingBytes();
+	if (!this->EnsemblePerTagArray.IsEmpty())
+	{
+		FPT_WorkspaceEntry& ActiveEntry = EntryArray.AddDefaulted_GetRef();
+		ActiveEntry.PatientId = this->ActivePatientId;
+		ActiveEntry.ConfigId = this->ActiveConfigId;
+		ActiveEntry.RoiId = this->ActiveRoiId;
+		ActiveEntry.bIsActive = true;
+		ActiveEntry.bIsCompressed = this->EnsemblePerTagArray[0].IsCompressed();
+		ActiveEntry.DatasetBytes = this->GetActiveDatasetBytes();
+		ActiveEntry.SurfaceBytes = ActiveSurfaceBytes;
+	}
+
+	const int32 FirstInactiveIndex = EntryArray.Num();
+	this->Workspace.GetEntries(EntryArray);
+
+	// Datasets sharing the checked out surface mapping report it as well
+	for (int32 EntryIndex = FirstInactiveIndex; EntryIndex < EntryArray.Num(); EntryIndex++)
+	{
+		if (EntryArray[EntryIndex].PatientId == this->ActivePatientId && EntryArray[EntryIndex].RoiId == this->ActiveRoiId)
+		{
+			EntryArray[EntryIndex].SurfaceBytes = ActiveSurfaceBytes;
+		}
+	}
+	return EntryArray;
+}
+
+int64 UPT_SimulationComponent::GetWorkspaceAllocatedBytes() const
+{
+	return this->GetActiveDatasetBytes() + this->GetActiveSurfaceMappingBytes() + this->Workspace.GetAllocatedSize();
+}
+
+void UPT_SimulationComponent::MoveDatasetTo(FPT_SimulationDataset& OutDataset)
+{
+	OutDataset.EnsemblePerTagArray = MoveTemp(this->EnsemblePerTagArray);
+	OutDataset.RoiIndexMappingPerTagArray = MoveTemp(this->RoiIndexMappingPerTagArray);
+	OutDataset.TagLengthArray = MoveTemp(this->TagLengthArray);
+	OutDataset.LowRankReport = MoveTemp(this->LowRankReport);
+	OutDataset.RoiCellVolumePerTagArray = MoveTemp(this->RoiCellVolumePerTagArray);
+	OutDataset.TagVolumePerTagArray = MoveTemp(this->TagVolumePerTagArray);
+	this->LowRankReport = FPT_LowRankReport();
+}
+
+void UPT_SimulationComponent::MoveDatasetFrom(FPT_SimulationDataset&& InDataset)
+{
+	this->EnsemblePerTagArray = MoveTemp(InDataset.EnsemblePerTagArray);
+	this->RoiIndexMappingPerTagArray = MoveTemp(InDataset.RoiIndexMappingPerTagArray);
+	this->TagLengthArray = MoveTemp(InDataset.TagLengthArray);
+	this->LowRankReport = MoveTemp(InDataset.LowRankReport);
+	this->RoiCellVolumePerTagArray = MoveTemp(InDataset.RoiCellVolumePerTagArray);
+	this->TagVolumePerTagArray = MoveTemp(InDataset.TagVolumePerTagArray);
+}
+
+void UPT_SimulationComponent::MoveSurfaceMappingTo(FPT_SurfaceMapping& OutSurfaceMapping)
+{
+	OutSurfaceMapping.VertexTagCellMapping = MoveTemp(this->VertexTagCellMapping);
+	OutSurfaceMapping.VerticesInRoiArray = MoveTemp(this->VerticesInRoiArray);
+	OutSurfaceMapping.VertexCellRowOffsetArray = MoveTemp(this->VertexCellRowOffsetArray);
+	OutSurfaceMapping.VertexCellTagArray = MoveTemp(this->VertexCellTagArray);
+	OutSurfaceMapping.VertexCellIndexArray = MoveTemp(this->VertexCellIndexArray);
+	OutSurfaceMapping.VertexCellVolumeArray = MoveTemp(this->VertexCellVolumeArray);
+	OutSurfaceMapping.VertexCellDistanceArray = MoveTemp(this->VertexCellDistanceArray);
+	OutSurfaceMapping.SurfaceMesh = MoveTemp(this->SurfaceMesh);
+	this->bVertexCellWeightsDirty = true;
+}
+
+void UPT_SimulationComponent::MoveSurfaceMappingFrom(FPT_SurfaceMapping&& InSurfaceMapping)
+{
+	this->VertexTagCellMapping = MoveTemp(InSurfaceMapping.VertexTagCellMapping);
+	this->VerticesInRoiArray = MoveTemp(InSurfaceMapping.VerticesInRoiArray);
+	this->VertexCellRowOffsetArray = MoveTemp(InSurfaceMapping.VertexCellRowOffsetArray);
+	this->VertexCellTagArray = MoveTemp(InSurfaceMapping.VertexCellTagArray);
+	this->VertexCellIndexArray = MoveTemp(InSurfaceMapping.VertexCellIndexArray);
+	this->VertexCellVolumeArray = MoveTemp(InSurfaceMapping.VertexCellVolumeArray);
+	this->VertexCellDistanceArray = MoveTemp(InSurfaceMapping.VertexCellDistanceArray);
+	this->SurfaceMesh = MoveTemp(InSurfaceMapping.SurfaceMesh);
+	this->bVertexCellWeightsDirty = true;
+}
+
+int64 UPT_SimulationComponent::GetActiveDatasetBytes() const
+{
+	SIZE_T Size = this->EnsemblePerTagArray.GetAllocatedSize() + this->TagLengthArray.GetAllocatedSize() + this->TagVolumePerTagArray.GetAllocatedSize();
+	for (const FPT_TagEnsemble& Ensemble : this->EnsemblePerTagArray)
+	{
+		Size += Ensemble.GetAllocatedSize();
+	}
+	for (const TArray<int32>& RoiIndexMapping : this->RoiIndexMappingPerTagArray)
+	{
+		Size += RoiIndexMapping.GetAllocatedSize();
+	}
+	for (const TArray<float>& RoiCellVolumes : this->RoiCellVolumePerTagArray)
+	{
+		Size += RoiCellVolumes.GetAllocatedSize();
+	}
+	return (int64)Size;
+}
+
+int64 UPT_SimulationComponent::GetActiveSurfaceMappingBytes() const
+{
+	SIZE_T Size = this->VertexTagCellMapping.GetAllocatedSize();
+	for (const TPair<int32, TArray<TArray<int32>>>& Pair : this->VertexTagCellMapping)
+	{
+		Size += Pair.Value.GetAllocatedSize();
+		for (const TArray<int32>& CellIndices : Pair.Value)
+		{
+			Size += CellIndices.GetAllocatedSize();
+		}
+	}
+
+	return (int64)(Size
+		+ this->VerticesInRoiArray.GetAllocatedSize()
+		+ this->VertexCellRowOffsetArray.GetAllocatedSize()
+		+ this->VertexCellTagArray.GetAllocatedSize()
+		+ this->VertexCellIndexArray.GetAllocatedSize()
+		+ this->VertexCellVolumeArray.GetAllocatedSize()
+		+ this->VertexCellDistanceArray.GetAllocatedSize()
+		+ FPT_MeshBuffer::GetUnsharedSize(this->SurfaceMesh));
+}
+
+void UPT_SimulationComponent::EnforceWorkspaceBudget()
+{
+	const int32 NumEvicted = this->Workspace.Evict(this->GetActiveDatasetBytes() + this->GetActiveSurfaceMappingBytes(), this->GetWorkspaceBudgetBytes());
+	if (NumEvicted > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::EnforceWorkspaceBudget] Evicted %d datasets, %lld bytes resident."), NumEvicted, this->GetWorkspaceAllocatedBytes());
+	}
+	this->ReportMemoryUsage();
+}
+
+void UPT_SimulationComponent::ReportMemoryUsage() const
+{
+	UPT_MemoryBudgetManager::ReportUsage(this->GetMemoryConsumerName(), EMemorySubsystem::Simulation, this->GetWorkspaceAllocatedBytes());
+}
+
+int64 UPT_SimulationComponent::RelieveMemory(const int64 InBytesToFree)
+{
+	const int64 BytesBefore = this->GetWorkspaceAllocatedBytes();
+
+	// Resident datasets go first, least recently used first
+	this->Workspace.Evict(this->GetActiveDatasetBytes() + this->GetActiveSurfaceMappingBytes(), BytesBefore - InBytesToFree);
+
+	// Then the active dataset gives up precision
+	if (BytesBefore - this->GetWorkspaceAllocatedBytes() < InBytesToFree && !this->EnsemblePerTagArray.IsEmpty() && !this->EnsemblePerTagArray[0].IsCompressed())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[UPT_SimulationComponent::RelieveMemory] Compressing the active dataset to stay within the memory budget."));
+		this->CompressSimulationData();
+	}
+
+	this->ReportMemoryUsage();
+	return FMath::Max<int64>(BytesBefore - this->GetWorkspaceAllocatedBytes(), 0);
 }
 
 void UPT_SimulationComponent::CalculateMeanAngleBetweenNormalAndVectorField(const TArray<FVector>& InNormalArray, const TArray<FVector>& InVectorFieldArray, double& OutMeanAngle)
 {
-	//// Ensure the arrays have the same size
-	//if (InNormalArray.Num() != InVectorFieldArray.Num() || InNormalArray.Num() == 0)
-	//{
-	//	UE_LOG(LogTemp, Error, TEXT("[CalculateMeanAngleBetweenNormalAndVectorField] Input NormalArray and VectorFieldArray are mismatched! Lengths are Normal: %f, VF: %f"), InNormalArray.Num(), InVectorFieldArray.Num());
-	//	OutMeanAngle = 0.0;
-	//	return;
-	//}
+	// Ensure the arrays have the same size
+	if (InNormalArray.Num() != InVectorFieldArray.Num() || InNormalArray.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[CalculateMeanAngleBetweenNormalAndVectorField] Input NormalArray and VectorFieldArray are mismatched! Lengths are Normal: %d, VF: %d"), InNormalArray.Num(), InVectorFieldArray.Num());
+		OutMeanAngle = 0.0;
+		return;
+	}
 
-	//double TotalAngle = 0.0;
-	//int32 Count = InNormalArray.Num();
+	// Sum the angles per block, the block sums are added in a fixed order so the result does not depend on the scheduling
+	constexpr int32 BlockSize = 4096;
+	const int32 Count = InNormalArray.Num();
+	TArray<double> BlockSums;
+	BlockSums.SetNumZeroed(FMath::DivideAndRoundUp(Count, BlockSize));
 
-	//for (int32 i = 0; i < Count; ++i)
-	//{
-	//	const FVector& Normal = InNormalArray[i].GetSafeNormal();
-	//	const FVector& VectorField = InVectorFieldArray[i].GetSafeNormal();
+	ParallelFor(BlockSums.Num(), [&](const int32 Block)
+	{
+		const int32 End = FMath::Min((Block + 1) * BlockSize, Count);
+		double Sum = 0.0;
+		for (int32 i = Block * BlockSize; i < End; i++)
+		{
+			double NormalComponent = 0.0;
+			Sum += CalculateNormalFieldAngle(InNormalArray[i], InVectorFieldArray[i], NormalComponent);
+		}
+		BlockSums[Block] = Sum;
+	});
 
-	//	// Calculate the dot product
-	//	double DotProduct = FVector::DotProduct(Normal, VectorField);
+	double TotalAngle = 0.0;
+	for (const double BlockSum : BlockSums)
+	{
+		TotalAngle += BlockSum;
+	}
 
-	//	// Clamp the dot product to the valid range for acos
-	//	DotProduct = FMath::Clamp(DotProduct, -1.0, 1.0);
+	// Calculate the mean angle
+	OutMeanAngle = TotalAngle / Count;
+}
 
-	//	// Compute the angle in radians and convert to degrees
-	//	double Angle = FMath::RadiansToDegrees(FMath::Acos(DotProduct));
+FPT_NormalFieldReport UPT_SimulationComponent::GetNormalFieldReport() const
+{
+	FPT_NormalFieldReport Report = this->NormalFieldReport;
+	Report.PercentileArray.Append(NormalFieldPercentiles, UE_ARRAY_COUNT(NormalFieldPercentiles));
+
+	TArray<double> SortedAngles;
+	TArray<double> SortedNormalComponents;
+	SortedAngles.Reserve(Report.NumVertices);
+	SortedNormalComponents.Reserve(Report.NumVertices);
+	for (TConstSetBitIterator<> It(this->NormalValidInRoi); It; ++It)
+	{
+		SortedAngles.Add(this->NormalAngleInRoi[It.GetIndex()]);
+		SortedNormalComponents.Add(this->NormalComponentInRoi[It.GetIndex()]);
+	}
+	SortedAngles.Sort();
+	SortedNormalComponents.Sort();
 
-	//	// Accumulate the angle
-	//	TotalAngle += Angle;
-	//}
+	for (const double Percentile : Report.PercentileArray)
+	{
+		Report.AnglePercentileArray.Add(CalculateSortedPercentile(SortedAngles, Percentile));
+		Report.NormalComponentPercentileArray.Add(CalculateSortedPercentile(SortedNormalComponents, Percentile));
+	}
+	return Report;
+}
 
-	//// Calculate the mean angle
-	//OutMeanAngle = TotalAngle / Count;
-	OutMeanAngle = 0.0;
+TArray<FLinearColor> UPT_SimulationComponent::MapNormalFieldToVertexColors(const bool& bInUseAngle, const double& InMinValue, const double& InMaxValue, const int32& InVertexArrayLength) const
+{
+	TArray<FLinearColor> OutVertexColors;
+	OutVertexColors.Init(FLinearColor(0.9f, 0.9f, 0.9f), InVertexArrayLength);
+	const TArray<double>& ValueArray = bInUseAngle ? this->NormalAngleInRoi : this->NormalComponentInRoi;
+
+	double MinValue = InMinValue;
+	double MaxValue = InMaxValue;
+	if (MaxValue <= MinValue)
+	{
+		MinValue = TNumericLimits<double>::Max();
+		MaxValue = TNumericLimits<double>::Lowest();
+		for (TConstSetBitIterator<> It(this->NormalValidInRoi); It; ++It)
+		{
+			MinValue = FMath::Min(MinValue, ValueArray[It.GetIndex()]);
+			MaxValue = FMath::Max(MaxValue, ValueArray[It.GetIndex()]);
+		}
+	}
+
+	const double Range = MaxValue - MinValue;
+	const double InvRange = Range > UE_SMALL_NUMBER ? 1.0 / Range : 0.0;
+	for (TConstSetBitIterator<> It(this->NormalValidInRoi); It; ++It)
+	{
+		const int32 CurrentVertexIndex = this->VerticesInRoiArray[It.GetIndex()];
+		if (OutVertexColors.IsValidIndex(CurrentVertexIndex))
+		{
+			OutVertexColors[CurrentVertexIndex] = SamplePlasmaColormap((ValueArray[It.GetIndex()] - MinValue) * InvRange);
+		}
+	}
+	return OutVertexColors;
+}
+
+bool UPT_SimulationComponent::CalculateElectrodeNormalComponents(TArray<double>& OutValueArray)
+{
+	OutValueArray.Empty();
+	const int32 NumTags = this->EnsemblePerTagArray.Num();
+	const int32 NumRows = FMath::Max(this->VertexCellRowOffsetArray.Num() - 1, 0);
+	const TArray<FVector>& SurfaceNormalArray = this->GetSurfaceNormalArray();
+	if (NumTags == 0 || NumRows == 0 || SurfaceNormalArray.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::CalculateElectrodeNormalComponents] No simulation data, ROI vertices or surface normals!"));
+		return false;
+	}
+
+	if (this->bVertexCellWeightsDirty || this->VertexCellWeightMode != this->VertexAveragingMode)
+	{
+		this->UpdateVertexCellWeights();
+	}
+
+	int32 NumValidRows = 0;
+	for (int32 Row = 0; Row < NumRows; Row++)
+	{
+		NumValidRows += SurfaceNormalArray.IsValidIndex(this->VerticesInRoiArray[Row]) && this->VertexCellRowOffsetArray[Row] != this->VertexCellRowOffsetArray[Row + 1] ? 1 : 0;
+	}
+	if (NumValidRows == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::CalculateElectrodeNormalComponents] No ROI vertex has a surface normal!"));
+		return false;
+	}
+
+	// Per tag, fold the vertex averaging and the mean over the vertices into one direction weight per ROI cell
+	TArray<int32> EnsembleIndexArray;
+	TArray<double> DirectionWeightArray;
+	TArray<double> SumArray;
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < NumTags; CurrentTagIndex++)
+	{
+		const FPT_TagEnsemble& Ensemble = this->EnsemblePerTagArray[CurrentTagIndex];
+		const int32 NumCells = Ensemble.GetNumCells();
+		if (NumCells == 0 || !this->RoiIndexMappingPerTagArray.IsValidIndex(CurrentTagIndex))
+		{
+			continue;
+		}
+
+		EnsembleIndexArray.Init(INDEX_NONE, this->TagLengthArray[CurrentTagIndex]);
+		const TArray<int32>& RoiIndexMapping = this->RoiIndexMappingPerTagArray[CurrentTagIndex];
+		for (int32 CurrentIndex = 0; CurrentIndex < NumCells; CurrentIndex++)
+		{
+			if (EnsembleIndexArray.IsValidIndex(RoiIndexMapping[CurrentIndex]))
+			{
+				EnsembleIndexArray[RoiIndexMapping[CurrentIndex]] = CurrentIndex;
+			}
+		}
+
+		DirectionWeightArray.SetNumZeroed(3 * NumCells);
+		bool bHasEntries = false;
+		for (int32 Row = 0; Row < NumRows; Row++)
+		{
+			const int32 CurrentVertexIndex = this->VerticesInRoiArray[Row];
+			if (!SurfaceNormalArray.IsValidIndex(CurrentVertexIndex))
+			{
+				continue;
+			}
+
+			const FVector UnitNormal = SurfaceNormalArray[CurrentVertexIndex].GetSafeNormal() / NumValidRows;
+			for (int32 Entry = this->VertexCellRowOffsetArray[Row]; Entry < this->VertexCellRowOffsetArray[Row + 1]; Entry++)
+			{
+				const int32 CurrentIndex = this->VertexCellTagArray[Entry] == CurrentTagIndex && EnsembleIndexArray.IsValidIndex(this->VertexCellIndexArray[Entry]) ? EnsembleIndexArray[this->VertexCellIndexArray[Entry]] : INDEX_NONE;
+				if (CurrentIndex == INDEX_NONE)
+				{
+					continue;
+				}
+
+				const double Weight = this->VertexCellWeightArray[Entry];
+				DirectionWeightArray[CurrentIndex] += Weight * UnitNormal.X;
+				DirectionWeightArray[NumCells + CurrentIndex] += Weight * UnitNormal.Y;
+				DirectionWeightArray[2 * NumCells + CurrentIndex] += Weight * UnitNormal.Z;
+				bHasEntries = true;
+			}
+		}
+
+		if (!bHasEntries)
+		{
+			continue;
+		}
+
+		Ensemble.CalculateWeightedChannelSums(FPT_TagEnsemble::VectorChannel, 3, DirectionWeightArray.GetData(), SumArray);
+		OutValueArray.SetNumZeroed(FMath::Max(OutValueArray.Num(), SumArray.Num()));
+		for (int32 CurrentElectrodeIndex = 0; CurrentElectrodeIndex < SumArray.Num(); CurrentElectrodeIndex++)
+		{
+			OutValueArray[CurrentElectrodeIndex] += SumArray[CurrentElectrodeIndex];
+		}
+	}
+
+	return !OutValueArray.IsEmpty();
 }
 
 double UPT_SimulationComponent::GetAverageMagnitudePerTag(const int32& InTagIndex, bool& OutIsValid)
@@ -853,12 +2247,6 @@ FVector UPT_SimulationComponent::GetAverageVectorFieldPerTag(const int32& InTagI
 	return FVector::ZeroVector;
 }
 
-void UPT_SimulationComponent::GetSimulationDataPerElectrodePerTag(const int32& InElectrodeIndex, const int32& InTagIndex, TArray<double>& OutSimulationMagnitudeDataArray, TArray<FVector>& OutSimulationVectorfieldDataArray)
-{
-	OutSimulationMagnitudeDataArray = this->SimulationMagnitudeDataPerElectrodePerTagArray[InElectrodeIndex][InTagIndex];
-	OutSimulationVectorfieldDataArray = this->SimulationVectorfieldDataPerElectrodePerTagArray[InElectrodeIndex][InTagIndex];
-}
-
 void UPT_SimulationComponent::GetInterpolatedSimulationDataPerTag(const int32& InTagIndex, TArray<double>& OutInterpolatedSimulationMagnitudeDataArray, TArray<FVector>& OutInterpolatedSimulationVectorfieldDataArray)
 {
 	OutInterpolatedSimulationMagnitudeDataArray = this->InterpolatedMagnitudeDataPerTagArray[InTagIndex];
@@ -871,6 +2259,11 @@ void UPT_SimulationComponent::GetSimulationDataFromJSONObject(
 	const int32& InNumberOfElectrodes
 )
 {
+	this->LoadTimings = FPT_LoadTimings();
+	this->LoadTimings.NumElectrodes = InNumberOfElectrodes;
+	const double LoadStart = FPlatformTime::Seconds();
+	double StageStart = LoadStart;
+
 	this->TagLengthArray.Empty();
 	this->TagLengthArray.SetNumZeroed(InDataTagArray.Num());
 	this->RoiIndexMappingPerTagArray.Empty();
@@ -899,20 +2292,45 @@ void UPT_SimulationComponent::GetSimulationDataFromJSONObject(
 		UPT_JSONConverter::ConvertJSONToInteger(TagLengthObjectPtr, InDataTagArray[CurrentTagIndex], CurrentTagLength);
 		this->TagLengthArray[CurrentTagIndex] = CurrentTagLength;
 
-		TArray<int32> CurrentRoiIndexMapping;
-		UPT_JSONConverter::ConvertJSONObjectToIntegerArray(IndexMappingObjectPtr, InDataTagArray[CurrentTagIndex], CurrentRoiIndexMapping);
-		this->RoiIndexMappingPerTagArray[CurrentTagIndex] = CurrentRoiIndexMapping;
+		UPT_JSONConverter::ConvertJSONObjectToIntegerArray(IndexMappingObjectPtr, InDataTagArray[CurrentTagIndex], this->RoiIndexMappingPerTagArray[CurrentTagIndex]);
 	}
+	this->LoadTimings.HeaderMilliseconds = EndLoadStage(StageStart);
 
-	this->SimulationMagnitudeDataPerElectrodePerTagArray.Empty();
-	this->SimulationMagnitudeDataPerElectrodePerTagArray.SetNumZeroed(InNumberOfElectrodes);
-	this->SimulationVectorfieldDataPerElectrodePerTagArray.Empty();
-	this->SimulationVectorfieldDataPerElectrodePerTagArray.SetNumZeroed(InNumberOfElectrodes);
+	// The new ensembles replace the current ones, so only they have to fit into the memory budget
+	this->EnsemblePerTagArray.Empty();
+	this->ReportMemoryUsage();
+
+	int64 NumRoiCells = 0;
+	for (const TArray<int32>& RoiIndexMapping : this->RoiIndexMappingPerTagArray)
+	{
+		NumRoiCells += RoiIndexMapping.Num();
+	}
+	this->LoadTimings.NumRoiCells = NumRoiCells;
+
+	FString BudgetMessage;
+	const int64 EnsembleBytes = (int64)InNumberOfElectrodes * FPT_TagEnsemble::NumChannels * NumRoiCells * sizeof(double);
+	if (!UPT_MemoryBudgetManager::RequestAllocation(this->GetMemoryConsumerName(), EMemorySubsystem::Simulation, EnsembleBytes, BudgetMessage))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::GetSimulationDataFromJSONObject] %s"), *BudgetMessage);
+		this->TagLengthArray.Empty();
+		this->RoiIndexMappingPerTagArray.Empty();
+		return;
+	}
+
+	// One zeroed ensemble per tag, electrodes missing in the response keep zeroed data
+	this->EnsemblePerTagArray.SetNum(InDataTagArray.Num());
+	for (int32 CurrentTagIndex = 0; CurrentTagIndex < InDataTagArray.Num(); CurrentTagIndex++)
+	{
+		this->EnsemblePerTagArray[CurrentTagIndex].Init(InNumberOfElectrodes, this->RoiIndexMappingPerTagArray[CurrentTagIndex].Num());
+	}
+	this->LowRankReport = FPT_LowRankReport();
+	this->LoadTimings.AllocationMilliseconds = EndLoadStage(StageStart);
 
 	const TSharedPtr<FJsonObject>* ElectrodesJsonObjectPtr;
 	if (InJsonObjectPtr->Get()->TryGetObjectField("Electrodes", ElectrodesJsonObjectPtr))
 	{
-		for (int32 CurrentElectrodeIndex = 0; CurrentElectrodeIndex < InNumberOfElectrodes; CurrentElectrodeIndex++)
+		// Every electrode owns its rows of the ensembles, so the electrodes decode concurrently without locking
+		ParallelFor(InNumberOfElectrodes, [&](const int32 CurrentElectrodeIndex)
 		{
 			const TSharedPtr<FJsonObject>* ElectrodeDataJsonObjectPtr;
 			if (ElectrodesJsonObjectPtr->Get()->TryGetObjectField(FString::Printf(TEXT("Electrode_%d"), CurrentElectrodeIndex), ElectrodeDataJsonObjectPtr))
@@ -921,28 +2339,32 @@ void UPT_SimulationComponent::GetSimulationDataFromJSONObject(
 			}
 			else
 			{
-				UE_LOG(LogTemp, Warning, TEXT("[UPT_SimulationComponent::GetSimulationDataFromJSONObject] Field Electrode_%d not found. Adding Empty Array!"), CurrentElectrodeIndex);
-				TArray<TArray<double>> SimulationMagnitudeDataPerTagArray;
-				TArray<TArray<FVector>> SimulationVectorfieldDataPerTagArray;
-				SimulationMagnitudeDataPerTagArray.SetNumZeroed(InDataTagArray.Num());
-				SimulationVectorfieldDataPerTagArray.SetNumZeroed(InDataTagArray.Num());
-
-				for(int32 CurrentTagIndex = 0; CurrentTagIndex < InDataTagArray.Num(); CurrentTagIndex++)
-				{
-					SimulationMagnitudeDataPerTagArray[CurrentTagIndex].SetNumZeroed(this->TagLengthArray[CurrentTagIndex]);
-					SimulationVectorfieldDataPerTagArray[CurrentTagIndex].SetNumZeroed(this->TagLengthArray[CurrentTagIndex]);
-				}
-
-				this->SimulationMagnitudeDataPerElectrodePerTagArray[CurrentElectrodeIndex] = SimulationMagnitudeDataPerTagArray;
-				this->SimulationVectorfieldDataPerElectrodePerTagArray[CurrentElectrodeIndex] = SimulationVectorfieldDataPerTagArray;
+				UE_LOG(LogTemp, Warning, TEXT("[UPT_SimulationComponent::GetSimulationDataFromJSONObject] Field Electrode_%d not found. Keeping zeroed data!"), CurrentElectrodeIndex);
 			}
-		}
+		});
 	}
 	else
 	{
 		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::GetSimulationDataFromJSONObject] Field Electrodes not found."));
 		return;
 	}
+	this->LoadTimings.ElectrodeDecodeMilliseconds = EndLoadStage(StageStart);
+
+	if (this->bUseLowRankCompression)
+	{
+		this->CompressSimulationData();
+	}
+	this->LoadTimings.CompressionMilliseconds = EndLoadStage(StageStart);
+
+	// Another configuration of the same patient and ROI already provided the surface mapping
+	if (this->bSurfaceMappingResident)
+	{
+		UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::GetSimulationDataFromJSONObject] Reusing the surface mapping of %s|%s."), *this->ActivePatientId, *this->ActiveRoiId);
+		this->LoadTimings.bSurfaceMappingReused = true;
+		this->EnforceWorkspaceBudget();
+		this->FinishLoadTimings(LoadStart);
+		return;
+	}
 
 	const TSharedPtr<FJsonObject>* MeshVertexTagCellMappingObjectPtr;
 	const TSharedPtr<FJsonObject>* VolumeVertexTagCellMappingObjectPtr;
@@ -961,67 +2383,94 @@ void UPT_SimulationComponent::GetSimulationDataFromJSONObject(
 		return;
 	}
 
-	for (const auto& Elem : (*VolumeVertexTagCellMappingObjectPtr)->Values)
+	// Volume rows come first, mesh rows of a vertex already in the volume mapping only fill in the mesh tags
+	struct FMappingRow
 	{
-		const int32 VertexIndex = FCString::Atoi(*Elem.Key);
-
-		const TSharedPtr<FJsonObject>* TagMappingObjectPtr = nullptr;
-		if (Elem.Value->TryGetObject(TagMappingObjectPtr))
-		{
-			TArray<TArray<int32>> CellIndicesPerTagArray;
-			CellIndicesPerTagArray.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
-
-			for (const int32 CurrentTagIndex : UPT_ConfigManager::GetDataTagVolumeIndexArray())
-			{
-				TArray<int32> VertexArray;
-				UPT_JSONConverter::ConvertJSONObjectToIntegerArray(TagMappingObjectPtr, UPT_ConfigManager::GetDataTagArray()[CurrentTagIndex], VertexArray, false);
+		int32 VertexIndex = INDEX_NONE;
+		bool bIsMesh = false;
+		const TSharedPtr<FJsonValue>* ValuePtr = nullptr;
+		TArray<TArray<int32>> CellIndicesPerTagArray;
+	};
 
-				CellIndicesPerTagArray[CurrentTagIndex] = VertexArray;
-			}
-			this->VertexTagCellMapping.Add(VertexIndex, CellIndicesPerTagArray);
-			this->VerticesInRoiArray.AddUnique(VertexIndex);
-		}
+	TArray<FMappingRow> MappingRowArray;
+	MappingRowArray.Reserve((*VolumeVertexTagCellMappingObjectPtr)->Values.Num() + (*MeshVertexTagCellMappingObjectPtr)->Values.Num());
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Elem : (*VolumeVertexTagCellMappingObjectPtr)->Values)
+	{
+		FMappingRow& Row = MappingRowArray.AddDefaulted_GetRef();
+		Row.VertexIndex = FCString::Atoi(*Elem.Key);
+		Row.ValuePtr = &Elem.Value;
+	}
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Elem : (*MeshVertexTagCellMappingObjectPtr)->Values)
+	{
+		FMappingRow& Row = MappingRowArray.AddDefaulted_GetRef();
+		Row.VertexIndex = FCString::Atoi(*Elem.Key);
+		Row.bIsMesh = true;
+		Row.ValuePtr = &Elem.Value;
 	}
 
-	for (const auto& Elem : (*MeshVertexTagCellMappingObjectPtr)->Values)
+	const int32 NumDataTags = UPT_ConfigManager::GetDataTagIndexArray().Num();
+	const TArray<int32> VolumeTagIndexArray = UPT_ConfigManager::GetDataTagVolumeIndexArray();
+	const TArray<int32> MeshTagIndexArray = UPT_ConfigManager::GetDataTagMeshIndexArray();
+	const TArray<FString> DataTagArray = UPT_ConfigManager::GetDataTagArray();
+
+	ParallelFor(MappingRowArray.Num(), [&](const int32 RowIndex)
 	{
-		const int32 VertexIndex = FCString::Atoi(*Elem.Key);
+		FMappingRow& Row = MappingRowArray[RowIndex];
 		const TSharedPtr<FJsonObject>* TagMappingObjectPtr = nullptr;
-		if (Elem.Value->TryGetObject(TagMappingObjectPtr))
+		if (!(*Row.ValuePtr)->TryGetObject(TagMappingObjectPtr))
 		{
-			TArray<TArray<int32>> CellIndicesPerTagArray;
-			// Prfen, ob der VertexIndex bereits existiert
-			bool bIsVertexIndexPresent = this->VertexTagCellMapping.Contains(VertexIndex);
-			if (bIsVertexIndexPresent)
-			{
-				// Vorhandene TagMap fr diesen VertexIndex abrufen
-				CellIndicesPerTagArray = this->VertexTagCellMapping[VertexIndex];
-			}
-			else
-			{
-				CellIndicesPerTagArray.SetNumZeroed(UPT_ConfigManager::GetDataTagIndexArray().Num());
-			}
+			return;
+		}
 
-			for (const int32 CurrentTagIndex : UPT_ConfigManager::GetDataTagMeshIndexArray())
-			{
-				TArray<int32> VertexArray;
-				UPT_JSONConverter::ConvertJSONObjectToIntegerArray(TagMappingObjectPtr, UPT_ConfigManager::GetDataTagArray()[CurrentTagIndex], VertexArray, false);
+		Row.CellIndicesPerTagArray.SetNum(NumDataTags);
+		for (const int32 CurrentTagIndex : (Row.bIsMesh ? MeshTagIndexArray : VolumeTagIndexArray))
+		{
+			UPT_JSONConverter::ConvertJSONObjectToIntegerArray(TagMappingObjectPtr, DataTagArray[CurrentTagIndex], Row.CellIndicesPerTagArray[CurrentTagIndex], false);
+		}
+	});
+	this->LoadTimings.MappingDecodeMilliseconds = EndLoadStage(StageStart);
 
-				CellIndicesPerTagArray[CurrentTagIndex] = VertexArray;
-			}
+	this->VertexTagCellMapping.Reserve(MappingRowArray.Num());
+	this->VerticesInRoiArray.Reserve(MappingRowArray.Num());
+	for (FMappingRow& Row : MappingRowArray)
+	{
+		if (Row.CellIndicesPerTagArray.IsEmpty())
+		{
+			continue;
+		}
 
-			if (bIsVertexIndexPresent)
-			{
-				this->VertexTagCellMapping[VertexIndex] = CellIndicesPerTagArray;
-			}
-			else
+		TArray<TArray<int32>>* CellIndicesPerTagArray = this->VertexTagCellMapping.Find(Row.VertexIndex);
+		if (CellIndicesPerTagArray == nullptr)
+		{
+			this->VertexTagCellMapping.Add(Row.VertexIndex, MoveTemp(Row.CellIndicesPerTagArray));
+			this->VerticesInRoiArray.Add(Row.VertexIndex);
+		}
+		else
+		{
+			for (const int32 CurrentTagIndex : (Row.bIsMesh ? MeshTagIndexArray : VolumeTagIndexArray))
 			{
-				this->VertexTagCellMapping.Add(VertexIndex, CellIndicesPerTagArray);
-				this->VerticesInRoiArray.AddUnique(VertexIndex);
+				(*CellIndicesPerTagArray)[CurrentTagIndex] = MoveTemp(Row.CellIndicesPerTagArray[CurrentTagIndex]);
 			}
 		}
 	}
+	this->LoadTimings.MappingMergeMilliseconds = EndLoadStage(StageStart);
+
+	this->BuildVertexCellRows();
+	this->LoadTimings.CellRowMilliseconds = EndLoadStage(StageStart);
 
+	this->EnforceWorkspaceBudget();
+	this->FinishLoadTimings(LoadStart);
+}
+
+void UPT_SimulationComponent::FinishLoadTimings(const double InLoadStart)
+{
+	this->LoadTimings.NumRoiVertices = this->VerticesInRoiArray.Num();
+	this->LoadTimings.TotalMilliseconds = (FPlatformTime::Seconds() - InLoadStart) * 1000.0;
+
+	UE_LOG(LogTemp, Log, TEXT("[UPT_SimulationComponent::FinishLoadTimings] %d electrodes, %lld cells, %d vertices in %.1f ms (header %.1f, allocation %.1f, electrodes %.1f, compression %.1f, mapping decode %.1f, mapping merge %.1f, cell rows %.1f)"),
+		this->LoadTimings.NumElectrodes, this->LoadTimings.NumRoiCells, this->LoadTimings.NumRoiVertices, this->LoadTimings.TotalMilliseconds,
+		this->LoadTimings.HeaderMilliseconds, this->LoadTimings.AllocationMilliseconds, this->LoadTimings.ElectrodeDecodeMilliseconds, this->LoadTimings.CompressionMilliseconds,
+		this->LoadTimings.MappingDecodeMilliseconds, this->LoadTimings.MappingMergeMilliseconds, this->LoadTimings.CellRowMilliseconds);
 }
 
 void UPT_SimulationComponent::ProcessElectrodeData(const TSharedPtr<FJsonObject>* InJsonObjectPtr, const TArray<FString>& InDataTagArray, const int32& InCurrentElectrodeIndex)
@@ -1043,52 +2492,24 @@ void UPT_SimulationComponent::ProcessElectrodeData(const TSharedPtr<FJsonObject>
 		return;
 	}
 
-	TArray<TArray<double>> SimulationMagnitudeDataPerTagArray;
-	SimulationMagnitudeDataPerTagArray.SetNumZeroed(InDataTagArray.Num());;
-	TArray<TArray<FVector>> SimulationVectorfieldDataPerTagArray;
-	SimulationVectorfieldDataPerTagArray.SetNumZeroed(InDataTagArray.Num());;
-
 	for (int32 CurrentTagIndex = 0; CurrentTagIndex < InDataTagArray.Num(); CurrentTagIndex++)
 	{
-		TArray<double> SimulationMagnitudeDataNotMapped;
-		TArray<double> SimulationMagnitudeDataMapped;
-		SimulationMagnitudeDataMapped.SetNumZeroed(this->TagLengthArray[CurrentTagIndex]);
-		UPT_JSONConverter::ConvertJSONObjectToDoubleArray(MagnitudeJsonObjectPtr, InDataTagArray[CurrentTagIndex], SimulationMagnitudeDataNotMapped);
-
-		TArray<FVector> SimulationVectorfieldDataNotMapped;
-		TArray<FVector> SimulationVectorfieldDataMapped;
-		SimulationVectorfieldDataMapped.SetNumZeroed(this->TagLengthArray[CurrentTagIndex]);
-		UPT_JSONConverter::ConvertJSONObjectToVectorArray(VectorfieldJsonObjectPtr, InDataTagArray[CurrentTagIndex], SimulationVectorfieldDataNotMapped);
-
-		for(int32 CurrentCellIndex = 0; CurrentCellIndex < this->RoiIndexMappingPerTagArray[CurrentTagIndex].Num(); CurrentCellIndex++)
+		// The response holds the ROI cells in the order of the ROI index mapping, which is the ensemble order,
+		// so the values are decoded straight into the rows of this electrode
+		FPT_TagEnsemble& Ensemble = this->EnsemblePerTagArray[CurrentTagIndex];
+		const int32 NumCells = Ensemble.GetNumCells();
+
+		const int32 NumMagnitudes = UPT_JSONConverter::ConvertJSONObjectToDoubleBuffer(MagnitudeJsonObjectPtr, InDataTagArray[CurrentTagIndex],
+			Ensemble.GetRawChannel(InCurrentElectrodeIndex, FPT_TagEnsemble::MagnitudeChannel), NumCells);
+		const int32 NumVectors = UPT_JSONConverter::ConvertJSONObjectToVectorBuffers(VectorfieldJsonObjectPtr, InDataTagArray[CurrentTagIndex],
+			Ensemble.GetRawChannel(InCurrentElectrodeIndex, FPT_TagEnsemble::VectorChannel),
+			Ensemble.GetRawChannel(InCurrentElectrodeIndex, FPT_TagEnsemble::VectorChannel + 1),
+			Ensemble.GetRawChannel(InCurrentElectrodeIndex, FPT_TagEnsemble::VectorChannel + 2), NumCells);
+
+		if (NumMagnitudes != NumCells || NumVectors != NumCells)
 		{
-			SimulationMagnitudeDataMapped[this->RoiIndexMappingPerTagArray[CurrentTagIndex][CurrentCellIndex]] = SimulationMagnitudeDataNotMapped[CurrentCellIndex];
-			SimulationVectorfieldDataMapped[this->RoiIndexMappingPerTagArray[CurrentTagIndex][CurrentCellIndex]] = SimulationVectorfieldDataNotMapped[CurrentCellIndex];
+			UE_LOG(LogTemp, Warning, TEXT("[UPT_SimulationComponent::ProcessElectrodeData] Electrode %d, Tag %s: Expected %d cells, got %d magnitudes and %d vectors!"), InCurrentElectrodeIndex, *InDataTagArray[CurrentTagIndex], NumCells, FMath::Max(NumMagnitudes, 0), FMath::Max(NumVectors, 0));
 		}
-
-		SimulationMagnitudeDataPerTagArray[CurrentTagIndex] = SimulationMagnitudeDataMapped;
-		SimulationVectorfieldDataPerTagArray[CurrentTagIndex] = SimulationVectorfieldDataMapped;
-
-	}
-
-	if (!SimulationMagnitudeDataPerTagArray.IsEmpty())
-	{
-		this->SimulationMagnitudeDataPerElectrodePerTagArray[InCurrentElectrodeIndex] = SimulationMagnitudeDataPerTagArray;
-	}
-	else
-	{
-		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessResponseForSimulationData] Magnitude Data is empty!"));
-		return;
-	}
-
-	if (!SimulationVectorfieldDataPerTagArray.IsEmpty())
-	{
-		this->SimulationVectorfieldDataPerElectrodePerTagArray[InCurrentElectrodeIndex] = SimulationVectorfieldDataPerTagArray;
-	}
-	else
-	{
-		UE_LOG(LogTemp, Error, TEXT("[UPT_SimulationComponent::ProcessResponseForSimulationData] Vectorfield Data is empty!"));
-		return;
 	}
 }
 
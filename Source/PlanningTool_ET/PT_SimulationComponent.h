@@ -7,8 +7,13 @@
 #include "Components/ActorComponent.h"
 #include "PT_StructContainer.h"
 #include "PT_HTTPComponent.h"
+#include "PT_ElectrodeEnsemble.h"
+#include "PT_SimulationWorkspace.h"
+#include "PT_MeshBuffer.h"
 #include "PT_SimulationComponent.generated.h"
 
+class APT_ElectrodeAreaActor;
+
 /**
  * @brief Simulation component for the Epilepsy Therapy Planning Tool.
  */
@@ -66,6 +71,11 @@ public:
 
 	/**
 	 * @brief Calculates vertex colors.
+	 *
+	 * Every vertex averages the colors of its adjacent cells with the weights of VertexAveragingMode. The weights are
+	 * precomputed in a sparse row per vertex, so all modes cost the same per update. The volume and distance modes need
+	 * the tetra volumes of SetTetraVolumesPerTag, vertices without them fall back to uniform weights.
+	 *
 	 * @param InVertexArrayLength Length of the vertex array.
 	 * @return TArray<FLinearColor> Array of vertex colors.
 	 */
@@ -101,6 +111,273 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
 	void ProcessInterpolation(const int32& InElectrodeIndexA, const int32& InElectrodeIndexB, const int32& InElectrodeIndexC, const double& InWeightA, const double& InWeightB, const double& InWeightC);
 
+	/**
+	 * @brief Processes interpolation for simulation data with an arbitrary number of weighted electrodes.
+	 *
+	 * Used by the k-nearest inverse distance and radial basis modes, whose weights come from the electrode area actor.
+	 *
+	 * @param InElectrodeIndexArray The indices of the electrodes to blend.
+	 * @param InWeightArray The weight of every electrode.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void ProcessWeightedInterpolation(const TArray<int32>& InElectrodeIndexArray, const TArray<double>& InWeightArray);
+
+	/**
+	 * @brief Superposes the fields of several electrodes, each driven with its own current amplitude.
+	 *
+	 * The vector fields of all channels are scaled by their amplitude and summed, the magnitude is recomputed per cell
+	 * from the summed vector. The result replaces the interpolated data, so the colormap and vertex color functions can
+	 * be used unchanged.
+	 *
+	 * @param InElectrodeIndexArray The electrode index of every channel.
+	 * @param InAmplitudeArray The current amplitude of every channel.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void ProcessSuperposition(const TArray<int32>& InElectrodeIndexArray, const TArray<double>& InAmplitudeArray);
+
+	/**
+	 * @brief Changes the amplitude of one channel of the current superposition and re-evaluates it.
+	 * @param InChannelIndex The index of the channel.
+	 * @param InAmplitude The new current amplitude.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void SetSuperpositionChannelAmplitude(const int32& InChannelIndex, const double& InAmplitude);
+
+	/**
+	 * @brief Sets a result slot of the difference mode to a blend of electrodes of the loaded simulation data.
+	 *
+	 * The slot is evaluated by ProcessDifference, it does not touch the interpolated data arrays.
+	 *
+	 * @param InSlotIndex The slot, 0 for A or 1 for B.
+	 * @param InElectrodeIndexArray The indices of the electrodes to blend.
+	 * @param InWeightArray The weight of every electrode, or the current amplitude for a superposition.
+	 * @param bInIsSuperposition Whether the magnitude is recomputed from the blended vector, like ProcessSuperposition.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void SetResultSlot(const int32& InSlotIndex, const TArray<int32>& InElectrodeIndexArray, const TArray<double>& InWeightArray, const bool& bInIsSuperposition);
+
+	/**
+	 * @brief Stores a copy of the current interpolated data in a result slot of the difference mode.
+	 *
+	 * Captured slots are kept by ResetSimulationDataArrays, so the results of two configurations can be compared as long
+	 * as both cover the same ROI cells.
+	 *
+	 * @param InSlotIndex The slot, 0 for A or 1 for B.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void CaptureResultSlot(const int32& InSlotIndex);
+
+	/**
+	 * @brief Clears both result slots and the difference data.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void ClearResultSlots();
+
+	/**
+	 * @brief Calculates the signed per cell difference slot A minus slot B of the magnitude and the vector field.
+	 *
+	 * Both slots are evaluated and subtracted in one pass per tag that also gathers the statistics. Two linear blends are
+	 * merged into a single blend with the weights of B negated, so the difference costs one interpolation.
+	 *
+	 * @return FPT_DifferenceReport The difference statistics, also available via GetDifferenceReport().
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	FPT_DifferenceReport ProcessDifference();
+
+	/**
+	 * @brief Gets the per cell difference of the last ProcessDifference call for a tag.
+	 * @param InTagIndex The index of the tag.
+	 * @param OutMagnitudeDifferenceArray The magnitude difference of every cell of the tag, 0 outside the ROI.
+	 * @param OutVectorfieldDifferenceArray The vector field difference of every cell of the tag, zero outside the ROI.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void GetDifferenceDataPerTag(const int32& InTagIndex, TArray<double>& OutMagnitudeDifferenceArray, TArray<FVector>& OutVectorfieldDifferenceArray);
+
+	/**
+	 * @brief Maps the magnitude difference of a tag to a diverging blue-white-red colormap centered at zero.
+	 * @param InTagIndex The index of the tag.
+	 * @param InMaxAbsoluteValue The absolute difference mapped to the ends of the colormap. If not positive, the largest absolute difference of the tag is used.
+	 * @return TArray<FLinearColor> The color of every cell of the tag, black outside the ROI.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	TArray<FLinearColor> MapDifferenceToDivergingColormap(const int32& InTagIndex, const double& InMaxAbsoluteValue);
+
+	/**
+	 * @brief Gets the statistics of the last ProcessDifference call.
+	 * @return FPT_DifferenceReport The difference statistics.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	FPT_DifferenceReport GetDifferenceReport() { return this->DifferenceReport; };
+
+	/**
+	 * @brief Looks up the diverging colormap.
+	 * @param InSignedValue The value in the range [-1, 1], 0 maps to the neutral center.
+	 * @return The color of the value.
+	 */
+	static FLinearColor SampleDivergingColormap(const double InSignedValue);
+
+	/**
+	 * @brief Gets the current amplitude of every superposition channel.
+	 * @return TArray<double> The amplitude array.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	TArray<double> GetSuperpositionAmplitudeArray() { return this->SuperpositionAmplitudeArray; };
+
+	/**
+	 * @brief Compresses the simulation data of every tag into a truncated low-rank basis.
+	 *
+	 * Interpolation keeps working on the compressed data, it blends the per-electrode coefficients and evaluates the
+	 * basis once per cell. Tags that are already compressed are skipped. The result is available via GetLowRankReport().
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void CompressSimulationData();
+
+	/**
+	 * @brief Gets the error and memory report of the low-rank compression.
+	 * @return FPT_LowRankReport The low-rank report.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	FPT_LowRankReport GetLowRankReport() { return this->LowRankReport; };
+
+	/**
+	 * @brief Gets the per stage timing breakdown of the last simulation data load.
+	 * @return FPT_LoadTimings The load timings.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	FPT_LoadTimings GetLoadTimings() const { return this->LoadTimings; };
+
+	/**
+	 * @brief Estimates the interpolation error by predicting every simulated electrode from its neighbors.
+	 *
+	 * Every electrode of the interpolator of the electrode area actor is left out in turn, predicted at its own position
+	 * with the active interpolation mode and compared with its simulated magnitude in every tag. The electrodes and tags
+	 * are evaluated in parallel. The result is also kept and available via GetLeaveOneOutReport().
+	 * In the bilinear mode a left out lattice node is predicted from the lattice around it; nodes without usable
+	 * neighbors are predicted with inverse distance weighting and flagged in the report.
+	 *
+	 * @param InElectrodeAreaActor The electrode area actor with a built interpolator.
+	 * @return FPT_LeaveOneOutReport The error report.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	FPT_LeaveOneOutReport RunLeaveOneOutAnalysis(const APT_ElectrodeAreaActor* InElectrodeAreaActor);
+
+	/**
+	 * @brief Calculates the ROI mean magnitude of every electrode in every tag.
+	 * @param OutMeanMagnitudeArray Receives the means in [Electrode * OutNumTags + Tag] layout.
+	 * @param OutNumElectrodes Receives the number of electrodes.
+	 * @param OutNumTags Receives the number of tags.
+	 */
+	void CalculateElectrodeMeanMagnitudes(TArray<double>& OutMeanMagnitudeArray, int32& OutNumElectrodes, int32& OutNumTags) const;
+
+	/**
+	 * @brief Gets the number of ROI cells of a tag.
+	 * @param InTagIndex The index of the data tag.
+	 * @return The number of ROI cells, 0 if no data is loaded for the tag.
+	 */
+	int32 GetNumRoiCells(const int32 InTagIndex) const { return this->EnsemblePerTagArray.IsValidIndex(InTagIndex) ? this->EnsemblePerTagArray[InTagIndex].GetNumCells() : 0; }
+
+	/**
+	 * @brief Looks up the plasma colormap.
+	 * @param InNormalizedValue The value in the range [0, 1].
+	 * @return The color of the value.
+	 */
+	static FLinearColor SamplePlasmaColormap(const double InNormalizedValue);
+
+	/**
+	 * @brief Gets the report of the last leave-one-out analysis.
+	 * @return FPT_LeaveOneOutReport The error report.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	FPT_LeaveOneOutReport GetLeaveOneOutReport() { return this->LeaveOneOutReport; };
+
+	/**
+	 * @brief Searches the electrode plane for the position that maximizes a field metric in the ROI.
+	 *
+	 * A coarse parallel sweep over the grid is refined with the Nelder-Mead method. The objective is evaluated directly
+	 * on the simulation data with the interpolation mode of the electrode area actor, without touching the interpolated
+	 * data arrays. The returned electrodes and weights of that mode can be passed to ProcessWeightedInterpolation to
+	 * display the result.
+	 *
+	 * @param InElectrodeAreaActor The electrode area actor holding the interpolator and the grid frame.
+	 * @param InObjective The objective to maximize.
+	 * @param InTagIndexArray The tags the objective is evaluated on. If empty, all tags are used. Ignored by NormalComponent, which uses the ROI surface.
+	 * @param InThreshold The magnitude threshold of the VolumeAboveThreshold objective.
+	 * @param InDirection The direction of the DirectionalComponent objective.
+	 * @param InSweepResolution The number of sweep nodes along every grid edge.
+	 * @param InMaxIterations The maximum number of Nelder-Mead iterations per start.
+	 * @return FPT_OptimizationResult The optimal position with the electrodes and weights of the interpolation mode there.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	FPT_OptimizationResult OptimizeElectrodePosition(const APT_ElectrodeAreaActor* InElectrodeAreaActor, const EOptimizationObjective InObjective, const TArray<int32>& InTagIndexArray, const double& InThreshold, const FVector& InDirection, const int32& InSweepResolution, const int32& InMaxIterations);
+
+	/**
+	 * @brief Calculates the volume of every tetra of a tag from the tetra data and the volume vertices.
+	 *
+	 * Has to be called after the simulation data is loaded, once per tag. The volumes of the ROI cells weight the
+	 * thresholded volume metrics of every following interpolation, the volumes and centroids of the cells adjacent to a
+	 * vertex the weights of the volume and distance modes of CalculateVertexColors.
+	 *
+	 * @param InTagIndex The index of the data tag.
+	 * @param InTetraDataArray The tetras of the tag, indexed like the cells of the tag.
+	 * @param InVertexArray The vertices the tetra corner indices and the vertex-tag mapping refer to.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void SetTetraVolumesPerTag(const int32& InTagIndex, const TArray<FPT_TetraData>& InTetraDataArray, const TArray<FVector>& InVertexArray);
+
+	/**
+	 * @brief Gets the thresholded volume metrics of the current interpolation result.
+	 * @return FPT_VolumeMetrics The metrics for the thresholds in VolumeThresholdArray.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	FPT_VolumeMetrics GetVolumeMetrics() const;
+
+	/**
+	 * @brief Sets the surface normals used by the normal field analysis of CalculateVertexColors.
+	 *
+	 * The normals are indexed like the mesh vertices. They are copied into a buffer of their own, SetSurfaceMeshBuffer
+	 * shares the normals of a loaded mesh instead. Vertices without a normal are left out of the analysis.
+	 *
+	 * @param InNormalArray The normal of every mesh vertex.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void SetSurfaceNormalArray(const TArray<FVector>& InNormalArray);
+
+	/**
+	 * @brief Shares the mesh buffer of a mesh actor, whose normals are used by the normal field analysis of CalculateVertexColors.
+	 * @param InMeshBuffer The handle returned by APT_Single3DActor::GetMeshBuffer.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void SetSurfaceMeshBuffer(const UPT_MeshBufferHandle* InMeshBuffer);
+
+	/**
+	 * @brief Gets the statistics of the angle between the surface normal and the vector field of the last vertex color pass.
+	 * @return FPT_NormalFieldReport The mean and percentile statistics.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	FPT_NormalFieldReport GetNormalFieldReport() const;
+
+	/**
+	 * @brief Maps the normal field analysis of the last vertex color pass to vertex colors with the plasma colormap.
+	 * @param bInUseAngle Whether the angle is mapped, otherwise the normal component.
+	 * @param InMinValue The value mapped to the lower end of the colormap.
+	 * @param InMaxValue The value mapped to the upper end of the colormap. If not above InMinValue, the data range is used.
+	 * @param InVertexArrayLength The number of mesh vertices.
+	 * @return TArray<FLinearColor> The vertex colors, grey outside the ROI.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	TArray<FLinearColor> MapNormalFieldToVertexColors(const bool& bInUseAngle, const double& InMinValue, const double& InMaxValue, const int32& InVertexArrayLength) const;
+
+	/**
+	 * @brief Calculates the mean normal component over the ROI surface vertices for every electrode alone.
+	 *
+	 * The normal component is linear in the field, so the value at any blend of electrodes is the weighted sum of these
+	 * values. Uses the surface normals and vertex averaging weights of the last vertex color pass.
+	 *
+	 * @param OutValueArray Receives one value per electrode.
+	 * @return True if surface normals and ROI vertices are available.
+	 */
+	bool CalculateElectrodeNormalComponents(TArray<double>& OutValueArray);
+
 	/**
 	 * @brief Calculates the percentile value for the input data.
 	 * @param InData The input data array.
@@ -142,10 +419,59 @@ public:
 
 	/**
 	 * @brief Resets the simulation data arrays.
+	 *
+	 * Discards the active dataset only, the datasets resident in the workspace are kept.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
 	void ResetSimulationDataArrays();
 
+	/**
+	 * @brief Switches the active dataset to another (patient, configuration, ROI) combination.
+	 *
+	 * The active dataset is parked in the workspace. If the requested dataset is resident, it becomes active without
+	 * loading. Otherwise the component is left empty under the new key: load the data with
+	 * GetSimulationDataFromJSONResponseBody without calling ResetSimulationDataArrays in between. Datasets of the same
+	 * patient and ROI share one surface mapping, which is then not parsed again. Interpolation results are discarded
+	 * in both cases. Afterwards, resident datasets are evicted in least recently used order to stay within
+	 * WorkspaceMemoryBudgetMB.
+	 *
+	 * @param InPatientId The patient ID.
+	 * @param InConfigId The configuration ID.
+	 * @param InRoiId The ROI ID.
+	 * @return True if the dataset was resident and is ready, false if it has to be loaded.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	bool SwitchDataset(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId);
+
+	/**
+	 * @brief Removes a dataset from the workspace, or resets the component if it is the active one.
+	 * @param InPatientId The patient ID.
+	 * @param InConfigId The configuration ID.
+	 * @param InRoiId The ROI ID.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void EvictDataset(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId);
+
+	/**
+	 * @brief Removes all inactive datasets from the workspace.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	void ClearWorkspace();
+
+	/**
+	 * @brief Describes the active and all resident datasets with their memory use.
+	 * @return TArray<FPT_WorkspaceEntry> The active dataset first, then the resident ones, most recently used first.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
+	TArray<FPT_WorkspaceEntry> GetWorkspaceEntries() const;
+
+	/**
+	 * @brief Gets the bytes held by the active dataset and the workspace, every surface mapping counted once.
+	 * @return int64 The number of bytes.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	int64 GetWorkspaceAllocatedBytes() const;
+
 	/**
 	 * @brief Sets the data color array for a specific tag.
 	 * @param InDataTagIndex The index of the data tag.
@@ -157,8 +483,8 @@ public:
 	/**
 	 * @brief Calculates the mean angle between normal and vector field.
 	 * @param InNormalArray The array of normal vectors.
-	 * @param InVectorFieldArray The array of vector field vectors.
-	 * @param OutMeanAngle The output mean angle.
+	 * @param InVectorFieldArray The array of vector field vectors, aligned with InNormalArray, e.g. GetVectorfieldInRoi().
+	 * @param OutMeanAngle The output mean angle in degrees, 0 if the arrays are mismatched.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "PT_SIMULATION_DATA")
 	void CalculateMeanAngleBetweenNormalAndVectorField(const TArray<FVector>& InNormalArray, const TArray<FVector>& InVectorFieldArray, double& OutMeanAngle);
@@ -240,25 +566,178 @@ public:
 	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
 	TArray<FVector> GetVectorfieldInRoi() { return this->VectorfieldInRoi; };
 
+	/**
+	 * @brief Gets the angle between the surface normal and the vector field in ROI, aligned with GetVerticesInRoiArray().
+	 * @return TArray<double> The angles in degrees, 90 for vertices without a normal.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	TArray<double> GetNormalAngleInRoi() { return this->NormalAngleInRoi; };
+
+	/**
+	 * @brief Gets the vector field component along the surface normal in ROI, aligned with GetVerticesInRoiArray().
+	 * @return TArray<double> The normal components, 0 for vertices without a normal.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_SIMULATION_DATA")
+	TArray<double> GetNormalComponentInRoi() { return this->NormalComponentInRoi; };
+
 	/** @brief Array of electrode indices. */
 	UPROPERTY(BlueprintReadOnly, Category = "PT_SIMULATION_DATA")
 	TArray<int32> ElectrodeIndexArray;
 
+	/** @brief Whether the simulation data is compressed into a truncated low-rank basis right after loading. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_SIMULATION_DATA")
+	bool bUseLowRankCompression = false;
+
+	/** @brief The maximum rank of the low-rank basis per tag. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_SIMULATION_DATA", meta = (ClampMin = "1", ClampMax = "64"))
+	int32 LowRankMaxRank = 16;
+
+	/** @brief The fraction of the energy of the simulation data that the low-rank basis has to retain. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_SIMULATION_DATA", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	double LowRankEnergyThreshold = 0.9999;
+
+	/** @brief The weighting of the adjacent cells in CalculateVertexColors. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_SIMULATION_DATA")
+	EVertexAveraging VertexAveragingMode = EVertexAveraging::Uniform;
+
+	/** @brief The magnitude thresholds of the volume metrics, evaluated together during every interpolation. Every threshold is evaluated, the first 16 are accumulated on the stack. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_SIMULATION_DATA")
+	TArray<double> VolumeThresholdArray;
+
+	/** @brief The memory budget of the active and all resident datasets in megabytes. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_SIMULATION_DATA", meta = (ClampMin = "0"))
+	int32 WorkspaceMemoryBudgetMB = 4096;
+
 protected:
 	/**
 	 * @brief Called when the game starts.
 	 */
 	virtual void BeginPlay() override;
 
+	/**
+	 * @brief Called when the game ends or the component is destroyed.
+	 * @param EndPlayReason The reason the play ended.
+	 */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
 	/**
-	 * @brief Retrieves simulation data per electrode per tag.
-	 * @param InElectrodeIndex The index of the electrode.
+	 * @brief Blends the simulation data of several electrodes for one tag and scatters it to the full tag length.
+	 * @param InDataTagIndex The index of the data tag.
+	 * @param InElectrodeIndices The indices of the electrodes to blend.
+	 * @param InWeights The weight of every electrode.
+	 * @param InNum The number of electrodes to blend.
+	 * @param OutMagnitudeDataArray The output array for blended magnitude data.
+	 * @param OutVectorfieldDataArray The output array for blended vector field data.
+	 * @param OutMeanMagnitude The output mean magnitude over the ROI cells.
+	 * @param OutMeanVectorField The output mean vector field over the ROI cells.
+	 * @param bInMagnitudeFromVector Whether the magnitude is recomputed from the blended vector instead of being blended.
+	 */
+	void BlendEnsemblePerTag(const int32& InDataTagIndex, const int32* InElectrodeIndices, const double* InWeights, const int32 InNum, TArray<double>& OutMagnitudeDataArray, TArray<FVector>& OutVectorfieldDataArray, double& OutMeanMagnitude, FVector& OutMeanVectorField, const bool bInMagnitudeFromVector = false);
+
+	/**
+	 * @brief Evaluates the current superposition channels for all tags.
+	 */
+	void EvaluateSuperposition();
+
+	/**
+	 * @brief Clears everything derived from the active dataset: interpolation results, colors and reports.
+	 */
+	void ResetDerivedData();
+
+	/** @brief Moves the per configuration data of the active dataset out of the component. */
+	void MoveDatasetTo(FPT_SimulationDataset& OutDataset);
+
+	/** @brief Moves a dataset into the component. */
+	void MoveDatasetFrom(FPT_SimulationDataset&& InDataset);
+
+	/** @brief Moves the surface mapping of the active dataset out of the component. */
+	void MoveSurfaceMappingTo(FPT_SurfaceMapping& OutSurfaceMapping);
+
+	/** @brief Moves a surface mapping into the component. */
+	void MoveSurfaceMappingFrom(FPT_SurfaceMapping&& InSurfaceMapping);
+
+	/** @brief Gets the bytes held by the per configuration data of the active dataset. */
+	int64 GetActiveDatasetBytes() const;
+
+	/** @brief Gets the bytes held by the surface mapping of the active dataset. */
+	int64 GetActiveSurfaceMappingBytes() const;
+
+	/** @brief Gets WorkspaceMemoryBudgetMB in bytes. */
+	int64 GetWorkspaceBudgetBytes() const { return (int64)this->WorkspaceMemoryBudgetMB * 1024 * 1024; }
+
+	/**
+	 * @brief Evicts resident datasets until the active dataset and the workspace fit into the budget.
+	 */
+	void EnforceWorkspaceBudget();
+
+	/** @brief Gets the name the component reports to the memory budget manager under. */
+	FString GetMemoryConsumerName() const { return FString::Printf(TEXT("%s.%s"), *GetNameSafe(this->GetOwner()), *this->GetName()); }
+
+	/**
+	 * @brief Reports the bytes of the active dataset and the workspace to the memory budget manager.
+	 */
+	void ReportMemoryUsage() const;
+
+	/**
+	 * @brief Relief handler of the memory budget manager.
+	 *
+	 * Evicts resident datasets in least recently used order first. If that is not enough, the precision of the active
+	 * dataset is lowered by compressing it into its low-rank basis.
+	 *
+	 * @param InBytesToFree The number of bytes to free.
+	 * @return The number of bytes freed.
+	 */
+	int64 RelieveMemory(const int64 InBytesToFree);
+
+	/**
+	 * @brief A result slot of the difference mode, either a blend of electrodes or a captured result.
+	 */
+	struct FResultSlot
+	{
+		/** Whether the slot is set. */
+		bool bIsSet = false;
+
+		/** Whether the slot holds a captured result instead of a blend. */
+		bool bIsCaptured = false;
+
+		/** Whether the magnitude of the blend is recomputed from the blended vector. */
+		bool bIsSuperposition = false;
+
+		/** The electrode indices of the blend. */
+		TArray<int32> ElectrodeIndexArray;
+
+		/** The weights of the blend. */
+		TArray<double> WeightArray;
+
+		/** The captured channels per tag in [Channel][Cell] layout, in the order of the captured ROI index mapping. */
+		TArray<TArray<double>> ChannelDataPerTagArray;
+
+		/** The ROI index mapping per tag at capture time. */
+		TArray<TArray<int32>> RoiIndexMappingPerTagArray;
+
+		/** The tag lengths at capture time. */
+		TArray<int32> TagLengthArray;
+	};
+
+	/**
+	 * @brief Evaluates a result slot for one tag.
+	 * @param InSlot The slot to evaluate.
 	 * @param InTagIndex The index of the tag.
-	 * @param OutSimulationMagnitudeDataArray The output array for simulation magnitude data.
-	 * @param OutSimulationVectorfieldDataArray The output array for simulation vector field data.
+	 * @param InScratchArray Receives the blended channels of a blend slot.
+	 * @return The channels in [Channel][Cell] layout, nullptr if the slot has no data for the tag.
+	 */
+	const double* EvaluateResultSlot(const FResultSlot& InSlot, const int32 InTagIndex, TArray<double>& InScratchArray) const;
+
+	/**
+	 * @brief Builds the sparse vertex to cell rows from the vertex-tag mapping, one row per vertex in VerticesInRoiArray.
+	 */
+	void BuildVertexCellRows();
+
+	/**
+	 * @brief Normalizes the vertex cell weights of every row for the current VertexAveragingMode.
 	 */
-	void GetSimulationDataPerElectrodePerTag(const int32& InElectrodeIndex, const int32& InTagIndex, TArray<double>& OutSimulationMagnitudeDataArray, TArray<FVector>& OutSimulationVectorfieldDataArray);
+	void UpdateVertexCellWeights();
 
 	/**
 	 * @brief Retrieves interpolated simulation data per tag.
@@ -277,18 +756,51 @@ private:
 	void GetSimulationDataFromJSONObject(const TSharedPtr<FJsonObject>* InJsonObjectPtr, const TArray<FString>& InDataTagArray, const int32& InNumberOfElectrodes);
 
 	/**
-	 * @brief Processes electrode data.
+	 * @brief Completes the load timings with the total time and logs them.
+	 * @param InLoadStart The start time of the load in seconds.
+	 */
+	void FinishLoadTimings(const double InLoadStart);
+
+	/**
+	 * @brief Decodes the data of one electrode straight into its rows of the ensembles.
+	 *
+	 * Only touches the rows of the given electrode, so different electrodes can be processed concurrently.
+	 *
 	 * @param InJsonObjectPtr The JSON object pointer.
 	 * @param InDataTagArray The array of data tags.
 	 * @param InCurrentElectrodeIndex The current electrode index.
 	 */
 	void ProcessElectrodeData(const TSharedPtr<FJsonObject>* InJsonObjectPtr, const TArray<FString>& InDataTagArray, const int32& InCurrentElectrodeIndex);
 
-	/** @brief Array of simulation magnitude data per electrode per tag. */
-	TArray<TArray<TArray<double>>> SimulationMagnitudeDataPerElectrodePerTagArray;
+	/** @brief Array of simulation data ensembles per tag, holding the ROI cells of all electrodes. */
+	TArray<FPT_TagEnsemble> EnsemblePerTagArray;
+
+	/** @brief Report of the last low-rank compression. */
+	FPT_LowRankReport LowRankReport;
+
+	/** @brief Per stage timing breakdown of the last simulation data load. */
+	FPT_LoadTimings LoadTimings;
+
+	/** @brief Report of the last leave-one-out analysis. */
+	FPT_LeaveOneOutReport LeaveOneOutReport;
+
+	/** @brief Volume of every ROI cell per tag, in ensemble order. Empty for tags without tetra volumes. */
+	TArray<TArray<float>> RoiCellVolumePerTagArray;
 
-	/** @brief Array of simulation vector field data per electrode per tag. */
-	TArray<TArray<TArray<FVector>>> SimulationVectorfieldDataPerElectrodePerTagArray;
+	/** @brief Volume of the whole tag per tag, 0 for tags without tetra volumes. */
+	TArray<double> TagVolumePerTagArray;
+
+	/** @brief Volume metrics per tag, accumulated during the interpolation pass. */
+	FPT_VolumeMetrics VolumeMetrics;
+
+	/** @brief Scratch buffer for blending, in [Channel][Cell] layout. */
+	TArray<double> BlendScratchArray;
+
+	/** @brief Electrode index of every superposition channel. */
+	TArray<int32> SuperpositionElectrodeIndexArray;
+
+	/** @brief Current amplitude of every superposition channel. */
+	TArray<double> SuperpositionAmplitudeArray;
 
 	/** @brief Array of interpolated magnitude data per tag. */
 	TArray<TArray<double>> InterpolatedMagnitudeDataPerTagArray;
@@ -326,9 +838,81 @@ private:
 	/** @brief Array of vertices in ROI. */
 	TArray<int32> VerticesInRoiArray;
 
+	/** @brief Offset of the first entry of every vertex row, one more than rows, rows follow VerticesInRoiArray. */
+	TArray<int32> VertexCellRowOffsetArray;
+
+	/** @brief Tag index of every vertex cell entry. */
+	TArray<uint8> VertexCellTagArray;
+
+	/** @brief Cell index of every vertex cell entry. */
+	TArray<int32> VertexCellIndexArray;
+
+	/** @brief Tetra volume of every vertex cell entry, negative while unknown. */
+	TArray<float> VertexCellVolumeArray;
+
+	/** @brief Distance between the vertex and the cell centroid of every vertex cell entry, negative while unknown. */
+	TArray<float> VertexCellDistanceArray;
+
+	/** @brief Normalized weight of every vertex cell entry for VertexCellWeightMode. */
+	TArray<float> VertexCellWeightArray;
+
+	/** @brief The averaging mode VertexCellWeightArray was normalized for. */
+	EVertexAveraging VertexCellWeightMode = EVertexAveraging::Uniform;
+
+	/** @brief Whether VertexCellWeightArray has to be normalized again. */
+	bool bVertexCellWeightsDirty = true;
+
 	/** @brief Array of data color arrays per tag. */
 	TArray<TArray<FLinearColor>> DataColorArrayPerTag;
 
 	/** @brief Array of vector fields in ROI. */
 	TArray<FVector> VectorfieldInRoi;
+
+	/** @brief The surface mesh whose normals are used, usually shared with the mesh actor. */
+	FPT_MeshBufferPtr SurfaceMesh;
+
+	/** @brief Gets the surface normal of every mesh vertex, empty if no surface mesh is set. */
+	const TArray<FVector>& GetSurfaceNormalArray() const { return this->SurfaceMesh.IsValid() ? this->SurfaceMesh->GetNormalArray() : FPT_MeshBuffer::GetEmpty().GetNormalArray(); }
+
+	/** @brief Angle between the surface normal and the vector field in ROI, in degrees. */
+	TArray<double> NormalAngleInRoi;
+
+	/** @brief Vector field component along the surface normal in ROI. */
+	TArray<double> NormalComponentInRoi;
+
+	/** @brief Whether the vertex in ROI has a surface normal and a field, aligned with VerticesInRoiArray. */
+	TBitArray<> NormalValidInRoi;
+
+	/** @brief Mean statistics of the last vertex color pass, the percentiles are added on request. */
+	FPT_NormalFieldReport NormalFieldReport;
+
+	/** @brief The result slots A and B of the difference mode. */
+	FResultSlot ResultSlotArray[2];
+
+	/** @brief Magnitude difference per tag of the last ProcessDifference call. */
+	TArray<TArray<double>> DifferenceMagnitudeDataPerTagArray;
+
+	/** @brief Vector field difference per tag of the last ProcessDifference call. */
+	TArray<TArray<FVector>> DifferenceVectorfieldDataPerTagArray;
+
+	/** @brief ROI index mapping per tag the last ProcessDifference call was evaluated on. */
+	TArray<TArray<int32>> DifferenceRoiIndexMappingPerTagArray;
+
+	/** @brief Statistics of the last ProcessDifference call. */
+	FPT_DifferenceReport DifferenceReport;
+
+	/** @brief The resident inactive datasets. */
+	FPT_SimulationWorkspace Workspace;
+
+	/** @brief The patient ID of the active dataset, empty if it was loaded without SwitchDataset. */
+	FString ActivePatientId;
+
+	/** @brief The configuration ID of the active dataset. */
+	FString ActiveConfigId;
+
+	/** @brief The ROI ID of the active dataset. */
+	FString ActiveRoiId;
+
+	/** @brief Whether the surface mapping of the active dataset was shared from the workspace and must not be parsed again. */
+	bool bSurfaceMappingResident = false;
 };
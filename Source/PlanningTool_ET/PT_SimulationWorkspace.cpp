@@ -0,0 +1,173 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+
+#include "PT_SimulationWorkspace.h"
+
+SIZE_T FPT_SurfaceMapping::GetAllocatedSize() const
+{
+	SIZE_T Size = this->VertexTagCellMapping.GetAllocatedSize();
+	for (const TPair<int32, TArray<TArray<int32>>>& Pair : this->VertexTagCellMapping)
+	{
+		Size += Pair.Value.GetAllocatedSize();
+		for (const TArray<int32>& CellIndices : Pair.Value)
+		{
+			Size += CellIndices.GetAllocatedSize();
+		}
+	}
+
+	return Size
+		+ this->VerticesInRoiArray.GetAllocatedSize()
+		+ this->VertexCellRowOffsetArray.GetAllocatedSize()
+		+ this->VertexCellTagArray.GetAllocatedSize()
+		+ this->VertexCellIndexArray.GetAllocatedSize()
+		+ this->VertexCellVolumeArray.GetAllocatedSize()
+		+ this->VertexCellDistanceArray.GetAllocatedSize()
+		+ FPT_MeshBuffer::GetUnsharedSize(this->SurfaceMesh);
+}
+
+SIZE_T FPT_SimulationDataset::GetAllocatedSize() const
+{
+	SIZE_T Size = this->EnsemblePerTagArray.GetAllocatedSize() + this->TagLengthArray.GetAllocatedSize() + this->TagVolumePerTagArray.GetAllocatedSize();
+	for (const FPT_TagEnsemble& Ensemble : this->EnsemblePerTagArray)
+	{
+		Size += Ensemble.GetAllocatedSize();
+	}
+	for (const TArray<int32>& RoiIndexMapping : this->RoiIndexMappingPerTagArray)
+	{
+		Size += RoiIndexMapping.GetAllocatedSize();
+	}
+	for (const TArray<float>& RoiCellVolumes : this->RoiCellVolumePerTagArray)
+	{
+		Size += RoiCellVolumes.GetAllocatedSize();
+	}
+	return Size;
+}
+
+void FPT_SimulationWorkspace::Store(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId, FPT_SimulationDataset&& InDataset)
+{
+	FEntry& Entry = this->EntryMap.FindOrAdd(MakeKey(InPatientId, InConfigId, InRoiId));
+	Entry.PatientId = InPatientId;
+	Entry.ConfigId = InConfigId;
+	Entry.RoiId = InRoiId;
+	Entry.Dataset = MoveTemp(InDataset);
+	Entry.LastUsed = ++this->UseCounter;
+}
+
+bool FPT_SimulationWorkspace::Take(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId, FPT_SimulationDataset& OutDataset)
+{
+	FEntry Entry;
+	if (!this->EntryMap.RemoveAndCopyValue(MakeKey(InPatientId, InConfigId, InRoiId), Entry))
+	{
+		return false;
+	}
+
+	OutDataset = MoveTemp(Entry.Dataset);
+	return true;
+}
+
+void FPT_SimulationWorkspace::StoreSurface(const FString& InPatientId, const FString& InRoiId, FPT_SurfaceMapping&& InSurfaceMapping)
+{
+	this->SurfaceMap.FindOrAdd(MakeSurfaceKey(InPatientId, InRoiId)) = MoveTemp(InSurfaceMapping);
+}
+
+bool FPT_SimulationWorkspace::TakeSurface(const FString& InPatientId, const FString& InRoiId, FPT_SurfaceMapping& OutSurfaceMapping)
+{
+	return this->SurfaceMap.RemoveAndCopyValue(MakeSurfaceKey(InPatientId, InRoiId), OutSurfaceMapping);
+}
+
+bool FPT_SimulationWorkspace::Remove(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId)
+{
+	const bool bRemoved = this->EntryMap.Remove(MakeKey(InPatientId, InConfigId, InRoiId)) > 0;
+	this->RemoveUnreferencedSurfaces();
+	return bRemoved;
+}
+
+int32 FPT_SimulationWorkspace::Evict(const int64 InActiveBytes, const int64 InBudgetBytes)
+{
+	this->RemoveUnreferencedSurfaces();
+
+	int32 NumEvicted = 0;
+	while (!this->EntryMap.IsEmpty() && InActiveBytes + this->GetAllocatedSize() > InBudgetBytes)
+	{
+		const FString* OldestKey = nullptr;
+		uint64 OldestUse = MAX_uint64;
+		for (const TPair<FString, FEntry>& Pair : this->EntryMap)
+		{
+			if (Pair.Value.LastUsed < OldestUse)
+			{
+				OldestUse = Pair.Value.LastUsed;
+				OldestKey = &Pair.Key;
+			}
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("[FPT_SimulationWorkspace::Evict] Evicting %s to stay within %lld bytes."), **OldestKey, InBudgetBytes);
+		this->EntryMap.Remove(FString(*OldestKey));
+		this->RemoveUnreferencedSurfaces();
+		NumEvicted++;
+	}
+	return NumEvicted;
+}
+
+void FPT_SimulationWorkspace::Empty()
+{
+	this->EntryMap.Empty();
+	this->SurfaceMap.Empty();
+}
+
+int64 FPT_SimulationWorkspace::GetAllocatedSize() const
+{
+	int64 Size = 0;
+	for (const TPair<FString, FEntry>& Pair : this->EntryMap)
+	{
+		Size += Pair.Value.Dataset.GetAllocatedSize();
+	}
+	for (const TPair<FString, FPT_SurfaceMapping>& Pair : this->SurfaceMap)
+	{
+		Size += Pair.Value.GetAllocatedSize();
+	}
+	return Size;
+}
+
+void FPT_SimulationWorkspace::GetEntries(TArray<FPT_WorkspaceEntry>& OutEntryArray) const
+{
+	TArray<const FEntry*> SortedEntries;
+	for (const TPair<FString, FEntry>& Pair : this->EntryMap)
+	{
+		SortedEntries.Add(&Pair.Value);
+	}
+	SortedEntries.Sort([](const FEntry& A, const FEntry& B) { return A.LastUsed > B.LastUsed; });
+
+	for (const FEntry* Entry : SortedEntries)
+	{
+		FPT_WorkspaceEntry& Info = OutEntryArray.AddDefaulted_GetRef();
+		Info.PatientId = Entry->PatientId;
+		Info.ConfigId = Entry->ConfigId;
+		Info.RoiId = Entry->RoiId;
+		Info.DatasetBytes = Entry->Dataset.GetAllocatedSize();
+
+		const FPT_SurfaceMapping* SurfaceMapping = this->SurfaceMap.Find(MakeSurfaceKey(Entry->PatientId, Entry->RoiId));
+		Info.SurfaceBytes = SurfaceMapping ? SurfaceMapping->GetAllocatedSize() : 0;
+		Info.bIsCompressed = !Entry->Dataset.EnsemblePerTagArray.IsEmpty() && Entry->Dataset.EnsemblePerTagArray[0].IsCompressed();
+	}
+}
+
+void FPT_SimulationWorkspace::RemoveUnreferencedSurfaces()
+{
+	for (auto It = this->SurfaceMap.CreateIterator(); It; ++It)
+	{
+		bool bIsReferenced = false;
+		for (const TPair<FString, FEntry>& Pair : this->EntryMap)
+		{
+			if (MakeSurfaceKey(Pair.Value.PatientId, Pair.Value.RoiId) == It.Key())
+			{
+				bIsReferenced = true;
+				break;
+			}
+		}
+
+		if (!bIsReferenced)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
@@ -0,0 +1,188 @@
+// Copyright (C) 2025 David Hasse - All Rights Reserved
+
+/**
+ * @file PT_SimulationWorkspace.h
+ * @brief Header file for the FPT_SimulationWorkspace class.
+ *
+ * This file contains the declaration of the FPT_SimulationWorkspace class, which keeps the simulation data of several
+ * (patient, configuration, ROI) combinations resident, so the simulation component can switch between them without
+ * loading them again.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PT_ElectrodeEnsemble.h"
+#include "PT_StructContainer.h"
+#include "PT_MeshBuffer.h"
+
+/**
+ * @struct FPT_SurfaceMapping
+ * @brief The mapping between the surface vertices of a patient mesh and the cells of a ROI.
+ *
+ * The mapping only depends on the patient and the ROI, so all configurations of the same patient and ROI share one.
+ */
+struct PLANNINGTOOL_ET_API FPT_SurfaceMapping
+{
+	/** @brief Cell indices per tag of every vertex in the ROI. */
+	TMap<int32, TArray<TArray<int32>>> VertexTagCellMapping;
+
+	/** @brief The vertices in the ROI. */
+	TArray<int32> VerticesInRoiArray;
+
+	/** @brief Offset of the first entry of every vertex row, rows follow VerticesInRoiArray. */
+	TArray<int32> VertexCellRowOffsetArray;
+
+	/** @brief Tag index of every vertex cell entry. */
+	TArray<uint8> VertexCellTagArray;
+
+	/** @brief Cell index of every vertex cell entry. */
+	TArray<int32> VertexCellIndexArray;
+
+	/** @brief Tetra volume of every vertex cell entry, negative while unknown. */
+	TArray<float> VertexCellVolumeArray;
+
+	/** @brief Distance between the vertex and the cell centroid of every vertex cell entry, negative while unknown. */
+	TArray<float> VertexCellDistanceArray;
+
+	/** @brief The surface mesh whose normals are used, usually shared with the mesh actor. */
+	FPT_MeshBufferPtr SurfaceMesh;
+
+	/** @brief Gets the number of bytes held by the mapping. */
+	SIZE_T GetAllocatedSize() const;
+};
+
+/**
+ * @struct FPT_SimulationDataset
+ * @brief The simulation data of one (patient, configuration, ROI) combination.
+ */
+struct PLANNINGTOOL_ET_API FPT_SimulationDataset
+{
+	/** @brief Simulation data of all electrodes per tag. */
+	TArray<FPT_TagEnsemble> EnsemblePerTagArray;
+
+	/** @brief ROI index mapping per tag. */
+	TArray<TArray<int32>> RoiIndexMappingPerTagArray;
+
+	/** @brief Number of cells per tag. */
+	TArray<int32> TagLengthArray;
+
+	/** @brief Error report of the low-rank compression. */
+	FPT_LowRankReport LowRankReport;
+
+	/** @brief Volume of every ROI cell per tag, in ensemble order. */
+	TArray<TArray<float>> RoiCellVolumePerTagArray;
+
+	/** @brief Volume of the whole tag per tag. */
+	TArray<double> TagVolumePerTagArray;
+
+	/** @brief Gets the number of bytes held by the dataset, without the shared surface mapping. */
+	SIZE_T GetAllocatedSize() const;
+};
+
+/**
+ * @class FPT_SimulationWorkspace
+ * @brief Keeps inactive simulation datasets and surface mappings resident.
+ *
+ * The active dataset lives in the simulation component, the workspace holds all others. Datasets and surface mappings
+ * are moved in and out, so switching costs no copies. A surface mapping exists only once: either checked out by the
+ * active dataset or held here under its (patient, ROI) key for the datasets that refer to it. Datasets are evicted in
+ * least recently used order once the resident data exceeds a memory budget, surface mappings as soon as no resident
+ * dataset refers to them anymore.
+ */
+class PLANNINGTOOL_ET_API FPT_SimulationWorkspace
+{
+public:
+	/**
+	 * @brief Moves a dataset into the workspace and marks it as most recently used. Replaces a dataset with the same key.
+	 * @param InPatientId The patient ID.
+	 * @param InConfigId The configuration ID.
+	 * @param InRoiId The ROI ID.
+	 * @param InDataset The dataset, left empty.
+	 */
+	void Store(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId, FPT_SimulationDataset&& InDataset);
+
+	/**
+	 * @brief Moves a dataset out of the workspace.
+	 * @param InPatientId The patient ID.
+	 * @param InConfigId The configuration ID.
+	 * @param InRoiId The ROI ID.
+	 * @param OutDataset Receives the dataset.
+	 * @return True if the dataset was resident.
+	 */
+	bool Take(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId, FPT_SimulationDataset& OutDataset);
+
+	/**
+	 * @brief Moves a surface mapping into the workspace. Replaces a mapping with the same key.
+	 * @param InPatientId The patient ID.
+	 * @param InRoiId The ROI ID.
+	 * @param InSurfaceMapping The surface mapping, left empty.
+	 */
+	void StoreSurface(const FString& InPatientId, const FString& InRoiId, FPT_SurfaceMapping&& InSurfaceMapping);
+
+	/**
+	 * @brief Moves a surface mapping out of the workspace.
+	 * @param InPatientId The patient ID.
+	 * @param InRoiId The ROI ID.
+	 * @param OutSurfaceMapping Receives the surface mapping.
+	 * @return True if the surface mapping was resident.
+	 */
+	bool TakeSurface(const FString& InPatientId, const FString& InRoiId, FPT_SurfaceMapping& OutSurfaceMapping);
+
+	/**
+	 * @brief Removes a dataset.
+	 * @return True if the dataset was resident.
+	 */
+	bool Remove(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId);
+
+	/**
+	 * @brief Evicts the least recently used datasets until the resident data fits into the budget.
+	 * @param InActiveBytes The bytes held by the active dataset and its surface mapping, counted against the budget.
+	 * @param InBudgetBytes The memory budget.
+	 * @return The number of evicted datasets.
+	 */
+	int32 Evict(const int64 InActiveBytes, const int64 InBudgetBytes);
+
+	/**
+	 * @brief Removes all datasets and surface mappings.
+	 */
+	void Empty();
+
+	/** @brief Gets the number of bytes held by all resident datasets and surface mappings. */
+	int64 GetAllocatedSize() const;
+
+	/**
+	 * @brief Describes every resident dataset, most recently used first.
+	 * @param OutEntryArray Receives one entry per dataset.
+	 */
+	void GetEntries(TArray<FPT_WorkspaceEntry>& OutEntryArray) const;
+
+private:
+	/** @brief A resident dataset. */
+	struct FEntry
+	{
+		FString PatientId;
+		FString ConfigId;
+		FString RoiId;
+		FPT_SimulationDataset Dataset;
+		uint64 LastUsed = 0;
+	};
+
+	/** @brief Builds the key of a dataset. */
+	static FString MakeKey(const FString& InPatientId, const FString& InConfigId, const FString& InRoiId) { return InPatientId + TEXT("|") + InConfigId + TEXT("|") + InRoiId; }
+
+	/** @brief Builds the key of a surface mapping. */
+	static FString MakeSurfaceKey(const FString& InPatientId, const FString& InRoiId) { return InPatientId + TEXT("|") + InRoiId; }
+
+	/** @brief Removes the surface mappings no resident dataset refers to. */
+	void RemoveUnreferencedSurfaces();
+
+	/** @brief The resident datasets by key. */
+	TMap<FString, FEntry> EntryMap;
+
+	/** @brief The resident surface mappings by key. */
+	TMap<FString, FPT_SurfaceMapping> SurfaceMap;
+
+	/** @brief Counter for the least recently used order. */
+	uint64 UseCounter = 0;
+};
@@ -3,6 +3,9 @@
 
 #include "PT_Single3DActor.h"
 #include "PT_JSONConverter.h"
+#include "PT_MemoryBudgetManager.h"
+#include "Async/Async.h"
+#include "ProceduralMeshComponent.h"
 
 // Sets default values
 APT_Single3DActor::APT_Single3DActor()
@@ -18,6 +21,17 @@ void APT_Single3DActor::BeginPlay()
 	
 }
 
+// Called when the actor is removed from the world
+void APT_Single3DActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	this->CancelMeshLODs();
+	UPT_MemoryBudgetManager::ReleaseUsage(this->GetMemoryConsumerName(EMemorySubsystem::Mesh));
+	UPT_MemoryBudgetManager::ReleaseUsage(this->GetMemoryConsumerName(EMemorySubsystem::Tetra));
+	UPT_MemoryBudgetManager::ReleaseUsage(this->GetMemoryConsumerName(EMemorySubsystem::PointCloud));
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void APT_Single3DActor::Tick(float DeltaTime)
 {
@@ -27,7 +41,7 @@ void APT_Single3DActor::Tick(float DeltaTime)
 
 TArray<FVector> APT_Single3DActor::GetVertexArray() const
 {
-	return this->VertexArray;
+	return this->GetMesh().GetVertexArray();
 }
 
 TArray<FLinearColor> APT_Single3DActor::GetVertexColorArray() const
@@ -37,12 +51,12 @@ TArray<FLinearColor> APT_Single3DActor::GetVertexColorArray() const
 
 TArray<int32> APT_Single3DActor::GetTriangleIndexArray() const
 {
-	return this->TriangleIndexArray;
+	return this->GetMesh().GetTriangleIndexArray();
 }
 
 TArray<FVector> APT_Single3DActor::GetNormalArray() const
 {
-	return this->NormalArray;
+	return this->GetMesh().GetNormalArray();
 }
 
 void APT_Single3DActor::CreatePointCloudArray(const TArray<int32>& InVertexIndexArray, const TArray<FVector>& InVertexArray, const TArray<FLinearColor>& InVertexColorArray, TArray<FLidarPointCloudPoint>& OutPointCloudArray)
@@ -69,42 +83,102 @@ void APT_Single3DActor::ConvertJSONResponseBodyToMesh(const UPT_HTTPComponent* I
 {
 	OutVertexArray.Empty();
 	OutTriangleIndexArray.Empty();
+	OutNormalArray.Empty();
 
-	this->VertexArray.Empty();
+	this->ResetMeshBuffer();
+	this->ResetMeshLODs();
+	this->ReportMemoryUsage();
 
-	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", this->VertexArray);
-	OutVertexArray = this->VertexArray;
-	this->InitWhiteVertexColor(this->VertexArray.Num(), 0.5f);
-	UPT_JSONConverter::ConvertJSONResponseBodyToTriangleIndexArray(InHTTPComponent, "triangles", this->TriangleIndexArray);
-	OutTriangleIndexArray = this->TriangleIndexArray;
-	
-	this->CalculateInvertedNormals(this->VertexArray, this->TriangleIndexArray, OutNormalArray);
+	if (!this->RequestMeshAllocation(InHTTPComponent))
+	{
+		return;
+	}
+
+	// The loaded arrays are moved into the shared buffer, the outputs only get copies if requested
+	TArray<FVector> LoadedVertexArray;
+	TArray<int32> LoadedTriangleIndexArray;
+	TArray<FVector> LoadedNormalArray;
+	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", LoadedVertexArray);
+	this->InitWhiteVertexColor(LoadedVertexArray.Num(), 0.5f);
+	UPT_JSONConverter::ConvertJSONResponseBodyToTriangleIndexArray(InHTTPComponent, "triangles", LoadedTriangleIndexArray);
+	this->CalculateInvertedNormals(LoadedVertexArray, LoadedTriangleIndexArray, LoadedNormalArray);
+	this->SetMeshBuffer(MoveTemp(LoadedVertexArray), MoveTemp(LoadedNormalArray), MoveTemp(LoadedTriangleIndexArray));
+
+	const FPT_MeshBuffer& Mesh = this->GetMesh();
+	if (this->bOutputMeshArrays)
+	{
+		OutVertexArray = Mesh.GetVertexArray();
+		OutTriangleIndexArray = Mesh.GetTriangleIndexArray();
+		OutNormalArray = Mesh.GetNormalArray();
+	}
+
+	this->MeshBVH.Build(Mesh.GetVertexArray(), Mesh.GetTriangleIndexArray());
+	this->ResetGeodesicDistance();
+	this->ReportMemoryUsage();
 
 	this->MeshDataLoadedCallbackEvent.Broadcast();
+
+	if (this->bGenerateMeshLODs)
+	{
+		this->GenerateMeshLODs();
+	}
 }
 
 void APT_Single3DActor::ConvertJSONResponseBodyToVolume(const UPT_HTTPComponent* InHTTPComponent, TArray<FLidarPointCloudPoint>& OutPointCloudArray)
 {
 	OutPointCloudArray.Empty();
 
-	this->VertexArray.Empty();
+	this->ResetMeshBuffer();
+	this->PointCloudBytes = 0;
+	this->ReportMemoryUsage();
 
-	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", this->VertexArray);
-	this->InitWhiteVertexColor(this->VertexArray.Num(), 0.5f);
+	if (!this->RequestMeshAllocation(InHTTPComponent))
+	{
+		return;
+	}
+
+	TArray<FVector> LoadedVertexArray;
+	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, "vertices", LoadedVertexArray);
+	this->InitWhiteVertexColor(LoadedVertexArray.Num(), 0.5f);
+	this->SetMeshBuffer(MoveTemp(LoadedVertexArray), TArray<FVector>(), TArray<int32>());
 
 	TArray<int32> VertexIndexArray;
 	UPT_JSONConverter::ConvertJSONResponseBodyToIntegerArray(InHTTPComponent, "volume", VertexIndexArray);
 
-	this->CreatePointCloudArray(VertexIndexArray, this->VertexArray, this->VertexColorArray, OutPointCloudArray);
+	this->GetMesh().CreatePointCloudArray(VertexIndexArray, this->VertexColorArray, OutPointCloudArray);
+	this->PointCloudBytes = OutPointCloudArray.GetAllocatedSize();
+	this->ReportMemoryUsage();
 
 	this->VolumeDataLoadedCallbackEvent.Broadcast();
 }
 
 void APT_Single3DActor::SetVertexArrayFromJSONResponseBody(const UPT_HTTPComponent* InHTTPComponent, const FString& InFieldName, TArray<FVector>& OutVertexArray)
 {
-	this->VertexArray.Empty();
-	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, InFieldName, this->VertexArray);
-	OutVertexArray = this->VertexArray;
+	OutVertexArray.Empty();
+
+	// The buffer is immutable, so the new vertices get a new buffer with the current normals and triangles
+	TArray<FVector> LoadedVertexArray;
+	UPT_JSONConverter::ConvertJSONResponseBodyToVectorArray(InHTTPComponent, InFieldName, LoadedVertexArray);
+	const FPT_MeshBuffer& PreviousMesh = this->GetMesh();
+	TArray<FVector> NormalArray = PreviousMesh.GetNormalArray().Num() == LoadedVertexArray.Num() ? PreviousMesh.GetNormalArray() : TArray<FVector>();
+	TArray<int32> TriangleIndexArray = PreviousMesh.GetTriangleIndexArray();
+	this->SetMeshBuffer(MoveTemp(LoadedVertexArray), MoveTemp(NormalArray), MoveTemp(TriangleIndexArray));
+
+	// Raycasts, geodesics and levels of detail have to follow the moved vertices
+	this->MeshBVH.Build(this->GetMesh().GetVertexArray(), this->GetMesh().GetTriangleIndexArray());
+	this->ResetGeodesicDistance();
+	this->ResetMeshLODs();
+	this->ReportMemoryUsage();
+
+	if (this->bOutputMeshArrays)
+	{
+		OutVertexArray = this->GetMesh().GetVertexArray();
+	}
+
+	if (this->bGenerateMeshLODs)
+	{
+		this->GenerateMeshLODs();
+	}
 }
 
 void APT_Single3DActor::SetVertexColorArrayFromJSONResponseBody(const UPT_HTTPComponent* InHTTPComponent, const FString& InFieldName, TArray<FLinearColor>& InVertexColorArray)
@@ -115,69 +189,694 @@ void APT_Single3DActor::SetVertexColorArrayFromJSONResponseBody(const UPT_HTTPCo
 }
 
 //Function which calculates the normals from the VertexArray
-void APT_Single3DActor::CalculateNormals(const TArray<FVector>& InVertexArray, const TArray<int32> InTriangleIndexArray, TArray<FVector>& OutNormalArray)
+void APT_Single3DActor::CalculateNormals(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray, TArray<FVector>& OutNormalArray)
+{
+	FPT_MeshNormals::Calculate(InVertexArray, InTriangleIndexArray, this->NormalWeighting, false, OutNormalArray);
+}
+
+//Function which calculates the inverted normals from the VertexArray
+void APT_Single3DActor::CalculateInvertedNormals(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray, TArray<FVector>& OutInvertedNormalArray)
+{
+	FPT_MeshNormals::Calculate(InVertexArray, InTriangleIndexArray, this->NormalWeighting, true, OutInvertedNormalArray);
+}
+
+void APT_Single3DActor::BenchmarkNormals(const int32& InIterations, double& OutScatterMilliseconds, double& OutGatherMilliseconds, double& OutBuildMilliseconds, double& OutMaxDeviation) const
 {
-	OutNormalArray.Init(FVector(0.0f, 0.0f, 0.0f), InVertexArray.Num());
+	OutScatterMilliseconds = 0.0;
+	OutGatherMilliseconds = 0.0;
+	OutBuildMilliseconds = 0.0;
+	OutMaxDeviation = 0.0;
+	const TArray<FVector>& VertexArray = this->GetMesh().GetVertexArray();
+	const TArray<int32>& TriangleIndexArray = this->GetMesh().GetTriangleIndexArray();
+	if (VertexArray.IsEmpty() || InIterations <= 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::BenchmarkNormals] No mesh is loaded!"));
+		return;
+	}
 
-	for (int32 i = 0; i < InTriangleIndexArray.Num(); i += 3)
-	{									
-		FVector Vertex0 = InVertexArray[InTriangleIndexArray[i]];
-		FVector Vertex1 = InVertexArray[InTriangleIndexArray[i + 1]];
-		FVector Vertex2 = InVertexArray[InTriangleIndexArray[i + 2]];
+	TArray<FVector> ScatterNormals;
+	double StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < InIterations; Iteration++)
+	{
+		FPT_MeshNormals::CalculateByScattering(VertexArray, TriangleIndexArray, true, ScatterNormals);
+	}
+	OutScatterMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0 / InIterations;
 
-		FVector Edge1 = Vertex1 - Vertex0;
-		FVector Edge2 = Vertex2 - Vertex0;
+	FPT_MeshNormals Kernel;
+	StartTime = FPlatformTime::Seconds();
+	Kernel.Build(VertexArray.Num(), TriangleIndexArray);
+	OutBuildMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
 
-		FVector Normal = FVector::CrossProduct(Edge1, Edge2);
+	TArray<FVector> GatherNormals;
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < InIterations; Iteration++)
+	{
+		Kernel.Compute(VertexArray, ENormalWeighting::Area, true, GatherNormals);
+	}
+	OutGatherMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0 / InIterations;
 
-		OutNormalArray[InTriangleIndexArray[i]] += Normal;
-		OutNormalArray[InTriangleIndexArray[i + 1]] += Normal;
-		OutNormalArray[InTriangleIndexArray[i + 2]] += Normal;
+	for (int32 Vertex = 0; Vertex < VertexArray.Num(); Vertex++)
+	{
+		OutMaxDeviation = FMath::Max(OutMaxDeviation, FVector::Dist(ScatterNormals[Vertex], GatherNormals[Vertex]));
+	}
+	if (OutMaxDeviation > 1e-6)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("[APT_Single3DActor::BenchmarkNormals] The normals deviate by up to %f."), OutMaxDeviation);
 	}
 
-	for (int32 i = 0; i < OutNormalArray.Num(); i++)
+	UE_LOG(LogTemp, Log, TEXT("[APT_Single3DActor::BenchmarkNormals] %d vertices: scatter %.3f ms, gather %.3f ms, adjacency %.3f ms."), VertexArray.Num(), OutScatterMilliseconds, OutGatherMilliseconds, OutBuildMilliseconds);
+}
+
+void APT_Single3DActor::ResetSingle3DActorArrays()
+{
+	this->ResetMeshBuffer();
+	this->VertexColorArray.Empty();
+	this->MeshBVH.Reset();
+	this->ResetGeodesicDistance();
+	this->ResetMeshLODs();
+	this->PointCloudBytes = 0;
+	this->ReportMemoryUsage();
+}
+
+void APT_Single3DActor::RaycastMeshBatch(const TArray<FVector>& InOrigins, const TArray<FVector>& InDirections, const double& InMaxDistance, TArray<FVector>& OutPositions, TArray<FVector>& OutNormals, TArray<bool>& OutHits) const
+{
+	const FTransform& ActorTransform = this->GetActorTransform();
+	TArray<FVector> LocalOrigins;
+	TArray<FVector> LocalDirections;
+	LocalOrigins.SetNumUninitialized(InOrigins.Num());
+	LocalDirections.SetNumUninitialized(InDirections.Num());
+	for (int32 i = 0; i < InOrigins.Num(); i++)
+	{
+		LocalOrigins[i] = ActorTransform.InverseTransformPosition(InOrigins[i]);
+	}
+	for (int32 i = 0; i < InDirections.Num(); i++)
 	{
-		OutNormalArray[i].Normalize();
+		LocalDirections[i] = ActorTransform.InverseTransformVector(InDirections[i]);
 	}
+
+	// The ray length is measured in world space, a uniformly scaled actor shortens it in actor space
+	const double Scale = ActorTransform.GetMaximumAxisScale();
+	TArray<FPT_MeshHit> Hits;
+	this->MeshBVH.RaycastBatch(LocalOrigins, LocalDirections, Scale > 0.0 ? InMaxDistance / Scale : InMaxDistance, Hits);
+	this->ConvertMeshHits(Hits, OutPositions, OutNormals, OutHits);
 }
 
-//Function which calculates the inverted normals from the VertexArray
-void APT_Single3DActor::CalculateInvertedNormals(const TArray<FVector>& InVertexArray, const TArray<int32> InTriangleIndexArray, TArray<FVector>& OutInvertedNormalArray)
+void APT_Single3DActor::FindClosestMeshPointsBatch(const TArray<FVector>& InPoints, const double& InMaxDistance, TArray<FVector>& OutPositions, TArray<FVector>& OutNormals, TArray<bool>& OutHits) const
 {
-	OutInvertedNormalArray.Init(FVector(0.0f, 0.0f, 0.0f), InVertexArray.Num());
+	const FTransform& ActorTransform = this->GetActorTransform();
+	TArray<FVector> LocalPoints;
+	LocalPoints.SetNumUninitialized(InPoints.Num());
+	for (int32 i = 0; i < InPoints.Num(); i++)
+	{
+		LocalPoints[i] = ActorTransform.InverseTransformPosition(InPoints[i]);
+	}
 
+	const double Scale = ActorTransform.GetMaximumAxisScale();
+	TArray<FPT_MeshHit> Hits;
+	this->MeshBVH.FindClosestPointBatch(LocalPoints, Scale > 0.0 ? InMaxDistance / Scale : InMaxDistance, Hits);
+	this->ConvertMeshHits(Hits, OutPositions, OutNormals, OutHits);
+}
 
-	for (int32 i = 0; i < InTriangleIndexArray.Num(); i += 3)
+void APT_Single3DActor::ProjectPointsOntoMesh(const TArray<FVector>& InPoints, const FVector& InDirection, TArray<FVector>& OutPositions, TArray<FVector>& OutNormals, TArray<bool>& OutHits) const
+{
+	if (!this->MeshBVH.IsBuilt())
 	{
-		FVector Vertex0 = InVertexArray[InTriangleIndexArray[i]];
-		FVector Vertex1 = InVertexArray[InTriangleIndexArray[i + 1]];
-		FVector Vertex2 = InVertexArray[InTriangleIndexArray[i + 2]];
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::ProjectPointsOntoMesh] No mesh is loaded!"));
+		OutPositions = InPoints;
+		OutNormals.Init(FVector::ZeroVector, InPoints.Num());
+		OutHits.Init(false, InPoints.Num());
+		return;
+	}
 
-		FVector Edge1 = Vertex1 - Vertex0;
-		FVector Edge2 = Vertex2 - Vertex0;
+	const FTransform& ActorTransform = this->GetActorTransform();
+	const FVector LocalDirection = ActorTransform.InverseTransformVector(InDirection).GetSafeNormal();
+	const double BoundsLength = this->MeshBVH.GetBounds().GetSize().Size();
 
-		FVector Normal = FVector::CrossProduct(Edge1, Edge2);
+	// Every ray starts one bounds diagonal behind its point and ends one diagonal in front of it, crossing the whole mesh
+	TArray<FVector> LocalOrigins;
+	LocalOrigins.SetNumUninitialized(InPoints.Num());
+	for (int32 i = 0; i < InPoints.Num(); i++)
+	{
+		LocalOrigins[i] = ActorTransform.InverseTransformPosition(InPoints[i]) - LocalDirection * BoundsLength;
+	}
 
-		OutInvertedNormalArray[InTriangleIndexArray[i]] -= Normal;
-		OutInvertedNormalArray[InTriangleIndexArray[i + 1]] -= Normal;
-		OutInvertedNormalArray[InTriangleIndexArray[i + 2]] -= Normal;
+	TArray<FPT_MeshHit> Hits;
+	this->MeshBVH.RaycastBatch(LocalOrigins, TArray<FVector>({ LocalDirection }), 2.0 * BoundsLength, Hits);
+
+	TArray<int32> MissedIndices;
+	TArray<FVector> MissedPoints;
+	for (int32 i = 0; i < Hits.Num(); i++)
+	{
+		if (!Hits[i].IsValid())
+		{
+			MissedIndices.Add(i);
+			MissedPoints.Add(LocalOrigins[i] + LocalDirection * BoundsLength);
+		}
 	}
 
-	for (int32 i = 0; i < OutInvertedNormalArray.Num(); i++)
+	TArray<FPT_MeshHit> ClosestHits;
+	this->MeshBVH.FindClosestPointBatch(MissedPoints, UE_DOUBLE_BIG_NUMBER, ClosestHits);
+	for (int32 i = 0; i < MissedIndices.Num(); i++)
 	{
-		OutInvertedNormalArray[i].Normalize();
+		Hits[MissedIndices[i]] = ClosestHits[i];
+	}
+
+	this->ConvertMeshHits(Hits, OutPositions, OutNormals, OutHits);
+	for (const int32 MissedIndex : MissedIndices)
+	{
+		OutHits[MissedIndex] = false;
 	}
 }
 
-void APT_Single3DActor::ResetSingle3DActorArrays()
+bool APT_Single3DActor::ComputeGeodesicDistances(const TArray<FVector>& InSourcePoints, TArray<double>& OutDistances) const
 {
-	this->VertexArray.Empty();
-	this->VertexColorArray.Empty();
-	this->TriangleIndexArray.Empty();
-	this->NormalArray.Empty();
+	OutDistances.Empty();
+	const FTransform& ActorTransform = this->GetActorTransform();
+	TArray<FVector> LocalPoints;
+	LocalPoints.SetNumUninitialized(InSourcePoints.Num());
+	for (int32 i = 0; i < InSourcePoints.Num(); i++)
+	{
+		LocalPoints[i] = ActorTransform.InverseTransformPosition(InSourcePoints[i]);
+	}
+
+	TArray<FPT_MeshHit> Sources;
+	this->MeshBVH.FindClosestPointBatch(LocalPoints, UE_DOUBLE_BIG_NUMBER, Sources);
+	if (!this->ComputeGeodesicField(Sources, OutDistances))
+	{
+		return false;
+	}
+
+	const double Scale = ActorTransform.GetMaximumAxisScale();
+	for (double& Distance : OutDistances)
+	{
+		Distance = (Distance >= 0.0) ? Distance * Scale : Distance;
+	}
+	return true;
+}
+
+bool APT_Single3DActor::GetGeodesicDistances(const FVector& InSourcePoint, const TArray<FVector>& InTargetPoints, TArray<double>& OutDistances) const
+{
+	OutDistances.Empty();
+	const FTransform& ActorTransform = this->GetActorTransform();
+	TArray<FVector> LocalPoints;
+	LocalPoints.SetNumUninitialized(InTargetPoints.Num() + 1);
+	LocalPoints[0] = ActorTransform.InverseTransformPosition(InSourcePoint);
+	for (int32 i = 0; i < InTargetPoints.Num(); i++)
+	{
+		LocalPoints[i + 1] = ActorTransform.InverseTransformPosition(InTargetPoints[i]);
+	}
+
+	TArray<FPT_MeshHit> Hits;
+	this->MeshBVH.FindClosestPointBatch(LocalPoints, UE_DOUBLE_BIG_NUMBER, Hits);
+
+	TArray<double> Field;
+	if (!this->ComputeGeodesicField({ Hits[0] }, Field))
+	{
+		return false;
+	}
+
+	const double Scale = ActorTransform.GetMaximumAxisScale();
+	OutDistances.SetNumUninitialized(InTargetPoints.Num());
+	for (int32 i = 0; i < InTargetPoints.Num(); i++)
+	{
+		OutDistances[i] = this->SampleGeodesicField(Field, Hits[i + 1]) * Scale;
+	}
+	return true;
+}
+
+bool APT_Single3DActor::PlaceGeodesicGrid(const FVector& InCenterPoint, const FRotator& InRotation, const double& InCellSize, const int32& InRowCount, const int32& InColumnCount, TArray<FVector>& OutElectrodePositionArray, TArray<FVector>& OutCornerPointArray) const
+{
+	OutElectrodePositionArray.Empty();
+	OutCornerPointArray.Empty();
+	if (InRowCount <= 0 || InColumnCount <= 0 || InCellSize <= 0.0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::PlaceGeodesicGrid] Invalid grid of %d x %d cells of size %f!"), InRowCount, InColumnCount, InCellSize);
+		return false;
+	}
+
+	const FTransform& ActorTransform = this->GetActorTransform();
+	const double Scale = ActorTransform.GetMaximumAxisScale();
+	const double CellSize = (Scale > 0.0) ? InCellSize / Scale : InCellSize;
+	const FRotationMatrix RotationMatrix(InRotation);
+	const FVector RowAxis = ActorTransform.InverseTransformVectorNoScale(RotationMatrix.GetUnitAxis(EAxis::X));
+	const FVector ColumnAxis = ActorTransform.InverseTransformVectorNoScale(RotationMatrix.GetUnitAxis(EAxis::Y));
+
+	FPT_MeshHit Center;
+	if (!this->MeshBVH.FindClosestPoint(ActorTransform.InverseTransformPosition(InCenterPoint), UE_DOUBLE_BIG_NUMBER, Center))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::PlaceGeodesicGrid] No mesh is loaded!"));
+		return false;
+	}
+
+	TArray<double> CenterField;
+	if (!this->ComputeGeodesicField({ Center }, CenterField))
+	{
+		return false;
+	}
+
+	OutElectrodePositionArray.SetNumUninitialized(InRowCount * InColumnCount);
+	TArray<double> RowField;
+	for (int32 Row = 0; Row < InRowCount; Row++)
+	{
+		const double RowOffset = (Row - 0.5 * (InRowCount - 1)) * CellSize;
+		const FPT_MeshHit RowStart = this->MarchGeodesic(Center, RowAxis, RowOffset, CenterField);
+		const bool bIsCenterRow = FMath::IsNearlyZero(RowOffset);
+		if (!bIsCenterRow && !this->ComputeGeodesicField({ RowStart }, RowField))
+		{
+			return false;
+		}
+
+		for (int32 Column = 0; Column < InColumnCount; Column++)
+		{
+			const double ColumnOffset = (Column - 0.5 * (InColumnCount - 1)) * CellSize;
+			const FPT_MeshHit Electrode = this->MarchGeodesic(RowStart, ColumnAxis, ColumnOffset, bIsCenterRow ? CenterField : RowField);
+			OutElectrodePositionArray[Row * InColumnCount + Column] = ActorTransform.TransformPosition(Electrode.Position);
+		}
+	}
+
+	OutCornerPointArray.Add(OutElectrodePositionArray[0]);
+	OutCornerPointArray.Add(OutElectrodePositionArray[InColumnCount - 1]);
+	OutCornerPointArray.Add(OutElectrodePositionArray[InRowCount * InColumnCount - 1]);
+	OutCornerPointArray.Add(OutElectrodePositionArray[(InRowCount - 1) * InColumnCount]);
+	return true;
+}
+
+bool APT_Single3DActor::ComputeGeodesicField(const TArray<FPT_MeshHit>& InSources, TArray<double>& OutDistances) const
+{
+	{
+		FScopeLock Lock(&this->GeodesicDistanceLock);
+		if (this->MeshBuffer.IsValid() && this->GeodesicDistanceMesh != this->MeshBuffer)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			this->GeodesicDistanceMesh = this->MeshBuffer;
+			this->GeodesicDistance.Build(this->MeshBuffer);
+			UE_LOG(LogTemp, Log, TEXT("[APT_Single3DActor::ComputeGeodesicField] Built the geodesic operators of %d vertices in %.3f s."), this->GeodesicDistance.Num(), FPlatformTime::Seconds() - StartTime);
+			this->ReportMemoryUsage();
+		}
+	}
+
+	if (!this->GeodesicDistance.IsBuilt())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::ComputeGeodesicField] No mesh is loaded!"));
+		return false;
+	}
+
+	// A point inside a triangle heats its corners by its barycentric weights
+	TArray<int32> SourceVertices;
+	TArray<double> SourceWeights;
+	for (const FPT_MeshHit& Source : InSources)
+	{
+		if (!Source.IsValid())
+		{
+			continue;
+		}
+		for (int32 Corner = 0; Corner < 3; Corner++)
+		{
+			SourceVertices.Add(this->GetMesh().GetTriangleIndexArray()[Source.Triangle * 3 + Corner]);
+			SourceWeights.Add(Source.Barycentric[Corner]);
+		}
+	}
+	return this->GeodesicDistance.ComputeDistances(SourceVertices, SourceWeights, OutDistances);
+}
+
+double APT_Single3DActor::SampleGeodesicField(const TArray<double>& InDistances, const FPT_MeshHit& InHit) const
+{
+	if (!InHit.IsValid())
+	{
+		return -1.0;
+	}
+
+	const TArray<int32>& TriangleIndexArray = this->GetMesh().GetTriangleIndexArray();
+	double Distance = 0.0;
+	for (int32 Corner = 0; Corner < 3; Corner++)
+	{
+		Distance += InHit.Barycentric[Corner] * InDistances[TriangleIndexArray[InHit.Triangle * 3 + Corner]];
+	}
+	return Distance;
+}
+
+FPT_MeshHit APT_Single3DActor::MarchGeodesic(const FPT_MeshHit& InStart, const FVector& InAxis, const double InDistance, const TArray<double>& InField) const
+{
+	if (FMath::IsNearlyZero(InDistance))
+	{
+		return InStart;
+	}
+
+	FVector Direction = InAxis - InStart.Normal * FVector::DotProduct(InAxis, InStart.Normal);
+	Direction = Direction.IsNearlyZero() ? InAxis.GetSafeNormal() : Direction.GetSafeNormal();
+	const double TargetDistance = FMath::Abs(InDistance);
+	Direction *= FMath::Sign(InDistance);
+
+	// The chord is shorter than the path along the surface, it is lengthened until the field reads the target distance
+	double ChordLength = TargetDistance;
+	FPT_MeshHit Hit = InStart;
+	for (int32 Iteration = 0; Iteration < 4; Iteration++)
+	{
+		if (!this->MeshBVH.FindClosestPoint(InStart.Position + Direction * ChordLength, UE_DOUBLE_BIG_NUMBER, Hit))
+		{
+			return InStart;
+		}
+
+		const double MeasuredDistance = this->SampleGeodesicField(InField, Hit);
+		if (MeasuredDistance <= UE_DOUBLE_SMALL_NUMBER || FMath::IsNearlyEqual(MeasuredDistance, TargetDistance, TargetDistance * 1e-3))
+		{
+			break;
+		}
+		ChordLength *= TargetDistance / MeasuredDistance;
+	}
+	return Hit;
+}
+
+void APT_Single3DActor::ConvertMeshHits(const TArray<FPT_MeshHit>& InHits, TArray<FVector>& OutPositions, TArray<FVector>& OutNormals, TArray<bool>& OutHits) const
+{
+	const FTransform& ActorTransform = this->GetActorTransform();
+
+	// Normals transform with the inverse transpose, under non-uniform scale they are divided by the scale, not multiplied
+	const FVector InverseScale = FTransform::GetSafeScaleReciprocal(ActorTransform.GetScale3D());
+	OutPositions.SetNumUninitialized(InHits.Num());
+	OutNormals.SetNumUninitialized(InHits.Num());
+	OutHits.SetNumUninitialized(InHits.Num());
+	for (int32 i = 0; i < InHits.Num(); i++)
+	{
+		OutHits[i] = InHits[i].IsValid();
+		OutPositions[i] = OutHits[i] ? ActorTransform.TransformPosition(InHits[i].Position) : FVector::ZeroVector;
+		OutNormals[i] = OutHits[i] ? ActorTransform.TransformVectorNoScale(InHits[i].Normal * InverseScale).GetSafeNormal() : FVector::ZeroVector;
+	}
+}
+
+void APT_Single3DActor::GenerateMeshLODs()
+{
+	this->CancelMeshLODs();
+	this->MeshLODs.Reset();
+	this->CurrentMeshLOD = 0;
+
+	TArray<FPT_MeshData> MeshDataArray;
+	this->GetLODSourceMeshData(MeshDataArray);
+	if (this->GetMesh().GetNumVertices() == 0 || MeshDataArray.Num() == 0 || this->LODTriangleRatios.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::GenerateMeshLODs] No mesh data loaded or no LOD ratios set!"));
+		return;
+	}
+
+	// The tags keep their IDs and descriptions, their triangles go to the job
+	TArray<TArray<int32>> TriangleIndexArrays;
+	TriangleIndexArrays.Reserve(MeshDataArray.Num());
+	for (FPT_MeshData& MeshData : MeshDataArray)
+	{
+		TriangleIndexArrays.Add(MoveTemp(MeshData.TriangleIndexArray));
+		MeshData.TriangleIndexArray.Empty();
+	}
+	this->MeshLODTags = MoveTemp(MeshDataArray);
+
+	const FBox Bounds(this->GetMesh().GetVertexArray());
+	this->MeshLODCenter = Bounds.GetCenter();
+	this->MeshLODRadius = Bounds.GetExtent().Size();
+
+	TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> CancelFlag = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+	this->MeshLODCancelFlag = CancelFlag;
+
+	// The job shares the immutable vertex buffer, so reloading the mesh does not affect a running reduction
+	Async(EAsyncExecution::ThreadPool, [WeakThis = TWeakObjectPtr<APT_Single3DActor>(this), CancelFlag, JobMesh = this->MeshBuffer, TriangleIndexArrays = MoveTemp(TriangleIndexArrays),
+		Ratios = this->LODTriangleRatios, Weighting = this->NormalWeighting]()
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		TSharedRef<TArray<FPT_MeshLOD>, ESPMode::ThreadSafe> LODs = MakeShared<TArray<FPT_MeshLOD>, ESPMode::ThreadSafe>();
+		if (!FPT_MeshSimplifier::GenerateLODChain(JobMesh->GetVertexArray(), TriangleIndexArrays, Ratios, Weighting, true, CancelFlag.Get(), *LODs))
+		{
+			return;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("[APT_Single3DActor::GenerateMeshLODs] %d LODs of %d vertices generated in %.1f ms."), LODs->Num(), JobMesh->GetNumVertices(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, CancelFlag, LODs]()
+		{
+			APT_Single3DActor* This = WeakThis.Get();
+			if (This && !*CancelFlag)
+			{
+				This->MeshLODs = LODs;
+				This->MeshLODCancelFlag.Reset();
+				This->ReportMemoryUsage();
+				This->MeshLODsReadyCallbackEvent.Broadcast();
+			}
+		});
+	});
+}
+
+void APT_Single3DActor::CancelMeshLODs()
+{
+	if (this->MeshLODCancelFlag.IsValid())
+	{
+		this->MeshLODCancelFlag->AtomicSet(true);
+		this->MeshLODCancelFlag.Reset();
+	}
+}
+
+int32 APT_Single3DActor::UpdateMeshLOD(const FVector& InViewLocation, const bool& bInIsInteracting)
+{
+	int32 LOD = 0;
+	if (this->MeshLODs.IsValid() && this->MeshLODRadius > 0.0)
+	{
+		const FTransform& ActorTransform = this->GetActorTransform();
+		const double Radius = this->MeshLODRadius * ActorTransform.GetMaximumAxisScale();
+		const double Distance = FVector::Dist(InViewLocation, ActorTransform.TransformPosition(this->MeshLODCenter)) / Radius;
+		for (int32 i = 0; i < this->LODDistanceFactors.Num() && Distance > this->LODDistanceFactors[i]; i++)
+		{
+			LOD = i + 1;
+		}
+		if (bInIsInteracting)
+		{
+			LOD = FMath::Max(LOD, this->InteractionLOD);
+		}
+		LOD = FMath::Clamp(LOD, 0, this->MeshLODs->Num());
+	}
+
+	if (LOD != this->CurrentMeshLOD)
+	{
+		this->CurrentMeshLOD = LOD;
+		this->MeshLODChangedEvent.Broadcast(LOD);
+	}
+	return this->CurrentMeshLOD;
+}
+
+bool APT_Single3DActor::GetMeshLOD(const int32& InLOD, TArray<FVector>& OutVertexArray, TArray<FVector>& OutNormalArray, TArray<int32>& OutTriangleIndexArray, TArray<FPT_MeshData>& OutMeshDataArray, TArray<int32>& OutVertexIndexMap) const
+{
+	OutVertexArray.Empty();
+	OutNormalArray.Empty();
+	OutTriangleIndexArray.Empty();
+	OutMeshDataArray.Empty();
+	OutVertexIndexMap.Empty();
+
+	if (!this->MeshLODs.IsValid() || InLOD < 1 || InLOD > this->MeshLODs->Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::GetMeshLOD] LOD %d is not available!"), InLOD);
+		return false;
+	}
+
+	const FPT_MeshLOD& MeshLOD = (*this->MeshLODs)[InLOD - 1];
+	OutVertexArray = MeshLOD.VertexArray;
+	OutNormalArray = MeshLOD.NormalArray;
+	OutVertexIndexMap = MeshLOD.VertexIndexMap;
+	OutTriangleIndexArray.Reserve(MeshLOD.GetNumTriangles() * 3);
+	OutMeshDataArray = this->MeshLODTags;
+	for (int32 Tag = 0; Tag < MeshLOD.TriangleIndexArrays.Num() && Tag < OutMeshDataArray.Num(); Tag++)
+	{
+		OutTriangleIndexArray.Append(MeshLOD.TriangleIndexArrays[Tag]);
+		OutMeshDataArray[Tag].TriangleIndexArray = MeshLOD.TriangleIndexArrays[Tag];
+	}
+	return true;
+}
+
+bool APT_Single3DActor::GetMeshLODVertexColors(const int32& InLOD, const TArray<FLinearColor>& InVertexColorArray, TArray<FLinearColor>& OutVertexColorArray) const
+{
+	OutVertexColorArray.Empty();
+	if (InLOD == 0)
+	{
+		OutVertexColorArray = InVertexColorArray;
+		return true;
+	}
+
+	if (!this->MeshLODs.IsValid() || InLOD < 1 || InLOD > this->MeshLODs->Num() || InVertexColorArray.Num() != this->GetMesh().GetNumVertices())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::GetMeshLODVertexColors] LOD %d is not available or %d colors do not match %d vertices!"), InLOD, InVertexColorArray.Num(), this->GetMesh().GetNumVertices());
+		return false;
+	}
+
+	const TArray<int32>& VertexIndexMap = (*this->MeshLODs)[InLOD - 1].VertexIndexMap;
+	OutVertexColorArray.SetNumUninitialized(VertexIndexMap.Num());
+	for (int32 i = 0; i < VertexIndexMap.Num(); i++)
+	{
+		OutVertexColorArray[i] = InVertexColorArray[VertexIndexMap[i]];
+	}
+	return true;
+}
+
+bool APT_Single3DActor::UpdateMeshSectionColors(UProceduralMeshComponent* InMeshComponent, const int32& InSectionIndex, const TArray<FLinearColor>& InVertexColorArray, const TArray<int32>& InVertexIndexArray, int32& OutNumChangedVertices) const
+{
+	OutNumChangedVertices = 0;
+
+	FProcMeshSection* Section = InMeshComponent ? InMeshComponent->GetProcMeshSection(InSectionIndex) : nullptr;
+	if (!Section || Section->ProcVertexBuffer.Num() != InVertexColorArray.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::UpdateMeshSectionColors] Section %d does not exist or does not have %d vertices!"), InSectionIndex, InVertexColorArray.Num());
+		return false;
+	}
+
+	// The packing matches CreateMeshSection_LinearColor, so unchanged vertices compare equal
+	TArray<FProcMeshVertex>& VertexBuffer = Section->ProcVertexBuffer;
+	const int32 NumVertices = InVertexIndexArray.Num() > 0 ? InVertexIndexArray.Num() : VertexBuffer.Num();
+	for (int32 i = 0; i < NumVertices; i++)
+	{
+		const int32 Vertex = InVertexIndexArray.Num() > 0 ? InVertexIndexArray[i] : i;
+		if (!VertexBuffer.IsValidIndex(Vertex))
+		{
+			continue;
+		}
+
+		const FColor Color = InVertexColorArray[Vertex].ToFColor(false);
+		if (VertexBuffer[Vertex].Color != Color)
+		{
+			VertexBuffer[Vertex].Color = Color;
+			OutNumChangedVertices++;
+		}
+	}
+
+	// Empty arrays keep the positions, normals, UVs and tangents, so bounds and collision are not rebuilt
+	if (OutNumChangedVertices > 0)
+	{
+		InMeshComponent->UpdateMeshSection(InSectionIndex, TArray<FVector>(), TArray<FVector>(), TArray<FVector2D>(), TArray<FColor>(), TArray<FProcMeshTangent>());
+	}
+	return true;
+}
+
+void APT_Single3DActor::SetMeshBuffer(TArray<FVector>&& InVertexArray, TArray<FVector>&& InNormalArray, TArray<int32>&& InTriangleIndexArray)
+{
+	this->MeshBuffer = FPT_MeshBuffer::Create(MoveTemp(InVertexArray), MoveTemp(InNormalArray), MoveTemp(InTriangleIndexArray));
+	this->MeshBufferHandle = UPT_MeshBufferHandle::Create(this, this->MeshBuffer);
+}
+
+void APT_Single3DActor::ResetGeodesicDistance()
+{
+	FScopeLock Lock(&this->GeodesicDistanceLock);
+	this->GeodesicDistance.Reset();
+	this->GeodesicDistanceMesh.Reset();
+}
+
+void APT_Single3DActor::ResetMeshBuffer()
+{
+	this->MeshBuffer.Reset();
+	this->MeshBufferHandle = nullptr;
+}
+
+void APT_Single3DActor::ResetMeshLODs()
+{
+	this->CancelMeshLODs();
+	this->MeshLODs.Reset();
+	this->MeshLODTags.Empty();
+	this->CurrentMeshLOD = 0;
+}
+
+void APT_Single3DActor::GetLODSourceMeshData(TArray<FPT_MeshData>& OutMeshDataArray) const
+{
+	OutMeshDataArray.Empty();
+	if (this->GetMesh().GetNumTriangles() > 0)
+	{
+		FPT_MeshData& MeshData = OutMeshDataArray.AddDefaulted_GetRef();
+		MeshData.TriangleIndexArray = this->GetMesh().GetTriangleIndexArray();
+	}
 }
 
 void APT_Single3DActor::InitWhiteVertexColor(const int32& InVertexArrayLength, const float& InAlphaValue)
 {
 	this->VertexColorArray.Init(FLinearColor(255.f, 255.f, 255.f, InAlphaValue), InVertexArrayLength);
 }
+
+FString APT_Single3DActor::GetMemoryConsumerName(const EMemorySubsystem InSubsystem) const
+{
+	return FString::Printf(TEXT("%s.%s"), *this->GetName(), *StaticEnum<EMemorySubsystem>()->GetNameStringByValue((int64)InSubsystem));
+}
+
+int64 APT_Single3DActor::GetMeshBytes() const
+{
+	return (int64)((this->MeshBuffer.IsValid() ? this->MeshBuffer->GetAllocatedSize() : 0) + this->VertexColorArray.GetAllocatedSize() + this->MeshBVH.GetAllocatedSize() + this->GeodesicDistance.GetAllocatedSize() + this->GetMeshLODBytes());
+}
+
+int64 APT_Single3DActor::GetMeshLODBytes() const
+{
+	int64 Bytes = 0;
+	if (this->MeshLODs.IsValid())
+	{
+		for (const FPT_MeshLOD& MeshLOD : *this->MeshLODs)
+		{
+			Bytes += (int64)MeshLOD.GetAllocatedSize();
+		}
+	}
+	return Bytes;
+}
+
+void APT_Single3DActor::ReportMemoryUsage() const
+{
+	UPT_MemoryBudgetManager::ReportUsage(this->GetMemoryConsumerName(EMemorySubsystem::Mesh), EMemorySubsystem::Mesh, this->GetMeshBytes());
+	UPT_MemoryBudgetManager::ReportUsage(this->GetMemoryConsumerName(EMemorySubsystem::Tetra), EMemorySubsystem::Tetra, this->GetTetraBytes());
+	UPT_MemoryBudgetManager::ReportUsage(this->GetMemoryConsumerName(EMemorySubsystem::PointCloud), EMemorySubsystem::PointCloud, this->PointCloudBytes);
+}
+
+/**
+ * @brief Counts the elements of a JSON field without parsing them.
+ * @param InObject The object holding the field.
+ * @param InFieldName The field, either an array or an object of arrays per tag.
+ * @return The number of array elements, summed over the tags for objects, 0 if the field is missing.
+ */
+static int64 CountJSONArrayElements(const TSharedPtr<FJsonObject>& InObject, const TCHAR* InFieldName)
+{
+	const TArray<TSharedPtr<FJsonValue>>* ValueArrayPtr;
+	if (InObject->TryGetArrayField(InFieldName, ValueArrayPtr))
+	{
+		return ValueArrayPtr->Num();
+	}
+
+	const TSharedPtr<FJsonObject>* TagObjectPtr;
+	if (!InObject->TryGetObjectField(InFieldName, TagObjectPtr))
+	{
+		return 0;
+	}
+
+	int64 NumElements = 0;
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& TagPair : (*TagObjectPtr)->Values)
+	{
+		const TArray<TSharedPtr<FJsonValue>>* TagArrayPtr;
+		if (TagPair.Value.IsValid() && TagPair.Value->TryGetArray(TagArrayPtr))
+		{
+			NumElements += TagArrayPtr->Num();
+		}
+	}
+	return NumElements;
+}
+
+bool APT_Single3DActor::RequestMeshAllocation(const UPT_HTTPComponent* InHTTPComponent) const
+{
+	const TSharedPtr<FJsonObject> ResponseObject = InHTTPComponent->GetResponseObject();
+	const TArray<TSharedPtr<FJsonValue>>* VertexValueArrayPtr;
+	if (!ResponseObject.IsValid() || !ResponseObject->TryGetArrayField(TEXT("vertices"), VertexValueArrayPtr))
+	{
+		// The converters report the missing field
+		return true;
+	}
+
+	// Position, color and normal per vertex, three indices per triangle of the single or per tag meshes,
+	// one tetrahedron per raw volume element and one point plus its vertex index per volume element
+	const int64 NumTriangles = CountJSONArrayElements(ResponseObject, TEXT("triangles")) + CountJSONArrayElements(ResponseObject, TEXT("meshes"));
+	const int64 NumTetras = CountJSONArrayElements(ResponseObject, TEXT("volumes_raw"));
+	const int64 NumVolumePoints = CountJSONArrayElements(ResponseObject, TEXT("volume")) + CountJSONArrayElements(ResponseObject, TEXT("volumes"));
+	const int64 EstimatedBytes = (int64)VertexValueArrayPtr->Num() * (2 * sizeof(FVector) + sizeof(FLinearColor))
+		+ NumTriangles * 3 * sizeof(int32)
+		+ NumTetras * sizeof(FPT_TetraData)
+		+ NumVolumePoints * (sizeof(FLidarPointCloudPoint) + sizeof(int32));
+
+	FString BudgetMessage;
+	if (!UPT_MemoryBudgetManager::RequestAllocation(this->GetMemoryConsumerName(EMemorySubsystem::Mesh), EMemorySubsystem::Mesh, EstimatedBytes, BudgetMessage))
+	{
+		UE_LOG(LogTemp, Error, TEXT("[APT_Single3DActor::RequestMeshAllocation] %s"), *BudgetMessage);
+		return false;
+	}
+	return true;
+}
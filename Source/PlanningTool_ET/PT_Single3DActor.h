@@ -6,11 +6,19 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "PT_StructContainer.h"
+#include "PT_MeshBVH.h"
+#include "PT_GeodesicDistance.h"
+#include "PT_MeshNormals.h"
+#include "PT_MeshSimplifier.h"
+#include "PT_MeshBuffer.h"
 #include <LidarPointCloudShared.h>
 #include "PT_Single3DActor.generated.h"
 
+class UProceduralMeshComponent;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FMeshDataCallbackEventDelegate);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FVolumeDataCallbackEventDelegate);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMeshLODChangedEventDelegate, int32, LOD);
 
 /**
  * @brief A class representing a single 3D actor in the Planning Tool.
@@ -32,6 +40,9 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the actor is removed from the world, releases its memory accounting
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -62,12 +73,23 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "PT_3D_Event")
 	FVolumeDataCallbackEventDelegate VolumeDataLoadedCallbackEvent;
 
+	/**
+	 * @brief A delegate called when the levels of detail of the mesh have been generated.
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "PT_3D_Event")
+	FMeshDataCallbackEventDelegate MeshLODsReadyCallbackEvent;
+
+	/**
+	 * @brief A delegate called when UpdateMeshLOD selects another level of detail. The Blueprint swaps the displayed mesh.
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "PT_3D_Event")
+	FMeshLODChangedEventDelegate MeshLODChangedEvent;
+
 	/**
 	 * @brief Gets the vertex array.
 	 *
 	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
-	 * It returns the vertex array of the actor.
-	 * The vertex array is a member variable of the actor and contains the vertices of the 3D model represented by the actor.
+	 * It returns a copy of the vertices of the 3D model represented by the actor. GetMeshBuffer gives access without copying.
 	 *
 	 * @return The vertex array of the actor.
 	 */
@@ -90,8 +112,8 @@ public:
 	 * @brief Gets the triangle index array.
 	 *
 	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
-	 * It returns the triangle index array of the actor.
-	 * The triangle index array is a member variable of the actor and contains the indices of the vertices that form the triangles of the 3D model represented by the actor.
+	 * It returns a copy of the indices of the vertices that form the triangles of the 3D model represented by the actor.
+	 * GetMeshBuffer gives access without copying.
 	 *
 	 * @return The triangle index array of the actor.
 	 */
@@ -102,14 +124,30 @@ public:
 	 * @brief Gets the normal array.
 	 *
 	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
-	 * It returns the normal array of the actor.
-	 * The normal array is a member variable of the actor and contains the normal vectors of the vertices of the 3D model represented by the actor.
+	 * It returns a copy of the normal vectors of the vertices of the 3D model represented by the actor.
+	 * GetMeshBuffer gives access without copying.
 	 *
 	 * @return The normal array of the actor.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
 	TArray<FVector> GetNormalArray() const;
 
+	/**
+	 * @brief Gets a handle to the shared buffer of the loaded mesh.
+	 *
+	 * This function is a BlueprintPure function that belongs to the "PT_3D_DATA" category.
+	 * The handle reads the mesh without copying it and can be passed on, e.g. to UPT_SimulationComponent::SetSurfaceMeshBuffer.
+	 * Every load creates a new handle, a handle kept from an earlier load still refers to the earlier mesh.
+	 *
+	 * @return The handle, nullptr if no mesh is loaded.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
+	UPT_MeshBufferHandle* GetMeshBuffer() const { return this->MeshBufferHandle; }
+
+	/** @brief Whether the loaders also copy the mesh into their output arrays. Blueprints reading the mesh through GetMeshBuffer can turn this off, so the mesh exists once. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_3D_DATA")
+	bool bOutputMeshArrays = true;
+
 	/**
 	 * @brief Creates an array of FLidarPointCloudPoint from given vertex indices, vertex array, and vertex color array.
 	 *
@@ -208,13 +246,14 @@ public:
 	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
 	 * It takes an array of vertices, an array of triangle indices, and an output array for the normal vectors as input.
 	 * It calculates the normals of the vertices based on the triangle indices and assigns them to the output array.
+	 * The triangle normals are weighted by NormalWeighting.
 	 *
 	 * @param InVertexArray The array of vertices.
 	 * @param InTriangleIndexArray The array of triangle indices.
 	 * @param OutNormalArray The output array for the normal vectors.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
-	void CalculateNormals(const TArray<FVector>& InVertexArray, const TArray<int32> InTriangleIndexArray, TArray<FVector>& OutNormalArray);
+	void CalculateNormals(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray, TArray<FVector>& OutNormalArray);
 
 	/**
 	 * @brief Calculates the inverted normals of the vertices of a 3D model.
@@ -222,13 +261,145 @@ public:
 	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
 	 * It takes an array of vertices, an array of triangle indices, and an output array for the inverted normal vectors as input.
 	 * It calculates the inverted normals of the vertices based on the triangle indices and assigns them to the output array.
+	 * The triangle normals are weighted by NormalWeighting.
 	 *
 	 * @param InVertexArray The array of vertices.
 	 * @param InTriangleIndexArray The array of triangle indices.
 	 * @param OutInvertedNormalArray The output array for the inverted normal vectors.
 	 */
 	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
-	void CalculateInvertedNormals(const TArray<FVector>& InVertexArray, const TArray<int32> InTriangleIndexArray, TArray<FVector>& OutInvertedNormalArray);
+	void CalculateInvertedNormals(const TArray<FVector>& InVertexArray, const TArray<int32>& InTriangleIndexArray, TArray<FVector>& OutInvertedNormalArray);
+
+	/**
+	 * @brief Measures the vertex normal computation on the loaded mesh.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * Compares the former per-triangle scatter loop with the shared gather kernel, once including and once excluding
+	 * the adjacency build. Deviations between both are logged.
+	 *
+	 * @param InIterations The number of timed runs per variant.
+	 * @param OutScatterMilliseconds The mean time of the scatter loop.
+	 * @param OutGatherMilliseconds The mean time of the gather kernel with a prebuilt adjacency.
+	 * @param OutBuildMilliseconds The time of the adjacency build.
+	 * @param OutMaxDeviation The largest difference between the normals of both variants.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void BenchmarkNormals(const int32& InIterations, double& OutScatterMilliseconds, double& OutGatherMilliseconds, double& OutBuildMilliseconds, double& OutMaxDeviation) const;
+
+	/**
+	 * @brief Starts generating the levels of detail of the loaded mesh on a worker thread.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * The mesh is reduced by quadric error edge collapses to every ratio of LODTriangleRatios in one pass. Tag borders
+	 * and open borders are kept, and the LOD vertices are a subset of the mesh vertices. A running generation is
+	 * canceled. MeshLODsReadyCallbackEvent is broadcast on the game thread when the LODs are available.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void GenerateMeshLODs();
+
+	/**
+	 * @brief Stops a running level of detail generation.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void CancelMeshLODs();
+
+	/**
+	 * @brief Selects the level of detail for the current view.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * The LOD grows with the distance between the view and the mesh center, measured in mesh radii against
+	 * LODDistanceFactors. While the user interacts, e.g. orbits the camera or waits for a simulation, at least
+	 * InteractionLOD is used. MeshLODChangedEvent is broadcast when the selection changes.
+	 *
+	 * @param InViewLocation The camera location in world space.
+	 * @param bInIsInteracting Whether the user is interacting.
+	 * @return The selected LOD, 0 for the full resolution mesh.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	int32 UpdateMeshLOD(const FVector& InViewLocation, const bool& bInIsInteracting);
+
+	/**
+	 * @brief Gets a generated level of detail.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * LOD 0 is the full resolution mesh the Blueprint already holds, so only LODs from 1 are returned.
+	 *
+	 * @param InLOD The LOD, from 1 to GetMeshLODCount() - 1.
+	 * @param OutVertexArray Receives the LOD vertices.
+	 * @param OutNormalArray Receives the LOD normals.
+	 * @param OutTriangleIndexArray Receives the triangle indices of all tags.
+	 * @param OutMeshDataArray Receives the triangle indices per tag, with the IDs and descriptions of the full resolution tags.
+	 * @param OutVertexIndexMap Receives the full resolution vertex index per LOD vertex.
+	 * @return True if the LOD exists.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	bool GetMeshLOD(const int32& InLOD, TArray<FVector>& OutVertexArray, TArray<FVector>& OutNormalArray, TArray<int32>& OutTriangleIndexArray, TArray<FPT_MeshData>& OutMeshDataArray, TArray<int32>& OutVertexIndexMap) const;
+
+	/**
+	 * @brief Picks the vertex colors of a level of detail from the full resolution vertex colors.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 *
+	 * @param InLOD The LOD, 0 copies the colors unchanged.
+	 * @param InVertexColorArray The full resolution vertex colors.
+	 * @param OutVertexColorArray Receives one color per LOD vertex.
+	 * @return True if the LOD exists and the colors match the mesh.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	bool GetMeshLODVertexColors(const int32& InLOD, const TArray<FLinearColor>& InVertexColorArray, TArray<FLinearColor>& OutVertexColorArray) const;
+
+	/**
+	 * @brief Recolors an existing procedural mesh section without rebuilding it.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * The colors are packed to FColor like CreateMeshSection_LinearColor does and written only for the given vertices,
+	 * e.g. GetVerticesInRoiArray() of the simulation component, whose colors change with every interpolation. Vertices
+	 * whose packed color did not change are skipped, and the section is only sent to the render thread if any vertex
+	 * changed. Positions, normals, bounds and collision of the section are left untouched.
+	 *
+	 * @param InMeshComponent The procedural mesh component holding the section.
+	 * @param InSectionIndex The section, created with one vertex per mesh vertex.
+	 * @param InVertexColorArray The vertex colors of the whole mesh.
+	 * @param InVertexIndexArray The vertices to update. If empty, all vertices are updated.
+	 * @param OutNumChangedVertices Receives the number of vertices whose color changed.
+	 * @return True if the section exists and matches the colors.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	bool UpdateMeshSectionColors(UProceduralMeshComponent* InMeshComponent, const int32& InSectionIndex, const TArray<FLinearColor>& InVertexColorArray, const TArray<int32>& InVertexIndexArray, int32& OutNumChangedVertices) const;
+
+	/**
+	 * @brief Gets the number of levels of detail, including the full resolution mesh.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
+	int32 GetMeshLODCount() const { return this->MeshLODs.IsValid() ? this->MeshLODs->Num() + 1 : 1; }
+
+	/**
+	 * @brief Gets the level of detail selected by the last UpdateMeshLOD call.
+	 */
+	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
+	int32 GetCurrentMeshLOD() const { return this->CurrentMeshLOD; }
+
+	/** @brief Whether levels of detail are generated whenever a mesh is loaded. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_3D_DATA")
+	bool bGenerateMeshLODs = true;
+
+	/** @brief The fraction of triangles kept per generated LOD, descending. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_3D_DATA")
+	TArray<float> LODTriangleRatios = { 0.35f, 0.1f };
+
+	/** @brief The view distance in mesh radii beyond which each generated LOD is used, ascending. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_3D_DATA")
+	TArray<float> LODDistanceFactors = { 3.f, 6.f };
+
+	/** @brief The smallest LOD used while the user interacts. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_3D_DATA", meta = (ClampMin = "0"))
+	int32 InteractionLOD = 1;
+
+	/** @brief How the triangle normals are weighted in the vertex normals. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "PT_3D_DATA")
+	ENormalWeighting NormalWeighting = ENormalWeighting::Area;
 
 	/**
 	 * @brief Resets the arrays of the single 3D actor.
@@ -248,19 +419,135 @@ public:
 	 * @return The length of the vertex array.
 	 */
 	UFUNCTION(BlueprintPure, Category = "PT_3D_DATA")
-	int32 GetVertexArrayLength() { return this->VertexArray.Num(); }
+	int32 GetVertexArrayLength() { return this->GetMesh().GetNumVertices(); }
+
+	/**
+	 * @brief Casts many rays against the mesh.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * The rays are intersected with the bounding volume hierarchy of the mesh on the CPU, so no collision is needed.
+	 *
+	 * @param InOrigins The ray origins in world space.
+	 * @param InDirections The ray directions in world space, one per origin or a single one shared by all rays.
+	 * @param InMaxDistance The length of every ray.
+	 * @param OutPositions Receives the hit position per ray in world space.
+	 * @param OutNormals Receives the face normal per ray in world space, facing the ray origin.
+	 * @param OutHits Receives whether each ray hit the mesh.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void RaycastMeshBatch(const TArray<FVector>& InOrigins, const TArray<FVector>& InDirections, const double& InMaxDistance, TArray<FVector>& OutPositions, TArray<FVector>& OutNormals, TArray<bool>& OutHits) const;
+
+	/**
+	 * @brief Finds the closest points on the mesh to many query points.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 *
+	 * @param InPoints The query points in world space.
+	 * @param InMaxDistance Points farther away are not considered.
+	 * @param OutPositions Receives the closest point per query point in world space.
+	 * @param OutNormals Receives the face normal per query point in world space.
+	 * @param OutHits Receives whether a point within InMaxDistance was found.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void FindClosestMeshPointsBatch(const TArray<FVector>& InPoints, const double& InMaxDistance, TArray<FVector>& OutPositions, TArray<FVector>& OutNormals, TArray<bool>& OutHits) const;
+
+	/**
+	 * @brief Projects points onto the mesh along a direction.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * Every point is cast along InDirection through the whole mesh, starting on the far side of its bounds. Points whose
+	 * ray misses the mesh are moved to their closest point instead. Used to drape the grid and its corner points onto
+	 * the skin before CreateGridJSON.
+	 *
+	 * @param InPoints The points in world space.
+	 * @param InDirection The projection direction in world space.
+	 * @param OutPositions Receives the projected point per input point in world space.
+	 * @param OutNormals Receives the face normal per input point in world space, facing against InDirection.
+	 * @param OutHits Receives whether each ray hit the mesh, false where the closest point was used.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	void ProjectPointsOntoMesh(const TArray<FVector>& InPoints, const FVector& InDirection, TArray<FVector>& OutPositions, TArray<FVector>& OutNormals, TArray<bool>& OutHits) const;
+
+	/**
+	 * @brief Computes the geodesic distance of every vertex to the nearest source point.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * The source points are moved to their closest points on the mesh. The distances are measured along the mesh surface
+	 * with the heat method, whose operators are built by the first geodesic query on a loaded mesh.
+	 *
+	 * @param InSourcePoints The source points in world space.
+	 * @param OutDistances Receives the distance per vertex in world units, -1 for vertices without triangles.
+	 * @return True if the distances could be computed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	bool ComputeGeodesicDistances(const TArray<FVector>& InSourcePoints, TArray<double>& OutDistances) const;
 
-protected:
 	/**
-	 * @brief An array of vertices.
+	 * @brief Measures the geodesic distances from one point to several others.
 	 *
-	 * This member variable is an array of FVector objects.
-	 * Each FVector object represents a vertex in a 3D space.
-	 * The array is used to store the vertices of the 3D model represented by the actor.
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * All points are moved to their closest points on the mesh.
 	 *
-	 * @var VertexArray The array of vertices.
+	 * @param InSourcePoint The point to measure from in world space.
+	 * @param InTargetPoints The points to measure to in world space.
+	 * @param OutDistances Receives the distance per target point in world units.
+	 * @return True if the distances could be computed.
 	 */
-	TArray<FVector> VertexArray;
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	bool GetGeodesicDistances(const FVector& InSourcePoint, const TArray<FVector>& InTargetPoints, TArray<double>& OutDistances) const;
+
+	/**
+	 * @brief Places a grid of electrodes whose neighbors are one cell size apart along the mesh surface.
+	 *
+	 * This function is a BlueprintCallable function that belongs to the "PT_3D_DATA" category.
+	 * The rows run along the forward axis and the columns along the right axis of InRotation. The center column is
+	 * placed at geodesic distances from the center point, every row at geodesic distances from its point on the center
+	 * column. Unlike a flat grid projected onto the mesh, the spacing does not stretch where the surface curves away.
+	 *
+	 * @param InCenterPoint The center of the grid in world space.
+	 * @param InRotation The orientation of the grid.
+	 * @param InCellSize The geodesic distance between neighboring electrodes in world units.
+	 * @param InRowCount The number of rows.
+	 * @param InColumnCount The number of columns.
+	 * @param OutElectrodePositionArray Receives the electrode positions row by row in world space.
+	 * @param OutCornerPointArray Receives the first and last electrode of the first row, then the last and first electrode of the last row.
+	 * @return True if the grid could be placed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "PT_3D_DATA")
+	bool PlaceGeodesicGrid(const FVector& InCenterPoint, const FRotator& InRotation, const double& InCellSize, const int32& InRowCount, const int32& InColumnCount, TArray<FVector>& OutElectrodePositionArray, TArray<FVector>& OutCornerPointArray) const;
+
+protected:
+	/**
+	 * @brief The shared buffer of the loaded mesh, invalid while no mesh is loaded.
+	 *
+	 * Holds the vertices, normals and triangle indices. Every load replaces the buffer instead of changing it, so worker
+	 * threads and handles holding the previous buffer keep reading consistent data.
+	 */
+	FPT_MeshBufferPtr MeshBuffer;
+
+	/**
+	 * @brief The Blueprint handle to MeshBuffer.
+	 */
+	UPROPERTY(Transient)
+	UPT_MeshBufferHandle* MeshBufferHandle = nullptr;
+
+	/**
+	 * @brief Gets the loaded mesh, or an empty mesh if none is loaded.
+	 */
+	const FPT_MeshBuffer& GetMesh() const { return this->MeshBuffer.IsValid() ? *this->MeshBuffer : FPT_MeshBuffer::GetEmpty(); }
+
+	/**
+	 * @brief Replaces the loaded mesh by a new shared buffer and creates its handle.
+	 * @param InVertexArray The vertices, moved into the buffer.
+	 * @param InNormalArray The vertex normals, moved into the buffer.
+	 * @param InTriangleIndexArray The triangle indices, moved into the buffer.
+	 */
+	void SetMeshBuffer(TArray<FVector>&& InVertexArray, TArray<FVector>&& InNormalArray, TArray<int32>&& InTriangleIndexArray);
+
+	/**
+	 * @brief Releases the loaded mesh.
+	 */
+	void ResetMeshBuffer();
 
 	/**
 	 * @brief An array of vertex colors.
@@ -274,26 +561,94 @@ protected:
 	TArray<FLinearColor> VertexColorArray;
 
 	/**
-	 * @brief An array of normals.
-	 *
-	 * This member variable is an array of FVector objects.
-	 * Each FVector object represents a normal vector in a 3D space.
-	 * The array is used to store the normals of the vertices of the 3D model represented by the actor.
-	 *
-	 * @var NormalArray The array of normals.
+	 * @brief The bounding volume hierarchy over the mesh in actor space, built when a mesh is loaded.
 	 */
-	TArray<FVector> NormalArray;
+	FPT_MeshBVH MeshBVH;
 
 	/**
-	 * @brief An array of triangle indices.
-	 *
-	 * This member variable is an array of int32 values.
-	 * Each int32 value represents an index to a vertex in the VertexArray.
-	 * The array is used to store the triangle indices of the 3D model represented by the actor.
+	 * @brief The geodesic distance operators of the mesh, built on the first geodesic query after a mesh is loaded.
+	 */
+	mutable FPT_GeodesicDistance GeodesicDistance;
+
+	/**
+	 * @brief The mesh the geodesic operators were last built for, also kept after a failed build so it is not repeated.
+	 */
+	mutable FPT_MeshBufferPtr GeodesicDistanceMesh;
+
+	/**
+	 * @brief Guards the lazy build of the geodesic operators.
+	 */
+	mutable FCriticalSection GeodesicDistanceLock;
+
+	/**
+	 * @brief Releases the geodesic operators, they are built again by the next geodesic query.
+	 */
+	void ResetGeodesicDistance();
+
+	/**
+	 * @brief Gets the triangles the levels of detail are generated from, one entry per tag.
+	 * @param OutMeshDataArray Receives the mesh data per tag.
+	 */
+	virtual void GetLODSourceMeshData(TArray<FPT_MeshData>& OutMeshDataArray) const;
+
+	/**
+	 * @brief Cancels the level of detail generation and releases the generated levels of detail.
+	 */
+	void ResetMeshLODs();
+
+	/**
+	 * @brief The generated levels of detail from LOD 1 on. Immutable once published.
+	 */
+	TSharedPtr<const TArray<FPT_MeshLOD>, ESPMode::ThreadSafe> MeshLODs;
+
+	/**
+	 * @brief The IDs and descriptions of the tags the levels of detail were generated from.
+	 */
+	TArray<FPT_MeshData> MeshLODTags;
+
+	/**
+	 * @brief The center and radius of the mesh in actor space, the reference of the LOD distances.
+	 */
+	FVector MeshLODCenter = FVector::ZeroVector;
+	double MeshLODRadius = 0.0;
+
+	/**
+	 * @brief The level of detail selected by the last UpdateMeshLOD call.
+	 */
+	int32 CurrentMeshLOD = 0;
+
+	/**
+	 * @brief Set to stop the running level of detail generation.
+	 */
+	TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> MeshLODCancelFlag;
+
+	/**
+	 * @brief Computes the geodesic distance field in actor space from points on the mesh.
 	 *
-	 * @var TriangleIndexArray The array of triangle indices.
+	 * Builds the geodesic operators of the loaded mesh first if they do not belong to it yet. The build factors two
+	 * sparse systems, so meshes that are never queried do not pay for it.
+	 */
+	bool ComputeGeodesicField(const TArray<FPT_MeshHit>& InSources, TArray<double>& OutDistances) const;
+
+	/**
+	 * @brief Interpolates a geodesic distance field at a point on the mesh.
+	 */
+	double SampleGeodesicField(const TArray<double>& InDistances, const FPT_MeshHit& InHit) const;
+
+	/**
+	 * @brief Finds the point on the mesh at a geodesic distance from a start point along a direction.
+	 * @param InStart The start point on the mesh.
+	 * @param InAxis The direction, projected onto the tangent plane of the start point.
+	 * @param InDistance The geodesic distance in actor space, negative to go against InAxis.
+	 * @param InField The geodesic distance field of the start point.
+	 * @return The point on the mesh.
+	 */
+	FPT_MeshHit MarchGeodesic(const FPT_MeshHit& InStart, const FVector& InAxis, const double InDistance, const TArray<double>& InField) const;
+
+	/**
+	 * @brief Converts query hits from actor space to world space.
 	 */
-	TArray<int32> TriangleIndexArray;
+	void ConvertMeshHits(const TArray<FPT_MeshHit>& InHits, TArray<FVector>& OutPositions, TArray<FVector>& OutNormals, TArray<bool>& OutHits) const;
 
 	/**
 	 * @brief Initializes the vertex color array with white color.
@@ -305,4 +660,53 @@ protected:
 	 * @param InAlphaValue The alpha value for the color (default is 1.0).
 	 */
 	void InitWhiteVertexColor(const int32& InVertexArrayLength, const float& InAlphaValue = 1.f);
+
+	/**
+	 * @brief The bytes of the point clouds created by the last volume load.
+	 *
+	 * The point clouds are handed to Blueprint, so only their size is kept for the memory budget manager.
+	 */
+	int64 PointCloudBytes = 0;
+
+	/**
+	 * @brief Gets the name the actor reports one subsystem to the memory budget manager under.
+	 * @param InSubsystem The subsystem.
+	 * @return The consumer name.
+	 */
+	FString GetMemoryConsumerName(const EMemorySubsystem InSubsystem) const;
+
+	/**
+	 * @brief Gets the bytes held by the mesh arrays of the actor.
+	 * @return The number of bytes.
+	 */
+	virtual int64 GetMeshBytes() const;
+
+	/**
+	 * @brief Gets the bytes held by the generated levels of detail.
+	 * @return The number of bytes.
+	 */
+	int64 GetMeshLODBytes() const;
+
+	/**
+	 * @brief Gets the bytes held by the tetra arrays of the actor.
+	 * @return The number of bytes.
+	 */
+	virtual int64 GetTetraBytes() const { return 0; }
+
+	/**
+	 * @brief Reports the mesh, tetra and point cloud bytes of the actor to the memory budget manager.
+	 */
+	void ReportMemoryUsage() const;
+
+	/**
+	 * @brief Checks with the memory budget manager whether the mesh of a response fits into the budget.
+	 *
+	 * The vertex, triangle, tetrahedron and volume element counts of the response bound the mesh, tetra and point
+	 * cloud arrays of the load before they are parsed, so the whole load is requested at once. The current mesh has
+	 * to be released and reported first.
+	 *
+	 * @param InHTTPComponent The HTTP component holding the response.
+	 * @return True if the mesh fits or the response has no vertices.
+	 */
+	bool RequestMeshAllocation(const UPT_HTTPComponent* InHTTPComponent) const;
 };
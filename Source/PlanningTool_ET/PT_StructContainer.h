@@ -5,6 +5,7 @@
 
 #include "CoreMinimal.h"
 #include <LidarPointCloudShared.h>
+#include "PT_EnumContainer.h"
 #include "PT_StructContainer.generated.h"
 
 /**
@@ -97,6 +98,450 @@ struct FPT_VolumeData
 	TArray<FLidarPointCloudPoint> PointCloudArray;
 };
 
+/**
+ * @brief A structure to hold the error report of the low-rank compression of the simulation data.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ * All per tag arrays are indexed by the data tag index. Tags that were not compressed report a rank of 0.
+ */
+USTRUCT(BlueprintType)
+struct FPT_LowRankReport
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The rank of the truncated basis per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LowRankReport")
+	TArray<int32> RankPerTag;
+
+	/** The relative Frobenius norm error of the factorization per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LowRankReport")
+	TArray<double> RelativeErrorPerTag;
+
+	/** The largest absolute error of any reconstructed value per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LowRankReport")
+	TArray<double> MaxAbsoluteErrorPerTag;
+
+	/** The number of bytes of the raw simulation data. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LowRankReport")
+	int64 RawBytes = 0;
+
+	/** The number of bytes of the simulation data after compression. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LowRankReport")
+	int64 CompressedBytes = 0;
+};
+
+/**
+ * @brief A structure to hold the result of a leave-one-out analysis of the interpolation error.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ * Every evaluated electrode is predicted from the remaining electrodes and compared with its simulated magnitude.
+ * Per electrode arrays share the order of ElectrodeIndexArray, per tag arrays are flattened as [Electrode * NumTags + Tag].
+ */
+USTRUCT(BlueprintType)
+struct FPT_LeaveOneOutReport
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The indices of the evaluated electrodes. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<int32> ElectrodeIndexArray;
+
+	/** The positions of the evaluated electrodes. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<FVector> ElectrodePositionArray;
+
+	/** The root mean square magnitude error over all ROI cells of all tags, per electrode. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<double> RmsErrorArray;
+
+	/** The root mean square magnitude error relative to the root mean square of the simulated magnitude, per electrode. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<double> RelativeRmsErrorArray;
+
+	/** The largest absolute magnitude error over all ROI cells of all tags, per electrode. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<double> MaxErrorArray;
+
+	/** Whether an electrode could not be predicted with the active mode and was predicted with inverse distance weighting instead, per electrode. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<bool> FallbackArray;
+
+	/** The number of electrodes predicted with inverse distance weighting instead of the active mode. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	int32 NumFallbacks = 0;
+
+	/** The interpolation mode the report was evaluated with. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	EInterpolationMode InterpolationMode = EInterpolationMode::Barycentric;
+
+	/** The interpolator version the report was evaluated with, see APT_ElectrodeAreaActor::GetInterpolatorVersion(). */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	int32 InterpolatorVersion = 0;
+
+	/** The number of tags of the per tag arrays. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	int32 NumTags = 0;
+
+	/** The root mean square magnitude error per electrode and tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<double> RmsErrorPerTagArray;
+
+	/** The largest absolute magnitude error per electrode and tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<double> MaxErrorPerTagArray;
+
+	/** The number of rows of the grid error map, 0 if the electrodes do not form a grid. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	int32 ErrorMapRows = 0;
+
+	/** The number of columns of the grid error map, 0 if the electrodes do not form a grid. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	int32 ErrorMapColumns = 0;
+
+	/** The relative RMS error at every grid node, [Row * ErrorMapColumns + Column], -1 for nodes without electrode. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LeaveOneOutReport")
+	TArray<double> ErrorMap;
+};
+
+/**
+ * @brief A structure to hold the thresholded volume metrics of the current interpolation result.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ * The metrics are accumulated during the interpolation pass, so reading them does not touch the field data again.
+ * Without tetra volumes every ROI cell counts with a volume of one, so the volumes become cell counts.
+ * Per tag and threshold arrays are flattened as [Tag * ThresholdArray.Num() + Threshold].
+ */
+USTRUCT(BlueprintType)
+struct FPT_VolumeMetrics
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The magnitude thresholds the metrics were evaluated for. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	TArray<double> ThresholdArray;
+
+	/** Whether tetra volumes were available for all tags, otherwise the volumes are cell counts. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	bool bHasTetraVolumes = false;
+
+	/** The number of tags of the per tag arrays. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	int32 NumTags = 0;
+
+	/** The ROI volume over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	double RoiVolume = 0.0;
+
+	/** The ROI volume with a magnitude above every threshold, over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	TArray<double> VolumeAboveThresholdArray;
+
+	/** The fraction of the ROI volume with a magnitude above every threshold, over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	TArray<double> FractionAboveThresholdArray;
+
+	/** The ROI volume per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	TArray<double> RoiVolumePerTagArray;
+
+	/** The volume of the whole tag, including the cells outside the ROI. 0 without tetra volumes. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	TArray<double> TagVolumePerTagArray;
+
+	/** The ROI volume with a magnitude above every threshold per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	TArray<double> VolumeAboveThresholdPerTagArray;
+
+	/** The fraction of the ROI volume with a magnitude above every threshold per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_VolumeMetrics")
+	TArray<double> FractionAboveThresholdPerTagArray;
+};
+
+/**
+ * @brief A structure to hold the result of the electrode position optimizer.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ * Besides the optimal position, the electrodes and weights of the optimized interpolation mode at that position are
+ * stored, so they can be passed directly to UPT_SimulationComponent::ProcessWeightedInterpolation.
+ */
+USTRUCT(BlueprintType)
+struct FPT_OptimizationResult
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Whether a valid position was found. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_OptimizationResult")
+	bool bIsValid = false;
+
+	/** The optimal electrode position on the electrode plane. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_OptimizationResult")
+	FVector Position = FVector::ZeroVector;
+
+	/** The objective value at the optimal position. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_OptimizationResult")
+	double ObjectiveValue = 0.0;
+
+	/** The electrode indices blended at the optimal position, three for the barycentric mode. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_OptimizationResult")
+	TArray<int32> ElectrodeIndexArray;
+
+	/** The weights of the interpolation mode at the optimal position, one per electrode index. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_OptimizationResult")
+	TArray<double> WeightArray;
+
+	/** The best objective value of the coarse sweep. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_OptimizationResult")
+	double SweepObjectiveValue = 0.0;
+
+	/** The total number of objective evaluations. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_OptimizationResult")
+	int32 NumEvaluations = 0;
+
+	/** The wall time of the optimization in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_OptimizationResult")
+	double ElapsedMilliseconds = 0.0;
+};
+
+/**
+ * @brief A structure to hold the statistics of the angle between the surface normal and the vector field.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ * The values are taken over the ROI surface vertices with a known normal, as computed by the last vertex color pass.
+ * The percentile arrays are indexed like PercentileArray.
+ */
+USTRUCT(BlueprintType)
+struct FPT_NormalFieldReport
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The number of ROI surface vertices the statistics are taken over. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_NormalFieldReport")
+	int32 NumVertices = 0;
+
+	/** The mean angle between the surface normal and the vector field in degrees. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_NormalFieldReport")
+	double MeanAngle = 0.0;
+
+	/** The mean vector field component along the surface normal. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_NormalFieldReport")
+	double MeanNormalComponent = 0.0;
+
+	/** The mean absolute vector field component along the surface normal. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_NormalFieldReport")
+	double MeanAbsoluteNormalComponent = 0.0;
+
+	/** The percentiles the percentile arrays are evaluated at. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_NormalFieldReport")
+	TArray<double> PercentileArray;
+
+	/** The angle in degrees at every percentile. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_NormalFieldReport")
+	TArray<double> AnglePercentileArray;
+
+	/** The normal component at every percentile. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_NormalFieldReport")
+	TArray<double> NormalComponentPercentileArray;
+};
+
+/**
+ * @brief A structure to hold the statistics of the per cell difference between two result slots.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ * The differences are signed, slot A minus slot B, and taken over the ROI cells with every cell counting equally.
+ */
+USTRUCT(BlueprintType)
+struct FPT_DifferenceReport
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Whether both slots were set and compatible. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	bool bIsValid = false;
+
+	/** The number of ROI cells over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	int32 NumCells = 0;
+
+	/** The mean magnitude difference over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	double MeanDifference = 0.0;
+
+	/** The mean absolute magnitude difference over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	double MeanAbsoluteDifference = 0.0;
+
+	/** The root mean square magnitude difference over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	double RmsDifference = 0.0;
+
+	/** The smallest magnitude difference over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	double MinDifference = 0.0;
+
+	/** The largest magnitude difference over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	double MaxDifference = 0.0;
+
+	/** The mean length of the vector field difference over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	double MeanVectorDifference = 0.0;
+
+	/** The fraction of the ROI cells whose magnitude is higher in slot A. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	double FractionIncreased = 0.0;
+
+	/** The mean magnitude difference per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	TArray<double> MeanDifferencePerTagArray;
+
+	/** The mean absolute magnitude difference per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	TArray<double> MeanAbsoluteDifferencePerTagArray;
+
+	/** The root mean square magnitude difference per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	TArray<double> RmsDifferencePerTagArray;
+
+	/** The smallest magnitude difference per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	TArray<double> MinDifferencePerTagArray;
+
+	/** The largest magnitude difference per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	TArray<double> MaxDifferencePerTagArray;
+
+	/** The mean length of the vector field difference per tag. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_DifferenceReport")
+	TArray<double> MeanVectorDifferencePerTagArray;
+};
+
+/**
+ * @brief A structure to describe a dataset held by the simulation workspace.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ * The surface bytes belong to the surface mapping of the patient and ROI, which all configurations of them share.
+ */
+USTRUCT(BlueprintType)
+struct FPT_WorkspaceEntry
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The patient ID. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_WorkspaceEntry")
+	FString PatientId;
+
+	/** The configuration ID. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_WorkspaceEntry")
+	FString ConfigId;
+
+	/** The ROI ID. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_WorkspaceEntry")
+	FString RoiId;
+
+	/** Whether the dataset is the active dataset of the simulation component. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_WorkspaceEntry")
+	bool bIsActive = false;
+
+	/** Whether the simulation data is compressed into a low-rank basis. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_WorkspaceEntry")
+	bool bIsCompressed = false;
+
+	/** The bytes held by the dataset itself. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_WorkspaceEntry")
+	int64 DatasetBytes = 0;
+
+	/** The bytes held by the surface mapping, shared by all configurations of the same patient and ROI. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_WorkspaceEntry")
+	int64 SurfaceBytes = 0;
+};
+
+/**
+ * @brief A structure to describe a consumer registered with the memory budget manager.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ */
+USTRUCT(BlueprintType)
+struct FPT_MemoryConsumer
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The name the consumer reports under. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_MemoryConsumer")
+	FString Name;
+
+	/** The subsystem the consumer belongs to. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_MemoryConsumer")
+	EMemorySubsystem Subsystem = EMemorySubsystem::Simulation;
+
+	/** The bytes held by the consumer. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_MemoryConsumer")
+	int64 Bytes = 0;
+
+	/** The fraction of the memory budget held by the consumer. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_MemoryConsumer")
+	double BudgetFraction = 0.0;
+};
+
+/**
+ * @brief A structure to hold the per stage timing breakdown of the last simulation data load.
+ *
+ * This structure is BlueprintType, meaning it can be used in Blueprint.
+ * Stages that did not run, like the mapping stages when the surface mapping was reused, report 0.
+ */
+USTRUCT(BlueprintType)
+struct FPT_LoadTimings
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** The time spent reading the tag lengths and the ROI index mappings in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	double HeaderMilliseconds = 0.0;
+
+	/** The time spent checking the memory budget and allocating the ensembles in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	double AllocationMilliseconds = 0.0;
+
+	/** The time spent decoding the electrodes into the ensembles in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	double ElectrodeDecodeMilliseconds = 0.0;
+
+	/** The time spent compressing the ensembles in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	double CompressionMilliseconds = 0.0;
+
+	/** The time spent decoding the vertex tag mappings in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	double MappingDecodeMilliseconds = 0.0;
+
+	/** The time spent merging the mesh and volume vertex tag mappings in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	double MappingMergeMilliseconds = 0.0;
+
+	/** The time spent flattening the mapping into vertex cell rows in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	double CellRowMilliseconds = 0.0;
+
+	/** The time of the whole load in milliseconds. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	double TotalMilliseconds = 0.0;
+
+	/** The number of loaded electrodes. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	int32 NumElectrodes = 0;
+
+	/** The number of ROI cells over all tags. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	int64 NumRoiCells = 0;
+
+	/** The number of vertices in the ROI. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	int32 NumRoiVertices = 0;
+
+	/** Whether the surface mapping was reused from the workspace instead of being decoded. */
+	UPROPERTY(BlueprintReadOnly, Category = "PT_LoadTimings")
+	bool bSurfaceMappingReused = false;
+};
+
 /**
  * @brief A container class for various structures.
  *